@@ -200,9 +200,10 @@ void setup()
     else
         MONITOR(MAIN_TAG, "Failed deleting peer");
 
-    uint8_t *delete_oldest = easyEspNow.deletePeer();
-    if (delete_oldest)
-        MONITOR(MAIN_TAG, "Success deleting oldest peer");
+    // the deleted peer is returned by value, an invalid peer (time_peer_added = 0) if nothing was deleted
+    peer_t delete_oldest = easyEspNow.deletePeer();
+    if (delete_oldest.time_peer_added != 0)
+        MONITOR(MAIN_TAG, "Success deleting oldest peer: %s", easyEspNow.easyMac2Char(delete_oldest.mac));
     else
         MONITOR(MAIN_TAG, "Failed deleting oldest peer");
 
@@ -228,9 +229,9 @@ void setup()
         // this will delete Broadcast address as well
         // if you want to keep broadcast address, adjust the while loop `peer_list.peer_number > 1`
         // otherwise you will end into an infinite loop
-        uint8_t *oldest_mac = easyEspNow.deletePeer(false);
-        if (oldest_mac)
-            MONITOR(MAIN_TAG, "Success deleting oldest peer: %s", easyEspNow.easyMac2Char(oldest_mac));
+        peer_t oldest_peer = easyEspNow.deletePeer(false);
+        if (oldest_peer.time_peer_added != 0)
+            MONITOR(MAIN_TAG, "Success deleting oldest peer: %s", easyEspNow.easyMac2Char(oldest_peer.mac));
         else
             MONITOR(MAIN_TAG, "Failed deleting oldest peer");
 
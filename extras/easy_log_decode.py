@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Decodes the binary log of EasyEspNow (`easyLogBegin(size, true)` in a build with `EASY_LOG_DEFERRED`).
+
+Records only carry the addresses of their format string and tag, the strings themselves are read from the ELF
+of the firmware that wrote them, so the ELF must be the exact build that ran on the device.
+
+    python3 easy_log_decode.py firmware.elf capture.bin
+    cat /dev/ttyUSB0 | python3 easy_log_decode.py firmware.elf -
+
+Anything between records (boot messages, `Serial.print` of the sketch) is skipped, records are found again by their
+sync word and a format address that points into the ELF.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+RECORD_SYNC = 0x5EA1
+MAX_WORDS = 10
+RECORD = struct.Struct("<HBBIII%dI" % MAX_WORDS)
+LABELS = ["NONE", "MONITOR", "ERROR", "WARNING", "INFO", "DEBUG", "VERBOSE"]
+MAX_STRING_LEN = 64
+
+# same conversion grammar as `easyLogFormat(...)` on the device
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|\d*)(?:\.(\*|\d*))?(hh|h|ll|l|L|q|j|z|t)?([diouxXcsfFeEgGaApn%])")
+
+
+class Elf32:
+    """Loaded sections of a little endian ELF32, just enough to read strings by address"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s is not a little endian ELF32 file" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            # allocated and backed by file content (not .bss)
+            if flags & 0x2 and sh_type != 8 and addr:
+                self.sections.append((addr, size, data[offset:offset + size]))
+
+    def string(self, address, limit=256):
+        for addr, size, content in self.sections:
+            if addr <= address < addr + size:
+                start = address - addr
+                end = content.find(b"\0", start, start + limit)
+                if end < 0:
+                    return None
+                return content[start:end].decode("utf-8", "replace")
+        return None
+
+
+def format_record(elf, fmt, words):
+    """Formats the argument words as the device would have"""
+    position = 0
+
+    def take(count):
+        nonlocal position
+        value = words[position:position + count]
+        position += count
+        if len(value) < count:
+            return None
+        return value[0] | (value[1] << 32) if count == 2 else value[0]
+
+    def convert(match):
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if width == "*":
+            value = take(1)
+            width = str(struct.unpack("<i", struct.pack("<I", value))[0]) if value is not None else ""
+        if precision == "*":
+            value = take(1)
+            precision = str(max(struct.unpack("<i", struct.pack("<I", value))[0], 0)) if value is not None else ""
+        wide = length in ("ll", "q", "j")
+        needed = 2 if wide or conversion in "fFeEgGaA" else 1
+        if conversion == "n":
+            return ""
+        value = take(needed)
+        if value is None:
+            return "?"
+
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        if conversion in "di":
+            bits = 64 if wide else 32
+            if value >= 1 << (bits - 1):
+                value -= 1 << bits
+            return (spec + "d") % value
+        if conversion in "ouxX":
+            return (spec + conversion) % value
+        if conversion == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conversion in "fFeEgGaA":
+            number = struct.unpack("<d", struct.pack("<Q", value))[0]
+            if conversion in "aA":
+                text = number.hex()
+                return text.upper() if conversion == "A" else text
+            return (spec + conversion) % number
+        if conversion == "s":
+            text = elf.string(value, MAX_STRING_LEN + 1) if value else "(null)"
+            if text is None:
+                # not in the ELF: a string built at runtime, only its address is known
+                text = "<0x%08x>" % value
+            if precision is None:
+                spec += ".%d" % MAX_STRING_LEN
+            return (spec + "s") % text
+        if conversion == "p":
+            return "0x%x" % value
+        return match.group(0)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(elf, data, out):
+    """Walks a capture, returns the number of records decoded and of bytes skipped"""
+    sync = struct.pack("<H", RECORD_SYNC)
+    offset = 0
+    records = 0
+    skipped = 0
+    while True:
+        found = data.find(sync, offset)
+        if found < 0 or found + RECORD.size > len(data):
+            skipped += len(data) - offset
+            break
+        fields = RECORD.unpack_from(data, found)
+        _, level, count, fmt_address, tag_address, timestamp = fields[:6]
+        fmt = elf.string(fmt_address) if 0 < level < len(LABELS) else None
+        if fmt is None:
+            # sync word by chance, not a record
+            skipped += found + 1 - offset
+            offset = found + 1
+            continue
+
+        skipped += found - offset
+        tag = elf.string(tag_address) or "?"
+        words = list(fields[6:6 + min(count, MAX_WORDS)])
+        out.write("[%d] [%s] [%s]: %s\n" % (timestamp, LABELS[level], tag, format_record(elf, fmt, words)))
+        records += 1
+        offset = found + RECORD.size
+    return records, skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes the binary log of EasyEspNow")
+    parser.add_argument("elf", help="ELF of the firmware that wrote the log")
+    parser.add_argument("capture", help="binary capture of the serial output, - for stdin")
+    args = parser.parse_args()
+
+    elf = Elf32(args.elf)
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+
+    records, skipped = decode(elf, data, sys.stdout)
+    sys.stderr.write("%d records, %d bytes skipped\n" % (records, skipped))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,1464 @@
+/*
+ * Benchmarks of the library on the host, against the loopback radio of `shim/host_radio.h`.
+ *
+ * Every result is printed as one JSON object per line, with the benchmark in `bench` and the configuration in `case`,
+ * so two runs can be compared with `extras/host/bench_compare.py`. Numbers measure the library and the host,
+ * radio delays are the ones configured, not the ones of a real ESP32.
+ *
+ *   easy_bench [name]    runs the benchmarks whose name contains `name`, all of them without it
+ */
+
+#include "EasyEspNow.h"
+#include "host_radio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+int CURRENT_LOG_LEVEL = LOG_NONE;
+
+// heap allocations of the process, to tell which callbacks allocate when they are set
+static std::atomic<uint32_t> heap_allocations{0};
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *memory = malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *memory) noexcept
+{
+	free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void *memory, size_t) noexcept
+{
+	free(memory);
+}
+
+static const uint8_t PEER[MAC_ADDR_LEN] = {0x24, 0x6F, 0x28, 0x00, 0x10, 0x01};
+
+static void peerMac(uint16_t index, uint8_t *mac)
+{
+	const uint8_t base[MAC_ADDR_LEN] = {0x24, 0x6F, 0x28, 0x01, 0x00, 0x00};
+	memcpy(mac, base, MAC_ADDR_LEN);
+	mac[4] = index >> 8;
+	mac[5] = index & 0xFF;
+}
+
+static double seconds(int64_t start_us)
+{
+	return (esp_timer_get_time() - start_us) / 1e6;
+}
+
+static uint32_t percentile(std::vector<uint32_t> &samples, double fraction)
+{
+	if (samples.empty())
+		return 0;
+	std::sort(samples.begin(), samples.end());
+	size_t index = (size_t)(fraction * (samples.size() - 1) + 0.5);
+	return samples[index];
+}
+
+static double mean(const std::vector<uint32_t> &samples)
+{
+	if (samples.empty())
+		return 0;
+	double total = 0;
+	for (uint32_t sample : samples)
+		total += sample;
+	return total / samples.size();
+}
+
+// one JSON object per result, fields are appended in the order they are given
+class Result
+{
+public:
+	Result(const char *bench, const std::string &name)
+	{
+		line = "{\"bench\":\"" + std::string(bench) + "\",\"case\":\"" + name + "\"";
+	}
+	Result &field(const char *key, double value)
+	{
+		char text[64];
+		snprintf(text, sizeof(text), ",\"%s\":%.6g", key, value);
+		line += text;
+		return *this;
+	}
+	Result &latencies(const char *prefix, std::vector<uint32_t> &samples)
+	{
+		std::string key(prefix);
+		field((key + "_p50_us").c_str(), percentile(samples, 0.50));
+		field((key + "_p90_us").c_str(), percentile(samples, 0.90));
+		field((key + "_p99_us").c_str(), percentile(samples, 0.99));
+		field((key + "_max_us").c_str(), samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end()));
+		return field((key + "_mean_us").c_str(), mean(samples));
+	}
+	void print()
+	{
+		Serial.printf("%s}\n", line.c_str());
+		Serial.flush();
+	}
+
+private:
+	std::string line;
+};
+
+static host_radio_config_t radio(uint32_t delay_us = 0, uint32_t jitter_us = 0, uint16_t loss_per_mille = 0)
+{
+	host_radio_config_t config = hostRadioDefaultConfig();
+	config.delay_us = delay_us;
+	config.jitter_us = jitter_us;
+	config.loss_per_mille = loss_per_mille;
+	return config;
+}
+
+static bool start(const host_radio_config_t &config, int tx_q_size, bool synch_send, uint8_t max_in_flight = DEFAULT_TX_MAX_IN_FLIGHT)
+{
+	hostRadioConfigure(config);
+	WiFi.mode(WIFI_STA);
+	easyEspNow.onDataReceived(nullptr);
+	easyEspNow.onDataSent(nullptr);
+	easyEspNow.onGroupSendResult(nullptr);
+	easyEspNow.setTXPacing(max_in_flight);
+	if (!easyEspNow.begin(1, WIFI_IF_STA, tx_q_size, synch_send))
+	{
+		Serial.printf("{\"error\":\"begin failed\"}\n");
+		return false;
+	}
+	easyEspNow.addPeer(PEER);
+	// counters of the library outlive stop()
+	easyEspNow.getStats(true);
+	easyEspNow.getFragmentationStats(true);
+	easyEspNow.getPeerDirectoryStats(true);
+	easyEspNow.getGroupStats(true);
+	easyEspNow.getRXStats(true);
+	easyEspNow.getEncryptionStats(true);
+	easyEspNow.getCompressionStats(true);
+	hostRadioStats(true);
+	return true;
+}
+
+static void finish()
+{
+	easyEspNow.waitForTXQueueToBeEmptied();
+	hostRadioDrain();
+	easyEspNow.stop();
+}
+
+static easy_send_error_t sendWhenReady(const uint8_t *dst, const uint8_t *payload, size_t len)
+{
+	easy_send_error_t result;
+	while ((result = easyEspNow.send(dst, payload, len)) == EASY_SEND_QUEUE_FULL_ERROR)
+		taskYIELD();
+	return result;
+}
+
+static void waitFor(std::atomic<uint32_t> &counter, uint32_t target, uint32_t timeout_ms = 5000)
+{
+	uint32_t start = millis();
+	while (counter.load() < target && millis() - start < timeout_ms)
+		taskYIELD();
+}
+
+/* ==========> send() throughput <========== */
+
+// `fixed_delay_ms` sleeps that long after every message, as the TX task did after every `esp_now_send` before it was paced
+// on completions: the baseline the pacing is measured against
+static void benchSendThroughput(const char *name, const host_radio_config_t &config, bool synch_send, uint8_t max_in_flight,
+								uint32_t messages, size_t payload_len, bool sealed = false, uint32_t fixed_delay_ms = 0)
+{
+	static std::atomic<uint32_t> completed;
+	static std::atomic<uint32_t> failed;
+	completed = 0;
+	failed = 0;
+	if (!start(config, 32, synch_send, max_in_flight))
+		return;
+	easyEspNow.onDataSent([](const uint8_t *dst, uint8_t status)
+						  {
+							  if (status != ESP_NOW_SEND_SUCCESS)
+								  failed++;
+							  completed++; });
+	if (sealed)
+	{
+		const uint8_t key[ENCRYPTION_KEY_LEN] = {1, 2, 3, 4};
+		easyEspNow.enableEncryption();
+		easyEspNow.setPeerKey(PEER, key);
+	}
+
+	uint8_t payload[MAX_DATA_LENGTH] = {};
+	uint32_t refused = 0;
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages; i++)
+	{
+		memcpy(payload, &i, sizeof(i));
+		if (sendWhenReady(PEER, payload, payload_len) != EASY_SEND_OK)
+			refused++;
+		if (fixed_delay_ms)
+			vTaskDelay(pdMS_TO_TICKS(fixed_delay_ms));
+	}
+	waitFor(completed, messages - refused);
+	double elapsed = seconds(start_us);
+
+	easy_stats_t stats = easyEspNow.getStats();
+	encryption_stats_t encryption = easyEspNow.getEncryptionStats();
+	host_radio_stats_t radio_stats = hostRadioStats();
+	finish();
+
+	Result("send_throughput", name)
+		.field("messages", messages)
+		.field("payload_len", payload_len)
+		.field("fixed_delay_ms", fixed_delay_ms)
+		.field("sealed", encryption.sealed)
+		.field("seconds", elapsed)
+		.field("msgs_per_s", completed / elapsed)
+		.field("kbytes_per_s", completed * payload_len / elapsed / 1024)
+		.field("refused", refused)
+		.field("failed", failed)
+		.field("no_mem", radio_stats.no_mem)
+		.field("enqueue_to_send_p50_us", easyLatencyPercentile(stats.enqueue_to_send, 50))
+		.field("enqueue_to_send_p99_us", easyLatencyPercentile(stats.enqueue_to_send, 99))
+		.field("send_to_complete_p50_us", easyLatencyPercentile(stats.send_to_complete, 50))
+		.field("tx_queue_depth_max", stats.tx_queue_depth_max)
+		.print();
+}
+
+/* ==========> End-to-end latency <========== */
+
+// `send()` to the looped back frame reaching the application, timestamp carried in the payload
+static void benchLatency(const char *name, const host_radio_config_t &config, bool rx_task, uint32_t messages, uint32_t burst)
+{
+	static std::vector<uint32_t> samples;
+	static std::mutex samples_mutex;
+	static std::atomic<uint32_t> received;
+	samples.clear();
+	samples.reserve(messages);
+	received = 0;
+	if (!start(config, 32, false, 4))
+		return;
+	if (rx_task)
+		easyEspNow.beginRXTask();
+
+	easyEspNow.onDataReceived([](const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *info)
+							  {
+								  int64_t sent_us;
+								  if (len < (int)sizeof(sent_us))
+									  return;
+								  memcpy(&sent_us, data, sizeof(sent_us));
+								  uint32_t latency = (uint32_t)(esp_timer_get_time() - sent_us);
+								  std::lock_guard<std::mutex> lock(samples_mutex);
+								  samples.push_back(latency);
+								  received++; });
+
+	uint8_t payload[64] = {};
+	uint32_t sent = 0;
+	while (sent < messages)
+	{
+		// `burst` messages back to back, then wait for all of them: 1 is the unloaded latency
+		uint32_t target = sent + burst;
+		for (; sent < target && sent < messages; sent++)
+		{
+			int64_t now_us = esp_timer_get_time();
+			memcpy(payload, &now_us, sizeof(now_us));
+			sendWhenReady(PEER, payload, sizeof(payload));
+		}
+		waitFor(received, sent, 1000);
+		received = sent;
+	}
+
+	finish();
+	std::lock_guard<std::mutex> lock(samples_mutex);
+	Result("latency", name)
+		.field("messages", messages)
+		.field("burst", burst)
+		.field("delay_us", config.delay_us)
+		.field("jitter_us", config.jitter_us)
+		.field("received", samples.size())
+		.latencies("e2e", samples)
+		.print();
+}
+
+/* ==========> Peer table <========== */
+
+template <typename Operation>
+static double nsPerOperation(uint32_t operations, Operation operation)
+{
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < operations; i++)
+		operation(i);
+	return (esp_timer_get_time() - start_us) * 1000.0 / operations;
+}
+
+static void benchPeerTable(uint32_t rounds)
+{
+	if (!start(radio(), 8, false))
+		return;
+	easyEspNow.deletePeer(PEER);
+
+	// ESP-NOW holds at most MAX_TOTAL_PEER_NUM peers, one round fills and empties it
+	const uint16_t peers = MAX_TOTAL_PEER_NUM;
+	uint8_t macs[MAX_TOTAL_PEER_NUM][MAC_ADDR_LEN];
+	for (uint16_t i = 0; i < peers; i++)
+		peerMac(i, macs[i]);
+
+	double add_ns = 0, exists_ns = 0, stats_ns = 0, last_seen_ns = 0, delete_ns = 0, delete_oldest_ns = 0;
+	peer_stats_t stats;
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		add_ns += nsPerOperation(peers, [&](uint32_t i)
+								 { easyEspNow.addPeer(macs[i]); });
+		exists_ns += nsPerOperation(peers, [&](uint32_t i)
+									{ easyEspNow.peerExists(macs[i]); });
+		stats_ns += nsPerOperation(peers, [&](uint32_t i)
+								   { easyEspNow.getPeerStats(macs[i], stats); });
+		last_seen_ns += nsPerOperation(peers, [&](uint32_t i)
+									   { easyEspNow.updateLastSeenPeer(macs[i]); });
+		if (round % 2)
+			delete_ns += nsPerOperation(peers, [&](uint32_t i)
+										{ easyEspNow.deletePeer(macs[i]); });
+		else
+			delete_oldest_ns += nsPerOperation(peers, [&](uint32_t i)
+											   { easyEspNow.deletePeer(false); });
+	}
+	finish();
+
+	Result("peer_table", "esp_now_20_peers")
+		.field("rounds", rounds)
+		.field("add_ns", add_ns / rounds)
+		.field("exists_ns", exists_ns / rounds)
+		.field("get_stats_ns", stats_ns / rounds)
+		.field("update_last_seen_ns", last_seen_ns / rounds)
+		.field("delete_ns", delete_ns / (rounds / 2))
+		.field("delete_oldest_ns", delete_oldest_ns / ((rounds + 1) / 2))
+		.print();
+}
+
+/* ==========> Callback dispatch <========== */
+
+typedef std::function<void(const uint8_t *src_mac, const uint8_t *data, int data_len, espnow_frame_recv_info_t *esp_now_frame)> std_frame_rcvd_data;
+
+static uint32_t callback_frames;
+
+static void countFrame(const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *frame)
+{
+	callback_frames++;
+}
+
+static void countFrameInContext(void *context, const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *frame)
+{
+	(*(uint32_t *)context)++;
+}
+
+// what rx_cb does with the receive callback: set it once, check it and call it for every frame. The callback is reached
+// through a volatile pointer, as the library reaches it through its instance, so the compiler can not see what it holds
+template <typename Callback, typename Make>
+static void benchCallback(const char *kind, const char *callable, uint32_t calls, Make make)
+{
+	static Callback callback;
+	static Callback *volatile target = &callback;
+
+	const uint32_t registrations = 1000;
+	uint32_t allocations = heap_allocations.load();
+	double register_ns = nsPerOperation(registrations, [&](uint32_t i)
+										{ *target = make(); });
+	allocations = heap_allocations.load() - allocations;
+
+	uint8_t src[MAC_ADDR_LEN] = {};
+	uint8_t data[32] = {};
+	callback_frames = 0;
+	double call_ns = nsPerOperation(calls, [&](uint32_t i)
+									{
+										Callback &cb = *target;
+										if (cb != nullptr)
+											cb(src, data, sizeof(data), nullptr); });
+
+	Result("callback_dispatch", std::string(kind) + "_" + callable)
+		.field("calls", calls)
+		.field("call_ns", call_ns)
+		.field("register_ns", register_ns)
+		.field("allocations_per_register", (double)allocations / registrations)
+		.field("sizeof", sizeof(Callback))
+		.field("frames", callback_frames)
+		.print();
+}
+
+static void benchCallbackDispatch(uint32_t calls)
+{
+	// a capture of three pointers: the instance, a context and a counter, more than std::function keeps in place
+	static uint32_t *counter = &callback_frames;
+	static void *instance = &counter;
+	static void *context = &instance;
+	auto captures = [](uint32_t *&count, void *&self, void *&ctx)
+	{ return [count, self, ctx](const uint8_t *, const uint8_t *, int, espnow_frame_recv_info_t *)
+	  { (*count)++; }; };
+
+	benchCallback<std_frame_rcvd_data>("std_function", "function", calls, []
+									   { return std_frame_rcvd_data(countFrame); });
+	benchCallback<frame_rcvd_data>("inplace", "function", calls, []
+								   { return frame_rcvd_data(countFrame); });
+	benchCallback<std_frame_rcvd_data>("std_function", "lambda_3_pointers", calls, [&]
+									   { return std_frame_rcvd_data(captures(counter, instance, context)); });
+	benchCallback<frame_rcvd_data>("inplace", "lambda_3_pointers", calls, [&]
+								   { return frame_rcvd_data(captures(counter, instance, context)); });
+	benchCallback<frame_rcvd_data>("inplace", "function_context", calls, []
+								   { return frame_rcvd_data(countFrameInContext, &callback_frames); });
+}
+
+// peers beyond the ESP-NOW limit are swapped in by the TX task when a frame goes to them
+static void benchPeerDirectory(uint16_t capacity, uint32_t messages)
+{
+	static std::atomic<uint32_t> completed;
+	completed = 0;
+	if (!start(radio(), 32, false, 4))
+		return;
+	easyEspNow.deletePeer(PEER);
+	easyEspNow.enablePeerDirectory(capacity);
+	easyEspNow.onDataSent([](const uint8_t *dst, uint8_t status)
+						  { completed++; });
+
+	std::vector<uint8_t> macs(capacity * MAC_ADDR_LEN);
+	for (uint16_t i = 0; i < capacity; i++)
+		peerMac(i, &macs[i * MAC_ADDR_LEN]);
+
+	double add_ns = nsPerOperation(capacity, [&](uint32_t i)
+								   { easyEspNow.addPeer(&macs[i * MAC_ADDR_LEN]); });
+	double last_seen_ns = nsPerOperation(capacity, [&](uint32_t i)
+										 { easyEspNow.updateLastSeenPeer(&macs[i * MAC_ADDR_LEN]); });
+	easyEspNow.getPeerDirectoryStats(true);
+
+	uint8_t payload[32] = {};
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages; i++)
+		sendWhenReady(&macs[(i % capacity) * MAC_ADDR_LEN], payload, sizeof(payload));
+	waitFor(completed, messages);
+	double elapsed = seconds(start_us);
+	peer_directory_stats_t stats = easyEspNow.getPeerDirectoryStats();
+	finish();
+
+	Result("peer_table", "directory_" + std::to_string(capacity) + "_peers")
+		.field("add_ns", add_ns)
+		.field("update_last_seen_ns", last_seen_ns)
+		.field("messages", messages)
+		.field("msgs_per_s", completed / elapsed)
+		.field("hits", stats.hits)
+		.field("misses", stats.misses)
+		.field("swaps", stats.swaps)
+		.field("swap_failures", stats.swap_failures)
+		.field("swap_mean_us", stats.swaps ? (double)stats.swap_time_total_us / stats.swaps : 0)
+		.field("swap_max_us", stats.swap_time_max_us)
+		.print();
+}
+
+/* ==========> Fragmentation <========== */
+
+static void benchFragmentation(const char *name, const host_radio_config_t &config, uint16_t message_len, uint32_t messages)
+{
+	static std::atomic<uint32_t> reassembled;
+	static uint16_t expected_len;
+	reassembled = 0;
+	expected_len = message_len;
+	if (!start(config, 32, false, 4))
+		return;
+	if (!easyEspNow.enableFragmentation(message_len))
+	{
+		finish();
+		return;
+	}
+	easyEspNow.onDataReceived([](const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *info)
+							  {
+								  if (len == expected_len)
+									  reassembled++; });
+
+	std::vector<uint8_t> message(message_len);
+	for (uint16_t i = 0; i < message_len; i++)
+		message[i] = (uint8_t)i;
+
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages; i++)
+		sendWhenReady(PEER, message.data(), message_len);
+	easyEspNow.waitForTXQueueToBeEmptied();
+	hostRadioDrain();
+	waitFor(reassembled, messages, 200);
+	double elapsed = seconds(start_us);
+	fragmentation_stats_t stats = easyEspNow.getFragmentationStats();
+	finish();
+
+	Result("fragmentation", name)
+		.field("message_len", message_len)
+		.field("messages", messages)
+		.field("loss_per_mille", config.loss_per_mille)
+		.field("seconds", elapsed)
+		.field("msgs_per_s", reassembled / elapsed)
+		.field("kbytes_per_s", (double)reassembled * message_len / elapsed / 1024)
+		.field("tx_fragments", stats.tx_fragments)
+		.field("rx_messages", stats.rx_messages)
+		.field("rx_timeouts", stats.rx_timeouts)
+		.field("rx_evictions", stats.rx_evictions)
+		.print();
+}
+
+/* ==========> Send handles <========== */
+
+// pipelined sends over a lossy radio, the failed messages are found by their handle and sent again until all are delivered
+// with more than one destination the fair scheduler interleaves the fragments of their messages, so many messages have a
+// failed fragment in flight while their last one is still queued
+static void benchSendHandles(const char *name, const host_radio_config_t &config, uint16_t message_len, uint32_t messages, uint8_t destinations = 1)
+{
+	static std::vector<uint8_t> received;
+	received.assign(messages, 0);
+	if (!start(config, 32, false, 4))
+		return;
+	// room to reassemble a message per destination while others that lost a fragment wait for their timeout
+	if (message_len > MAX_DATA_LENGTH && !easyEspNow.enableFragmentation(message_len, destinations > 1 ? 4 * destinations : DEFAULT_REASSEMBLY_SLOTS))
+	{
+		finish();
+		return;
+	}
+	std::vector<uint8_t> macs(destinations * MAC_ADDR_LEN);
+	memcpy(macs.data(), PEER, MAC_ADDR_LEN);
+	for (uint8_t i = 1; i < destinations; i++)
+	{
+		peerMac(i, &macs[i * MAC_ADDR_LEN]);
+		easyEspNow.addPeer(&macs[i * MAC_ADDR_LEN]);
+	}
+	if (destinations > 1)
+		easyEspNow.enableFairScheduling();
+	easyEspNow.enableSendTracking(64);
+	easyEspNow.onDataReceived([](const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *info)
+							  {
+								  uint32_t id;
+								  memcpy(&id, data, sizeof(id));
+								  if (id < received.size())
+									  received[id] = 1; });
+
+	std::vector<uint8_t> message(message_len);
+	std::unordered_map<easy_send_handle_t, uint32_t> in_flight;
+	std::vector<uint32_t> to_send;
+	std::vector<uint32_t> samples;
+	std::vector<uint8_t> acked(messages, 0);
+	for (uint32_t id = messages; id > 0; id--)
+		to_send.push_back(id - 1);
+	uint32_t completions = 0;
+	uint32_t failures = 0;
+	uint32_t retries = 0;
+	uint32_t sends = 0;
+
+	int64_t start_us = esp_timer_get_time();
+	uint32_t start_ms = millis();
+	while ((!to_send.empty() || !in_flight.empty()) && millis() - start_ms < 10000)
+	{
+		if (!to_send.empty())
+		{
+			uint32_t id = to_send.back();
+			memcpy(message.data(), &id, sizeof(id));
+			easy_send_handle_t handle;
+			if (easyEspNow.send(&macs[(id % destinations) * MAC_ADDR_LEN], message.data(), message_len, DEFAULT_SYNCH_SEND_TIMEOUT_MS, DEFAULT_TX_PRIORITY,
+								&handle) == EASY_SEND_OK)
+			{
+				in_flight[handle] = id;
+				to_send.pop_back();
+				sends++;
+			}
+		}
+
+		send_completion_t completion;
+		bool polled = false;
+		while (easyEspNow.pollSendCompletion(&completion))
+		{
+			polled = true;
+			auto it = in_flight.find(completion.handle);
+			if (it == in_flight.end())
+				continue;
+			completions++;
+			samples.push_back(completion.latency_us);
+			if (completion.status != ESP_NOW_SEND_SUCCESS)
+			{
+				failures++;
+				retries++;
+				to_send.push_back(it->second);
+			}
+			else
+				acked[it->second] = 1;
+			in_flight.erase(it);
+		}
+		if (to_send.empty() && !polled)
+			taskYIELD();
+	}
+	double elapsed = seconds(start_us);
+	hostRadioDrain();
+	uint32_t delivered = 0;
+	uint32_t acked_not_delivered = 0;
+	for (uint32_t id = 0; id < messages; id++)
+	{
+		delivered += received[id];
+		acked_not_delivered += acked[id] && !received[id];
+	}
+	easy_stats_t stats = easyEspNow.getStats();
+	finish();
+
+	Result("send_handles", name)
+		.field("message_len", message_len)
+		.field("messages", messages)
+		.field("loss_per_mille", config.loss_per_mille)
+		.field("destinations", destinations)
+		.field("seconds", elapsed)
+		.field("msgs_per_s", messages / elapsed)
+		.field("sends", sends)
+		.field("completions", completions)
+		.field("failures", failures)
+		.field("retries", retries)
+		.field("unresolved", in_flight.size())
+		.field("delivered", delivered)
+		.field("acked_not_delivered", acked_not_delivered)
+		.field("completions_missed", stats.send_completions_missed)
+		.latencies("completion", samples)
+		.print();
+}
+
+/* ==========> Reliable channels <========== */
+
+// reliable messages over a lossy radio, interleaved in synchronous send mode with blocking `send()` calls that hold the one
+// slot of the application while the acknowledgements of the reliable channel have to go out. Returns `false` if a reliable
+// message was not delivered, the acknowledgements then waited behind the blocked sender
+static bool benchReliable(const char *name, bool synch_send, uint32_t messages)
+{
+	static std::atomic<uint32_t> delivered;
+	static std::atomic<uint32_t> failed;
+	delivered = 0;
+	failed = 0;
+	if (!start(radio(500, 0, 20), 8, synch_send))
+		return false;
+	if (!easyEspNow.enableReliable())
+	{
+		finish();
+		return false;
+	}
+	easyEspNow.getReliableStats(true);
+	easyEspNow.onReliableStatus([](const uint8_t *dst, uint16_t sequence, bool ok)
+								{
+									if (ok)
+										delivered++;
+									else
+										failed++; });
+
+	uint8_t payload[32] = {};
+	uint32_t refused = 0;
+	uint32_t confirmed = 0;
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages; i++)
+	{
+		memcpy(payload, &i, sizeof(i));
+		if (easyEspNow.sendReliable(PEER, payload, sizeof(payload)) != EASY_SEND_OK)
+			refused++;
+		if (synch_send && easyEspNow.send(PEER, payload, sizeof(payload)) == EASY_SEND_OK)
+			confirmed++;
+	}
+	uint32_t start_ms = millis();
+	while (delivered + failed < messages - refused && millis() - start_ms < 5000)
+		taskYIELD();
+	double elapsed = seconds(start_us);
+
+	reliable_stats_t stats = easyEspNow.getReliableStats();
+	easyEspNow.onReliableStatus(nullptr);
+	finish();
+
+	Result("reliable", name)
+		.field("messages", messages)
+		.field("synchronous", synch_send)
+		.field("refused", refused)
+		.field("delivered", delivered)
+		.field("failed", failed)
+		.field("sync_sends_confirmed", confirmed)
+		.field("retransmissions", stats.retransmissions)
+		.field("acks_sent", stats.acks_sent)
+		.field("acks_piggybacked", stats.acks_piggybacked)
+		.field("received", stats.received)
+		.field("msgs_per_s", delivered / elapsed)
+		.field("seconds", elapsed)
+		.print();
+	return refused == 0 && delivered == messages;
+}
+
+/* ==========> Fair scheduler <========== */
+
+// a control loop sending a short message every 2 ms to one peer while another peer is sent long frames flat out, in the same
+// class, over a radio that takes 500 us per frame: FIFO order, the fair scheduler, and the fair scheduler with the flat out peer capped
+static void benchFairScheduler(const char *name, bool fair, uint32_t chatty_rate_bytes_per_s, uint32_t control_messages)
+{
+	static const uint8_t CONTROL[MAC_ADDR_LEN] = {0x24, 0x6F, 0x28, 0x00, 0x10, 0x02};
+	static std::vector<uint32_t> samples;
+	static std::mutex samples_mutex;
+	static std::atomic<uint32_t> chatty_delivered;
+	samples.clear();
+	chatty_delivered = 0;
+	if (!start(radio(500), 32, false, 1))
+		return;
+	easyEspNow.addPeer(CONTROL);
+	if (fair)
+		easyEspNow.enableFairScheduling();
+	if (chatty_rate_bytes_per_s)
+		easyEspNow.setPeerRateLimit(PEER, chatty_rate_bytes_per_s);
+	easyEspNow.onSendComplete([](const send_completion_t *completion)
+							  {
+								  if (memcmp(completion->dst_addr, CONTROL, MAC_ADDR_LEN) != 0)
+								  {
+									  if (completion->status == ESP_NOW_SEND_SUCCESS)
+										  chatty_delivered++;
+									  return;
+								  }
+								  std::lock_guard<std::mutex> lock(samples_mutex);
+								  samples.push_back(completion->latency_us); });
+
+	uint8_t chatty[200] = {};
+	uint8_t control[16] = {};
+	uint32_t control_sent = 0;
+	uint32_t control_refused = 0;
+	int64_t start_us = esp_timer_get_time();
+	int64_t next_control_us = start_us;
+	while (control_sent < control_messages)
+	{
+		if (esp_timer_get_time() >= next_control_us)
+		{
+			if (easyEspNow.send(CONTROL, control, sizeof(control)) != EASY_SEND_OK)
+				control_refused++;
+			control_sent++;
+			next_control_us += 2000;
+		}
+		else if (easyEspNow.send(PEER, chatty, sizeof(chatty)) != EASY_SEND_OK)
+			taskYIELD();
+	}
+	double elapsed = seconds(start_us);
+	uint32_t chatty_at_end = chatty_delivered;
+
+	tx_destination_stats_t destinations[4] = {};
+	uint8_t count = easyEspNow.getTXDestinationStats(destinations, 4);
+	double chatty_share = 0;
+	double control_share = 0;
+	uint32_t chatty_throttled = 0;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (memcmp(destinations[i].mac, PEER, MAC_ADDR_LEN) == 0)
+		{
+			chatty_share = destinations[i].share_permille / 10.0;
+			chatty_throttled = destinations[i].throttled;
+		}
+		if (memcmp(destinations[i].mac, CONTROL, MAC_ADDR_LEN) == 0)
+			control_share = destinations[i].share_permille / 10.0;
+	}
+	finish();
+
+	std::lock_guard<std::mutex> lock(samples_mutex);
+	Result("fair_scheduler", name)
+		.field("control_messages", control_messages)
+		.field("control_refused", control_refused)
+		.field("control_delivered", samples.size())
+		.latencies("control", samples)
+		.field("chatty_msgs_per_s", chatty_at_end / elapsed)
+		.field("chatty_throttled", chatty_throttled)
+		.field("chatty_airtime_pct", chatty_share)
+		.field("control_airtime_pct", control_share)
+		.print();
+}
+
+/* ==========> Backpressure <========== */
+
+typedef enum
+{
+	BACKPRESSURE_POLL_10MS,	  // sleep 10 ms whenever the queue is full, as waitForTXQueueToBeEmptied() used to
+	BACKPRESSURE_YIELD,		  // retry right away
+	BACKPRESSURE_WAIT_SPACE,  // waitForSpace() when the queue is full
+	BACKPRESSURE_WATERMARKS, // stop at the high watermark, resume on the event group bit of the low one
+} backpressure_mode_t;
+
+// a producer sending flat out into a TX queue of 8 slots over a radio that takes 500 us per frame, then waiting for the
+// last completion: how many sends are refused, how often the producer wakes up, the throughput and how late the drain is seen
+static void benchBackpressure(const char *name, backpressure_mode_t mode, uint32_t messages)
+{
+	static const EventBits_t HIGH_BIT = 1 << 0;
+	static const EventBits_t LOW_BIT = 1 << 1;
+	static std::atomic<uint32_t> completed;
+	static std::atomic<int64_t> last_completion_us;
+	static std::atomic<uint32_t> crossings;
+	completed = 0;
+	last_completion_us = 0;
+	crossings = 0;
+	if (!start(radio(500), 8, false, 1))
+		return;
+	easyEspNow.onDataSent([](const uint8_t *dst, uint8_t status)
+						  {
+							  last_completion_us = esp_timer_get_time();
+							  completed++; });
+	EventGroupHandle_t group = xEventGroupCreate();
+	if (mode == BACKPRESSURE_WATERMARKS)
+	{
+		easyEspNow.setTXWatermarks(6, 2, group, HIGH_BIT, LOW_BIT);
+		easyEspNow.onTXWatermark([](bool above_high, uint16_t slots_used)
+								 { crossings++; });
+	}
+
+	uint8_t payload[200] = {};
+	uint32_t refused = 0;
+	uint32_t wakeups = 0;
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages;)
+	{
+		if (mode == BACKPRESSURE_WATERMARKS && (xEventGroupGetBits(group) & HIGH_BIT))
+		{
+			xEventGroupWaitBits(group, LOW_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+			wakeups++;
+		}
+		memcpy(payload, &i, sizeof(i));
+		if (easyEspNow.send(PEER, payload, sizeof(payload)) == EASY_SEND_OK)
+		{
+			i++;
+			continue;
+		}
+		refused++;
+		wakeups++;
+		if (mode == BACKPRESSURE_POLL_10MS)
+			vTaskDelay(pdMS_TO_TICKS(10));
+		else if (mode == BACKPRESSURE_WAIT_SPACE || mode == BACKPRESSURE_WATERMARKS)
+			easyEspNow.waitForSpace(1);
+		else
+			taskYIELD();
+	}
+
+	bool drained = true;
+	if (mode == BACKPRESSURE_POLL_10MS)
+	{
+		while (completed < messages)
+			vTaskDelay(pdMS_TO_TICKS(10));
+	}
+	else if (mode == BACKPRESSURE_YIELD)
+		waitFor(completed, messages);
+	else
+		drained = easyEspNow.waitForDrain(pdMS_TO_TICKS(5000));
+	int64_t drained_us = esp_timer_get_time();
+	double elapsed = seconds(start_us);
+	finish();
+	easyEspNow.setTXWatermarks(0, 0);
+	easyEspNow.onTXWatermark(nullptr);
+	vEventGroupDelete(group);
+
+	Result("backpressure", name)
+		.field("messages", messages)
+		.field("drained", drained)
+		.field("msgs_per_s", completed / elapsed)
+		.field("sends_refused", refused)
+		.field("producer_wakeups", wakeups)
+		.field("watermark_crossings", crossings)
+		.field("drain_seen_after_us", drained_us - last_completion_us)
+		.print();
+}
+
+/* ==========> Ping <========== */
+
+static std::atomic<bool> ping_bulk_running;
+
+static void pingBulkTask(void *)
+{
+	uint8_t payload[200] = {};
+	// leaves 4 slots free, a responder without a free slot does not answer and the probe counts as lost
+	while (ping_bulk_running)
+		if (easyEspNow.waitForSpace(4, pdMS_TO_TICKS(10)))
+			easyEspNow.send(PEER, payload, sizeof(payload), DEFAULT_SYNCH_SEND_TIMEOUT_MS, TX_PRIORITY_BULK);
+	vTaskDelete(NULL);
+}
+
+// ping over the loopback radio, which answers its own probes: the round trip is the radio delay twice, each way is one delay
+// and the clock offset is 0, so the error of the estimates shows. With bulk traffic queued the probes wait behind it
+static void benchPing(const char *name, const host_radio_config_t &config, bool bulk, uint16_t count)
+{
+	if (!start(config, 16, false, 1))
+		return;
+	easyEspNow.enableProbes(count);
+	TaskHandle_t bulk_task = NULL;
+	if (bulk)
+	{
+		ping_bulk_running = true;
+		xTaskCreate(pingBulkTask, "bulk", 4096, NULL, 1, &bulk_task);
+		vTaskDelay(pdMS_TO_TICKS(20));
+	}
+
+	ping_result_t result = {};
+	int64_t start_us = esp_timer_get_time();
+	bool ok = easyEspNow.ping(PEER, count, 64, &result, 5, 200);
+	double elapsed = seconds(start_us);
+	if (bulk)
+	{
+		ping_bulk_running = false;
+		vTaskDelay(pdMS_TO_TICKS(20));
+	}
+	finish();
+
+	Result("ping", name)
+		.field("ok", ok)
+		.field("radio_delay_us", config.delay_us)
+		.field("sent", result.sent)
+		.field("received", result.received)
+		.field("loss_permille", result.loss_permille)
+		.field("rtt_min_us", result.rtt_min_us)
+		.field("rtt_avg_us", result.rtt_avg_us)
+		.field("rtt_p99_us", result.rtt_p99_us)
+		.field("rtt_max_us", result.rtt_max_us)
+		.field("queue_avg_us", result.queue_avg_us)
+		.field("air_avg_us", result.air_avg_us)
+		.field("turnaround_avg_us", result.turnaround_avg_us)
+		.field("clock_offset_us", (double)result.clock_offset_us)
+		.field("forward_avg_us", result.forward_avg_us)
+		.field("return_avg_us", result.return_avg_us)
+		.field("seconds", elapsed)
+		.print();
+}
+
+/* ==========> Encryption <========== */
+
+// known answer from RFC 8439 §2.8.2: seal must give its ciphertext and tag, open must give back the plaintext and refuse
+// the same frame with one bit of the tag flipped. Returns `false` if any of them does not hold
+static bool benchEncryptionVector()
+{
+	static const uint8_t nonce[EasyAead::NONCE_LEN] = {0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+	static const uint8_t aad[] = {0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7};
+	static const char plaintext[] = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+	static const uint8_t ciphertext[] = {
+		0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+		0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe, 0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+		0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+		0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+		0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c, 0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+		0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+		0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+		0x61, 0x16};
+	static const uint8_t expected_tag[EasyAead::TAG_LEN] = {0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+														  0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91};
+	const size_t len = sizeof(ciphertext);
+
+	uint8_t key_bytes[EasyAead::KEY_LEN];
+	for (uint8_t i = 0; i < EasyAead::KEY_LEN; i++)
+		key_bytes[i] = 0x80 + i;
+	EasyAead key;
+	key.setKey(key_bytes);
+
+	uint8_t data[sizeof(ciphertext)];
+	uint8_t tag[EasyAead::TAG_LEN];
+	memcpy(data, plaintext, len);
+	key.seal(nonce, aad, sizeof(aad), data, len, tag);
+	bool sealed = memcmp(data, ciphertext, len) == 0 && memcmp(tag, expected_tag, EasyAead::TAG_LEN) == 0;
+
+	uint8_t plain[sizeof(ciphertext)] = {};
+	bool opened = key.open(nonce, aad, sizeof(aad), ciphertext, plain, len, expected_tag) && memcmp(plain, plaintext, len) == 0;
+
+	// a forged frame is refused and its plaintext never written
+	uint8_t forged_tag[EasyAead::TAG_LEN];
+	memcpy(forged_tag, expected_tag, EasyAead::TAG_LEN);
+	forged_tag[EasyAead::TAG_LEN - 1] ^= 0x01;
+	memset(plain, 0, len);
+	bool forged_rejected = !key.open(nonce, aad, sizeof(aad), ciphertext, plain, len, forged_tag);
+	for (size_t i = 0; i < len; i++)
+		forged_rejected &= plain[i] == 0;
+
+	Result("encryption", "rfc8439_2_8_2_vector")
+		.field("len", len)
+		.field("seal_ok", sealed)
+		.field("open_ok", opened)
+		.field("forged_rejected", forged_rejected)
+		.print();
+	return sealed && opened && forged_rejected;
+}
+
+// cost of sealing and opening one frame, against the airtime of that frame at 1 Mbps: the budget the TX task spends per frame
+static void benchEncryption(size_t frame_len, uint32_t frames)
+{
+	const uint8_t key_bytes[EasyAead::KEY_LEN] = {1, 2, 3, 4};
+	EasyAead key;
+	key.setKey(key_bytes);
+
+	uint8_t frame[MAX_DATA_LENGTH] = {};
+	uint8_t plain[MAX_DATA_LENGTH];
+	uint8_t nonce[EasyAead::NONCE_LEN] = {};
+	uint8_t tag[EasyAead::TAG_LEN];
+	const size_t aad_len = EASY_FRAME_HEADER_LEN + EASY_SEALED_HEADER_LEN;
+
+	double seal_ns = nsPerOperation(frames, [&](uint32_t i)
+									{
+										memcpy(nonce + 8, &i, sizeof(i));
+										key.seal(nonce, frame, aad_len, frame + aad_len, frame_len, tag); });
+	// a valid tag, so opening pays for the decryption too
+	key.seal(nonce, frame, aad_len, frame + aad_len, frame_len, tag);
+	uint32_t opened = 0;
+	double open_ns = nsPerOperation(frames, [&](uint32_t i)
+									{ opened += key.open(nonce, frame, aad_len, frame + aad_len, plain, frame_len, tag); });
+	double set_key_ns = nsPerOperation(frames, [&](uint32_t i)
+									   { key.setKey(key_bytes); });
+
+	// 1 Mbps, long preamble: 192 µs, then 8 µs per byte
+	double air_us = 192 + (frame_len + ESPNOW_AIR_OVERHEAD_LEN) * 8.0;
+	double sealed_air_us = air_us + EASY_SEALED_OVERHEAD * 8.0;
+
+	Result("encryption", "chacha20_poly1305_" + std::to_string(frame_len))
+		.field("frame_len", frame_len)
+		.field("frames", frames)
+		.field("opened", opened)
+		.field("seal_ns", seal_ns)
+		.field("open_ns", open_ns)
+		.field("set_key_ns", set_key_ns)
+		.field("seal_mbytes_per_s", frame_len * 1e3 / seal_ns)
+		.field("open_mbytes_per_s", frame_len * 1e3 / open_ns)
+		.field("overhead_bytes", EASY_SEALED_OVERHEAD)
+		.field("airtime_growth_pct", (sealed_air_us - air_us) * 100 / air_us)
+		.field("seal_pct_of_airtime", seal_ns / 10 / sealed_air_us)
+		.print();
+}
+
+/* ==========> Compression <========== */
+
+// the keys of a sensor reading, what a dictionary trained on such traffic holds
+static const char JSON_DICTIONARY[] = "\"status\":\"calibrating\"\"status\":\"low_battery\"{\"node\":\"sensor-\",\"temperature\":"
+									  ",\"humidity\":,\"pressure\":10,\"battery\":,\"ts\":1,\"status\":\"ok\"}";
+
+typedef struct __attribute__((packed))
+{
+	uint16_t node;
+	int16_t temperature_centi;
+	uint16_t humidity_permille;
+	uint32_t uptime_s;
+	uint8_t flags;
+} bench_reading_t;
+
+// JSON-ish text or an array of readings changing a little from one frame to the next
+static std::vector<std::vector<uint8_t>> compressionFrames(bool json, uint32_t frames)
+{
+	std::vector<std::vector<uint8_t>> result;
+	uint32_t seed = 7;
+	auto next = [&seed](uint32_t range)
+	{ seed = seed * 1103515245 + 12345; return (seed >> 16) % range; };
+	const char *statuses[] = {"ok", "ok", "ok", "low_battery", "calibrating"};
+	for (uint32_t i = 0; i < frames; i++)
+	{
+		std::vector<uint8_t> frame;
+		if (json)
+		{
+			char text[MAX_DATA_LENGTH];
+			int len = snprintf(text, sizeof(text), "{\"node\":\"sensor-%u\",\"temperature\":%u.%u,\"humidity\":%u,\"pressure\":%u,\"battery\":%u,\"ts\":%u,\"status\":\"%s\"}",
+							   next(40), 10 + next(25), next(10), 20 + next(70), 980 + next(50), next(101), 1700000000 + i * 60, statuses[next(5)]);
+			frame.assign(text, text + len);
+		}
+		else
+		{
+			bench_reading_t readings[MAX_DATA_LENGTH / sizeof(bench_reading_t)];
+			for (uint16_t r = 0; r < sizeof(readings) / sizeof(readings[0]); r++)
+				readings[r] = {r, (int16_t)(2150 + next(20)), (uint16_t)(400 + next(8)), 86400 + i, 0};
+			frame.assign((uint8_t *)readings, (uint8_t *)readings + sizeof(readings));
+		}
+		result.push_back(frame);
+	}
+	return result;
+}
+
+// the codec alone: ratio with the TX task policy, time per frame, airtime saved at 1 Mbps
+static void benchCompression(bool json, bool with_dictionary, uint32_t frames)
+{
+	std::vector<std::vector<uint8_t>> samples = compressionFrames(json, frames);
+	static EasyLz lz;
+	static EasyLz::Dictionary dictionary;
+	if (json)
+		dictionary.set((const uint8_t *)JSON_DICTIONARY, sizeof(JSON_DICTIONARY) - 1);
+	else
+		dictionary.set(samples[0].data(), samples[0].size()); // a reading frame captured beforehand
+	const EasyLz::Dictionary *used = with_dictionary ? &dictionary : nullptr;
+
+	uint8_t stream[MAX_DATA_LENGTH];
+	uint8_t inflated[MAX_DATA_LENGTH];
+	std::vector<size_t> lengths(frames);
+	uint64_t bytes_in = 0, bytes_out = 0;
+	double air_in_us = 0, air_out_us = 0;
+	uint32_t compressed = 0, mismatches = 0;
+
+	double encode_ns = nsPerOperation(frames, [&](uint32_t i)
+									  { lengths[i] = lz.compress(used, samples[i].data(), samples[i].size(), stream, samples[i].size() - EASY_COMPRESSED_OVERHEAD - 1); });
+	for (uint32_t i = 0; i < frames; i++)
+	{
+		size_t len = samples[i].size();
+		size_t sent = lengths[i] ? lengths[i] + EASY_COMPRESSED_OVERHEAD : len;
+		compressed += lengths[i] != 0;
+		bytes_in += len;
+		bytes_out += sent;
+		air_in_us += 192 + (len + ESPNOW_AIR_OVERHEAD_LEN) * 8.0;
+		air_out_us += 192 + (sent + ESPNOW_AIR_OVERHEAD_LEN) * 8.0;
+	}
+
+	// streams kept aside so the decoder is timed alone
+	std::vector<std::vector<uint8_t>> streams(frames);
+	for (uint32_t i = 0; i < frames; i++)
+	{
+		size_t len = lz.compress(used, samples[i].data(), samples[i].size(), stream, sizeof(stream));
+		streams[i].assign(stream, stream + len);
+	}
+	double decode_ns = nsPerOperation(frames, [&](uint32_t i)
+									  { int len = EasyLz::decompress(used, streams[i].data(), streams[i].size(), inflated, sizeof(inflated));
+										mismatches += len != (int)samples[i].size() || memcmp(inflated, samples[i].data(), len) != 0; });
+
+	Result("compression", std::string(json ? "json" : "struct") + (with_dictionary ? "_dictionary" : "_no_dictionary"))
+		.field("frames", frames)
+		.field("mean_frame_len", (double)bytes_in / frames)
+		.field("compressed", compressed)
+		.field("ratio", (double)bytes_in / bytes_out)
+		.field("encode_ns", encode_ns)
+		.field("decode_ns", decode_ns)
+		.field("airtime_saved_pct", (air_in_us - air_out_us) * 100 / air_in_us)
+		.field("mismatches", mismatches)
+		.print();
+}
+
+// through the TX task and rx_cb: frames to PEER loop back compressed and must arrive as they were sent
+static void benchCompressionLoopback(uint32_t messages)
+{
+	static std::vector<std::vector<uint8_t>> samples;
+	static std::atomic<uint32_t> received;
+	static std::atomic<uint32_t> mismatches;
+	samples = compressionFrames(true, messages);
+	received = 0;
+	mismatches = 0;
+
+	easyEspNow.setCompressionDictionary(1, (const uint8_t *)JSON_DICTIONARY, sizeof(JSON_DICTIONARY) - 1);
+	if (!start(radio(), 32, false, 4))
+		return;
+	easyEspNow.onDataReceived([](const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *frame)
+							  {
+								  // the loopback radio keeps the order
+								  const std::vector<uint8_t> &expected = samples[received++ % samples.size()];
+								  if (len != (int)expected.size() || memcmp(data, expected.data(), len) != 0)
+									  mismatches++; });
+	easyEspNow.enableCompression();
+	easyEspNow.setPeerCompression(PEER, 1);
+
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages; i++)
+		sendWhenReady(PEER, samples[i].data(), samples[i].size());
+	waitFor(received, messages);
+	double elapsed = seconds(start_us);
+
+	compression_stats_t stats = easyEspNow.getCompressionStats();
+	finish();
+
+	Result("compression", "json_loopback")
+		.field("messages", messages)
+		.field("received", received)
+		.field("mismatches", mismatches)
+		.field("msgs_per_s", received / elapsed)
+		.field("compressed", stats.compressed)
+		.field("inflated", stats.inflated)
+		.field("ratio", stats.bytes_out ? (double)stats.bytes_in / stats.bytes_out : 0)
+		.field("encode_us_per_frame", stats.compressed + stats.not_compressed ? (double)stats.encode_us / (stats.compressed + stats.not_compressed) : 0)
+		.field("decode_us_per_frame", stats.inflated ? (double)stats.decode_us / stats.inflated : 0)
+		.field("errors", stats.errors)
+		.print();
+}
+
+/* ==========> Typed messages <========== */
+
+struct BenchTemperature
+{
+	uint32_t sequence;
+	float celsius;
+};
+struct BenchPosition
+{
+	uint32_t sequence;
+	int32_t x, y, z;
+};
+struct BenchCommand
+{
+	uint32_t sequence;
+	uint8_t opcode;
+	uint8_t argument[31];
+};
+EASY_MESSAGE(BenchTemperature);
+EASY_MESSAGE(BenchPosition);
+EASY_MESSAGE(BenchCommand);
+
+static std::atomic<uint32_t> typed_received;
+static std::atomic<uint32_t> typed_mismatches;
+
+template <typename T>
+static void typedHandler(const uint8_t *src, const T &message, espnow_frame_recv_info_t *frame)
+{
+	// the loopback radio keeps the order
+	if (message.sequence != typed_received++)
+		typed_mismatches++;
+}
+
+// the three kinds of message round robin, as structs through send<T>(...) and onMessage<T>(...), or as bytes with a kind
+// byte in front and a switch in onDataReceived(...), the way it is done by hand
+static void benchTypedMessages(bool typed, bool rx_task, uint32_t messages)
+{
+	typed_received = 0;
+	typed_mismatches = 0;
+	if (!start(radio(), 32, false, 4))
+		return;
+	// a ring that holds the whole TX queue, the benchmark measures delivery, not overflows
+	if (rx_task)
+		easyEspNow.beginRXTask(64);
+	if (typed)
+	{
+		easyEspNow.onMessage<BenchTemperature>(typedHandler<BenchTemperature>);
+		easyEspNow.onMessage<BenchPosition>(typedHandler<BenchPosition>);
+		easyEspNow.onMessage<BenchCommand>(typedHandler<BenchCommand>);
+	}
+	else
+		easyEspNow.onDataReceived([](const uint8_t *src, const uint8_t *data, int len, espnow_frame_recv_info_t *frame)
+								  {
+									  uint32_t sequence;
+									  switch (data[0])
+									  {
+									  case 1:
+									  {
+										  BenchTemperature message;
+										  memcpy(&message, data + 1, sizeof(message));
+										  sequence = message.sequence;
+										  break;
+									  }
+									  case 2:
+									  {
+										  BenchPosition message;
+										  memcpy(&message, data + 1, sizeof(message));
+										  sequence = message.sequence;
+										  break;
+									  }
+									  default:
+									  {
+										  BenchCommand message;
+										  memcpy(&message, data + 1, sizeof(message));
+										  sequence = message.sequence;
+										  break;
+									  }
+									  }
+									  if (sequence != typed_received++)
+										  typed_mismatches++; });
+
+	int64_t start_us = esp_timer_get_time();
+	for (uint32_t i = 0; i < messages; i++)
+	{
+		BenchTemperature temperature = {i, 21.5f};
+		BenchPosition position = {i, 1, 2, 3};
+		BenchCommand command = {i, 7, {}};
+		uint8_t raw[1 + sizeof(BenchCommand)];
+		easy_send_error_t result;
+		do
+		{
+			if (typed)
+				result = i % 3 == 0 ? easyEspNow.send(PEER, temperature) : i % 3 == 1 ? easyEspNow.send(PEER, position)
+																					   : easyEspNow.send(PEER, command);
+			else
+			{
+				size_t len = i % 3 == 0 ? sizeof(temperature) : i % 3 == 1 ? sizeof(position)
+																		   : sizeof(command);
+				raw[0] = i % 3 + 1;
+				memcpy(raw + 1, i % 3 == 0 ? (const void *)&temperature : i % 3 == 1 ? (const void *)&position
+																					  : (const void *)&command,
+					   len);
+				result = easyEspNow.send(PEER, raw, 1 + len);
+			}
+			if (result == EASY_SEND_QUEUE_FULL_ERROR)
+				taskYIELD();
+		} while (result == EASY_SEND_QUEUE_FULL_ERROR);
+	}
+	waitFor(typed_received, messages);
+	double elapsed = seconds(start_us);
+	if (typed)
+	{
+		easyEspNow.onMessage<BenchTemperature>(nullptr);
+		easyEspNow.onMessage<BenchPosition>(nullptr);
+		easyEspNow.onMessage<BenchCommand>(nullptr);
+	}
+	if (rx_task)
+		easyEspNow.stopRXTask();
+	finish();
+
+	Result("typed_messages", std::string(typed ? "typed" : "raw_switch") + (rx_task ? "_rx_task" : "_callback"))
+		.field("messages", messages)
+		.field("received", typed_received)
+		.field("mismatches", typed_mismatches)
+		.field("msgs_per_s", typed_received / elapsed)
+		.print();
+}
+
+/* ==========> Group fan-out <========== */
+
+static void benchGroupFanout(group_send_mode_t mode, uint8_t members, uint32_t messages)
+{
+	static std::vector<uint32_t> samples;
+	static std::atomic<uint32_t> results;
+	static std::atomic<uint32_t> incomplete;
+	static std::atomic<uint32_t> repairs;
+	samples.clear();
+	results = 0;
+	incomplete = 0;
+	repairs = 0;
+
+	// every member echoes the broadcast, so it acknowledges it like a real member would
+	host_radio_config_t config = radio(500);
+	config.broadcast_fanout = true;
+	if (!start(config, 32, false, 4))
+		return;
+	easyEspNow.deletePeer(PEER);
+	easyEspNow.addPeer(ESPNOW_BROADCAST_ADDRESS);
+	easyEspNow.enableGroups();
+	int8_t group = easyEspNow.createGroup("bench");
+	easyEspNow.joinGroup("bench");
+	uint8_t mac[MAC_ADDR_LEN];
+	for (uint8_t i = 0; i < members; i++)
+	{
+		peerMac(i, mac);
+		easyEspNow.addPeer(mac);
+		easyEspNow.addToGroup(group, mac);
+	}
+	easyEspNow.onGroupSendResult([](const group_send_result_t *result)
+								 {
+									 samples.push_back(result->elapsed_us);
+									 uint32_t all = result->member_count >= 32 ? 0xFFFFFFFF : (1UL << result->member_count) - 1;
+									 if (result->delivered != all)
+										 incomplete++;
+									 repairs += result->repairs;
+									 results++; });
+
+	uint8_t payload[32] = {};
+	for (uint32_t i = 0; i < messages; i++)
+	{
+		while (easyEspNow.sendToGroup(group, payload, sizeof(payload), mode) == EASY_SEND_QUEUE_FULL_ERROR)
+			taskYIELD();
+		waitFor(results, i + 1, 1000);
+	}
+	finish();
+
+	Result("group_fanout", std::string(mode == GROUP_SEND_UNICAST ? "unicast_" : "broadcast_") + std::to_string(members))
+		.field("members", members)
+		.field("messages", messages)
+		.field("delay_us", config.delay_us)
+		.field("results", results)
+		.field("incomplete", incomplete)
+		.field("repairs", repairs)
+		.latencies("fanout", samples)
+		.print();
+}
+
+int main(int argc, char **argv)
+{
+	std::string filter = argc > 1 ? argv[1] : "";
+	int status = 0;
+	auto wanted = [&](const char *bench)
+	{ return filter.empty() || std::string(bench).find(filter) != std::string::npos; };
+
+	if (wanted("send_throughput"))
+	{
+		benchSendThroughput("async_inflight1", radio(), false, 1, 20000, 200);
+		benchSendThroughput("async_inflight4", radio(), false, 4, 20000, 200);
+		benchSendThroughput("async_inflight4_airtime500us", radio(500), false, 4, 2000, 200);
+		benchSendThroughput("async_inflight1_airtime500us", radio(500), false, 1, 2000, 200);
+		benchSendThroughput("fixed_13ms_airtime500us", radio(500), false, 1, 200, 200, false, 13);
+		benchSendThroughput("sync", radio(), true, 1, 5000, 200);
+	}
+	if (wanted("encryption"))
+	{
+		// a cipher that does not match the RFC is not worth timing, the run fails
+		if (!benchEncryptionVector())
+			status = 1;
+		const size_t lengths[] = {32, 128, MAX_SEALED_DATA_LENGTH};
+		for (size_t len : lengths)
+			benchEncryption(len, 20000);
+
+		// looped back frames would come from the destination with a nonce of the sender, so only the TX side is measured
+		host_radio_config_t no_loopback = radio();
+		no_loopback.loopback = false;
+		benchSendThroughput("encryption_plain_inflight4", no_loopback, false, 4, 20000, 200);
+		benchSendThroughput("encryption_sealed_inflight4", no_loopback, false, 4, 20000, 200, true);
+	}
+	if (wanted("compression"))
+	{
+		for (bool json : {true, false})
+		{
+			benchCompression(json, false, 5000);
+			benchCompression(json, true, 5000);
+		}
+		benchCompressionLoopback(5000);
+	}
+	if (wanted("typed_messages"))
+	{
+		for (bool rx_task : {false, true})
+		{
+			benchTypedMessages(false, rx_task, 20000);
+			benchTypedMessages(true, rx_task, 20000);
+		}
+	}
+	if (wanted("latency"))
+	{
+		benchLatency("unloaded_callback", radio(), false, 2000, 1);
+		benchLatency("unloaded_rx_task", radio(), true, 2000, 1);
+		benchLatency("burst16_callback", radio(), false, 2000, 16);
+		benchLatency("unloaded_delay1000_jitter500", radio(1000, 500), false, 500, 1);
+	}
+	if (wanted("callback_dispatch"))
+		benchCallbackDispatch(20000000);
+	if (wanted("peer_table"))
+	{
+		benchPeerTable(500);
+		benchPeerDirectory(256, 5000);
+	}
+	if (wanted("fragmentation"))
+	{
+		benchFragmentation("1k_clean", radio(), 1024, 500);
+		benchFragmentation("1k_loss1pct", radio(0, 0, 10), 1024, 500);
+		benchFragmentation("4k_clean", radio(), 4096, 500);
+		benchFragmentation("4k_loss1pct", radio(0, 0, 10), 4096, 500);
+	}
+	if (wanted("send_handles"))
+	{
+		benchSendHandles("clean", radio(), 200, 5000);
+		benchSendHandles("loss2pct", radio(0, 0, 20), 200, 5000);
+		benchSendHandles("4k_loss1pct", radio(0, 0, 10), 4096, 200);
+		benchSendHandles("2frag_loss30pct_8_destinations", radio(500, 0, 300), 400, 500, 8);
+	}
+	if (wanted("reliable"))
+	{
+		benchReliable("async_loss2pct", false, 500);
+		// a reliable channel that stalls behind blocked senders fails the run
+		if (!benchReliable("sync_loss2pct", true, 500))
+			status = 1;
+	}
+	if (wanted("fair_scheduler"))
+	{
+		benchFairScheduler("fifo", false, 0, 500);
+		benchFairScheduler("fair", true, 0, 500);
+		benchFairScheduler("fair_chatty_capped_20kBps", true, 20000, 500);
+	}
+	if (wanted("backpressure"))
+	{
+		benchBackpressure("poll_10ms", BACKPRESSURE_POLL_10MS, 2000);
+		benchBackpressure("yield", BACKPRESSURE_YIELD, 2000);
+		benchBackpressure("wait_for_space", BACKPRESSURE_WAIT_SPACE, 2000);
+		benchBackpressure("watermarks", BACKPRESSURE_WATERMARKS, 2000);
+	}
+	if (wanted("ping"))
+	{
+		benchPing("clean_delay1000", radio(1000), false, 200);
+		benchPing("delay1000_jitter500", radio(1000, 500), false, 200);
+		benchPing("delay1000_loss5pct", radio(1000, 0, 50), false, 200);
+		benchPing("delay500_bulk_load", radio(500), true, 200);
+	}
+	if (wanted("group_fanout"))
+	{
+		const uint8_t sizes[] = {1, 2, 4, 8, 16};
+		for (uint8_t members : sizes)
+		{
+			benchGroupFanout(GROUP_SEND_UNICAST, members, 100);
+			benchGroupFanout(GROUP_SEND_BROADCAST, members, 100);
+		}
+	}
+	return status;
+}
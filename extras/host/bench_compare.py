@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Compares two runs of the host benchmarks and fails when one got slower.
+
+    make -C extras/host run > baseline.jsonl
+    ... change the library ...
+    make -C extras/host run > current.jsonl
+    extras/host/bench_compare.py baseline.jsonl current.jsonl --threshold 10
+
+Results are matched by `bench` and `case`. Metrics ending in `_per_s` are better higher, metrics ending in `_us` or
+`_ns` are better lower, every other field is a count and ignored. Exits with 1 when a metric is worse than the
+threshold, in percent. Maximums are shown but never fail the comparison: one preempted sample decides them.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            result = json.loads(line)
+            if "bench" in result:
+                results[(result["bench"], result.get("case", ""))] = result
+    return results
+
+
+def direction(metric):
+    if metric.endswith("_per_s"):
+        return 1
+    if metric.endswith("_us") or metric.endswith("_ns"):
+        return -1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two runs of the host benchmarks")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=15.0, help="allowed regression in percent (default 15)")
+    parser.add_argument("--all", action="store_true", help="show every metric, not only the ones that changed past the threshold")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+
+    for key in sorted(baseline):
+        if key not in current:
+            print("%s/%s: missing in current run" % key)
+            continue
+        for metric, old in baseline[key].items():
+            new = current[key].get(metric)
+            sign = direction(metric)
+            if sign == 0 or not isinstance(old, (int, float)) or not isinstance(new, (int, float)):
+                continue
+            if old == 0:
+                change = 0.0 if new == 0 else float("inf")
+            else:
+                change = (new - old) * 100.0 / old
+            worse = -change * sign > args.threshold
+            better = change * sign > args.threshold
+            gating = "_max" not in metric
+            if worse and gating:
+                regressions += 1
+            if worse or better or args.all:
+                print("%-14s %-30s %-26s %12.6g -> %12.6g  %+7.1f%%%s" % (key[0], key[1], metric, old, new, change,
+                                                                           "  REGRESSION" if worse and gating else ""))
+
+    for key in sorted(set(current) - set(baseline)):
+        print("%s/%s: new in current run" % key)
+
+    print("%d regression(s) beyond %.1f%%" % (regressions, args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,55 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+ * Host stand-in for the parts of the Arduino ESP32 core the library and its examples use
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <functional>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define CONFIG_ARDUINO_RUNNING_CORE 1
+#define ARDUINO_RUNNING_CORE CONFIG_ARDUINO_RUNNING_CORE
+
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+
+/**
+ * Serial port writing to the standard output
+ */
+class HardwareSerial
+{
+public:
+	void begin(unsigned long baud) {}
+	int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+	size_t print(const char *text);
+	size_t print(int value);
+	size_t println(const char *text = "");
+	size_t println(int value);
+	size_t write(uint8_t byte);
+	size_t write(const uint8_t *data, size_t len);
+	void flush();
+	operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+#endif
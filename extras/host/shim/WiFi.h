@@ -0,0 +1,29 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "esp_wifi.h"
+
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+/**
+ * Host stand-in for the Arduino `WiFi` object, only what the examples and benchmarks use
+ */
+class WiFiClass
+{
+public:
+	bool mode(wifi_mode_t mode) { return esp_wifi_set_mode(mode) == ESP_OK; }
+	wifi_mode_t getMode()
+	{
+		wifi_mode_t mode = WIFI_MODE_NULL;
+		esp_wifi_get_mode(&mode);
+		return mode;
+	}
+	bool disconnect() { return true; }
+};
+
+extern WiFiClass WiFi;
+
+#endif
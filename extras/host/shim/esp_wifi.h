@@ -0,0 +1,78 @@
+#ifndef HOST_ESP_WIFI_H
+#define HOST_ESP_WIFI_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Host stand-in for the parts of the ESP-IDF WiFi driver the library uses. The "radio" only keeps a mode, a channel and
+ * the MAC of each interface, see `host_radio.h` to configure them
+ */
+
+typedef enum
+{
+	WIFI_MODE_NULL = 0,
+	WIFI_MODE_STA,
+	WIFI_MODE_AP,
+	WIFI_MODE_APSTA,
+	WIFI_MODE_MAX
+} wifi_mode_t;
+
+typedef enum
+{
+	WIFI_IF_STA = 0,
+	WIFI_IF_AP = 1,
+} wifi_interface_t;
+
+typedef enum
+{
+	WIFI_SECOND_CHAN_NONE = 0,
+	WIFI_SECOND_CHAN_ABOVE,
+	WIFI_SECOND_CHAN_BELOW,
+} wifi_second_chan_t;
+
+// same layout as ESP-IDF (ESP32), the library reads it in front of the received ESP-NOW frame
+typedef struct
+{
+	signed rssi : 8;
+	unsigned rate : 5;
+	unsigned : 1;
+	unsigned sig_mode : 2;
+	unsigned : 16;
+	unsigned mcs : 7;
+	unsigned cwb : 1;
+	unsigned : 16;
+	unsigned smoothing : 1;
+	unsigned not_sounding : 1;
+	unsigned : 1;
+	unsigned aggregation : 1;
+	unsigned stbc : 2;
+	unsigned fec_coding : 1;
+	unsigned sgi : 1;
+	signed noise_floor : 8;
+	unsigned ampdu_cnt : 8;
+	unsigned channel : 4;
+	unsigned secondary_channel : 4;
+	unsigned : 8;
+	unsigned timestamp : 32;
+	unsigned : 32;
+	unsigned : 31;
+	unsigned ant : 1;
+	unsigned sig_len : 12;
+	unsigned : 12;
+	unsigned rx_state : 8;
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct
+{
+	wifi_pkt_rx_ctrl_t rx_ctrl;
+	uint8_t payload[0];
+} wifi_promiscuous_pkt_t;
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second);
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+/**
+ * @brief Starts the task in its own thread
+ * @note `vTaskSuspend(...)` and `vTaskDelete(...)` of another task take effect the next time that task blocks
+ * in one of these primitives (queue, semaphore, notification, delay), threads can not be stopped at any point
+ */
+BaseType_t xTaskCreateUniversal(TaskFunction_t task, const char *name, uint32_t stack_depth, void *parameters,
+								UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth, void *parameters,
+								   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id);
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *parameters,
+					   UBaseType_t priority, TaskHandle_t *created_task);
+
+/**
+ * @brief Deletes a task. Deleting another task waits until its thread has left the task function
+ */
+void vTaskDelete(TaskHandle_t task);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+void taskYIELD(void);
+
+#endif
@@ -0,0 +1,138 @@
+#include "Arduino.h"
+
+#include <mutex>
+#include <random>
+
+HardwareSerial Serial;
+
+static std::mutex random_mutex;
+static std::mt19937 random_engine(0);
+
+int HardwareSerial::printf(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int written = vprintf(format, args);
+	va_end(args);
+	return written;
+}
+
+size_t HardwareSerial::print(const char *text)
+{
+	return fputs(text, stdout) < 0 ? 0 : strlen(text);
+}
+
+size_t HardwareSerial::print(int value)
+{
+	int written = ::printf("%d", value);
+	return written < 0 ? 0 : written;
+}
+
+size_t HardwareSerial::println(const char *text)
+{
+	size_t written = print(text);
+	return written + (fputc('\n', stdout) == EOF ? 0 : 1);
+}
+
+size_t HardwareSerial::println(int value)
+{
+	size_t written = print(value);
+	return written + (fputc('\n', stdout) == EOF ? 0 : 1);
+}
+
+size_t HardwareSerial::write(uint8_t byte)
+{
+	return fputc(byte, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t len)
+{
+	return fwrite(data, 1, len, stdout);
+}
+
+void HardwareSerial::flush()
+{
+	fflush(stdout);
+}
+
+unsigned long millis()
+{
+	return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)esp_timer_get_time();
+}
+
+void delay(uint32_t ms)
+{
+	vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+	int64_t until = esp_timer_get_time() + us;
+	while (esp_timer_get_time() < until)
+		;
+}
+
+long random(long max)
+{
+	return max <= 0 ? 0 : random(0, max);
+}
+
+long random(long min, long max)
+{
+	if (min >= max)
+		return min;
+	std::lock_guard<std::mutex> lock(random_mutex);
+	return std::uniform_int_distribution<long>(min, max - 1)(random_engine);
+}
+
+void randomSeed(unsigned long seed)
+{
+	std::lock_guard<std::mutex> lock(random_mutex);
+	random_engine.seed(seed);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+	switch (code)
+	{
+	case ESP_OK:
+		return "ESP_OK";
+	case ESP_FAIL:
+		return "ESP_FAIL";
+	case ESP_ERR_NO_MEM:
+		return "ESP_ERR_NO_MEM";
+	case ESP_ERR_INVALID_ARG:
+		return "ESP_ERR_INVALID_ARG";
+	case ESP_ERR_INVALID_STATE:
+		return "ESP_ERR_INVALID_STATE";
+	case ESP_ERR_NOT_FOUND:
+		return "ESP_ERR_NOT_FOUND";
+	case ESP_ERR_WIFI_NOT_INIT:
+		return "ESP_ERR_WIFI_NOT_INIT";
+	case ESP_ERR_ESPNOW_NOT_INIT:
+		return "ESP_ERR_ESPNOW_NOT_INIT";
+	case ESP_ERR_ESPNOW_ARG:
+		return "ESP_ERR_ESPNOW_ARG";
+	case ESP_ERR_ESPNOW_NO_MEM:
+		return "ESP_ERR_ESPNOW_NO_MEM";
+	case ESP_ERR_ESPNOW_FULL:
+		return "ESP_ERR_ESPNOW_FULL";
+	case ESP_ERR_ESPNOW_NOT_FOUND:
+		return "ESP_ERR_ESPNOW_NOT_FOUND";
+	case ESP_ERR_ESPNOW_INTERNAL:
+		return "ESP_ERR_ESPNOW_INTERNAL";
+	case ESP_ERR_ESPNOW_EXIST:
+		return "ESP_ERR_ESPNOW_EXIST";
+	case ESP_ERR_ESPNOW_IF:
+		return "ESP_ERR_ESPNOW_IF";
+	case ESP_ERR_ESPNOW_CHAN:
+		return "ESP_ERR_ESPNOW_CHAN";
+	default:
+		return "UNKNOWN ERROR";
+	}
+}
@@ -0,0 +1,15 @@
+#ifndef HOST_DEVICE_H
+#define HOST_DEVICE_H
+
+/*
+ * What firmware keeps in a global exists once per ESP32. A host process simulating several devices keeps it once per
+ * device instead: the current device is the one of the running task, tasks belong to the device of the task that
+ * created them. The realtime shim runs a single device.
+ */
+
+/**
+ * @brief Context slot of the current device, the library keeps there the instance its ESP-NOW callbacks belong to
+ */
+void *&hostDeviceContext();
+
+#endif
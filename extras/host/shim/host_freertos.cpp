@@ -0,0 +1,432 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * FreeRTOS on POSIX threads. Every blocking primitive waits on one condition variable of the "kernel" and every change
+ * wakes all waiters up, which is plenty for the handful of tasks the library runs.
+ */
+
+struct host_task
+{
+	std::thread thread;
+	TaskFunction_t function;
+	void *parameters;
+	std::string name;
+	uint32_t notification = 0;
+	bool suspended = false;
+	bool deleted = false;
+	bool exited = false;
+};
+
+struct host_event_group
+{
+	EventBits_t bits = 0;
+};
+
+struct host_queue
+{
+	uint32_t length;
+	uint32_t item_size;
+	std::vector<uint8_t> storage;
+	uint32_t head = 0;
+	uint32_t count = 0;
+};
+
+namespace
+{
+	// thrown in a deleted task to unwind out of its task function
+	struct task_deleted
+	{
+	};
+
+	// never destroyed: tasks may still wait on them while the process exits
+	std::mutex &kernel = *new std::mutex();
+	std::condition_variable &changed = *new std::condition_variable();
+	thread_local host_task *current_task = nullptr;
+	// owns the task of a thread not created by xTaskCreate, freed when that thread exits
+	thread_local std::unique_ptr<host_task> foreign_task;
+	thread_local uint8_t thread_id_anchor;
+
+	const std::chrono::steady_clock::time_point process_start = std::chrono::steady_clock::now();
+
+	host_task *self()
+	{
+		if (!current_task)
+		{
+			// threads not created by xTaskCreate (main, radio) get a task the first time they need one
+			foreign_task.reset(new host_task());
+			foreign_task->name = "host";
+			current_task = foreign_task.get();
+		}
+		return current_task;
+	}
+
+	// suspension and deletion of a task take effect here, whenever it blocks
+	void checkpoint(std::unique_lock<std::mutex> &lock)
+	{
+		host_task *task = self();
+		while (task->suspended && !task->deleted)
+			changed.wait(lock);
+		if (task->deleted && task->function)
+			throw task_deleted();
+	}
+
+	template <typename Predicate>
+	bool waitFor(std::unique_lock<std::mutex> &lock, TickType_t ticks, Predicate ready)
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks * portTICK_PERIOD_MS);
+		while (true)
+		{
+			checkpoint(lock);
+			if (ready())
+				return true;
+			if (ticks == 0)
+				return false;
+			if (ticks == portMAX_DELAY)
+				changed.wait(lock);
+			else if (changed.wait_until(lock, deadline) == std::cv_status::timeout)
+			{
+				checkpoint(lock);
+				return ready();
+			}
+		}
+	}
+
+	void runTask(host_task *task)
+	{
+		current_task = task;
+		{
+			// wait until the creator has published the handle
+			std::unique_lock<std::mutex> lock(kernel);
+		}
+		try
+		{
+			task->function(task->parameters);
+		}
+		catch (const task_deleted &)
+		{
+		}
+
+		std::lock_guard<std::mutex> lock(kernel);
+		task->exited = true;
+		changed.notify_all();
+	}
+
+	host_queue *createQueue(UBaseType_t length, UBaseType_t item_size, UBaseType_t initial_count)
+	{
+		if (length == 0)
+			return nullptr;
+		host_queue *queue = new host_queue();
+		queue->length = length;
+		queue->item_size = item_size;
+		queue->storage.resize((size_t)length * item_size);
+		queue->count = initial_count;
+		return queue;
+	}
+}
+
+int64_t esp_timer_get_time(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - process_start).count();
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+	uintptr_t me = (uintptr_t)&thread_id_anchor;
+	if (mux->owner.load(std::memory_order_relaxed) == me)
+	{
+		mux->count++;
+		return;
+	}
+	uintptr_t expected = 0;
+	while (!mux->owner.compare_exchange_weak(expected, me, std::memory_order_acquire, std::memory_order_relaxed))
+	{
+		expected = 0;
+		std::this_thread::yield();
+	}
+	mux->count = 1;
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+	if (--mux->count == 0)
+		mux->owner.store(0, std::memory_order_release);
+}
+
+BaseType_t xTaskCreateUniversal(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+								UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+	host_task *task = new host_task();
+	task->function = function;
+	task->parameters = parameters;
+	task->name = name ? name : "";
+
+	std::lock_guard<std::mutex> lock(kernel);
+	if (created_task)
+		*created_task = task;
+	task->thread = std::thread(runTask, task);
+	return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+								   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+	return xTaskCreateUniversal(function, name, stack_depth, parameters, priority, created_task, core_id);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+					   UBaseType_t priority, TaskHandle_t *created_task)
+{
+	return xTaskCreateUniversal(function, name, stack_depth, parameters, priority, created_task, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+	if (!task || task == current_task)
+	{
+		if (current_task && current_task->function)
+			throw task_deleted();
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(kernel);
+		task->deleted = true;
+		changed.notify_all();
+		changed.wait(lock, [task]
+					 { return task->exited; });
+	}
+	task->thread.join();
+	delete task;
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+	std::unique_lock<std::mutex> lock(kernel);
+	host_task *target = task ? task : self();
+	target->suspended = true;
+	if (target == self())
+		checkpoint(lock);
+}
+
+void vTaskResume(TaskHandle_t task)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	if (task)
+		task->suspended = false;
+	changed.notify_all();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	std::unique_lock<std::mutex> lock(kernel);
+	waitFor(lock, ticks ? ticks : 1, []
+			{ return false; });
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)(esp_timer_get_time() / (1000 * portTICK_PERIOD_MS));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return self();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	task->notification++;
+	changed.notify_all();
+	return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+	std::unique_lock<std::mutex> lock(kernel);
+	host_task *task = self();
+	if (!waitFor(lock, ticks_to_wait, [task]
+				 { return task->notification > 0; }))
+		return 0;
+
+	uint32_t value = task->notification;
+	task->notification = clear_on_exit ? 0 : value - 1;
+	return value;
+}
+
+void taskYIELD(void)
+{
+	std::this_thread::yield();
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+	return createQueue(length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait, bool front)
+{
+	std::unique_lock<std::mutex> lock(kernel);
+	if (!waitFor(lock, ticks_to_wait, [queue]
+				 { return queue->count < queue->length; }))
+		return pdFALSE;
+
+	uint32_t position;
+	if (front)
+	{
+		queue->head = (queue->head + queue->length - 1) % queue->length;
+		position = queue->head;
+	}
+	else
+		position = (queue->head + queue->count) % queue->length;
+	if (queue->item_size && item)
+		memcpy(queue->storage.data() + (size_t)position * queue->item_size, item, queue->item_size);
+	queue->count++;
+	changed.notify_all();
+	return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	return queueSend(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	return queueSend(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	return queueSend(queue, item, ticks_to_wait, true);
+}
+
+static BaseType_t queueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait, bool remove)
+{
+	std::unique_lock<std::mutex> lock(kernel);
+	if (!waitFor(lock, ticks_to_wait, [queue]
+				 { return queue->count > 0; }))
+		return pdFALSE;
+
+	if (queue->item_size && item)
+		memcpy(item, queue->storage.data() + (size_t)queue->head * queue->item_size, queue->item_size);
+	if (remove)
+	{
+		queue->head = (queue->head + 1) % queue->length;
+		queue->count--;
+		changed.notify_all();
+	}
+	return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+	return queueReceive(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+	return queueReceive(queue, item, ticks_to_wait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	return queue->length - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	queue->head = 0;
+	queue->count = 0;
+	changed.notify_all();
+	return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return createQueue(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	return createQueue(1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+	return createQueue(max_count, 0, initial_count);
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+	return new host_event_group();
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	group->bits |= bits;
+	changed.notify_all();
+	return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	EventBits_t before = group->bits;
+	group->bits &= ~bits;
+	return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+	std::lock_guard<std::mutex> lock(kernel);
+	return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit, BaseType_t wait_for_all,
+								TickType_t ticks_to_wait)
+{
+	std::unique_lock<std::mutex> lock(kernel);
+	bool set = waitFor(lock, ticks_to_wait, [group, bits, wait_for_all]
+					   { return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0; });
+	// the bits as they were when the wait ended, cleared afterwards only if it did not time out
+	EventBits_t value = group->bits;
+	if (set && clear_on_exit)
+		group->bits &= ~bits;
+	return value;
+}
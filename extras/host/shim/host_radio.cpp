@@ -0,0 +1,526 @@
+#include "host_radio.h"
+#include "host_device.h"
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "WiFi.h"
+
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+WiFiClass WiFi;
+
+namespace
+{
+	// ESP-NOW action frame as it sits in front of the payload, same layout as `espnow_frame_format_t`
+	typedef struct
+	{
+		uint8_t frame_control;
+		uint8_t flags;
+		uint16_t duration;
+		uint8_t destination_address[6];
+		uint8_t source_address[6];
+		uint8_t broadcast_address[6];
+		uint16_t sequence_control;
+		uint8_t category_code;
+		uint8_t organization_identifier[3];
+		uint8_t random_values[4];
+		uint8_t element_id;
+		uint8_t length;
+		uint8_t vendor_organization_identifier[3];
+		uint8_t type;
+		uint8_t version;
+	} __attribute__((packed)) host_espnow_frame_t;
+
+	static_assert(sizeof(host_espnow_frame_t) == 39, "Must match espnow_frame_format_t");
+
+	typedef struct
+	{
+		int64_t due_us;
+		uint8_t destination[ESP_NOW_ETH_ALEN];
+		esp_now_send_status_t status;
+		bool loop_back;
+		bool broadcast;
+		uint16_t sequence;
+		uint8_t channel;
+		int8_t rssi;
+		uint8_t len;
+		uint8_t data[ESP_NOW_MAX_DATA_LEN];
+	} pending_frame_t;
+
+	const uint8_t BROADCAST[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+	// never destroyed: the radio thread may still wait on them while the process exits
+	std::mutex &radio_mutex = *new std::mutex();
+	std::condition_variable &radio_changed = *new std::condition_variable();
+	host_radio_config_t radio_config = hostRadioDefaultConfig();
+	host_radio_stats_t radio_stats = {};
+	uint32_t random_state = 1;
+
+	wifi_mode_t wifi_mode = WIFI_MODE_NULL;
+	uint8_t wifi_channel = 1;
+	wifi_second_chan_t wifi_second = WIFI_SECOND_CHAN_NONE;
+
+	bool now_initialized = false;
+	esp_now_recv_cb_t recv_cb = nullptr;
+	esp_now_send_cb_t send_cb = nullptr;
+	esp_now_peer_info_t peers[ESP_NOW_MAX_TOTAL_PEER_NUM];
+	int peer_count = 0;
+
+	std::deque<pending_frame_t> pending;
+	bool completing = false;
+	int64_t last_due_us = 0;
+	uint16_t next_sequence = 0;
+	bool radio_running = false; // the radio thread is detached, a process may exit without stopping ESP-NOW
+	bool radio_stop = false;
+
+	uint32_t nextRandom()
+	{
+		// xorshift32, enough to spread losses and jitter
+		random_state ^= random_state << 13;
+		random_state ^= random_state >> 17;
+		random_state ^= random_state << 5;
+		return random_state;
+	}
+
+	int findPeer(const uint8_t *mac)
+	{
+		for (int i = 0; i < peer_count; i++)
+			if (memcmp(peers[i].peer_addr, mac, ESP_NOW_ETH_ALEN) == 0)
+				return i;
+		return -1;
+	}
+
+	// builds what the driver has in front of a received payload, `rx_cb` reads it back
+	void loopBack(const pending_frame_t &frame, const uint8_t *source, const uint8_t *own_mac, esp_now_recv_cb_t on_received)
+	{
+		alignas(4) uint8_t buffer[sizeof(wifi_pkt_rx_ctrl_t) + sizeof(host_espnow_frame_t) + ESP_NOW_MAX_DATA_LEN] = {};
+		wifi_pkt_rx_ctrl_t *rx_ctrl = (wifi_pkt_rx_ctrl_t *)buffer;
+		host_espnow_frame_t *header = (host_espnow_frame_t *)(buffer + sizeof(wifi_pkt_rx_ctrl_t));
+		uint8_t *payload = buffer + sizeof(wifi_pkt_rx_ctrl_t) + sizeof(host_espnow_frame_t);
+
+		rx_ctrl->rssi = frame.rssi;
+		rx_ctrl->channel = frame.channel;
+		rx_ctrl->noise_floor = -95;
+		rx_ctrl->timestamp = (uint32_t)esp_timer_get_time();
+		rx_ctrl->sig_len = sizeof(host_espnow_frame_t) + frame.len + 4;
+		header->frame_control = 0xD0; // management, action
+		memcpy(header->destination_address, frame.broadcast ? BROADCAST : own_mac, ESP_NOW_ETH_ALEN);
+		memcpy(header->source_address, source, ESP_NOW_ETH_ALEN);
+		memcpy(header->broadcast_address, BROADCAST, ESP_NOW_ETH_ALEN);
+		header->sequence_control = frame.sequence << 4;
+		header->category_code = 127;
+		header->organization_identifier[0] = header->vendor_organization_identifier[0] = 0x18;
+		header->organization_identifier[1] = header->vendor_organization_identifier[1] = 0xFE;
+		header->organization_identifier[2] = header->vendor_organization_identifier[2] = 0x34;
+		header->element_id = 0xDD;
+		header->length = frame.len + 5;
+		header->type = 4;
+		header->version = 1;
+		memcpy(payload, frame.data, frame.len);
+
+		on_received(source, payload, frame.len);
+	}
+
+	void radioTask()
+	{
+		std::unique_lock<std::mutex> lock(radio_mutex);
+		while (true)
+		{
+			if (radio_stop && pending.empty())
+			{
+				radio_running = false;
+				radio_changed.notify_all();
+				return;
+			}
+			if (pending.empty())
+			{
+				radio_changed.wait(lock);
+				continue;
+			}
+			int64_t wait_us = pending.front().due_us - esp_timer_get_time();
+			if (wait_us > 0)
+			{
+				radio_changed.wait_for(lock, std::chrono::microseconds(wait_us));
+				continue;
+			}
+
+			pending_frame_t frame = pending.front();
+			completing = true;
+			esp_now_send_cb_t on_sent = send_cb;
+			esp_now_recv_cb_t on_received = recv_cb;
+			uint8_t own_mac[ESP_NOW_ETH_ALEN];
+			uint8_t broadcast_echo_mac[ESP_NOW_ETH_ALEN];
+			memcpy(own_mac, radio_config.own_mac, ESP_NOW_ETH_ALEN);
+			memcpy(broadcast_echo_mac, radio_config.broadcast_echo_mac, ESP_NOW_ETH_ALEN);
+			bool fanout = radio_config.broadcast_fanout;
+			uint8_t sources[ESP_NOW_MAX_TOTAL_PEER_NUM][ESP_NOW_ETH_ALEN];
+			uint8_t source_count = 0;
+			if (frame.loop_back && frame.broadcast && fanout)
+			{
+				for (int i = 0; i < peer_count; i++)
+					if (memcmp(peers[i].peer_addr, BROADCAST, ESP_NOW_ETH_ALEN) != 0)
+						memcpy(sources[source_count++], peers[i].peer_addr, ESP_NOW_ETH_ALEN);
+				radio_stats.looped += source_count;
+			}
+			else if (frame.loop_back)
+				radio_stats.looped++;
+			lock.unlock();
+
+			// callbacks run without the radio lock, they are allowed to send
+			if (on_sent)
+				on_sent(frame.destination, frame.status);
+			if (frame.loop_back && on_received)
+			{
+				if (!frame.broadcast || !fanout)
+					loopBack(frame, frame.broadcast ? broadcast_echo_mac : frame.destination, own_mac, on_received);
+				else
+					for (uint8_t i = 0; i < source_count; i++)
+						loopBack(frame, sources[i], own_mac, on_received);
+			}
+
+			lock.lock();
+			pending.pop_front();
+			completing = false;
+			radio_changed.notify_all();
+		}
+	}
+
+	// called with the radio lock held
+	void queueFrame(const uint8_t *destination, const uint8_t *data, size_t len, int64_t now_us)
+	{
+		pending_frame_t frame;
+		bool broadcast = memcmp(destination, BROADCAST, ESP_NOW_ETH_ALEN) == 0;
+		bool lost = radio_config.loss_per_mille && nextRandom() % 1000 < radio_config.loss_per_mille;
+		int64_t due_us = now_us + radio_config.delay_us + (radio_config.jitter_us ? nextRandom() % (radio_config.jitter_us + 1) : 0);
+
+		// the radio sends one frame after the other, completions never overtake each other
+		if (due_us < last_due_us)
+			due_us = last_due_us;
+		last_due_us = due_us;
+
+		frame.due_us = due_us;
+		memcpy(frame.destination, destination, ESP_NOW_ETH_ALEN);
+		frame.status = lost && !broadcast ? ESP_NOW_SEND_FAIL : ESP_NOW_SEND_SUCCESS;
+		frame.loop_back = radio_config.loopback && !lost;
+		frame.broadcast = broadcast;
+		frame.sequence = next_sequence++ & 0x0FFF;
+		frame.channel = wifi_channel;
+		frame.rssi = radio_config.rssi;
+		frame.len = (uint8_t)len;
+		memcpy(frame.data, data, len);
+		pending.push_back(frame);
+
+		radio_stats.sent++;
+		if (lost)
+			radio_stats.lost++;
+	}
+}
+
+void *&hostDeviceContext()
+{
+	// one device only
+	static void *context = nullptr;
+	return context;
+}
+
+host_radio_config_t hostRadioDefaultConfig()
+{
+	host_radio_config_t config = {};
+	config.delay_us = 0;
+	config.jitter_us = 0;
+	config.loss_per_mille = 0;
+	config.loopback = true;
+	config.max_pending = 16;
+	config.rssi = -40;
+	const uint8_t own_mac[ESP_NOW_ETH_ALEN] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+	const uint8_t broadcast_echo_mac[ESP_NOW_ETH_ALEN] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0xFE};
+	memcpy(config.own_mac, own_mac, ESP_NOW_ETH_ALEN);
+	memcpy(config.broadcast_echo_mac, broadcast_echo_mac, ESP_NOW_ETH_ALEN);
+	config.seed = 1;
+	return config;
+}
+
+void hostRadioConfigure(const host_radio_config_t &config)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	radio_config = config;
+	random_state = config.seed ? config.seed : 1;
+}
+
+host_radio_stats_t hostRadioStats(bool reset)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	host_radio_stats_t stats = radio_stats;
+	if (reset)
+		radio_stats = {};
+	return stats;
+}
+
+void hostRadioDrain()
+{
+	std::unique_lock<std::mutex> lock(radio_mutex);
+	radio_changed.wait(lock, []
+					   { return pending.empty() && !completing; });
+}
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	*mode = wifi_mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+	if (mode >= WIFI_MODE_MAX)
+		return ESP_ERR_INVALID_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	wifi_mode = mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	*primary = wifi_channel;
+	*second = wifi_second;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+	if (primary < 1 || primary > 14)
+		return ESP_ERR_INVALID_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	wifi_channel = primary;
+	wifi_second = second;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	memcpy(mac, radio_config.own_mac, ESP_NOW_ETH_ALEN);
+	// the soft-AP MAC follows the station one, as on the ESP32
+	if (ifx == WIFI_IF_AP)
+		mac[5]++;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_init(void)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	if (now_initialized)
+		return ESP_OK;
+	now_initialized = true;
+	peer_count = 0;
+	radio_stop = false;
+	last_due_us = 0;
+	if (!radio_running)
+	{
+		radio_running = true;
+		std::thread(radioTask).detach();
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+	std::unique_lock<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_OK;
+	// frames in the radio still complete, as their callbacks are unregistered they go nowhere
+	now_initialized = false;
+	recv_cb = nullptr;
+	send_cb = nullptr;
+	radio_stop = true;
+	radio_changed.notify_all();
+	radio_changed.wait(lock, []
+					   { return !radio_running; });
+	return ESP_OK;
+}
+
+esp_err_t esp_now_get_version(uint32_t *version)
+{
+	if (!version)
+		return ESP_ERR_ESPNOW_ARG;
+	*version = 1;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	recv_cb = cb;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	recv_cb = nullptr;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	send_cb = cb;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_send_cb(void)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	send_cb = nullptr;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+	int64_t now_us = esp_timer_get_time();
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	if (!data || len == 0 || len > ESP_NOW_MAX_DATA_LEN)
+		return ESP_ERR_ESPNOW_ARG;
+
+	// `NULL` sends to every unicast peer
+	int destinations = 0;
+	if (peer_addr)
+	{
+		if (findPeer(peer_addr) < 0)
+			return ESP_ERR_ESPNOW_NOT_FOUND;
+		destinations = 1;
+	}
+	else
+	{
+		for (int i = 0; i < peer_count; i++)
+			if (memcmp(peers[i].peer_addr, BROADCAST, ESP_NOW_ETH_ALEN) != 0)
+				destinations++;
+		if (destinations == 0)
+			return ESP_ERR_ESPNOW_NOT_FOUND;
+	}
+
+	if (radio_config.max_pending && pending.size() + destinations > radio_config.max_pending)
+	{
+		radio_stats.no_mem++;
+		return ESP_ERR_ESPNOW_NO_MEM;
+	}
+
+	if (peer_addr)
+		queueFrame(peer_addr, data, len, now_us);
+	else
+		for (int i = 0; i < peer_count; i++)
+			if (memcmp(peers[i].peer_addr, BROADCAST, ESP_NOW_ETH_ALEN) != 0)
+				queueFrame(peers[i].peer_addr, data, len, now_us);
+	radio_changed.notify_all();
+	return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+	if (!peer)
+		return ESP_ERR_ESPNOW_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	if (peer->channel > 14)
+		return ESP_ERR_ESPNOW_CHAN;
+	if (findPeer(peer->peer_addr) >= 0)
+		return ESP_ERR_ESPNOW_EXIST;
+	if (peer_count >= ESP_NOW_MAX_TOTAL_PEER_NUM)
+		return ESP_ERR_ESPNOW_FULL;
+	if (peer->encrypt)
+	{
+		int encrypted = 0;
+		for (int i = 0; i < peer_count; i++)
+			encrypted += peers[i].encrypt;
+		if (encrypted >= ESP_NOW_MAX_ENCRYPT_PEER_NUM)
+			return ESP_ERR_ESPNOW_FULL;
+	}
+	peers[peer_count++] = *peer;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+	if (!peer_addr)
+		return ESP_ERR_ESPNOW_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	int index = findPeer(peer_addr);
+	if (index < 0)
+		return ESP_ERR_ESPNOW_NOT_FOUND;
+	peers[index] = peers[--peer_count];
+	return ESP_OK;
+}
+
+esp_err_t esp_now_mod_peer(const esp_now_peer_info_t *peer)
+{
+	if (!peer)
+		return ESP_ERR_ESPNOW_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	int index = findPeer(peer->peer_addr);
+	if (index < 0)
+		return ESP_ERR_ESPNOW_NOT_FOUND;
+	peers[index] = *peer;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_get_peer(const uint8_t *peer_addr, esp_now_peer_info_t *peer)
+{
+	if (!peer_addr || !peer)
+		return ESP_ERR_ESPNOW_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	int index = findPeer(peer_addr);
+	if (index < 0)
+		return ESP_ERR_ESPNOW_NOT_FOUND;
+	*peer = peers[index];
+	return ESP_OK;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr)
+{
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	return now_initialized && peer_addr && findPeer(peer_addr) >= 0;
+}
+
+esp_err_t esp_now_get_peer_num(esp_now_peer_num_t *num)
+{
+	if (!num)
+		return ESP_ERR_ESPNOW_ARG;
+	std::lock_guard<std::mutex> lock(radio_mutex);
+	if (!now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	num->total_num = peer_count;
+	num->encrypt_num = 0;
+	for (int i = 0; i < peer_count; i++)
+		num->encrypt_num += peers[i].encrypt;
+	return ESP_OK;
+}
@@ -0,0 +1,61 @@
+#ifndef HOST_RADIO_H
+#define HOST_RADIO_H
+
+#include <stdint.h>
+#include "esp_now.h"
+
+/*
+ * Loopback radio behind the host `esp_now_*` stand-in.
+ *
+ * Every accepted frame is completed by `tx_cb` after the configured delay, in the order frames were sent, as ESP-NOW does.
+ * A frame lost on the way completes as failed when it was unicast and as delivered when it was broadcast (no ACK on the air).
+ * Delivered frames are looped back to `rx_cb` as if the destination had sent the very same frame back: the source
+ * of a looped back unicast is its destination, the source of a looped back broadcast is `broadcast_echo_mac`, or every
+ * unicast peer in turn with `broadcast_fanout`, as if each of them had heard it.
+ * Frames handed to the radio and not completed yet are bounded, beyond that `esp_now_send` returns `ESP_ERR_ESPNOW_NO_MEM`.
+ */
+
+typedef struct
+{
+	uint32_t delay_us;				/**< Time from `esp_now_send` to `tx_cb` and to the looped back `rx_cb`*/
+	uint32_t jitter_us;				/**< Random extra delay, up to this much. Completions keep their order*/
+	uint16_t loss_per_mille;		/**< Frames lost out of 1000*/
+	bool loopback;					/**< Hand delivered frames back to `rx_cb`*/
+	bool broadcast_fanout;			/**< Hand a delivered broadcast back once per unicast peer, instead of once from `broadcast_echo_mac`*/
+	uint16_t max_pending;			/**< Frames in the radio at the same time before `ESP_ERR_ESPNOW_NO_MEM`, `0` for no bound*/
+	int8_t rssi;					/**< RSSI of looped back frames*/
+	uint8_t own_mac[6];				/**< MAC of this device, both interfaces*/
+	uint8_t broadcast_echo_mac[6];	/**< Source of looped back broadcasts*/
+	uint32_t seed;					/**< Seed of loss and jitter, same seed same losses*/
+} host_radio_config_t;
+
+typedef struct
+{
+	uint32_t sent;	  /**< Frames accepted by `esp_now_send`, one per destination when sending to all peers*/
+	uint32_t lost;	  /**< Frames lost on the way*/
+	uint32_t looped;  /**< Frames handed back to `rx_cb`, a broadcast with `broadcast_fanout` counts once per peer*/
+	uint32_t no_mem;  /**< `esp_now_send` calls refused with `ESP_ERR_ESPNOW_NO_MEM`*/
+} host_radio_stats_t;
+
+/**
+ * @brief Default configuration: no delay, no loss, loopback on, 16 frames pending at most
+ */
+host_radio_config_t hostRadioDefaultConfig();
+
+/**
+ * @brief Applies a configuration. Takes effect for the frames sent from now on
+ */
+void hostRadioConfigure(const host_radio_config_t &config);
+
+/**
+ * @brief Returns the radio counters
+ * @param reset `true` to reset the counters after reading them
+ */
+host_radio_stats_t hostRadioStats(bool reset = false);
+
+/**
+ * @brief Waits until every frame handed to the radio has been completed
+ */
+void hostRadioDrain();
+
+#endif
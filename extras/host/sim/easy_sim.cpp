@@ -0,0 +1,575 @@
+/*
+ * Network simulation: many devices, each one running its own `EasyEspNow`, on the simulated radio of `sim.h`.
+ *
+ * Every device runs an application task sending messages of `payload` bytes at `rate` messages per second (Poisson
+ * arrivals), to the gateway (`pattern=gateway`), to random devices of its channel (`pattern=mesh`) or to everyone
+ * (`pattern=broadcast`), or only the gateway sends, `rate` messages per second to every device (`pattern=downlink`).
+ * Devices are spread over `channels` channels, with more than one the gateway hops over them, staying `dwell_ms` on each
+ * one, through `switchChannel(...)`, or with `scheduler=1` lets the channel scheduler move its radio.
+ *
+ * The report is one JSON object per line: one per device, one per channel in use and a total. Runs are reproducible,
+ * the same arguments give the same report but for `wall_s` and `speedup`.
+ *
+ *   easy_sim [key=value ...]    see `usage()` for the keys
+ */
+
+#include "EasyEspNow.h"
+#include "sim.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+
+int CURRENT_LOG_LEVEL = LOG_NONE;
+
+static const uint8_t CHANNEL_PLAN[] = {1, 6, 11, 3, 9, 13, 2, 7, 12, 4, 10, 5, 8, 14};
+static const uint32_t SIM_MESSAGE_MAGIC = 0x4D495345; // "ESIM"
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t source;
+	uint16_t reserved;
+	uint32_t sequence;
+	int64_t sent_us;
+} __attribute__((packed)) sim_message_t;
+
+typedef enum
+{
+	PATTERN_GATEWAY,
+	PATTERN_MESH,
+	PATTERN_BROADCAST,
+	PATTERN_DOWNLINK,
+} sim_pattern_t;
+
+typedef struct
+{
+	uint32_t nodes = 20;
+	double seconds = 3600;
+	double rate = 1;
+	uint32_t payload = 64;
+	sim_pattern_t pattern = PATTERN_GATEWAY;
+	uint32_t channels = 1;
+	uint32_t dwell_ms = 50;
+	bool scheduler = false;
+	uint32_t latency_ms = DEFAULT_CHANNEL_MAX_LATENCY_MS;
+	uint32_t encrypt = 0;
+	uint32_t compress = 0;
+	bool fair = false;
+	uint32_t queue = 16;
+	bool sync = false;
+	bool rx_task = false;
+	bool dedup = true;
+	sim_config_t radio = simDefaultConfig();
+} sim_options_t;
+
+struct sim_node_t
+{
+	int id;
+	EasyEspNow *easy;
+	uint8_t mac[MAC_ADDR_LEN];
+	uint8_t channel;
+	bool gateway;
+	std::vector<int> destinations;
+
+	// as a source
+	uint32_t next_sequence = 0;
+	uint32_t offered = 0;
+	uint32_t send_results[EASY_SEND_RESULTS] = {};
+	uint32_t delivered = 0;
+	uint64_t delivered_bytes = 0;
+	EasyLatencyHistogram end_to_end;
+
+	// as a destination
+	uint32_t received = 0;
+	uint32_t received_duplicates = 0;
+	std::set<uint64_t> seen;
+};
+
+static sim_options_t options;
+static std::vector<sim_node_t *> nodes;
+
+static void usage()
+{
+	Serial.printf("easy_sim [key=value ...]\n"
+				  "  nodes=20          devices, the gateway included\n"
+				  "  seconds=3600      virtual time to simulate\n"
+				  "  rate=1            messages per second sent by every device, Poisson arrivals\n"
+				  "  payload=64        message length, 20 to %d\n"
+				  "  pattern=gateway   gateway, mesh, broadcast or downlink\n"
+				  "  channels=1        channels the devices are spread over\n"
+				  "  dwell_ms=50       time the gateway stays on each channel when there are more than one\n"
+				  "  scheduler=0       1 for the gateway to use the channel scheduler instead of hopping every dwell_ms\n"
+				  "  latency_ms=%" PRIu32 "     latency bound of the channel scheduler\n"
+				  "  encrypt=0         1 to encrypt with a network key, 2 with a key per pair of devices as well\n"
+				  "  compress=0        1 to compress the text that fills the messages, 2 with a pre-shared dictionary\n"
+				  "  fair=0            1 for every device to use the fair scheduler, not along with scheduler=1\n"
+				  "  queue=16          TX queue of every device\n"
+				  "  sync=0            1 for synchronous sends\n"
+				  "  rx_task=0         1 to deliver through the RX task\n"
+				  "  dedup=1           0 to leave the duplicate filter off\n"
+				  "  loss=0            loss of every link, per mille\n"
+				  "  seed=1            seed of the run\n"
+				  "  bitrate=1000      PHY rate, kbps\n"
+				  "  retries=7         MAC retries of unicast frames\n"
+				  "  switch_us=0       time a radio is deaf after a channel change\n",
+				  MAX_DATA_LENGTH, DEFAULT_CHANNEL_MAX_LATENCY_MS);
+}
+
+static bool parse(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument(argv[i]);
+		size_t equals = argument.find('=');
+		if (equals == std::string::npos)
+			return false;
+		std::string key = argument.substr(0, equals);
+		std::string value = argument.substr(equals + 1);
+		double number = atof(value.c_str());
+
+		if (key == "nodes")
+			options.nodes = (uint32_t)number;
+		else if (key == "seconds")
+			options.seconds = number;
+		else if (key == "rate")
+			options.rate = number;
+		else if (key == "payload")
+			options.payload = (uint32_t)number;
+		else if (key == "pattern" && value == "gateway")
+			options.pattern = PATTERN_GATEWAY;
+		else if (key == "pattern" && value == "mesh")
+			options.pattern = PATTERN_MESH;
+		else if (key == "pattern" && value == "broadcast")
+			options.pattern = PATTERN_BROADCAST;
+		else if (key == "pattern" && value == "downlink")
+			options.pattern = PATTERN_DOWNLINK;
+		else if (key == "channels")
+			options.channels = (uint32_t)number;
+		else if (key == "dwell_ms")
+			options.dwell_ms = (uint32_t)number;
+		else if (key == "scheduler")
+			options.scheduler = number != 0;
+		else if (key == "encrypt")
+			options.encrypt = (uint32_t)number;
+		else if (key == "compress")
+			options.compress = (uint32_t)number;
+		else if (key == "fair")
+			options.fair = number != 0;
+		else if (key == "latency_ms")
+			options.latency_ms = (uint32_t)number;
+		else if (key == "queue")
+			options.queue = (uint32_t)number;
+		else if (key == "sync")
+			options.sync = number != 0;
+		else if (key == "rx_task")
+			options.rx_task = number != 0;
+		else if (key == "dedup")
+			options.dedup = number != 0;
+		else if (key == "loss")
+			options.radio.loss_per_mille = (uint16_t)number;
+		else if (key == "seed")
+			options.radio.seed = (uint32_t)number;
+		else if (key == "bitrate")
+			options.radio.bitrate_kbps = (uint32_t)number;
+		else if (key == "retries")
+			options.radio.retry_limit = (uint8_t)number;
+		else if (key == "switch_us")
+			options.radio.channel_switch_us = (uint32_t)number;
+		else
+			return false;
+	}
+	return options.nodes >= 2 && options.seconds > 0 && options.rate > 0 && options.payload >= sizeof(sim_message_t) &&
+		   options.payload <= (options.encrypt ? MAX_SEALED_DATA_LENGTH : MAX_DATA_LENGTH) && options.encrypt <= 2 && options.compress <= 2 && options.channels >= 1 && options.channels <= sizeof(CHANNEL_PLAN) &&
+		   options.dwell_ms > 0 && options.latency_ms > 0 && options.radio.bitrate_kbps > 0 && !(options.fair && options.scheduler);
+}
+
+// one JSON object per line, fields are appended in the order they are given
+class Line
+{
+public:
+	explicit Line(const char *kind)
+	{
+		line = "{\"sim\":\"" + std::string(kind) + "\"";
+	}
+	Line &field(const char *key, double value)
+	{
+		char text[64];
+		snprintf(text, sizeof(text), ",\"%s\":%.6g", key, value);
+		line += text;
+		return *this;
+	}
+	Line &field(const char *key, const char *value)
+	{
+		line += ",\"" + std::string(key) + "\":\"" + value + "\"";
+		return *this;
+	}
+	void print()
+	{
+		Serial.printf("%s}\n", line.c_str());
+		Serial.flush();
+	}
+
+private:
+	std::string line;
+};
+
+static void onMessage(sim_node_t &node, const uint8_t *data, int data_len)
+{
+	sim_message_t message;
+	if (data_len < (int)sizeof(message))
+		return;
+	memcpy(&message, data, sizeof(message));
+	if (message.magic != SIM_MESSAGE_MAGIC || message.source >= nodes.size())
+		return;
+
+	// MAC retries whose ACK got lost arrive twice unless the duplicate filter catches them
+	if (!node.seen.insert(((uint64_t)message.source << 32) | message.sequence).second)
+	{
+		node.received_duplicates++;
+		return;
+	}
+	node.received++;
+	sim_node_t &source = *nodes[message.source];
+	source.delivered++;
+	source.delivered_bytes += data_len;
+	source.end_to_end.record((uint32_t)(esp_timer_get_time() - message.sent_us));
+}
+
+// network key shared by all, pair keys made of the two MACs so both ends derive the same one
+static bool setUpKeys(sim_node_t &node)
+{
+	EasyEspNow &easy = *node.easy;
+	if (!easy.enableEncryption(options.encrypt == 2 ? nodes.size() : 1))
+		return false;
+	uint8_t key[ENCRYPTION_KEY_LEN] = {0xE5};
+	if (!easy.setPeerKey(ESPNOW_BROADCAST_ADDRESS, key))
+		return false;
+	for (size_t i = 0; options.encrypt == 2 && i < nodes.size(); i++)
+	{
+		if (nodes[i] == &node)
+			continue;
+		for (uint8_t b = 0; b < MAC_ADDR_LEN; b++)
+		{
+			key[b] = node.mac[b] ^ nodes[i]->mac[b];
+			key[MAC_ADDR_LEN + b] = node.mac[b] & nodes[i]->mac[b];
+		}
+		if (!easy.setPeerKey(nodes[i]->mac, key))
+			return false;
+	}
+	return true;
+}
+
+// with compression the messages are filled with a sensor reading in text, the dictionary holds one such reading
+static const char SIM_TEXT[] = "{\"temperature\":21.5,\"humidity\":40,\"pressure\":1013,\"battery\":87,\"status\":\"ok\"}";
+
+static bool setUpCompression(sim_node_t &node)
+{
+	EasyEspNow &easy = *node.easy;
+	uint8_t dictionary = options.compress == 2 ? 1 : COMPRESSION_NO_DICTIONARY;
+	if (options.compress == 2 && !easy.setCompressionDictionary(1, (const uint8_t *)SIM_TEXT, sizeof(SIM_TEXT) - 1))
+		return false;
+	if (!easy.enableCompression())
+		return false;
+	for (int destination : node.destinations)
+		easy.setPeerCompression(nodes[destination]->mac, dictionary);
+	if (options.pattern == PATTERN_BROADCAST)
+		easy.setPeerCompression(ESPNOW_BROADCAST_ADDRESS, dictionary);
+	return true;
+}
+
+static bool setUp(sim_node_t &node)
+{
+	EasyEspNow &easy = *node.easy;
+	WiFi.mode(WIFI_STA);
+	if (!easy.begin(node.channel, WIFI_IF_STA, options.queue, options.sync))
+		return false;
+	if (options.encrypt && !setUpKeys(node))
+		return false;
+	if (options.dedup)
+		easy.enableRXDedup();
+	if (options.rx_task)
+		easy.beginRXTask();
+	if (options.pattern == PATTERN_BROADCAST && !easy.addPeer(ESPNOW_BROADCAST_ADDRESS))
+		return false;
+	easy.onDataReceived([&node](const uint8_t *src_mac, const uint8_t *data, int data_len, espnow_frame_recv_info_t *frame)
+						{ onMessage(node, data, data_len); });
+
+	// beyond what ESP-NOW holds, peers live in the directory and are swapped in when sent to
+	if (node.destinations.size() >= MAX_TOTAL_PEER_NUM && !easy.enablePeerDirectory(node.destinations.size() + 1))
+		return false;
+	for (int destination : node.destinations)
+		easy.addPeer(nodes[destination]->mac);
+	if (options.compress && !setUpCompression(node))
+		return false;
+	if (options.fair && !easy.enableFairScheduling(DEFAULT_FAIR_MAX_DESTINATIONS, 0, options.radio.bitrate_kbps))
+		return false;
+
+	if (node.gateway && options.scheduler)
+	{
+		if (!easy.enableChannelScheduling(options.latency_ms))
+			return false;
+		for (int destination : node.destinations)
+			easy.setPeerChannel(nodes[destination]->mac, nodes[destination]->channel);
+	}
+	return true;
+}
+
+static void applicationTask(void *parameters)
+{
+	sim_node_t &node = *(sim_node_t *)parameters;
+	if (!setUp(node))
+	{
+		Serial.printf("{\"error\":\"node %d failed to start\"}\n", node.id);
+		vTaskDelete(NULL);
+	}
+
+	bool sends = options.pattern == PATTERN_GATEWAY ? !node.gateway : options.pattern == PATTERN_DOWNLINK ? node.gateway : true;
+	uint8_t payload[MAX_DATA_LENGTH] = {};
+	for (size_t i = sizeof(sim_message_t); options.compress && i < sizeof(payload); i++)
+		payload[i] = SIM_TEXT[(i - sizeof(sim_message_t)) % (sizeof(SIM_TEXT) - 1)];
+	// the downlink gateway sends the messages of every device
+	double mean_gap_us = 1e6 / options.rate / (options.pattern == PATTERN_DOWNLINK ? node.destinations.size() : 1);
+	while (sends)
+	{
+		// exponential gaps, rounded to ticks
+		double uniform = (simRandom() + 1.0) / 4294967296.0;
+		uint32_t gap_ms = (uint32_t)(-log(uniform) * mean_gap_us / 1000);
+		vTaskDelay(pdMS_TO_TICKS(gap_ms ? gap_ms : 1));
+
+		sim_message_t message = {SIM_MESSAGE_MAGIC, (uint16_t)node.id, 0, node.next_sequence++, esp_timer_get_time()};
+		memcpy(payload, &message, sizeof(message));
+		easy_send_error_t result;
+		if (options.pattern == PATTERN_BROADCAST)
+			result = node.easy->sendBroadcast(payload, options.payload);
+		else
+		{
+			int destination = node.destinations[simRandom() % node.destinations.size()];
+			result = node.easy->send(nodes[destination]->mac, payload, options.payload);
+		}
+		node.offered++;
+		node.send_results[-result]++;
+	}
+	vTaskDelete(NULL);
+}
+
+// the gateway listens on every channel in turn
+static void hopTask(void *parameters)
+{
+	sim_node_t &node = *(sim_node_t *)parameters;
+	uint32_t next = 0;
+	while (true)
+	{
+		vTaskDelay(pdMS_TO_TICKS(options.dwell_ms));
+		next = (next + 1) % options.channels;
+		node.easy->switchChannel(CHANNEL_PLAN[next]);
+	}
+}
+
+static void buildNetwork()
+{
+	for (uint32_t i = 0; i < options.nodes; i++)
+	{
+		sim_node_t *node = new sim_node_t();
+		node->id = simAddDevice();
+		simDeviceMac(node->id, node->mac);
+		bool with_gateway = options.pattern == PATTERN_GATEWAY || options.pattern == PATTERN_DOWNLINK;
+		node->gateway = with_gateway && i == 0;
+		// the gateway starts on the first channel, the others are spread over all of them
+		node->channel = CHANNEL_PLAN[node->gateway ? 0 : (with_gateway ? i - 1 : i) % options.channels];
+		node->easy = new EasyEspNow();
+		nodes.push_back(node);
+	}
+
+	for (sim_node_t *node : nodes)
+	{
+		if (options.pattern == PATTERN_GATEWAY && !node->gateway)
+			node->destinations.push_back(0);
+		else if (options.pattern == PATTERN_DOWNLINK && node->gateway)
+		{
+			for (sim_node_t *other : nodes)
+				if (other != node)
+					node->destinations.push_back(other->id);
+		}
+		else if (options.pattern == PATTERN_MESH)
+			for (sim_node_t *other : nodes)
+				if (other != node && other->channel == node->channel)
+					node->destinations.push_back(other->id);
+	}
+
+	for (sim_node_t *node : nodes)
+	{
+		if (options.pattern == PATTERN_MESH && node->destinations.empty())
+			continue;
+		simStartTask(node->id, applicationTask, node, "loopTask", 1);
+		if (node->gateway && options.channels > 1 && !options.scheduler)
+			simStartTask(node->id, hopTask, node, "hop", 1);
+	}
+}
+
+static uint64_t digest(uint64_t hash, uint64_t value)
+{
+	// FNV-1a over the counters, equal digests tell two runs took the same path
+	for (int i = 0; i < 8; i++)
+	{
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+static void report(double wall_s)
+{
+	const char *patterns[] = {"gateway", "mesh", "broadcast", "downlink"};
+	double virtual_s = options.seconds;
+	uint64_t totals_offered = 0, totals_accepted = 0, totals_delivered = 0, totals_bytes = 0, totals_queue_full = 0;
+	uint64_t totals_collisions = 0, totals_link = 0, totals_ack = 0, totals_failed = 0, totals_off_channel = 0;
+	uint64_t totals_esp_now = 0, totals_chan = 0, totals_overflows = 0, totals_filtered = 0, totals_duplicates = 0;
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	channel_stats_t gateway_channels = {};
+
+	for (sim_node_t *node : nodes)
+	{
+		easy_stats_t stats = node->easy->getStats();
+		rx_ring_stats_t rx_stats = node->easy->getRXStats();
+		sim_radio_stats_t radio = simRadioStats(node->id);
+		latency_histogram_t end_to_end = node->end_to_end.snapshot();
+		channel_stats_t scheduler = node->easy->getChannelStats();
+		encryption_stats_t encryption = node->easy->getEncryptionStats();
+		compression_stats_t compression = node->easy->getCompressionStats();
+		if (node->gateway)
+			gateway_channels = scheduler;
+		uint32_t accepted = node->send_results[-EASY_SEND_OK];
+		uint32_t queue_full = node->send_results[-EASY_SEND_QUEUE_FULL_ERROR];
+		// with broadcast every device but the source may get every message
+		double expected = options.pattern == PATTERN_BROADCAST ? (double)node->offered * (nodes.size() - 1) : node->offered;
+
+		Line("node")
+			.field("node", node->id)
+			.field("role", node->gateway ? "gateway" : "device")
+			.field("channel", node->channel)
+			.field("offered", node->offered)
+			.field("accepted", accepted)
+			.field("delivered", node->delivered)
+			.field("delivery_ratio", expected ? node->delivered / expected : 0)
+			.field("goodput_bps", node->delivered_bytes * 8 / virtual_s)
+			.field("received", node->received)
+			.field("e2e_p50_us", easyLatencyPercentile(end_to_end, 50))
+			.field("e2e_p99_us", easyLatencyPercentile(end_to_end, 99))
+			.field("queue_p50_us", easyLatencyPercentile(stats.enqueue_to_send, 50))
+			.field("queue_p99_us", easyLatencyPercentile(stats.enqueue_to_send, 99))
+			.field("access_p50_us", easyLatencyPercentile(radio.access_delay, 50))
+			.field("access_p99_us", easyLatencyPercentile(radio.access_delay, 99))
+			.field("send_to_complete_p99_us", easyLatencyPercentile(stats.send_to_complete, 99))
+			.field("tx_queue_depth_max", stats.tx_queue_depth_max)
+			.field("tx_attempts", radio.tx_attempts)
+			.field("drop_queue_full", queue_full)
+			.field("drop_esp_now", stats.esp_now_send_errors)
+			.field("no_mem", radio.no_mem)
+			.field("drop_retries", radio.tx_failed)
+			.field("collisions", radio.collisions)
+			.field("link_losses", radio.link_losses)
+			.field("ack_losses", radio.ack_losses)
+			.field("off_channel", radio.off_channel)
+			.field("chan_errors", radio.chan_errors)
+			.field("rx_overflows", rx_stats.overflows)
+			.field("rx_duplicates_filtered", rx_stats.duplicates)
+			.field("rx_duplicates", node->received_duplicates)
+			.field("channel_switches", radio.channel_switches)
+			.field("scheduler_switches", scheduler.switches)
+			.field("latency_switches", scheduler.latency_switches)
+			.field("sealed", encryption.sealed)
+			.field("opened", encryption.opened)
+			.field("auth_failures", encryption.auth_failures + encryption.no_key + encryption.plain_dropped)
+			.field("compressed", compression.compressed)
+			.field("compression_ratio", compression.bytes_out ? (double)compression.bytes_in / compression.bytes_out : 0)
+			.field("inflated", compression.inflated)
+			.field("compression_errors", compression.errors)
+			.print();
+
+		totals_offered += node->offered;
+		totals_accepted += accepted;
+		totals_delivered += node->delivered;
+		totals_bytes += node->delivered_bytes;
+		totals_queue_full += queue_full;
+		totals_esp_now += stats.esp_now_send_errors;
+		totals_failed += radio.tx_failed;
+		totals_collisions += radio.collisions;
+		totals_link += radio.link_losses;
+		totals_ack += radio.ack_losses;
+		totals_off_channel += radio.off_channel;
+		totals_chan += radio.chan_errors;
+		totals_overflows += rx_stats.overflows;
+		totals_filtered += rx_stats.duplicates;
+		totals_duplicates += node->received_duplicates;
+		hash = digest(hash, node->offered);
+		hash = digest(hash, node->delivered);
+		hash = digest(hash, end_to_end.total_us);
+		hash = digest(hash, radio.tx_attempts);
+	}
+
+	for (uint8_t channel = 1; channel <= 14; channel++)
+	{
+		sim_channel_stats_t channel_stats = simChannelStats(channel);
+		if (channel_stats.attempts == 0)
+			continue;
+		Line("channel")
+			.field("channel", channel)
+			.field("busy_pct", channel_stats.busy_us / (virtual_s * 1e4))
+			.field("attempts", channel_stats.attempts)
+			.field("collisions", channel_stats.collisions)
+			.field("gateway_dwell_pct", gateway_channels.dwell_ms[channel] / (virtual_s * 10))
+			.print();
+	}
+
+	char digest_text[20];
+	snprintf(digest_text, sizeof(digest_text), "%016llx", (unsigned long long)hash);
+	Line("total")
+		.field("pattern", patterns[options.pattern])
+		.field("nodes", options.nodes)
+		.field("channels", options.channels)
+		.field("seed", options.radio.seed)
+		.field("virtual_s", virtual_s)
+		.field("wall_s", wall_s)
+		.field("speedup", virtual_s / wall_s)
+		.field("events", simEvents())
+		.field("offered", totals_offered)
+		.field("accepted", totals_accepted)
+		.field("delivered", totals_delivered)
+		.field("goodput_bps", totals_bytes * 8 / virtual_s)
+		.field("drop_queue_full", totals_queue_full)
+		.field("drop_esp_now", totals_esp_now)
+		.field("drop_retries", totals_failed)
+		.field("collisions", totals_collisions)
+		.field("link_losses", totals_link)
+		.field("ack_losses", totals_ack)
+		.field("off_channel", totals_off_channel)
+		.field("chan_errors", totals_chan)
+		.field("rx_overflows", totals_overflows)
+		.field("rx_duplicates_filtered", totals_filtered)
+		.field("rx_duplicates", totals_duplicates)
+		.field("digest", digest_text)
+		.print();
+}
+
+int main(int argc, char **argv)
+{
+	if (!parse(argc, argv))
+	{
+		usage();
+		return 1;
+	}
+
+	simBegin(options.radio);
+	buildNetwork();
+
+	auto wall_start = std::chrono::steady_clock::now();
+	simRun((int64_t)(options.seconds * 1e6));
+	double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+	report(wall_s);
+	return 0;
+}
@@ -0,0 +1,154 @@
+#ifndef EASY_SIM_H
+#define EASY_SIM_H
+
+/*
+ * Deterministic discrete-event simulation of many ESP32 running the library, in one process and on one thread.
+ *
+ * Kernel: every FreeRTOS task is a coroutine. Tasks run one at a time, highest priority first and in the order they became
+ * ready among equals, and a task handing work to a higher priority one is preempted right there, as in FreeRTOS.
+ * Code takes no time: the virtual clock behind `esp_timer_get_time()`, `millis()` and the ticks only moves when every task
+ * is blocked, straight to the next timeout or radio event. An hour of traffic runs in seconds.
+ *
+ * Radio: one collision domain per WiFi channel. A frame takes its airtime on the channel it is sent on, plus SIFS and the
+ * ACK for unicast. Devices sense the carrier and back off (DIFS and a random number of slots out of a contention window
+ * that doubles on every retry), two devices picking the same slot collide. A frame reaches the devices listening on its
+ * channel unless it collided or is lost on the link, unicast frames are retried until acknowledged or out of retries,
+ * an ACK lost on the way makes the destination receive the retry as a duplicate.
+ *
+ * Everything random comes from the seed: same seed, same run.
+ */
+
+#include <stdint.h>
+#include <functional>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "easy_stats.h"
+
+/**
+ * Air and MAC timing of the simulated radios, the defaults are 802.11b at 1 Mbps as ESP-NOW sends by default
+ */
+typedef struct
+{
+	uint32_t seed;				   /**< Seed of every random draw, backoffs, losses and `random()` included*/
+	uint32_t bitrate_kbps;		   /**< PHY rate of data frames and ACKs*/
+	uint16_t preamble_us;		   /**< PLCP preamble and header*/
+	uint16_t slot_us;			   /**< Backoff slot, also how late a device may start and still collide instead of sensing the carrier*/
+	uint16_t sifs_us;			   /**< Gap before an ACK, DIFS is SIFS and two slots*/
+	uint16_t cw_min;			   /**< Contention window of a first attempt, in slots*/
+	uint16_t cw_max;			   /**< Largest contention window*/
+	uint8_t retry_limit;		   /**< Retries of a unicast frame that is not acknowledged*/
+	uint16_t max_pending;		   /**< Frames a device holds in its radio before `esp_now_send` returns `ESP_ERR_ESPNOW_NO_MEM`*/
+	uint32_t channel_switch_us;	   /**< Time a device neither sends nor receives after changing channel*/
+	uint16_t loss_per_mille;	   /**< Loss of every link, out of 1000, until `simSetLink(...)` says otherwise*/
+	int8_t rssi;				   /**< RSSI of every link, until `simSetLink(...)` says otherwise*/
+} sim_config_t;
+
+/**
+ * Radio counters of one device. Attempt counters count every transmission of a frame, retries included
+ */
+typedef struct
+{
+	uint32_t tx_frames;		   /**< Frames accepted by `esp_now_send`, one per destination when sending to all peers*/
+	uint32_t tx_attempts;	   /**< Transmissions, retries included*/
+	uint32_t tx_delivered;	   /**< Frames completed as delivered*/
+	uint32_t tx_failed;		   /**< Unicast frames completed as not delivered: out of retries*/
+	uint32_t no_mem;		   /**< `esp_now_send` calls refused because the radio was full*/
+	uint32_t chan_errors;	   /**< `esp_now_send` calls refused because the peer is registered on another channel*/
+	uint32_t collisions;	   /**< Attempts that overlapped another transmission on the channel*/
+	uint32_t link_losses;	   /**< Unicast attempts lost on the way to the destination*/
+	uint32_t ack_losses;	   /**< Unicast attempts received whose ACK was lost on the way back*/
+	uint32_t off_channel;	   /**< Unicast attempts whose destination was on another channel or switching*/
+	uint32_t no_destination;   /**< Unicast attempts to a MAC no simulated device has*/
+	uint32_t rx_frames;		   /**< Frames handed to `rx_cb`*/
+	uint32_t rx_collided;	   /**< Frames for this device lost to a collision*/
+	uint32_t rx_lost;		   /**< Frames for this device lost on the link*/
+	uint32_t channel_switches; /**< Channel changes*/
+	latency_histogram_t access_delay;	/**< From `esp_now_send` to the start of the last transmission of a frame: queueing and backoff*/
+	latency_histogram_t send_to_complete; /**< From `esp_now_send` to `tx_cb`*/
+} sim_radio_stats_t;
+
+/**
+ * Use of one channel
+ */
+typedef struct
+{
+	uint64_t busy_us;	  /**< Time with at least one transmission or ACK on the air*/
+	uint32_t attempts;	  /**< Transmissions started*/
+	uint32_t collisions;  /**< Transmissions that overlapped another one*/
+} sim_channel_stats_t;
+
+/**
+ * @brief Default configuration: 1 Mbps, long preamble, 20 µs slots, 7 retries, no loss
+ */
+sim_config_t simDefaultConfig();
+
+/**
+ * @brief Starts an empty simulation at virtual time 0. Call it once, before anything else
+ */
+void simBegin(const sim_config_t &config);
+
+/**
+ * @brief Adds a device with its own WiFi, ESP-NOW and tasks
+ * @return device id, from `0` up
+ */
+int simAddDevice();
+
+/**
+ * @return number of devices
+ */
+int simDeviceCount();
+
+/**
+ * @brief MAC of the station interface of a device, the soft-AP one follows it
+ */
+void simDeviceMac(int device, uint8_t mac[6]);
+
+/**
+ * @brief Sets the loss and RSSI of the link from one device to another, one way
+ * @param loss_per_mille Frames lost out of 1000, `1000` takes the link down
+ */
+void simSetLink(int from, int to, uint16_t loss_per_mille, int8_t rssi);
+
+/**
+ * @brief Starts a task on a device, as the Arduino core starts `loopTask`
+ */
+BaseType_t simStartTask(int device, TaskFunction_t function, void *parameters, const char *name, UBaseType_t priority = 1);
+
+/**
+ * @brief Runs an action at a virtual time, outside of any task and as the given device, the way the WiFi driver calls
+ * the ESP-NOW callbacks. The action must not block
+ */
+void simSchedule(int64_t at_us, int device, std::function<void()> action);
+
+/**
+ * @return device of the running task or action
+ */
+int simCurrentDevice();
+
+/**
+ * @brief Runs the simulation until the virtual clock has moved by `duration_us`
+ */
+void simRun(int64_t duration_us);
+
+/**
+ * @return events handled since `simBegin(...)`: task switches, timeouts and radio events
+ */
+uint64_t simEvents();
+
+/**
+ * @brief Returns the radio counters of a device
+ */
+sim_radio_stats_t simRadioStats(int device);
+
+/**
+ * @brief Returns the use of a channel, `1` to `14`
+ */
+sim_channel_stats_t simChannelStats(uint8_t channel);
+
+/**
+ * @brief Uniform random number of the simulation, from the seed
+ */
+uint32_t simRandom();
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef EASY_SIM_INTERNAL_H
+#define EASY_SIM_INTERNAL_H
+
+#include "sim.h"
+
+/*
+ * Shared by the simulated kernel and the simulated radio
+ */
+
+/**
+ * @brief Configuration given to `simBegin(...)`
+ */
+const sim_config_t &simConfig();
+
+/**
+ * @brief Clears the devices of the radio, called by `simBegin(...)`
+ */
+void simRadioBegin();
+
+#endif
@@ -0,0 +1,738 @@
+#include "sim.h"
+#include "sim_internal.h"
+#include "host_device.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "Arduino.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <deque>
+#include <queue>
+#include <string>
+#include <vector>
+
+/*
+ * FreeRTOS on coroutines and a virtual clock. Only one task runs at any time, on the thread that called `simRun(...)`,
+ * so nothing here needs a lock and every run takes the same path.
+ */
+
+// host code needs far more stack than the same task on the ESP32
+static const size_t SIM_TASK_STACK_SIZE = 256 * 1024;
+
+struct host_queue;
+
+typedef enum
+{
+	TASK_READY,
+	TASK_RUNNING,
+	TASK_BLOCKED,
+	TASK_SUSPENDED,
+	TASK_FINISHED,
+} sim_task_state_t;
+
+struct host_task
+{
+	ucontext_t context;
+	void *stack = nullptr;
+	TaskFunction_t function;
+	void *parameters;
+	std::string name;
+	UBaseType_t priority;
+	int device;
+	sim_task_state_t state = TASK_READY;
+	bool started = false;
+	bool suspend_requested = false;
+	bool deleted = false;
+	uint32_t notification = 0;
+	bool waiting_notification = false;
+	host_queue *waiting_on = nullptr;
+	uint64_t wait_generation = 0;	   // moves on every wake up, a timeout armed before finds another number
+	ucontext_t *resume_to = nullptr; // where a deleted task goes once it has unwound
+};
+
+struct host_queue
+{
+	uint32_t length;
+	uint32_t item_size;
+	std::vector<uint8_t> storage;
+	uint32_t head = 0;
+	uint32_t count = 0;
+	std::vector<host_task *> waiters;
+};
+
+struct host_event_group
+{
+	EventBits_t bits = 0;
+	host_queue object; // only its waiters are used
+};
+
+namespace
+{
+	// thrown in a deleted task to unwind out of its task function
+	struct task_deleted
+	{
+	};
+
+	typedef struct
+	{
+		int64_t at_us;
+		uint64_t order; // events due at the same time keep the order they were scheduled in
+		host_task *task; // timeout of a blocked task, or
+		uint64_t generation;
+		int device; // an action run as this device
+		std::function<void()> action;
+	} sim_event_t;
+
+	struct later
+	{
+		bool operator()(const sim_event_t &a, const sim_event_t &b) const
+		{
+			return a.at_us != b.at_us ? a.at_us > b.at_us : a.order > b.order;
+		}
+	};
+
+	sim_config_t config = simDefaultConfig();
+	int64_t now_us = 0;
+	uint64_t next_order = 0;
+	uint64_t events_handled = 0;
+	uint64_t random_state = 1;
+	std::priority_queue<sim_event_t, std::vector<sim_event_t>, later> events;
+	std::deque<host_task *> ready[configMAX_PRIORITIES];
+	host_task *current_task = nullptr;
+	int current_device = 0;
+	uint32_t critical_nesting = 0;
+	ucontext_t scheduler_context;
+	std::deque<void *> device_contexts;
+
+	void schedule(int64_t at_us, host_task *task, int device, std::function<void()> action)
+	{
+		sim_event_t event;
+		event.at_us = at_us;
+		event.order = next_order++;
+		event.task = task;
+		event.generation = task ? task->wait_generation : 0;
+		event.device = device;
+		event.action = std::move(action);
+		events.push(std::move(event));
+	}
+
+	void forgetWait(host_task *task)
+	{
+		if (task->waiting_on)
+		{
+			std::vector<host_task *> &waiters = task->waiting_on->waiters;
+			for (size_t i = 0; i < waiters.size(); i++)
+				if (waiters[i] == task)
+				{
+					waiters.erase(waiters.begin() + i);
+					break;
+				}
+		}
+		task->waiting_on = nullptr;
+		task->waiting_notification = false;
+		task->wait_generation++;
+	}
+
+	void makeReady(host_task *task, bool front = false)
+	{
+		forgetWait(task);
+		task->state = TASK_READY;
+		if (front)
+			ready[task->priority].push_front(task);
+		else
+			ready[task->priority].push_back(task);
+	}
+
+	void unready(host_task *task)
+	{
+		std::deque<host_task *> &list = ready[task->priority];
+		for (size_t i = 0; i < list.size(); i++)
+			if (list[i] == task)
+			{
+				list.erase(list.begin() + i);
+				break;
+			}
+	}
+
+	host_task *nextReady()
+	{
+		for (int priority = configMAX_PRIORITIES - 1; priority >= 0; priority--)
+			if (!ready[priority].empty())
+			{
+				host_task *task = ready[priority].front();
+				ready[priority].pop_front();
+				return task;
+			}
+		return nullptr;
+	}
+
+	bool readyAbove(UBaseType_t priority, bool or_equal)
+	{
+		for (int p = configMAX_PRIORITIES - 1; p > (int)priority || (or_equal && p == (int)priority); p--)
+			if (!ready[p].empty())
+				return true;
+		return false;
+	}
+
+	// gives the thread back to the scheduler until someone makes the task ready again
+	void switchToScheduler()
+	{
+		host_task *task = current_task;
+		swapcontext(&task->context, &scheduler_context);
+		if (task->deleted)
+			throw task_deleted();
+	}
+
+	// a task that made a higher priority task ready gives way to it right away, as FreeRTOS does
+	void preemptIfNeeded()
+	{
+		if (!current_task || critical_nesting > 0 || !readyAbove(current_task->priority, false))
+			return;
+		makeReady(current_task, true);
+		switchToScheduler();
+	}
+
+	// suspension takes effect here, deletion whenever the task is switched back in
+	void checkpoint(host_task *task)
+	{
+		while (task->suspend_requested)
+		{
+			task->state = TASK_SUSPENDED;
+			switchToScheduler();
+		}
+	}
+
+	void block(host_task *task, host_queue *object, bool notification, int64_t deadline_us)
+	{
+		task->state = TASK_BLOCKED;
+		task->waiting_on = object;
+		task->waiting_notification = notification;
+		if (object)
+			object->waiters.push_back(task);
+		if (deadline_us >= 0)
+			schedule(deadline_us, task, task->device, nullptr);
+		switchToScheduler();
+	}
+
+	template <typename Predicate>
+	bool waitFor(TickType_t ticks, host_queue *object, bool notification, Predicate is_ready)
+	{
+		host_task *task = current_task;
+		int64_t deadline_us = ticks == portMAX_DELAY ? -1 : now_us + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+		while (true)
+		{
+			if (task)
+				checkpoint(task);
+			if (is_ready())
+				return true;
+			// actions run outside of any task and can not block, neither can the thread driving the simulation
+			if (ticks == 0 || !task)
+				return false;
+			if (deadline_us >= 0 && now_us >= deadline_us)
+				return false;
+			block(task, object, notification, deadline_us);
+		}
+	}
+
+	void wakeWaiters(host_queue *queue)
+	{
+		while (!queue->waiters.empty())
+			makeReady(queue->waiters.front());
+	}
+
+	void taskEntry()
+	{
+		host_task *task = current_task;
+		try
+		{
+			task->function(task->parameters);
+		}
+		catch (const task_deleted &)
+		{
+		}
+
+		task->state = TASK_FINISHED;
+		forgetWait(task);
+		setcontext(task->resume_to ? task->resume_to : &scheduler_context);
+	}
+
+	void runTask(host_task *task)
+	{
+		current_task = task;
+		current_device = task->device;
+		task->state = TASK_RUNNING;
+		task->started = true;
+		swapcontext(&scheduler_context, &task->context);
+		current_task = nullptr;
+		if (task->state == TASK_FINISHED && task->stack)
+		{
+			free(task->stack);
+			task->stack = nullptr;
+		}
+	}
+
+	host_queue *createQueue(UBaseType_t length, UBaseType_t item_size, UBaseType_t initial_count)
+	{
+		if (length == 0)
+			return nullptr;
+		host_queue *queue = new host_queue();
+		queue->length = length;
+		queue->item_size = item_size;
+		queue->storage.resize((size_t)length * item_size);
+		queue->count = initial_count;
+		return queue;
+	}
+}
+
+sim_config_t simDefaultConfig()
+{
+	sim_config_t config = {};
+	config.seed = 1;
+	config.bitrate_kbps = 1000;
+	config.preamble_us = 192;
+	config.slot_us = 20;
+	config.sifs_us = 10;
+	config.cw_min = 31;
+	config.cw_max = 1023;
+	config.retry_limit = 7;
+	config.max_pending = 16;
+	config.channel_switch_us = 0;
+	config.loss_per_mille = 0;
+	config.rssi = -60;
+	return config;
+}
+
+const sim_config_t &simConfig()
+{
+	return config;
+}
+
+void simBegin(const sim_config_t &sim_config)
+{
+	config = sim_config;
+	now_us = 0;
+	random_state = config.seed ? config.seed : 1;
+	randomSeed(config.seed);
+	simRadioBegin();
+}
+
+void simSchedule(int64_t at_us, int device, std::function<void()> action)
+{
+	schedule(at_us < now_us ? now_us : at_us, nullptr, device, std::move(action));
+}
+
+int simCurrentDevice()
+{
+	return current_device;
+}
+
+BaseType_t simStartTask(int device, TaskFunction_t function, void *parameters, const char *name, UBaseType_t priority)
+{
+	int caller_device = current_device;
+	current_device = device;
+	BaseType_t result = xTaskCreate(function, name, 0, parameters, priority, nullptr);
+	current_device = caller_device;
+	return result;
+}
+
+void simRun(int64_t duration_us)
+{
+	int64_t until_us = now_us + duration_us;
+	while (true)
+	{
+		host_task *task = nextReady();
+		if (task)
+		{
+			events_handled++;
+			runTask(task);
+			continue;
+		}
+
+		// every task is blocked: jump to the next event
+		if (events.empty() || events.top().at_us > until_us)
+			break;
+		sim_event_t event = std::move(const_cast<sim_event_t &>(events.top()));
+		events.pop();
+		if (event.at_us > now_us)
+			now_us = event.at_us;
+		events_handled++;
+
+		if (event.task)
+		{
+			if (event.task->state == TASK_BLOCKED && event.task->wait_generation == event.generation)
+				makeReady(event.task);
+		}
+		else
+		{
+			current_device = event.device;
+			event.action();
+		}
+	}
+	now_us = until_us;
+}
+
+uint64_t simEvents()
+{
+	return events_handled;
+}
+
+uint32_t simRandom()
+{
+	// xorshift64*
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+	return (uint32_t)((random_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void *&hostDeviceContext()
+{
+	while ((int)device_contexts.size() <= current_device)
+		device_contexts.push_back(nullptr);
+	return device_contexts[current_device];
+}
+
+int64_t esp_timer_get_time(void)
+{
+	return now_us;
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+	// one task at a time and no preemption inside: the lock only has to be counted
+	mux->count++;
+	critical_nesting++;
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+	mux->count--;
+	critical_nesting--;
+}
+
+BaseType_t xTaskCreateUniversal(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+								UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+	host_task *task = new host_task();
+	task->function = function;
+	task->parameters = parameters;
+	task->name = name ? name : "";
+	task->priority = priority < configMAX_PRIORITIES ? priority : configMAX_PRIORITIES - 1;
+	task->device = current_device;
+	task->stack = malloc(SIM_TASK_STACK_SIZE);
+	if (!task->stack)
+	{
+		delete task;
+		return pdFAIL;
+	}
+	getcontext(&task->context);
+	task->context.uc_stack.ss_sp = task->stack;
+	task->context.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+	task->context.uc_link = nullptr;
+	makecontext(&task->context, taskEntry, 0);
+
+	if (created_task)
+		*created_task = task;
+	makeReady(task);
+	preemptIfNeeded();
+	return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+								   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+	return xTaskCreateUniversal(function, name, stack_depth, parameters, priority, created_task, core_id);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+					   UBaseType_t priority, TaskHandle_t *created_task)
+{
+	return xTaskCreateUniversal(function, name, stack_depth, parameters, priority, created_task, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+	if (!task || task == current_task)
+	{
+		if (current_task)
+			throw task_deleted();
+		return;
+	}
+	if (task->state == TASK_FINISHED)
+		return;
+
+	if (task->state == TASK_READY)
+		unready(task);
+	forgetWait(task);
+	task->deleted = true;
+	if (task->started)
+	{
+		// switch to it right away so it unwinds now, as FreeRTOS would stop it now
+		host_task *caller_task = current_task;
+		int caller_device = current_device;
+		ucontext_t here;
+		task->resume_to = &here;
+		current_task = task;
+		current_device = task->device;
+		task->state = TASK_RUNNING;
+		swapcontext(&here, &task->context);
+		current_task = caller_task;
+		current_device = caller_device;
+	}
+	// handles stay valid, a timeout armed by the task finds it finished
+	task->state = TASK_FINISHED;
+	free(task->stack);
+	task->stack = nullptr;
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+	host_task *target = task ? task : current_task;
+	if (!target || target->state == TASK_FINISHED)
+		return;
+	target->suspend_requested = true;
+	if (target == current_task)
+		checkpoint(target);
+	else if (target->state == TASK_READY)
+	{
+		unready(target);
+		target->state = TASK_SUSPENDED;
+	}
+}
+
+void vTaskResume(TaskHandle_t task)
+{
+	if (!task)
+		return;
+	task->suspend_requested = false;
+	if (task->state == TASK_SUSPENDED)
+	{
+		makeReady(task);
+		preemptIfNeeded();
+	}
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	if (ticks == 0)
+	{
+		taskYIELD();
+		return;
+	}
+	waitFor(ticks, nullptr, false, []
+			{ return false; });
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)(now_us / (1000 * portTICK_PERIOD_MS));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return current_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+	task->notification++;
+	if (task->state == TASK_BLOCKED && task->waiting_notification)
+	{
+		makeReady(task);
+		preemptIfNeeded();
+	}
+	return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+	host_task *task = current_task;
+	if (!task || !waitFor(ticks_to_wait, nullptr, true, [task]
+						  { return task->notification > 0; }))
+		return 0;
+
+	uint32_t value = task->notification;
+	task->notification = clear_on_exit ? 0 : value - 1;
+	return value;
+}
+
+void taskYIELD(void)
+{
+	host_task *task = current_task;
+	if (!task)
+		return;
+	if (readyAbove(task->priority, true))
+	{
+		makeReady(task);
+		switchToScheduler();
+		return;
+	}
+	// nobody else to run: a task spinning on the clock lets a microsecond pass
+	block(task, nullptr, false, now_us + 1);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+	return createQueue(length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+	if (!queue)
+		return;
+	while (!queue->waiters.empty())
+		forgetWait(queue->waiters.front());
+	delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait, bool front)
+{
+	if (!waitFor(ticks_to_wait, queue, false, [queue]
+				 { return queue->count < queue->length; }))
+		return pdFALSE;
+
+	uint32_t position;
+	if (front)
+	{
+		queue->head = (queue->head + queue->length - 1) % queue->length;
+		position = queue->head;
+	}
+	else
+		position = (queue->head + queue->count) % queue->length;
+	if (queue->item_size && item)
+		memcpy(queue->storage.data() + (size_t)position * queue->item_size, item, queue->item_size);
+	queue->count++;
+	wakeWaiters(queue);
+	preemptIfNeeded();
+	return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	return queueSend(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	return queueSend(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	return queueSend(queue, item, ticks_to_wait, true);
+}
+
+static BaseType_t queueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait, bool remove)
+{
+	if (!waitFor(ticks_to_wait, queue, false, [queue]
+				 { return queue->count > 0; }))
+		return pdFALSE;
+
+	if (queue->item_size && item)
+		memcpy(item, queue->storage.data() + (size_t)queue->head * queue->item_size, queue->item_size);
+	if (remove)
+	{
+		queue->head = (queue->head + 1) % queue->length;
+		queue->count--;
+		wakeWaiters(queue);
+		preemptIfNeeded();
+	}
+	return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+	return queueReceive(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+	return queueReceive(queue, item, ticks_to_wait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+	return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+	return queue->length - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+	queue->head = 0;
+	queue->count = 0;
+	wakeWaiters(queue);
+	preemptIfNeeded();
+	return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return createQueue(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	return createQueue(1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+	return createQueue(max_count, 0, initial_count);
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+	return new host_event_group();
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+	if (!group)
+		return;
+	while (!group->object.waiters.empty())
+		forgetWait(group->object.waiters.front());
+	delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	group->bits |= bits;
+	EventBits_t value = group->bits;
+	wakeWaiters(&group->object);
+	preemptIfNeeded();
+	return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	EventBits_t before = group->bits;
+	group->bits &= ~bits;
+	return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+	return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit, BaseType_t wait_for_all,
+								TickType_t ticks_to_wait)
+{
+	bool set = waitFor(ticks_to_wait, &group->object, false, [group, bits, wait_for_all]
+					   { return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0; });
+	// the bits as they were when the wait ended, cleared afterwards only if it did not time out
+	EventBits_t value = group->bits;
+	if (set && clear_on_exit)
+		group->bits &= ~bits;
+	return value;
+}
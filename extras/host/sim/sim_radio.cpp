@@ -0,0 +1,746 @@
+#include "sim.h"
+#include "sim_internal.h"
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "WiFi.h"
+
+#include <string.h>
+#include <deque>
+#include <vector>
+
+/*
+ * ESP-NOW and WiFi of every simulated device, and the air between them. Each `esp_*` call acts on the device of the
+ * running task, the radio events run as the device they belong to.
+ */
+
+WiFiClass WiFi;
+
+namespace
+{
+	// ESP-NOW action frame as it sits in front of the payload, same layout as `espnow_frame_format_t`
+	typedef struct
+	{
+		uint8_t frame_control;
+		uint8_t flags;
+		uint16_t duration;
+		uint8_t destination_address[6];
+		uint8_t source_address[6];
+		uint8_t broadcast_address[6];
+		uint16_t sequence_control;
+		uint8_t category_code;
+		uint8_t organization_identifier[3];
+		uint8_t random_values[4];
+		uint8_t element_id;
+		uint8_t length;
+		uint8_t vendor_organization_identifier[3];
+		uint8_t type;
+		uint8_t version;
+	} __attribute__((packed)) sim_espnow_frame_t;
+
+	static_assert(sizeof(sim_espnow_frame_t) == 39, "Must match espnow_frame_format_t");
+
+	const uint8_t BROADCAST[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	const uint16_t AIR_OVERHEAD_LEN = 43; // MAC header, action and vendor headers, FCS
+	const uint16_t ACK_LEN = 14;
+
+	typedef struct
+	{
+		uint8_t destination[ESP_NOW_ETH_ALEN];
+		bool broadcast;
+		uint8_t len;
+		uint8_t data[ESP_NOW_MAX_DATA_LEN];
+		uint16_t sequence;
+		uint8_t retries;
+		int64_t queued_us;
+		int64_t started_us;
+	} sim_frame_t;
+
+	typedef struct
+	{
+		uint16_t loss_per_mille;
+		int8_t rssi;
+	} sim_link_t;
+
+	typedef struct
+	{
+		uint64_t id;
+		int sender;
+		int64_t start_us;
+		int64_t end_us;
+		int64_t reserved_until_us; // end of the ACK for unicast, the carrier others sense
+		bool collided;
+	} sim_transmission_t;
+
+	typedef struct
+	{
+		std::vector<sim_transmission_t> on_air;
+		int64_t accounted_until_us;
+		sim_channel_stats_t stats;
+	} sim_channel_t;
+
+	struct sim_device_t
+	{
+		uint8_t mac[ESP_NOW_ETH_ALEN];
+		wifi_mode_t wifi_mode = WIFI_MODE_NULL;
+		uint8_t channel = 1;
+		wifi_second_chan_t second = WIFI_SECOND_CHAN_NONE;
+		int64_t listening_from_us = 0; // end of the last channel switch
+
+		bool now_initialized = false;
+		esp_now_recv_cb_t recv_cb = nullptr;
+		esp_now_send_cb_t send_cb = nullptr;
+		esp_now_peer_info_t peers[ESP_NOW_MAX_TOTAL_PEER_NUM];
+		int peer_count = 0;
+
+		std::deque<sim_frame_t> radio; // the front one is contending or on the air
+		bool contending = false;
+		uint16_t cw = 0;
+		uint16_t next_sequence = 0;
+		uint64_t epoch = 0; // moves on `esp_now_deinit`, events of the frames dropped then find another one
+
+		sim_radio_stats_t stats = {};
+		EasyLatencyHistogram access_delay;
+		EasyLatencyHistogram send_to_complete;
+	};
+
+	std::deque<sim_device_t> devices;
+	std::vector<std::vector<sim_link_t>> links;
+	sim_channel_t channels[15];
+	uint64_t next_transmission = 0;
+
+	sim_device_t &self()
+	{
+		return devices[simCurrentDevice()];
+	}
+
+	int64_t now()
+	{
+		return esp_timer_get_time();
+	}
+
+	int64_t airtime(uint16_t len)
+	{
+		const sim_config_t &config = simConfig();
+		return config.preamble_us + ((int64_t)len * 8 * 1000 + config.bitrate_kbps - 1) / config.bitrate_kbps;
+	}
+
+	int64_t difs()
+	{
+		return simConfig().sifs_us + 2 * simConfig().slot_us;
+	}
+
+	int64_t backoff(uint16_t cw)
+	{
+		return difs() + (int64_t)(simRandom() % ((uint32_t)cw + 1)) * simConfig().slot_us;
+	}
+
+	bool lost(int from, int to)
+	{
+		uint16_t loss = links[from][to].loss_per_mille;
+		return loss && simRandom() % 1000 < loss;
+	}
+
+	void sourceMac(const sim_device_t &device, uint8_t mac[ESP_NOW_ETH_ALEN])
+	{
+		memcpy(mac, device.mac, ESP_NOW_ETH_ALEN);
+		// the soft-AP MAC follows the station one, as on the ESP32
+		if (device.wifi_mode == WIFI_MODE_AP)
+			mac[5]++;
+	}
+
+	int findDevice(const uint8_t *mac)
+	{
+		for (size_t i = 0; i < devices.size(); i++)
+		{
+			if (memcmp(devices[i].mac, mac, ESP_NOW_ETH_ALEN - 1) != 0)
+				continue;
+			if (devices[i].mac[5] == mac[5] || (uint8_t)(devices[i].mac[5] + 1) == mac[5])
+				return (int)i;
+		}
+		return -1;
+	}
+
+	int findPeer(const sim_device_t &device, const uint8_t *mac)
+	{
+		for (int i = 0; i < device.peer_count; i++)
+			if (memcmp(device.peers[i].peer_addr, mac, ESP_NOW_ETH_ALEN) == 0)
+				return i;
+		return -1;
+	}
+
+	void markBusy(sim_channel_t &channel, int64_t start_us, int64_t until_us)
+	{
+		int64_t from_us = start_us > channel.accounted_until_us ? start_us : channel.accounted_until_us;
+		if (until_us > from_us)
+			channel.stats.busy_us += until_us - from_us;
+		if (until_us > channel.accounted_until_us)
+			channel.accounted_until_us = until_us;
+	}
+
+	// forgets the transmissions whose carrier is gone
+	void prune(sim_channel_t &channel, int64_t at_us)
+	{
+		std::vector<sim_transmission_t> &on_air = channel.on_air;
+		for (size_t i = 0; i < on_air.size();)
+			if (on_air[i].reserved_until_us <= at_us)
+				on_air.erase(on_air.begin() + i);
+			else
+				i++;
+	}
+
+	// a transmission is sensed one slot after it started, until then starting too collides with it
+	bool sensedBusy(sim_channel_t &channel, int64_t at_us, int64_t &until_us)
+	{
+		bool busy = false;
+		for (const sim_transmission_t &transmission : channel.on_air)
+			if (transmission.start_us + simConfig().slot_us <= at_us)
+			{
+				busy = true;
+				if (transmission.reserved_until_us > until_us)
+					until_us = transmission.reserved_until_us;
+			}
+		return busy;
+	}
+
+	void tryToSend(int device_id, uint64_t epoch);
+
+	void scheduleAttempt(int device_id, int64_t at_us)
+	{
+		uint64_t epoch = devices[device_id].epoch;
+		simSchedule(at_us, device_id, [device_id, epoch]
+					{ tryToSend(device_id, epoch); });
+	}
+
+	void deliver(int receiver_id, int sender_id, const sim_frame_t &frame, uint8_t channel)
+	{
+		sim_device_t &receiver = devices[receiver_id];
+		receiver.stats.rx_frames++;
+
+		alignas(4) uint8_t buffer[sizeof(wifi_pkt_rx_ctrl_t) + sizeof(sim_espnow_frame_t) + ESP_NOW_MAX_DATA_LEN] = {};
+		wifi_pkt_rx_ctrl_t *rx_ctrl = (wifi_pkt_rx_ctrl_t *)buffer;
+		sim_espnow_frame_t *header = (sim_espnow_frame_t *)(buffer + sizeof(wifi_pkt_rx_ctrl_t));
+		uint8_t *payload = buffer + sizeof(wifi_pkt_rx_ctrl_t) + sizeof(sim_espnow_frame_t);
+		uint8_t source[ESP_NOW_ETH_ALEN];
+		sourceMac(devices[sender_id], source);
+
+		rx_ctrl->rssi = links[sender_id][receiver_id].rssi;
+		rx_ctrl->channel = channel;
+		rx_ctrl->noise_floor = -95;
+		rx_ctrl->timestamp = (uint32_t)now();
+		rx_ctrl->sig_len = sizeof(sim_espnow_frame_t) + frame.len + 4;
+		header->frame_control = 0xD0; // management, action
+		memcpy(header->destination_address, frame.destination, ESP_NOW_ETH_ALEN);
+		memcpy(header->source_address, source, ESP_NOW_ETH_ALEN);
+		memcpy(header->broadcast_address, BROADCAST, ESP_NOW_ETH_ALEN);
+		header->sequence_control = frame.sequence << 4;
+		header->category_code = 127;
+		header->organization_identifier[0] = header->vendor_organization_identifier[0] = 0x18;
+		header->organization_identifier[1] = header->vendor_organization_identifier[1] = 0xFE;
+		header->organization_identifier[2] = header->vendor_organization_identifier[2] = 0x34;
+		header->element_id = 0xDD;
+		header->length = frame.len + 5;
+		header->type = 4;
+		header->version = 1;
+		memcpy(payload, frame.data, frame.len);
+
+		if (receiver.recv_cb)
+			receiver.recv_cb(source, payload, frame.len);
+	}
+
+	// the receiver hears a frame if it listened on its channel the whole time, and it neither collided nor got lost
+	bool receive(int receiver_id, int sender_id, const sim_frame_t &frame, const sim_transmission_t &transmission, uint8_t channel)
+	{
+		sim_device_t &receiver = devices[receiver_id];
+		sim_device_t &sender = devices[sender_id];
+		if (!receiver.now_initialized || receiver.channel != channel || receiver.listening_from_us > transmission.start_us)
+		{
+			if (!frame.broadcast)
+				sender.stats.off_channel++;
+			return false;
+		}
+		if (transmission.collided)
+		{
+			receiver.stats.rx_collided++;
+			return false;
+		}
+		if (lost(sender_id, receiver_id))
+		{
+			receiver.stats.rx_lost++;
+			if (!frame.broadcast)
+				sender.stats.link_losses++;
+			return false;
+		}
+
+		// `rx_cb` runs as the receiver
+		sim_frame_t copy = frame;
+		simSchedule(now(), receiver_id, [receiver_id, sender_id, copy, channel]
+					{ deliver(receiver_id, sender_id, copy, channel); });
+		return true;
+	}
+
+	void complete(int device_id, uint64_t epoch, esp_now_send_status_t status)
+	{
+		sim_device_t &device = devices[device_id];
+		if (device.epoch != epoch || device.radio.empty())
+			return;
+
+		sim_frame_t frame = device.radio.front();
+		device.radio.pop_front();
+		device.access_delay.record((uint32_t)(frame.started_us - frame.queued_us));
+		device.send_to_complete.record((uint32_t)(now() - frame.queued_us));
+		if (status == ESP_NOW_SEND_SUCCESS)
+			device.stats.tx_delivered++;
+		else
+			device.stats.tx_failed++;
+
+		device.cw = simConfig().cw_min;
+		if (device.radio.empty())
+			device.contending = false;
+		else
+			scheduleAttempt(device_id, now() + backoff(device.cw));
+
+		if (device.send_cb)
+			device.send_cb(frame.destination, status);
+	}
+
+	void endTransmission(int device_id, uint64_t epoch, uint8_t channel_number, uint64_t transmission_id)
+	{
+		sim_device_t &device = devices[device_id];
+		sim_channel_t &channel = channels[channel_number];
+		sim_transmission_t transmission = {};
+		for (const sim_transmission_t &candidate : channel.on_air)
+			if (candidate.id == transmission_id)
+				transmission = candidate;
+		if (device.epoch != epoch || device.radio.empty())
+			return;
+
+		sim_frame_t &frame = device.radio.front();
+		int64_t done_us = transmission.reserved_until_us;
+		if (frame.broadcast)
+		{
+			for (size_t i = 0; i < devices.size(); i++)
+				if ((int)i != device_id)
+					receive((int)i, device_id, frame, transmission, channel_number);
+			simSchedule(done_us, device_id, [device_id, epoch]
+						{ complete(device_id, epoch, ESP_NOW_SEND_SUCCESS); });
+			return;
+		}
+
+		int destination_id = findDevice(frame.destination);
+		bool delivered = false;
+		if (destination_id < 0)
+			device.stats.no_destination++;
+		else
+			delivered = receive(destination_id, device_id, frame, transmission, channel_number);
+
+		bool acknowledged = delivered && !lost(destination_id, device_id);
+		if (delivered && !acknowledged)
+			device.stats.ack_losses++;
+
+		if (acknowledged)
+			simSchedule(done_us, device_id, [device_id, epoch]
+						{ complete(device_id, epoch, ESP_NOW_SEND_SUCCESS); });
+		else if (frame.retries >= simConfig().retry_limit)
+			simSchedule(done_us, device_id, [device_id, epoch]
+						{ complete(device_id, epoch, ESP_NOW_SEND_FAIL); });
+		else
+		{
+			// no ACK by the end of the ACK timeout: retry with a doubled contention window
+			frame.retries++;
+			device.cw = (uint16_t)(device.cw * 2 + 1) > simConfig().cw_max ? simConfig().cw_max : device.cw * 2 + 1;
+			scheduleAttempt(device_id, done_us + backoff(device.cw));
+		}
+	}
+
+	void tryToSend(int device_id, uint64_t epoch)
+	{
+		sim_device_t &device = devices[device_id];
+		if (device.epoch != epoch || device.radio.empty())
+			return;
+
+		int64_t at_us = now();
+		if (device.listening_from_us > at_us)
+		{
+			scheduleAttempt(device_id, device.listening_from_us + backoff(device.cw));
+			return;
+		}
+
+		uint8_t channel_number = device.channel;
+		sim_channel_t &channel = channels[channel_number];
+		prune(channel, at_us);
+		int64_t busy_until_us = 0;
+		if (sensedBusy(channel, at_us, busy_until_us))
+		{
+			scheduleAttempt(device_id, busy_until_us + backoff(device.cw));
+			return;
+		}
+
+		sim_frame_t &frame = device.radio.front();
+		const sim_config_t &config = simConfig();
+		sim_transmission_t transmission;
+		transmission.id = next_transmission++;
+		transmission.sender = device_id;
+		transmission.start_us = at_us;
+		transmission.end_us = at_us + airtime(frame.len + AIR_OVERHEAD_LEN);
+		transmission.reserved_until_us = frame.broadcast ? transmission.end_us : transmission.end_us + config.sifs_us + airtime(ACK_LEN);
+		transmission.collided = false;
+
+		// whatever is on the air and was not sensed yet collides with this one
+		for (sim_transmission_t &other : channel.on_air)
+			if (other.end_us > at_us)
+			{
+				if (!other.collided)
+				{
+					other.collided = true;
+					devices[other.sender].stats.collisions++;
+					channel.stats.collisions++;
+				}
+				if (!transmission.collided)
+				{
+					transmission.collided = true;
+					device.stats.collisions++;
+					channel.stats.collisions++;
+				}
+			}
+
+		channel.on_air.push_back(transmission);
+		channel.stats.attempts++;
+		markBusy(channel, transmission.start_us, transmission.reserved_until_us);
+		device.stats.tx_attempts++;
+		frame.started_us = at_us;
+
+		uint64_t transmission_id = transmission.id;
+		simSchedule(transmission.end_us, device_id, [device_id, epoch, channel_number, transmission_id]
+					{ endTransmission(device_id, epoch, channel_number, transmission_id); });
+	}
+
+	void queueFrame(sim_device_t &device, const uint8_t *destination, const uint8_t *data, size_t len)
+	{
+		sim_frame_t frame;
+		memcpy(frame.destination, destination, ESP_NOW_ETH_ALEN);
+		frame.broadcast = memcmp(destination, BROADCAST, ESP_NOW_ETH_ALEN) == 0;
+		frame.len = (uint8_t)len;
+		memcpy(frame.data, data, len);
+		frame.sequence = device.next_sequence++ & 0x0FFF;
+		frame.retries = 0;
+		frame.queued_us = now();
+		frame.started_us = frame.queued_us;
+		device.radio.push_back(frame);
+		device.stats.tx_frames++;
+	}
+}
+
+void simRadioBegin()
+{
+	devices.clear();
+	links.clear();
+	for (sim_channel_t &channel : channels)
+		channel = {};
+	next_transmission = 0;
+}
+
+int simAddDevice()
+{
+	int id = (int)devices.size();
+	devices.emplace_back();
+	sim_device_t &device = devices.back();
+	// even station MACs, the soft-AP one is the next odd MAC
+	const uint8_t mac[ESP_NOW_ETH_ALEN] = {0x24, 0x6F, 0x28, 0x5E, (uint8_t)((id * 2) >> 8), (uint8_t)(id * 2)};
+	memcpy(device.mac, mac, ESP_NOW_ETH_ALEN);
+	device.cw = simConfig().cw_min;
+
+	sim_link_t link = {simConfig().loss_per_mille, simConfig().rssi};
+	for (std::vector<sim_link_t> &row : links)
+		row.push_back(link);
+	links.emplace_back(devices.size(), link);
+	return id;
+}
+
+int simDeviceCount()
+{
+	return (int)devices.size();
+}
+
+void simDeviceMac(int device, uint8_t mac[6])
+{
+	memcpy(mac, devices[device].mac, ESP_NOW_ETH_ALEN);
+}
+
+void simSetLink(int from, int to, uint16_t loss_per_mille, int8_t rssi)
+{
+	links[from][to] = {loss_per_mille, rssi};
+}
+
+sim_radio_stats_t simRadioStats(int device_id)
+{
+	sim_device_t &device = devices[device_id];
+	sim_radio_stats_t stats = device.stats;
+	stats.access_delay = device.access_delay.snapshot();
+	stats.send_to_complete = device.send_to_complete.snapshot();
+	return stats;
+}
+
+sim_channel_stats_t simChannelStats(uint8_t channel)
+{
+	return channel >= 1 && channel <= 14 ? channels[channel].stats : sim_channel_stats_t{};
+}
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode)
+{
+	if (self().wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	*mode = self().wifi_mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+	if (mode >= WIFI_MODE_MAX)
+		return ESP_ERR_INVALID_ARG;
+	self().wifi_mode = mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+	if (self().wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	*primary = self().channel;
+	*second = self().second;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+	if (primary < 1 || primary > 14)
+		return ESP_ERR_INVALID_ARG;
+	sim_device_t &device = self();
+	if (device.wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	if (device.channel != primary)
+	{
+		// deaf and mute while the PLL settles
+		device.channel = primary;
+		device.listening_from_us = now() + simConfig().channel_switch_us;
+		device.stats.channel_switches++;
+	}
+	device.second = second;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+	memcpy(mac, self().mac, ESP_NOW_ETH_ALEN);
+	if (ifx == WIFI_IF_AP)
+		mac[5]++;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_init(void)
+{
+	sim_device_t &device = self();
+	if (device.wifi_mode == WIFI_MODE_NULL)
+		return ESP_ERR_WIFI_NOT_INIT;
+	if (device.now_initialized)
+		return ESP_OK;
+	device.now_initialized = true;
+	device.peer_count = 0;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_OK;
+	// frames still in the radio are dropped without a `tx_cb`
+	device.now_initialized = false;
+	device.recv_cb = nullptr;
+	device.send_cb = nullptr;
+	device.radio.clear();
+	device.contending = false;
+	device.cw = simConfig().cw_min;
+	device.epoch++;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_get_version(uint32_t *version)
+{
+	if (!version)
+		return ESP_ERR_ESPNOW_ARG;
+	*version = 1;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+	if (!self().now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	self().recv_cb = cb;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void)
+{
+	if (!self().now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	self().recv_cb = nullptr;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+	if (!self().now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	self().send_cb = cb;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_send_cb(void)
+{
+	if (!self().now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	self().send_cb = nullptr;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	if (!data || len == 0 || len > ESP_NOW_MAX_DATA_LEN)
+		return ESP_ERR_ESPNOW_ARG;
+
+	// `NULL` sends to every unicast peer
+	int destinations = 0;
+	if (peer_addr)
+	{
+		int index = findPeer(device, peer_addr);
+		if (index < 0)
+			return ESP_ERR_ESPNOW_NOT_FOUND;
+		// a peer pinned to a channel can only be reached from that channel
+		if (device.peers[index].channel != 0 && device.peers[index].channel != device.channel)
+		{
+			device.stats.chan_errors++;
+			return ESP_ERR_ESPNOW_CHAN;
+		}
+		destinations = 1;
+	}
+	else
+	{
+		for (int i = 0; i < device.peer_count; i++)
+			if (memcmp(device.peers[i].peer_addr, BROADCAST, ESP_NOW_ETH_ALEN) != 0)
+				destinations++;
+		if (destinations == 0)
+			return ESP_ERR_ESPNOW_NOT_FOUND;
+	}
+
+	uint16_t max_pending = simConfig().max_pending;
+	if (max_pending && device.radio.size() + destinations > max_pending)
+	{
+		device.stats.no_mem++;
+		return ESP_ERR_ESPNOW_NO_MEM;
+	}
+
+	if (peer_addr)
+		queueFrame(device, peer_addr, data, len);
+	else
+		for (int i = 0; i < device.peer_count; i++)
+			if (memcmp(device.peers[i].peer_addr, BROADCAST, ESP_NOW_ETH_ALEN) != 0)
+				queueFrame(device, device.peers[i].peer_addr, data, len);
+
+	if (!device.contending)
+	{
+		device.contending = true;
+		scheduleAttempt(simCurrentDevice(), now() + backoff(device.cw));
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+	if (!peer)
+		return ESP_ERR_ESPNOW_ARG;
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	if (peer->channel > 14)
+		return ESP_ERR_ESPNOW_CHAN;
+	if (findPeer(device, peer->peer_addr) >= 0)
+		return ESP_ERR_ESPNOW_EXIST;
+	if (device.peer_count >= ESP_NOW_MAX_TOTAL_PEER_NUM)
+		return ESP_ERR_ESPNOW_FULL;
+	if (peer->encrypt)
+	{
+		int encrypted = 0;
+		for (int i = 0; i < device.peer_count; i++)
+			encrypted += device.peers[i].encrypt;
+		if (encrypted >= ESP_NOW_MAX_ENCRYPT_PEER_NUM)
+			return ESP_ERR_ESPNOW_FULL;
+	}
+	device.peers[device.peer_count++] = *peer;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+	if (!peer_addr)
+		return ESP_ERR_ESPNOW_ARG;
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	int index = findPeer(device, peer_addr);
+	if (index < 0)
+		return ESP_ERR_ESPNOW_NOT_FOUND;
+	device.peers[index] = device.peers[--device.peer_count];
+	return ESP_OK;
+}
+
+esp_err_t esp_now_mod_peer(const esp_now_peer_info_t *peer)
+{
+	if (!peer)
+		return ESP_ERR_ESPNOW_ARG;
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	int index = findPeer(device, peer->peer_addr);
+	if (index < 0)
+		return ESP_ERR_ESPNOW_NOT_FOUND;
+	device.peers[index] = *peer;
+	return ESP_OK;
+}
+
+esp_err_t esp_now_get_peer(const uint8_t *peer_addr, esp_now_peer_info_t *peer)
+{
+	if (!peer_addr || !peer)
+		return ESP_ERR_ESPNOW_ARG;
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	int index = findPeer(device, peer_addr);
+	if (index < 0)
+		return ESP_ERR_ESPNOW_NOT_FOUND;
+	*peer = device.peers[index];
+	return ESP_OK;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr)
+{
+	return self().now_initialized && peer_addr && findPeer(self(), peer_addr) >= 0;
+}
+
+esp_err_t esp_now_get_peer_num(esp_now_peer_num_t *num)
+{
+	if (!num)
+		return ESP_ERR_ESPNOW_ARG;
+	sim_device_t &device = self();
+	if (!device.now_initialized)
+		return ESP_ERR_ESPNOW_NOT_INIT;
+	num->total_num = device.peer_count;
+	num->encrypt_num = 0;
+	for (int i = 0; i < device.peer_count; i++)
+		num->encrypt_num += device.peers[i].encrypt;
+	return ESP_OK;
+}
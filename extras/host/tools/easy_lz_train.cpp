@@ -0,0 +1,275 @@
+// Trains a pre-shared compression dictionary for `setCompressionDictionary(...)` from captured traffic.
+//
+//   easy_lz_train [options] capture...
+//
+//   --hex        every line of a capture is one frame in hex ("7b 22 74" or "7b2274"), as printed from `onDataReceived`
+//                by a sniffer node. Without it every line is one frame of text, JSON lines for instance
+//   --size=N     dictionary length, up to 512 bytes (default 512)
+//   --segment=N  length of the pieces the dictionary is assembled from (default 24)
+//   --name=NAME  name of the array in the generated header (default easy_dictionary)
+//
+// The header goes to the standard output, a report on the standard error: frames, compression ratio and encode and decode
+// time per frame without and with the dictionary, measured with the same `EasyLz` the library runs.
+//
+// The dictionary is built the way COVER builds them for zstd: every 6 bytes sequence is scored by the number of frames it
+// appears in, and the segments covering the most frequent sequences are taken greedily, a sequence counting once.
+// The first segment taken ends the dictionary, so the most useful bytes are the closest to the frames.
+
+#include <easy_lz.h>
+#include <easy_frame.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static const size_t KMER = 6;
+static const size_t MAX_FRAME = 250;
+
+typedef std::vector<uint8_t> Bytes;
+
+static uint64_t kmerAt(const Bytes &frame, size_t i)
+{
+	uint64_t key = 0;
+	for (size_t k = 0; k < KMER; k++)
+		key = (key << 8) | frame[i + k];
+	return key;
+}
+
+static bool parseHex(const std::string &line, Bytes &frame)
+{
+	int high = -1;
+	for (char c : line)
+	{
+		int v;
+		if (c >= '0' && c <= '9')
+			v = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			v = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			v = c - 'A' + 10;
+		else if (c == ' ' || c == ':' || c == ',' || c == '\t' || c == '\r')
+			continue;
+		else
+			return false;
+		if (high < 0)
+			high = v;
+		else
+		{
+			frame.push_back((uint8_t)(high << 4 | v));
+			high = -1;
+		}
+	}
+	return high < 0;
+}
+
+static Bytes train(const std::vector<Bytes> &frames, size_t size, size_t segment)
+{
+	// weight of a sequence: the frames it appears in, a sequence seen in one frame only is no use to the others
+	std::unordered_map<uint64_t, uint32_t> weight;
+	for (const Bytes &frame : frames)
+	{
+		std::unordered_set<uint64_t> seen;
+		for (size_t i = 0; i + KMER <= frame.size(); i++)
+			if (seen.insert(kmerAt(frame, i)).second)
+				weight[kmerAt(frame, i)]++;
+	}
+	for (auto &entry : weight)
+		if (entry.second < 2)
+			entry.second = 0;
+
+	std::vector<Bytes> taken;
+	size_t total = 0;
+	while (total < size)
+	{
+		size_t len = segment < size - total ? segment : size - total;
+		if (len < KMER)
+			break;
+
+		// sliding sum of the weights of the sequences starting in each window of `len` bytes
+		uint64_t best = 0;
+		const Bytes *best_frame = nullptr;
+		size_t best_at = 0;
+		for (const Bytes &frame : frames)
+		{
+			if (frame.size() < len)
+				continue;
+			uint64_t sum = 0;
+			for (size_t i = 0; i + KMER <= frame.size(); i++)
+			{
+				sum += weight[kmerAt(frame, i)];
+				if (i >= len - KMER + 1)
+					sum -= weight[kmerAt(frame, i - (len - KMER + 1))];
+				if (i + 1 >= len - KMER + 1 && sum > best)
+				{
+					best = sum;
+					best_frame = &frame;
+					best_at = i + KMER - len;
+				}
+			}
+		}
+		if (!best_frame)
+			break;
+
+		Bytes piece(best_frame->begin() + best_at, best_frame->begin() + best_at + len);
+		for (size_t i = 0; i + KMER <= piece.size(); i++)
+			weight[kmerAt(piece, i)] = 0;
+		taken.push_back(piece);
+		total += len;
+	}
+
+	Bytes dictionary;
+	for (auto it = taken.rbegin(); it != taken.rend(); ++it)
+		dictionary.insert(dictionary.end(), it->begin(), it->end());
+	return dictionary;
+}
+
+struct Evaluation
+{
+	size_t bytes_in = 0;
+	size_t bytes_out = 0;
+	size_t compressed = 0;
+	double encode_ns = 0;
+	double decode_ns = 0;
+};
+
+// same policy as the TX task: a frame goes compressed only if that makes it shorter, headers counted
+static Evaluation evaluate(const std::vector<Bytes> &frames, const EasyLz::Dictionary *dictionary)
+{
+	static EasyLz lz;
+	Evaluation result;
+	uint8_t stream[MAX_FRAME];
+	uint8_t inflated[MAX_FRAME];
+	const int rounds = 20;
+
+	for (const Bytes &frame : frames)
+	{
+		size_t room = frame.size() > EASY_COMPRESSED_OVERHEAD + 1 ? frame.size() - EASY_COMPRESSED_OVERHEAD - 1 : 0;
+		size_t len = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; r++)
+			len = room ? lz.compress(dictionary, frame.data(), frame.size(), stream, room) : 0;
+		result.encode_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+		result.bytes_in += frame.size();
+		if (len == 0)
+		{
+			result.bytes_out += frame.size();
+			continue;
+		}
+		result.bytes_out += len + EASY_COMPRESSED_OVERHEAD;
+		result.compressed++;
+
+		int out = 0;
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; r++)
+			out = EasyLz::decompress(dictionary, stream, len, inflated, sizeof(inflated));
+		result.decode_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+		if (out != (int)frame.size() || memcmp(inflated, frame.data(), frame.size()) != 0)
+		{
+			fprintf(stderr, "round trip failed on a frame of %zu bytes\n", frame.size());
+			exit(1);
+		}
+	}
+	return result;
+}
+
+static void report(const char *label, const Evaluation &e, size_t frames)
+{
+	fprintf(stderr, "%-16s ratio %.2f  compressed %zu/%zu  encode %.0f ns/frame  decode %.0f ns/frame\n", label,
+			e.bytes_out ? (double)e.bytes_in / e.bytes_out : 0.0, e.compressed, frames, frames ? e.encode_ns / frames : 0.0,
+			e.compressed ? e.decode_ns / e.compressed : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+	bool hex = false;
+	size_t size = EasyLz::MAX_DICTIONARY_LEN;
+	size_t segment = 24;
+	std::string name = "easy_dictionary";
+	std::vector<std::string> captures;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--hex")
+			hex = true;
+		else if (arg.rfind("--size=", 0) == 0)
+			size = strtoul(arg.c_str() + 7, nullptr, 10);
+		else if (arg.rfind("--segment=", 0) == 0)
+			segment = strtoul(arg.c_str() + 10, nullptr, 10);
+		else if (arg.rfind("--name=", 0) == 0)
+			name = arg.substr(7);
+		else if (arg.rfind("--", 0) == 0)
+		{
+			fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return 2;
+		}
+		else
+			captures.push_back(arg);
+	}
+	if (captures.empty() || size < KMER || size > EasyLz::MAX_DICTIONARY_LEN || segment < KMER)
+	{
+		fprintf(stderr, "usage: easy_lz_train [--hex] [--size=%d] [--segment=24] [--name=NAME] capture...\n", EasyLz::MAX_DICTIONARY_LEN);
+		return 2;
+	}
+
+	std::vector<Bytes> frames;
+	for (const std::string &path : captures)
+	{
+		std::ifstream in(path);
+		if (!in)
+		{
+			fprintf(stderr, "can not open %s\n", path.c_str());
+			return 1;
+		}
+		std::string line;
+		size_t number = 0;
+		while (std::getline(in, line))
+		{
+			number++;
+			Bytes frame;
+			if (hex)
+			{
+				if (!parseHex(line, frame))
+				{
+					fprintf(stderr, "%s:%zu: not a hex frame, skipped\n", path.c_str(), number);
+					continue;
+				}
+			}
+			else
+				frame.assign(line.begin(), line.end());
+			if (frame.empty())
+				continue;
+			if (frame.size() > MAX_FRAME)
+				frame.resize(MAX_FRAME);
+			frames.push_back(frame);
+		}
+	}
+	if (frames.empty())
+	{
+		fprintf(stderr, "no frames in the captures\n");
+		return 1;
+	}
+
+	Bytes dictionary = train(frames, size, segment);
+
+	static EasyLz::Dictionary indexed;
+	indexed.set(dictionary.data(), (uint16_t)dictionary.size());
+	fprintf(stderr, "%zu frames, dictionary of %zu bytes\n", frames.size(), dictionary.size());
+	report("no dictionary", evaluate(frames, nullptr), frames.size());
+	report("dictionary", evaluate(frames, &indexed), frames.size());
+
+	printf("// Trained by easy_lz_train on %zu frames. Register the same bytes on every node:\n", frames.size());
+	printf("//   easyEspNow.setCompressionDictionary(1, %s, sizeof(%s));\n", name.c_str(), name.c_str());
+	printf("static const uint8_t %s[%zu] = {", name.c_str(), dictionary.size());
+	for (size_t i = 0; i < dictionary.size(); i++)
+		printf("%s0x%02x%s", i % 16 ? " " : "\n\t", dictionary[i], i + 1 < dictionary.size() ? "," : "");
+	printf("\n};\n");
+	return 0;
+}
@@ -3,7 +3,7 @@
 #ifndef MESH_NOW_ESP_H
 #define MESH_NOW_ESP_H
 
-#if defined ESP32
+#if defined(ESP32) || defined(EASY_ESP_NOW_HOST)
 #include "easy_esp_now.h"
 #else
 #error "Unsupported Platform"
@@ -1,9 +1,11 @@
 #ifndef COMMS_HAL_INTERFACE_H
 #define COMMS_HAL_INTERFACE_H
-#ifdef ESP32
+#if defined(ESP32) || defined(EASY_ESP_NOW_HOST)
 
 #include <esp_wifi.h>
 
+#include "easy_callback.h"
+
 /*
 typedef enum {
     WIFI_MODE_NULL = 0,  // null mode
@@ -52,8 +54,9 @@ typedef struct
     espnow_frame_format_t *esp_now_frame;
 } espnow_frame_recv_info_t;
 
-typedef std::function<void(const uint8_t *src_mac, const uint8_t *data, int data_len, espnow_frame_recv_info_t *esp_now_frame)> frame_rcvd_data;
-typedef std::function<void(const uint8_t *dst_addr, uint8_t status)> frame_sent_data;
+// stored in place, see `EasyCallback`: a function, a lambda capturing up to `EASY_CALLBACK_CAPACITY` bytes, or a function with a context
+typedef EasyCallback<void(const uint8_t *src_mac, const uint8_t *data, int data_len, espnow_frame_recv_info_t *esp_now_frame)> frame_rcvd_data;
+typedef EasyCallback<void(const uint8_t *dst_addr, uint8_t status)> frame_sent_data;
 
 typedef enum
 {
@@ -0,0 +1,241 @@
+#include <string.h>
+
+#include "easy_aead.h"
+
+static inline uint32_t load32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t rotl32(uint32_t v, int n)
+{
+	return (v << n) | (v >> (32 - n));
+}
+
+#define CHACHA_QUARTER(a, b, c, d) \
+	a += b;                        \
+	d = rotl32(d ^ a, 16);         \
+	c += d;                        \
+	b = rotl32(b ^ c, 12);         \
+	a += b;                        \
+	d = rotl32(d ^ a, 8);          \
+	c += d;                        \
+	b = rotl32(b ^ c, 7);
+
+/**
+ * Poly1305 with 26 bits limbs, so every product fits in 64 bits on a 32 bits CPU
+ */
+class Poly1305
+{
+public:
+	explicit Poly1305(const uint8_t key[32])
+	{
+		r[0] = load32(key + 0) & 0x3ffffff;
+		r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+		r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+		r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+		r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+		for (int i = 0; i < 4; i++)
+			pad[i] = load32(key + 16 + i * 4);
+	}
+
+	/**
+	 * @brief Absorbs `len` bytes, the last partial block padded with zeros as AEAD wants it
+	 */
+	void update(const uint8_t *data, size_t len)
+	{
+		while (len >= 16)
+		{
+			blockOf(data);
+			data += 16;
+			len -= 16;
+		}
+		if (len)
+		{
+			uint8_t last[16] = {0};
+			memcpy(last, data, len);
+			blockOf(last);
+		}
+	}
+
+	void finish(uint8_t tag[16])
+	{
+		uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+		uint32_t c;
+		c = h1 >> 26; h1 &= 0x3ffffff; h2 += c;
+		c = h2 >> 26; h2 &= 0x3ffffff; h3 += c;
+		c = h3 >> 26; h3 &= 0x3ffffff; h4 += c;
+		c = h4 >> 26; h4 &= 0x3ffffff; h0 += c * 5;
+		c = h0 >> 26; h0 &= 0x3ffffff; h1 += c;
+
+		// h - p, kept only if it did not go negative, without branching on the value
+		uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+		uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+		uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+		uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+		uint32_t g4 = h4 + c - (1UL << 26);
+		uint32_t mask = (g4 >> 31) - 1;
+		h0 = (h0 & ~mask) | (g0 & mask);
+		h1 = (h1 & ~mask) | (g1 & mask);
+		h2 = (h2 & ~mask) | (g2 & mask);
+		h3 = (h3 & ~mask) | (g3 & mask);
+		h4 = (h4 & ~mask) | (g4 & mask);
+
+		h0 = h0 | (h1 << 26);
+		h1 = (h1 >> 6) | (h2 << 20);
+		h2 = (h2 >> 12) | (h3 << 14);
+		h3 = (h3 >> 18) | (h4 << 8);
+
+		uint64_t f;
+		f = (uint64_t)h0 + pad[0]; store32(tag + 0, (uint32_t)f);
+		f = (uint64_t)h1 + pad[1] + (f >> 32); store32(tag + 4, (uint32_t)f);
+		f = (uint64_t)h2 + pad[2] + (f >> 32); store32(tag + 8, (uint32_t)f);
+		f = (uint64_t)h3 + pad[3] + (f >> 32); store32(tag + 12, (uint32_t)f);
+	}
+
+private:
+	uint32_t r[5];
+	uint32_t h[5] = {0, 0, 0, 0, 0};
+	uint32_t pad[4];
+
+	void blockOf(const uint8_t *m)
+	{
+		const uint32_t s1 = r[1] * 5, s2 = r[2] * 5, s3 = r[3] * 5, s4 = r[4] * 5;
+		uint32_t h0 = h[0] + (load32(m + 0) & 0x3ffffff);
+		uint32_t h1 = h[1] + ((load32(m + 3) >> 2) & 0x3ffffff);
+		uint32_t h2 = h[2] + ((load32(m + 6) >> 4) & 0x3ffffff);
+		uint32_t h3 = h[3] + ((load32(m + 9) >> 6) & 0x3ffffff);
+		uint32_t h4 = h[4] + ((load32(m + 12) >> 8) | (1UL << 24));
+
+		uint64_t d0 = (uint64_t)h0 * r[0] + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+		uint64_t d1 = (uint64_t)h0 * r[1] + (uint64_t)h1 * r[0] + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+		uint64_t d2 = (uint64_t)h0 * r[2] + (uint64_t)h1 * r[1] + (uint64_t)h2 * r[0] + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+		uint64_t d3 = (uint64_t)h0 * r[3] + (uint64_t)h1 * r[2] + (uint64_t)h2 * r[1] + (uint64_t)h3 * r[0] + (uint64_t)h4 * s4;
+		uint64_t d4 = (uint64_t)h0 * r[4] + (uint64_t)h1 * r[3] + (uint64_t)h2 * r[2] + (uint64_t)h3 * r[1] + (uint64_t)h4 * r[0];
+
+		uint32_t c;
+		c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3ffffff;
+		d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3ffffff;
+		d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3ffffff;
+		d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3ffffff;
+		d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3ffffff;
+		h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+		h1 += c;
+
+		h[0] = h0;
+		h[1] = h1;
+		h[2] = h2;
+		h[3] = h3;
+		h[4] = h4;
+	}
+};
+
+void EasyAead::setKey(const uint8_t key[KEY_LEN])
+{
+	// "expand 32-byte k"
+	schedule[0] = 0x61707865;
+	schedule[1] = 0x3320646e;
+	schedule[2] = 0x79622d32;
+	schedule[3] = 0x6b206574;
+	for (int i = 0; i < 8; i++)
+		schedule[4 + i] = load32(key + i * 4);
+	for (int i = 12; i < 16; i++)
+		schedule[i] = 0;
+}
+
+void EasyAead::clear()
+{
+	volatile uint32_t *words = schedule;
+	for (int i = 0; i < 16; i++)
+		words[i] = 0;
+}
+
+void EasyAead::block(uint32_t counter, const uint8_t nonce[NONCE_LEN], uint8_t out[64]) const
+{
+	uint32_t x[16];
+	memcpy(x, schedule, sizeof(x));
+	x[12] = counter;
+	x[13] = load32(nonce + 0);
+	x[14] = load32(nonce + 4);
+	x[15] = load32(nonce + 8);
+
+	uint32_t w[16];
+	memcpy(w, x, sizeof(w));
+	for (int i = 0; i < 10; i++)
+	{
+		CHACHA_QUARTER(w[0], w[4], w[8], w[12])
+		CHACHA_QUARTER(w[1], w[5], w[9], w[13])
+		CHACHA_QUARTER(w[2], w[6], w[10], w[14])
+		CHACHA_QUARTER(w[3], w[7], w[11], w[15])
+		CHACHA_QUARTER(w[0], w[5], w[10], w[15])
+		CHACHA_QUARTER(w[1], w[6], w[11], w[12])
+		CHACHA_QUARTER(w[2], w[7], w[8], w[13])
+		CHACHA_QUARTER(w[3], w[4], w[9], w[14])
+	}
+	for (int i = 0; i < 16; i++)
+		store32(out + i * 4, w[i] + x[i]);
+}
+
+void EasyAead::xorStream(const uint8_t nonce[NONCE_LEN], const uint8_t *in, uint8_t *out, size_t len) const
+{
+	// block 0 keys Poly1305, the message starts at block 1
+	uint8_t stream[64];
+	uint32_t counter = 1;
+	while (len)
+	{
+		block(counter++, nonce, stream);
+		size_t n = len < sizeof(stream) ? len : sizeof(stream);
+		for (size_t i = 0; i < n; i++)
+			out[i] = in[i] ^ stream[i];
+		in += n;
+		out += n;
+		len -= n;
+	}
+}
+
+void EasyAead::computeTag(const uint8_t nonce[NONCE_LEN], const uint8_t *aad, size_t aad_len, const uint8_t *cipher, size_t len, uint8_t tag[TAG_LEN]) const
+{
+	uint8_t poly_key[64];
+	block(0, nonce, poly_key);
+	Poly1305 poly(poly_key);
+	poly.update(aad, aad_len);
+	poly.update(cipher, len);
+
+	uint8_t lengths[16];
+	store32(lengths + 0, (uint32_t)aad_len);
+	store32(lengths + 4, 0);
+	store32(lengths + 8, (uint32_t)len);
+	store32(lengths + 12, 0);
+	poly.update(lengths, sizeof(lengths));
+	poly.finish(tag);
+}
+
+void EasyAead::seal(const uint8_t nonce[NONCE_LEN], const uint8_t *aad, size_t aad_len, uint8_t *data, size_t len, uint8_t tag[TAG_LEN]) const
+{
+	xorStream(nonce, data, data, len);
+	computeTag(nonce, aad, aad_len, data, len, tag);
+}
+
+bool EasyAead::open(const uint8_t nonce[NONCE_LEN], const uint8_t *aad, size_t aad_len, const uint8_t *in, uint8_t *out, size_t len, const uint8_t tag[TAG_LEN]) const
+{
+	uint8_t expected[TAG_LEN];
+	computeTag(nonce, aad, aad_len, in, len, expected);
+
+	// constant time compare, a forger must not learn how many bytes were right
+	uint8_t diff = 0;
+	for (uint8_t i = 0; i < TAG_LEN; i++)
+		diff |= expected[i] ^ tag[i];
+	if (diff)
+		return false;
+
+	xorStream(nonce, in, out, len);
+	return true;
+}
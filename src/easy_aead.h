@@ -0,0 +1,59 @@
+#ifndef EASY_AEAD_H
+#define EASY_AEAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * ChaCha20-Poly1305 authenticated encryption (RFC 8439), in portable C++ so it runs the same on the ESP32 and on a host.
+ *
+ * A key object holds the key schedule: the ChaCha20 state with the constants and the key already laid out, only the
+ * counter and the nonce are filled in per frame. It is set once per key and copied by value, no allocation anywhere.
+ * Sealing works in place, opening checks the tag first and only then decrypts, so a forged frame never yields plaintext.
+ * Each nonce must be used only once with a key.
+ */
+class EasyAead
+{
+public:
+	static const uint8_t KEY_LEN = 32;
+	static const uint8_t NONCE_LEN = 12;
+	static const uint8_t TAG_LEN = 16;
+
+	/**
+	 * @brief Computes the key schedule of a 256 bits key
+	 */
+	void setKey(const uint8_t key[KEY_LEN]);
+
+	/**
+	 * @brief Forgets the key
+	 */
+	void clear();
+
+	/**
+	 * @brief Encrypts in place and authenticates the data and the additional data
+	 * @param nonce Unique per frame for this key
+	 * @param aad Authenticated but not encrypted, typically the header of the frame. Can be `nullptr` if `aad_len` is `0`
+	 * @param aad_len Length of `aad`
+	 * @param data Plaintext in, ciphertext out
+	 * @param len Length of `data`
+	 * @param tag Receives the authentication tag
+	 */
+	void seal(const uint8_t nonce[NONCE_LEN], const uint8_t *aad, size_t aad_len, uint8_t *data, size_t len, uint8_t tag[TAG_LEN]) const;
+
+	/**
+	 * @brief Checks the tag and decrypts
+	 * @param in Ciphertext
+	 * @param out Receives the plaintext, only written if the tag is valid. Can be `in`
+	 * @return `true` if the frame is authentic, `false` otherwise
+	 */
+	bool open(const uint8_t nonce[NONCE_LEN], const uint8_t *aad, size_t aad_len, const uint8_t *in, uint8_t *out, size_t len, const uint8_t tag[TAG_LEN]) const;
+
+private:
+	uint32_t schedule[16]; ///< @brief ChaCha20 initial state, counter and nonce words left at `0`
+
+	void block(uint32_t counter, const uint8_t nonce[NONCE_LEN], uint8_t out[64]) const;
+	void xorStream(const uint8_t nonce[NONCE_LEN], const uint8_t *in, uint8_t *out, size_t len) const;
+	void computeTag(const uint8_t nonce[NONCE_LEN], const uint8_t *aad, size_t aad_len, const uint8_t *cipher, size_t len, uint8_t tag[TAG_LEN]) const;
+};
+
+#endif
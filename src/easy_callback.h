@@ -0,0 +1,108 @@
+#ifndef EASY_CALLBACK_H
+#define EASY_CALLBACK_H
+
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Room for the captures of a callback, in bytes. Three pointers by default: `this`, a context and a counter fit.
+ * Define it before building to change it, for example `-DEASY_CALLBACK_CAPACITY=32`
+ **/
+#ifndef EASY_CALLBACK_CAPACITY
+#define EASY_CALLBACK_CAPACITY (3 * sizeof(void *))
+#endif
+
+template <typename Signature, size_t Capacity = EASY_CALLBACK_CAPACITY>
+class EasyCallback;
+
+/**
+ * Callback stored in place, in `Capacity` bytes of the object: a plain function, a lambda and its captures, or a function
+ * taking a context pointer along with that pointer. It never allocates, copying it copies its bytes and calling it is one
+ * indirect call, so it can be set from anywhere and called from the WiFi task at a fixed cost.
+ *
+ * What is stored must fit in `Capacity` and be trivially copyable, both checked at compile time: capture pointers and
+ * references, not objects that own memory. State that does not fit goes behind a pointer, or the context of
+ * `EasyCallback(function, context)`.
+ */
+template <typename R, typename... Args, size_t Capacity>
+class EasyCallback<R(Args...), Capacity>
+{
+public:
+	EasyCallback() {}
+
+	EasyCallback(std::nullptr_t) {}
+
+	/**
+	 * @brief Plain function, `nullptr` leaves the callback empty
+	 */
+	EasyCallback(R (*function)(Args...))
+	{
+		if (function)
+			store(function);
+	}
+
+	/**
+	 * @brief Function called with `context` in front of the arguments
+	 */
+	EasyCallback(R (*function)(void *context, Args...), void *context)
+	{
+		if (function)
+			store(Bound{function, context});
+	}
+
+	/**
+	 * @brief Lambda or any other function object
+	 */
+	template <typename F, typename D = typename std::decay<F>::type,
+			  typename = typename std::enable_if<!std::is_same<D, EasyCallback>::value && !std::is_pointer<D>::value>::type>
+	EasyCallback(F &&callable)
+	{
+		store(D(std::forward<F>(callable)));
+	}
+
+	explicit operator bool() const { return invoke != nullptr; }
+
+	friend bool operator==(const EasyCallback &callback, std::nullptr_t) { return callback.invoke == nullptr; }
+	friend bool operator!=(const EasyCallback &callback, std::nullptr_t) { return callback.invoke != nullptr; }
+
+	/**
+	 * @brief Calls the callback. Check it is not empty first
+	 */
+	R operator()(Args... args) const
+	{
+		return invoke(storage, std::forward<Args>(args)...);
+	}
+
+private:
+	struct Bound
+	{
+		R (*function)(void *context, Args...);
+		void *context;
+		R operator()(Args... args) const { return function(context, std::forward<Args>(args)...); }
+	};
+
+	template <typename D>
+	static R call(const void *storage, Args... args)
+	{
+		return (*static_cast<const D *>(storage))(std::forward<Args>(args)...);
+	}
+
+	template <typename D>
+	void store(D callable)
+	{
+		static_assert(sizeof(D) <= Capacity, "callback captures too much, capture a pointer instead or raise EASY_CALLBACK_CAPACITY");
+		static_assert(alignof(D) <= alignof(void *), "callback captures an over-aligned object, capture a pointer to it instead");
+		static_assert(std::is_trivially_copyable<D>::value && std::is_trivially_destructible<D>::value,
+					  "callback must be trivially copyable: capture pointers or references, not objects that own memory");
+		new (storage) D(callable);
+		invoke = &call<D>;
+	}
+
+	alignas(void *) unsigned char storage[Capacity] = {};
+	R (*invoke)(const void *storage, Args...) = nullptr;
+};
+
+#endif
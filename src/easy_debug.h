@@ -46,58 +46,119 @@
 // #define CURRENT_LOG_LEVEL LOG_NONE
 extern int CURRENT_LOG_LEVEL;
 
-#define MONITOR(tag, format, ...)                                                              \
-    do                                                                                         \
-    {                                                                                          \
-        if (CURRENT_LOG_LEVEL >= LOG_MONITOR)                                                  \
-        {                                                                                      \
-            Serial.printf("[%lu] [MONITOR] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__); \
-        }                                                                                      \
+/*
+ * Most detailed level compiled in. Macros above it expand to nothing, their format strings and arguments are not even
+ * in the binary, whatever `CURRENT_LOG_LEVEL` is at runtime. Define it before building, for example `-DEASY_LOG_COMPILE_LEVEL=LOG_WARNING`
+ **/
+#ifndef EASY_LOG_COMPILE_LEVEL
+#define EASY_LOG_COMPILE_LEVEL LOG_VERBOSE
+#endif
+
+/*
+ * With `EASY_LOG_DEFERRED` defined, the macros only write the format string address and the raw arguments to a ring,
+ * formatting and printing is done later by a low priority task. See `easy_log.h`
+ **/
+#ifdef EASY_LOG_DEFERRED
+#include "easy_log.h"
+#define EASY_LOG_WRITE(level, label, tag, format, ...) easyLogDeferred(level, tag, format, ##__VA_ARGS__)
+#else
+#define EASY_LOG_WRITE(level, label, tag, format, ...) Serial.printf("[%lu] [" label "] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__)
+#endif
+
+#if EASY_LOG_COMPILE_LEVEL >= LOG_MONITOR
+#define MONITOR(tag, format, ...)                                               \
+    do                                                                          \
+    {                                                                           \
+        if (CURRENT_LOG_LEVEL >= LOG_MONITOR)                                   \
+        {                                                                       \
+            EASY_LOG_WRITE(LOG_MONITOR, "MONITOR", tag, format, ##__VA_ARGS__); \
+        }                                                                       \
     } while (0)
+#else
+#define MONITOR(tag, format, ...) \
+    do                            \
+    {                             \
+    } while (0)
+#endif
 
-#define ERROR(tag, format, ...)                                                              \
-    do                                                                                       \
-    {                                                                                        \
-        if (CURRENT_LOG_LEVEL >= LOG_ERROR)                                                  \
-        {                                                                                    \
-            Serial.printf("[%lu] [ERROR] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__); \
-        }                                                                                    \
+#if EASY_LOG_COMPILE_LEVEL >= LOG_ERROR
+#define ERROR(tag, format, ...)                                             \
+    do                                                                      \
+    {                                                                       \
+        if (CURRENT_LOG_LEVEL >= LOG_ERROR)                                 \
+        {                                                                   \
+            EASY_LOG_WRITE(LOG_ERROR, "ERROR", tag, format, ##__VA_ARGS__); \
+        }                                                                   \
+    } while (0)
+#else
+#define ERROR(tag, format, ...) \
+    do                          \
+    {                           \
     } while (0)
+#endif
 
-#define WARNING(tag, format, ...)                                                              \
-    do                                                                                         \
-    {                                                                                          \
-        if (CURRENT_LOG_LEVEL >= LOG_WARNING)                                                  \
-        {                                                                                      \
-            Serial.printf("[%lu] [WARNING] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__); \
-        }                                                                                      \
+#if EASY_LOG_COMPILE_LEVEL >= LOG_WARNING
+#define WARNING(tag, format, ...)                                               \
+    do                                                                          \
+    {                                                                           \
+        if (CURRENT_LOG_LEVEL >= LOG_WARNING)                                   \
+        {                                                                       \
+            EASY_LOG_WRITE(LOG_WARNING, "WARNING", tag, format, ##__VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+#else
+#define WARNING(tag, format, ...) \
+    do                            \
+    {                             \
     } while (0)
+#endif
 
-#define INFO(tag, format, ...)                                                              \
-    do                                                                                      \
-    {                                                                                       \
-        if (CURRENT_LOG_LEVEL >= LOG_INFO)                                                  \
-        {                                                                                   \
-            Serial.printf("[%lu] [INFO] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__); \
-        }                                                                                   \
+#if EASY_LOG_COMPILE_LEVEL >= LOG_INFO
+#define INFO(tag, format, ...)                                            \
+    do                                                                    \
+    {                                                                     \
+        if (CURRENT_LOG_LEVEL >= LOG_INFO)                                \
+        {                                                                 \
+            EASY_LOG_WRITE(LOG_INFO, "INFO", tag, format, ##__VA_ARGS__); \
+        }                                                                 \
     } while (0)
+#else
+#define INFO(tag, format, ...) \
+    do                         \
+    {                          \
+    } while (0)
+#endif
 
-#define DEBUG(tag, format, ...)                                                              \
-    do                                                                                       \
-    {                                                                                        \
-        if (CURRENT_LOG_LEVEL >= LOG_DEBUG)                                                  \
-        {                                                                                    \
-            Serial.printf("[%lu] [DEBUG] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__); \
-        }                                                                                    \
+#if EASY_LOG_COMPILE_LEVEL >= LOG_DEBUG
+#define DEBUG(tag, format, ...)                                             \
+    do                                                                      \
+    {                                                                       \
+        if (CURRENT_LOG_LEVEL >= LOG_DEBUG)                                 \
+        {                                                                   \
+            EASY_LOG_WRITE(LOG_DEBUG, "DEBUG", tag, format, ##__VA_ARGS__); \
+        }                                                                   \
+    } while (0)
+#else
+#define DEBUG(tag, format, ...) \
+    do                          \
+    {                           \
     } while (0)
+#endif
 
-#define VERBOSE(tag, format, ...)                                                              \
-    do                                                                                         \
-    {                                                                                          \
-        if (CURRENT_LOG_LEVEL >= LOG_VERBOSE)                                                  \
-        {                                                                                      \
-            Serial.printf("[%lu] [VERBOSE] [%s]: " format "\n", millis(), tag, ##__VA_ARGS__); \
-        }                                                                                      \
+#if EASY_LOG_COMPILE_LEVEL >= LOG_VERBOSE
+#define VERBOSE(tag, format, ...)                                               \
+    do                                                                          \
+    {                                                                           \
+        if (CURRENT_LOG_LEVEL >= LOG_VERBOSE)                                   \
+        {                                                                       \
+            EASY_LOG_WRITE(LOG_VERBOSE, "VERBOSE", tag, format, ##__VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+#else
+#define VERBOSE(tag, format, ...) \
+    do                            \
+    {                             \
     } while (0)
+#endif
 
 #endif
\ No newline at end of file
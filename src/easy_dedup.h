@@ -0,0 +1,167 @@
+#ifndef EASY_DEDUP_H
+#define EASY_DEDUP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Duplicate filter for received frames, with a fixed amount of memory and constant time lookups.
+ *
+ * Every source has a window of the last 64 sequence numbers seen from it. Sources live in a set-associative table:
+ * the hash of the MAC picks a set of `WAYS` entries, a source missing from its set replaces the entry of the set that was
+ * idle the longest. Sequence numbers are compared modulo their width, so the 12 bits of the 802.11 sequence control
+ * and 16 bits application sequence numbers both work.
+ *
+ * A window holds the newest sequence number and a 64 bits map of the numbers at and below it: a number ahead slides the
+ * window, one inside it is a repeat if its bit is set, one 64 or more behind restarts the window. An evicted source
+ * starts over the next time it is heard, its first frame is accepted: eviction can let one repeat through, it never drops
+ * a new frame. A source idle longer than the expiry starts over as well, so a peer that restarted its counter or a
+ * wrapped sequence number is never mistaken for a stream of repeats.
+ *
+ * Not thread safe, meant to be used by a single receive path.
+ */
+class EasyDedup
+{
+public:
+	static const uint8_t MAC_LEN = 6;
+	static const uint8_t WAYS = 2;
+	static const uint8_t WINDOW = 64;
+
+	/**
+	 * @brief Allocates the table. This is the only allocation the filter does
+	 * @param sources Sources tracked at the same time, rounded up to a power of two
+	 * @param expiry_ms Idle time after which the window of a source is forgotten
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 */
+	bool begin(uint16_t sources, uint32_t expiry_ms)
+	{
+		end();
+		if (sources == 0 || sources > 1024 || expiry_ms == 0)
+			return false;
+
+		uint16_t sets = 1;
+		while ((uint32_t)sets * WAYS < sources)
+			sets <<= 1;
+
+		entries = (entry_t *)calloc((size_t)sets * WAYS, sizeof(entry_t));
+		if (!entries)
+			return false;
+
+		set_mask = sets - 1;
+		expiry = expiry_ms;
+		return true;
+	}
+
+	/**
+	 * @brief Frees the table
+	 */
+	void end()
+	{
+		free(entries);
+		entries = nullptr;
+		set_mask = 0;
+	}
+
+	/**
+	 * @brief Checks a frame against the window of its source and records it
+	 * @param src Source of the frame
+	 * @param space Sequence number space, so different kinds of sequence numbers of the same source do not mix
+	 * @param seq Sequence number of the frame
+	 * @param seq_bits Width of the sequence number, up to 16
+	 * @param now_ms Current time in ms
+	 * @return `true` if the frame was already seen
+	 */
+	bool seen(const uint8_t *src, uint8_t space, uint16_t seq, uint8_t seq_bits, uint32_t now_ms)
+	{
+		if (!entries)
+			return false;
+
+		entry_t *set = entries + (size_t)(hash(src, space) & set_mask) * WAYS;
+		entry_t *entry = nullptr;
+		entry_t *victim = set;
+		for (uint8_t way = 0; way < WAYS; way++)
+		{
+			entry_t &candidate = set[way];
+			if (candidate.valid && candidate.space == space && memcmp(candidate.src, src, MAC_LEN) == 0)
+			{
+				entry = &candidate;
+				break;
+			}
+			if (!candidate.valid || (victim->valid && now_ms - candidate.last_ms > now_ms - victim->last_ms))
+				victim = &candidate;
+		}
+
+		uint16_t mask = seq_bits >= 16 ? 0xFFFF : (uint16_t)((1U << seq_bits) - 1);
+		if (!entry || now_ms - entry->last_ms > expiry)
+		{
+			if (!entry)
+			{
+				entry = victim;
+				memcpy(entry->src, src, MAC_LEN);
+				entry->space = space;
+				entry->valid = true;
+			}
+			restart(*entry, seq, now_ms);
+			return false;
+		}
+		entry->last_ms = now_ms;
+
+		// distance from the newest sequence number, in the half of the space ahead of it or behind it
+		uint16_t ahead = (uint16_t)(seq - entry->highest) & mask;
+		if (ahead != 0 && ahead <= (mask >> 1))
+		{
+			entry->window = ahead >= WINDOW ? 1 : (entry->window << ahead) | 1;
+			entry->highest = seq;
+			return false;
+		}
+
+		uint16_t behind = (uint16_t)(entry->highest - seq) & mask;
+		if (behind >= WINDOW)
+		{
+			// far behind the window, the source started over
+			restart(*entry, seq, now_ms);
+			return false;
+		}
+
+		uint64_t bit = (uint64_t)1 << behind;
+		if (entry->window & bit)
+			return true;
+		entry->window |= bit;
+		return false;
+	}
+
+private:
+	typedef struct
+	{
+		uint8_t src[MAC_LEN];
+		uint8_t space;
+		bool valid;
+		uint16_t highest; ///< @brief Newest sequence number seen
+		uint32_t last_ms; ///< @brief Last frame seen
+		uint64_t window;  ///< @brief Bit `i` set means `highest - i` was seen
+	} entry_t;
+
+	entry_t *entries = nullptr;
+	uint16_t set_mask = 0;
+	uint32_t expiry = 0;
+
+	static void restart(entry_t &entry, uint16_t seq, uint32_t now_ms)
+	{
+		entry.highest = seq;
+		entry.window = 1;
+		entry.last_ms = now_ms;
+	}
+
+	static uint32_t hash(const uint8_t *mac, uint8_t space)
+	{
+		uint32_t h = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+		h ^= ((uint32_t)mac[0] << 8 | mac[1] | (uint32_t)space << 16) * 0x9E3779B1u;
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		return h;
+	}
+};
+
+#endif
@@ -1,7 +1,13 @@
-#ifdef ESP32
+#if defined(ESP32) || defined(EASY_ESP_NOW_HOST)
 
 #include "easy_esp_now.h"
 
+#include <inttypes.h>
+
+#ifdef EASY_ESP_NOW_HOST
+#include <host_device.h>
+#endif
+
 EasyEspNow easyEspNow;
 
 constexpr auto TAG_CORE = "EASY_ESP_NOW";
@@ -106,695 +112,5859 @@ bool EasyEspNow::begin(uint8_t channel, wifi_interface_t phy_interface, int tx_q
 void EasyEspNow::stop()
 {
 	MONITOR(TAG_CORE, "----------> STOPPING ESP-NOW");
+	stopRXTask();
 	vTaskDelete(txTaskHandle);
-	vQueueDelete(txQueue);
+	txTaskHandle = NULL;
+	// frames held by the channel scheduler are slots, freed right below
+	channel_scheduling = false;
+	channel_staged = 0;
+	tx_channel = 0;
+	channel_peers_follow = false;
+	// and so are the ones held by the fair scheduler
+	fair_scheduling = false;
+	fair_active = false;
+	fair_staged = 0;
+	memset(fair_class_staged, 0, sizeof(fair_class_staged));
+	free(fair_flows);
+	fair_flows = nullptr;
+	fair_flow_count = 0;
+	// open aggregates hold slots that are freed right below
+	if (aggregation_mutex != NULL)
+	{
+		xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+		free(tx_aggregates);
+		tx_aggregates = nullptr;
+		aggregation_enabled = false;
+		xSemaphoreGive(aggregation_mutex);
+	}
+	// the event group belongs to the application, which may delete it once stopped: the next begin() must not touch it
+	portENTER_CRITICAL(&tx_mux);
+	tx_watermark_group = NULL;
+	portEXIT_CRITICAL(&tx_mux);
+	deinitTXSlots();
+	portENTER_CRITICAL(&reliable_mux);
+	reliable_peer_t *old_reliable_peers = reliable_peers;
+	reliable_peers = nullptr;
+	reliable_max_peers = 0;
+	portEXIT_CRITICAL(&reliable_mux);
+	if (old_reliable_peers)
+	{
+		free(old_reliable_peers[0].entries);
+		free(old_reliable_peers);
+	}
+	portENTER_CRITICAL(&group_mux);
+	group_send_t *old_group_sends = group_sends;
+	group_sends = nullptr;
+	group_max_sends = 0;
+	portEXIT_CRITICAL(&group_mux);
+	free(old_group_sends);
+	fragmentation_enabled = false;
+	fragmentation_max_message_len = MAX_DATA_LENGTH;
+	reassembler.end();
+	disableRXDedup();
+	disableSendTracking();
+	disableProbes();
+	disableEncryption();
+	disableCompression();
+	for (uint8_t id = 1; id <= MAX_COMPRESSION_DICTIONARIES; id++)
+		setCompressionDictionary(id, nullptr, 0);
 	esp_now_unregister_recv_cb();
 	esp_now_unregister_send_cb();
 	esp_now_deinit();
+	if (radioOwner() == this)
+		radioOwner() = nullptr;
+
+	// ESP-NOW forgets its peers on deinit, so does the peer directory
+	portENTER_CRITICAL(&peers_mux);
+	peer_table.clear();
+	peer_list.peer_number = 0;
+	EasyPeerTable<peer_t> directory = directory_table;
+	peer_t *directory_storage = peer_directory;
+	directory_table = EasyPeerTable<peer_t>();
+	peer_directory = nullptr;
+	portEXIT_CRITICAL(&peers_mux);
+	directory.end();
+	free(directory_storage);
 	MONITOR(TAG_CORE, "<---------- ESP-NOW STOPPED");
 }
 
 easy_send_error_t EasyEspNow::send(const uint8_t *dstAddress, const uint8_t *payload, size_t payload_len)
 {
+	return send(dstAddress, payload, payload_len, DEFAULT_SYNCH_SEND_TIMEOUT_MS);
+}
+
+easy_send_error_t EasyEspNow::send(const uint8_t *dstAddress, const uint8_t *payload, size_t payload_len, uint32_t confirm_timeout_ms,
+							   easy_tx_priority_t priority, easy_send_handle_t *handle)
+{
+	if (handle)
+		*handle = EASY_SEND_HANDLE_NONE;
+
 	if (!payload || !payload_len)
 	{
 		ERROR(TAG_CORE, "Parameters Error");
-		return EASY_SEND_PARAM_ERROR;
+		return countSendResult(EASY_SEND_PARAM_ERROR);
 	}
 
-	if (payload_len < 1 || payload_len > MAX_DATA_LENGTH)
-	{
-		ERROR(TAG_CORE, "Length: %d. Payload length must be between [Min, Max]: [%d ... %d] bytes", payload_len, 1, MAX_DATA_LENGTH);
-		return EASY_SEND_PAYLOAD_LENGTH_ERROR;
-	}
+	easy_iovec_t fragment = {.data = payload, .len = payload_len};
+	return sendv(dstAddress, &fragment, 1, confirm_timeout_ms, priority, handle);
+}
 
-	int enqueued_tx_messages = uxQueueMessagesWaiting(txQueue);
-	DEBUG(TAG_CORE, "TX Queue Status (Enqueued | Capacity) -> %d | %d\n", enqueued_tx_messages, easyEspNow.tx_queue_size);
+easy_send_error_t EasyEspNow::sendv(const uint8_t *dstAddress, const easy_iovec_t *fragments, size_t fragment_count, uint32_t confirm_timeout_ms,
+								easy_tx_priority_t priority, easy_send_handle_t *handle)
+{
+	// every message gets a handle, for onSendComplete(...) even if the caller does not keep it
+	easy_send_handle_t message_handle;
+	if (!handle)
+		handle = &message_handle;
+	*handle = EASY_SEND_HANDLE_NONE;
 
-	// in synch mode wait here until the message in the queue is removed and sent
-	if (this->synchronous_send)
+	if (!fragments || !fragment_count || priority >= TX_PRIORITY_CLASSES)
 	{
-		while (uxQueueMessagesWaiting(txQueue) == tx_queue_size)
-		{
-			WARNING(TAG_CORE, "Synchronous send mode. Waiting for free space in TX Queue");
-			taskYIELD();
-		}
+		ERROR(TAG_CORE, "Parameters Error");
+		return countSendResult(EASY_SEND_PARAM_ERROR);
 	}
-	else
+
+	size_t payload_len = 0;
+	for (size_t i = 0; i < fragment_count; i++)
 	{
-		if (enqueued_tx_messages == tx_queue_size)
+		if (!fragments[i].data && fragments[i].len)
 		{
-			WARNING(TAG_CORE, "TX Queue full. Can not add message to queue. Dropping message...");
-			return EASY_SEND_QUEUE_FULL_ERROR;
+			ERROR(TAG_CORE, "Parameters Error. Fragment #%zu has no data", i);
+			return countSendResult(EASY_SEND_PARAM_ERROR);
 		}
+		payload_len += fragments[i].len;
 	}
 
-	tx_queue_item_t item_to_enqueue;
-
-	// in case dst address in null, put [0x00, 0x00, 0x00, 0x00, 0x00, 0x00] as destination
-	// this will tell to send the message to all the peers in the list
-	if (!dstAddress)
-		memcpy(item_to_enqueue.dst_address, zero_mac, ESP_NOW_ETH_ALEN);
-	else
-		memcpy(item_to_enqueue.dst_address, dstAddress, ESP_NOW_ETH_ALEN);
-
-	memcpy(item_to_enqueue.payload_data, payload, payload_len);
-	item_to_enqueue.payload_len = payload_len;
-
-	// portMAX_DELAY -> will wait indefinitely
-	// pdMS_TO_TICKS -> will have a timeout
-	if (xQueueSend(txQueue, &item_to_enqueue, pdMS_TO_TICKS(10)) == pdTRUE)
+	size_t max_payload_len = fragmentation_enabled ? fragmentation_max_message_len : max_frame_len;
+	if (payload_len < 1 || payload_len > max_payload_len)
 	{
-		MONITOR(TAG_CORE, "Success to enqueue TX message");
-		return EASY_SEND_OK;
+		ERROR(TAG_CORE, "Length: %zu. Payload length must be between [Min, Max]: [%d ... %zu] bytes", payload_len, 1, max_payload_len);
+		return countSendResult(EASY_SEND_PAYLOAD_LENGTH_ERROR);
 	}
-	else
+
+	if (txFreeSlots == NULL)
 	{
-		WARNING(TAG_CORE, "Failed to enqueue item");
-		return EASY_SEND_MSG_ENQUEUE_ERROR;
+		ERROR(TAG_CORE, "TX Queue has not been initialized. Call begin(...) first");
+		return countSendResult(EASY_SEND_MSG_ENQUEUE_ERROR);
 	}
-}
 
-void EasyEspNow::enableTXTask(bool enable)
-{
-	if (!txTaskHandle)
+	// first bytes of the message, wherever the caller fragments put them
+	uint8_t head[EASY_FRAME_HEADER_LEN];
+	size_t head_len = 0;
+	for (size_t i = 0; i < fragment_count && head_len < EASY_FRAME_HEADER_LEN; i++)
+		for (size_t j = 0; j < fragments[i].len && head_len < EASY_FRAME_HEADER_LEN; j++)
+			head[head_len++] = ((const uint8_t *)fragments[i].data)[j];
+
+	if (tx_aggregates)
 	{
-		WARNING(TAG_CORE, "Unable to resume or suspend TX Task because it has not been created yet!");
-		return;
+		xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+		if (tx_aggregates)
+		{
+			const uint8_t *dst_address = dstAddress ? dstAddress : zero_mac;
+
+			// control messages are never held back in an aggregate
+			if (payload_len <= aggregation_max_message_len && priority != TX_PRIORITY_CONTROL)
+			{
+				easy_send_error_t result = aggregateMessage(dst_address, fragments, fragment_count, payload_len, priority, handle);
+				xSemaphoreGive(aggregation_mutex);
+				return result;
+			}
+
+			// larger message, the aggregate of the same destination goes first
+			for (uint8_t i = 0; i < aggregation_max_open; i++)
+			{
+				if (tx_aggregates[i].open && memcmp(tx_aggregates[i].dst_address, dst_address, MAC_ADDR_LEN) == 0)
+					flushAggregate(tx_aggregates[i], AGGREGATE_FLUSH_BYPASS);
+			}
+		}
+		xSemaphoreGive(aggregation_mutex);
 	}
 
-	if (enable && tx_task_resumed == false)
+	// a message that looks like a library frame is escaped by commitTXSlot(...), one that has no room left for the escape
+	// header goes as a single fragment instead
+	bool escaped = easyFrameNeedsEscape(head, head_len) && frameEscaping();
+	if (fragmentation_enabled && (payload_len > max_frame_len || (escaped && payload_len + EASY_FRAME_HEADER_LEN > max_frame_len)))
+		return sendFragmented(dstAddress, fragments, fragment_count, payload_len, confirm_timeout_ms, priority, handle);
+
+	DEBUG(TAG_CORE, "TX Queue Status (Enqueued | Capacity) -> %d | %d\n", tx_queue_size - uxQueueMessagesWaiting(txFreeSlots), tx_queue_size);
+
+	// in synch mode wait here until a slot is freed by the TX task
+	tx_queue_item_t *slot = acquireTXSlot(this->synchronous_send ? portMAX_DELAY : 0);
+	if (!slot)
 	{
-		INFO(TAG_CORE, "Resuming TX Task ...");
-		vTaskResume(txTaskHandle);
-		tx_task_resumed = true;
+		WARNING(TAG_CORE, "TX Queue full. Can not add message to queue. Dropping message...");
+		return countSendResult(EASY_SEND_QUEUE_FULL_ERROR);
 	}
 
-	else if (enable == false && tx_task_resumed == true)
+	// gather the fragments straight into the slot
+	size_t offset = 0;
+	for (size_t i = 0; i < fragment_count; i++)
 	{
-		INFO(TAG_CORE, "Suspending TX Task ...");
-		vTaskSuspend(txTaskHandle);
-		tx_task_resumed = false;
+		memcpy(slot->payload_data + offset, fragments[i].data, fragments[i].len);
+		offset += fragments[i].len;
 	}
 
-	return;
+	return commitTXSlot(slot, dstAddress, payload_len, confirm_timeout_ms, priority, handle);
 }
 
-bool EasyEspNow::readyToSendData()
+tx_queue_item_t *EasyEspNow::acquireTXSlot(TickType_t wait_ticks)
 {
-	return uxQueueMessagesWaiting(txQueue) < tx_queue_size;
+	if (txFreeSlots == NULL)
+	{
+		WARNING(TAG_CORE, "TX slots have not been initialized. Call begin(...) first");
+		return nullptr;
+	}
+	return takeTXSlot(txFreeSlots, wait_ticks);
 }
 
-void EasyEspNow::waitForTXQueueToBeEmptied()
+tx_queue_item_t *EasyEspNow::acquireLibraryTXSlot(TickType_t wait_ticks)
 {
-	if (easyEspNow.txQueue == NULL)
+	if (txLibrarySlots != NULL)
 	{
-		WARNING(TAG_CORE, "TX Queue can't be emptied because it has not been initialized...");
-		return;
+		tx_queue_item_t *slot = takeTXSlot(txLibrarySlots, 0);
+		if (slot)
+			return slot;
 	}
+	return acquireTXSlot(wait_ticks);
+}
 
-	WARNING(TAG_CORE, "Waiting for TX Queue to be emptied...");
-	// if the task is suspended no need to continue blocking, otherwise will be stuck here
-	while (uxQueueMessagesWaiting(easyEspNow.txQueue) > 0 && tx_task_resumed == true)
+tx_queue_item_t *EasyEspNow::takeTXSlot(QueueHandle_t pool, TickType_t wait_ticks)
+{
+	tx_slot_index_t index;
+	if (xQueueReceive(pool, &index, wait_ticks) != pdTRUE)
+		return nullptr;
+	countUsedTXSlot(true);
+
+	tx_slot_states[index].group_send = 0;
+	tx_slot_states[index].handle = EASY_SEND_HANDLE_NONE;
+	tx_slot_states[index].handle_last = true;
+	tx_slot_states[index].message = TX_SLOT_NONE;
+	tx_slot_states[index].probe = 0;
+	return &tx_slots[index];
+}
+
+easy_send_error_t EasyEspNow::commitTXSlot(tx_queue_item_t *slot, const uint8_t *dstAddress, size_t payload_len, uint32_t confirm_timeout_ms,
+										   easy_tx_priority_t priority, easy_send_handle_t *handle)
+{
+	// a receiver with library features takes a message that starts like a library frame for one. A plain node sends the bytes
+	// of the application untouched, as ESP-NOW and the versions before the escape do
+	if (slotIndex(slot) >= 0 && payload_len <= max_frame_len && easyFrameNeedsEscape(slot->payload_data, payload_len) && frameEscaping())
 	{
-		vTaskDelay(pdMS_TO_TICKS(10));
+		if (payload_len + EASY_FRAME_HEADER_LEN > max_frame_len)
+		{
+			if (handle)
+				*handle = EASY_SEND_HANDLE_NONE;
+			ERROR(TAG_CORE, "Length: %zu. A payload starting with 0x%02X is escaped and can be up to %d bytes", payload_len, EASY_FRAME_MAGIC,
+				  max_frame_len - EASY_FRAME_HEADER_LEN);
+			releaseTXSlot(slot);
+			return countSendResult(EASY_SEND_PAYLOAD_LENGTH_ERROR);
+		}
+		memmove(slot->payload_data + EASY_FRAME_HEADER_LEN, slot->payload_data, payload_len);
+		easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_ESCAPED};
+		memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+		payload_len += EASY_FRAME_HEADER_LEN;
 	}
-	return;
+	return queueTXSlot(slot, dstAddress, payload_len, confirm_timeout_ms, priority, handle, this->synchronous_send);
 }
 
-void EasyEspNow::onDataReceived(frame_rcvd_data frame_rcvd_cb)
+void EasyEspNow::setFrameEscaping(bool enabled)
 {
-	DEBUG(TAG_CORE, "Registering custom onReceive Callback Function");
-	dataReceived = frame_rcvd_cb;
+	frame_escaping = enabled;
+	MONITOR(TAG_CORE, "Escaping of messages starting with 0x%02X %s", EASY_FRAME_MAGIC, enabled ? "forced" : "left to the features");
 }
 
-void EasyEspNow::onDataSent(frame_sent_data frame_sent_cb)
+bool EasyEspNow::frameEscaping() const
 {
-	DEBUG(TAG_CORE, "Registering custom onSent Callback function");
-	dataSent = frame_sent_cb;
+	return frame_escaping || aggregation_enabled || fragmentation_enabled || reliable_peers || group_sends || encryption_enabled ||
+		   compression_enabled || probes_enabled;
 }
 
-/* ==========> Peer Management Functions <========== */
-
-bool EasyEspNow::addPeer(const uint8_t *peer_addr_to_add)
+easy_send_error_t EasyEspNow::queueTXSlot(tx_queue_item_t *slot, const uint8_t *dstAddress, size_t payload_len, uint32_t confirm_timeout_ms,
+										  easy_tx_priority_t priority, easy_send_handle_t *handle, bool synchronous)
 {
-	// peer can be in a different interface from the home (this station) and still receive the message.
-	esp_now_peer_info_t peer_info;
-	memcpy(peer_info.peer_addr, peer_addr_to_add, MAC_ADDR_LEN);
-	peer_info.ifidx = wifi_phy_interface; // this does not really matter to set it the same as the peer. This is relevant to the home station WiFi mode and interface. ESP_ERR_ESPNOW_IF
-	peer_info.channel = wifi_primary_channel;
-	peer_info.encrypt = false;
+	if (handle)
+		*handle = EASY_SEND_HANDLE_NONE;
 
-	err = esp_now_add_peer(&peer_info);
-	if (err == ESP_OK)
+	int index = slotIndex(slot);
+	if (index < 0)
 	{
-		memcpy(peer_list.peer[peer_list.peer_number].mac, peer_addr_to_add, MAC_ADDR_LEN);
-		peer_list.peer[peer_list.peer_number].time_peer_added = millis();
-		peer_list.peer_number++;
-
-		MONITOR(TAG_PEERS, "Successfully added peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_add), peer_list.peer_number);
-		return true;
+		ERROR(TAG_CORE, "Parameters Error. Slot does not belong to the TX slot pool");
+		return countSendResult(EASY_SEND_PARAM_ERROR);
 	}
-	else
+
+	if (payload_len < 1 || payload_len > max_frame_len)
 	{
-		ERROR(TAG_PEERS, "Failed to add peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_addr_to_add), esp_err_to_name(err));
-		return false;
+		ERROR(TAG_CORE, "Length: %zu. Payload length must be between [Min, Max]: [%d ... %d] bytes", payload_len, 1, max_frame_len);
+		releaseTXSlot(slot);
+		return countSendResult(EASY_SEND_PAYLOAD_LENGTH_ERROR);
 	}
-}
 
-bool EasyEspNow::deletePeer(const uint8_t *peer_addr_to_delete)
-{
-	err = esp_now_del_peer(peer_addr_to_delete);
-	if (err == ESP_OK)
+	if (priority >= TX_PRIORITY_CLASSES)
 	{
-		for (int i = 0; i < peer_list.peer_number; i++)
-		{
-			if (memcmp(peer_list.peer[i].mac, peer_addr_to_delete, MAC_ADDR_LEN) == 0)
-			{
-				// Peer found, shift subsequent peers to fill the gap
-				for (int j = i; j < peer_list.peer_number - 1; j++)
-				{
-					peer_list.peer[j] = peer_list.peer[j + 1];
-				}
-				// Decrease the peer count
-				peer_list.peer_number--;
-				break;
-			}
-		}
-
-		MONITOR(TAG_PEERS, "Successfully deleted peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_delete), peer_list.peer_number);
-		return true;
+		ERROR(TAG_CORE, "Parameters Error. Priority class %d does not exist", priority);
+		releaseTXSlot(slot);
+		return countSendResult(EASY_SEND_PARAM_ERROR);
 	}
+
+	// in case dst address in null, put [0x00, 0x00, 0x00, 0x00, 0x00, 0x00] as destination
+	// this will tell to send the message to all the peers in the list
+	if (!dstAddress)
+		memcpy(slot->dst_address, zero_mac, ESP_NOW_ETH_ALEN);
 	else
+		memcpy(slot->dst_address, dstAddress, ESP_NOW_ETH_ALEN);
+
+	slot->payload_len = payload_len;
+
+	// given before the slot is queued, its completion can be reported before commit returns
+	if (handle)
 	{
-		ERROR(TAG_PEERS, "Failed to delete peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_addr_to_delete), esp_err_to_name(err));
-		return false;
+		*handle = newSendHandle();
+		tx_slot_states[index].handle = *handle;
+		tx_slot_states[index].submitted_us = micros();
 	}
+
+	easy_send_error_t result = enqueueTXSlot((tx_slot_index_t)index, confirm_timeout_ms, priority, synchronous);
+	if (handle && result != EASY_SEND_OK)
+		*handle = EASY_SEND_HANDLE_NONE;
+	return result;
 }
 
-uint8_t *EasyEspNow::deletePeer(bool keep_broadcast_addr)
+void EasyEspNow::releaseTXSlot(tx_queue_item_t *slot)
 {
-	if (peer_list.peer_number == 0)
+	int index = slotIndex(slot);
+	if (index < 0)
 	{
-		WARNING(TAG_PEERS, "Peer List is empty. No peer can be deleted!");
-		return nullptr;
+		ERROR(TAG_CORE, "Can not release slot. It does not belong to the TX slot pool");
+		return;
 	}
 
-	int8_t oldest_index = -1;				// Initialize it with invalid index
-	uint32_t oldest_peer_time = UINT32_MAX; // Start with max value
+	freeTXSlot((tx_slot_index_t)index);
+}
+
+easy_send_error_t EasyEspNow::enqueueTXSlot(tx_slot_index_t slot_index, uint32_t confirm_timeout_ms, easy_tx_priority_t priority, bool synchronous)
+{
+	tx_slot_state_t &state = tx_slot_states[slot_index];
+	tx_class_stats_t &stats = tx_class_stats[priority];
+	uint16_t capacity = tx_class_capacity[priority] ? tx_class_capacity[priority] : tx_queue_size;
+	bool admitted = false;
+	bool destination_full = false;
 
-	for (int i = 0; i < peer_list.peer_number; i++)
+	portENTER_CRITICAL(&tx_mux);
+	state.waiting = synchronous;
+	state.completed = false;
+	state.peer_in_flight = false;
+	state.priority = priority;
+	state.enqueued_us = micros();
+	state.flow = FAIR_FLOW_NONE;
+	// a destination with its whole backlog queued waits for its turn, the others still get in
+	if (fair_scheduling)
 	{
-		//  Time, is saved in millis, time increases, so older peers will have smaller time value as they were adder earlier
-		if (keep_broadcast_addr && memcmp(peer_list.peer[i].mac, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0)
+		uint8_t flow_index = fairFlow(tx_slots[slot_index].dst_address);
+		tx_destination_stats_t &flow_stats = fair_flows[flow_index].stats;
+		if (flow_stats.backlog >= fair_destination_backlog)
 		{
-			DEBUG(TAG_PEERS, "Broadcast MAC detected");
-			continue;
+			flow_stats.dropped++;
+			destination_full = true;
 		}
 		else
 		{
-			if (peer_list.peer[i].time_peer_added < oldest_peer_time)
-			{
-				oldest_peer_time = peer_list.peer[i].time_peer_added;
-				oldest_index = i;
-			}
+			state.flow = flow_index;
+			flow_stats.backlog++;
+			if (flow_stats.backlog > flow_stats.backlog_max)
+				flow_stats.backlog_max = flow_stats.backlog;
 		}
 	}
+	// reserve the place in the class, so concurrent senders can not overfill it
+	if (!destination_full && stats.depth < capacity)
+	{
+		stats.depth++;
+		stats_tx_queue_depth++;
+		if (stats_tx_queue_depth > stats_tx_queue_depth_max)
+			stats_tx_queue_depth_max = stats_tx_queue_depth;
+		admitted = true;
+	}
+	portEXIT_CRITICAL(&tx_mux);
 
-	DEBUG(TAG_PEERS, "Oldest index: %d", oldest_index);
+	if (destination_full)
+	{
+		WARNING(TAG_CORE, "Destination [" EASYMACSTR "] has its whole backlog queued. Dropping message...", EASYMAC2STR(tx_slots[slot_index].dst_address));
+		state.waiting = false;
+		releaseTXSlot(&tx_slots[slot_index]);
+		return countSendResult(EASY_SEND_QUEUE_FULL_ERROR);
+	}
 
-	if (oldest_index == -1)
+	if (!admitted && tx_class_drop_policy[priority] == TX_DROP_OLDEST)
 	{
-		WARNING(TAG_PEERS, "No valid peer found to delete!");
-		return nullptr; // No valid peer to delete
+		// the new frame takes the place of the oldest one of the class, depth does not change
+		tx_slot_index_t oldest;
+		if (xQueueReceive(txQueues[priority], &oldest, 0) == pdTRUE)
+		{
+			WARNING(TAG_CORE, "TX class %d full. Dropping its oldest message...", priority);
+			portENTER_CRITICAL(&tx_mux);
+			stats.dropped++;
+			portEXIT_CRITICAL(&tx_mux);
+			releaseFairBacklog(oldest);
+			completeTXSlot(oldest, ESP_NOW_SEND_FAIL);
+			admitted = true;
+		}
+	}
+
+	if (!admitted)
+	{
+		WARNING(TAG_CORE, "TX class %d full. Can not add message to queue. Dropping message...", priority);
+		portENTER_CRITICAL(&tx_mux);
+		stats.dropped++;
+		portEXIT_CRITICAL(&tx_mux);
+		releaseFairBacklog(slot_index);
+		state.waiting = false;
+		releaseTXSlot(&tx_slots[slot_index]);
+		return countSendResult(EASY_SEND_QUEUE_FULL_ERROR);
+	}
+
+	// every class queue has room for every slot, no need to wait
+	if (xQueueSend(txQueues[priority], &slot_index, 0) != pdTRUE)
+	{
+		WARNING(TAG_CORE, "Failed to enqueue item");
+		portENTER_CRITICAL(&tx_mux);
+		stats.depth--;
+		stats_tx_queue_depth--;
+		portEXIT_CRITICAL(&tx_mux);
+		releaseFairBacklog(slot_index);
+		state.waiting = false;
+		releaseTXSlot(&tx_slots[slot_index]);
+		return countSendResult(EASY_SEND_MSG_ENQUEUE_ERROR);
 	}
 
-	uint8_t *peer_mac_to_delete = (uint8_t *)malloc(MAC_ADDR_LEN);
-	memcpy(peer_mac_to_delete, peer_list.peer[oldest_index].mac, MAC_ADDR_LEN);
+	portENTER_CRITICAL(&tx_mux);
+	stats.enqueued++;
+	if (stats.depth > stats.depth_max)
+		stats.depth_max = stats.depth;
+	portEXIT_CRITICAL(&tx_mux);
+	xSemaphoreGive(txPending);
 
-	err = esp_now_del_peer(peer_mac_to_delete);
-	if (err == ESP_OK)
+	DEBUG(TAG_CORE, "Success to enqueue TX message");
+	if (synchronous == false)
+		return countSendResult(EASY_SEND_OK);
+
+	// in synch mode block here until tx_cb reports the delivery status of this very slot
+	if (xSemaphoreTake(state.done, pdMS_TO_TICKS(confirm_timeout_ms)) != pdTRUE)
 	{
-		// Peer found, shift subsequent peers to fill the gap
-		for (int j = oldest_index; j < peer_list.peer_number - 1; j++)
+		bool completed_meanwhile;
+		portENTER_CRITICAL(&tx_mux);
+		completed_meanwhile = state.completed;
+		// nobody waits anymore, the completion will give the slot back to the pool
+		state.waiting = false;
+		portEXIT_CRITICAL(&tx_mux);
+
+		if (completed_meanwhile == false)
 		{
-			peer_list.peer[j] = peer_list.peer[j + 1];
+			WARNING(TAG_CORE, "Synchronous send mode. No delivery status within %" PRIu32 " ms", confirm_timeout_ms);
+			return countSendResult(EASY_SEND_CONFIRM_ERROR);
 		}
-		// Decrease the peer count
-		peer_list.peer_number--;
-		MONITOR(TAG_PEERS, "Successfully deleted peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_mac_to_delete), peer_list.peer_number);
-		return peer_mac_to_delete;
+		// completion raced with the timeout, consume the signal
+		xSemaphoreTake(state.done, 0);
 	}
-	else
+
+	esp_now_send_status_t status = state.status;
+	releaseTXSlot(&tx_slots[slot_index]);
+
+	if (status != ESP_NOW_SEND_SUCCESS)
 	{
-		ERROR(TAG_PEERS, "Failed to delete peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_mac_to_delete), esp_err_to_name(err));
-		return nullptr;
+		WARNING(TAG_CORE, "Synchronous send mode. Message was not delivered");
+		return countSendResult(EASY_SEND_CONFIRM_ERROR);
 	}
+	return countSendResult(EASY_SEND_OK);
 }
 
-peer_t EasyEspNow::getPeer(const uint8_t *peer_addr_to_get, esp_now_peer_info_t &peer_info)
+bool EasyEspNow::dequeueTXSlot(tx_slot_index_t *slot_index, TickType_t wait)
 {
-	peer_t peer = {}; // for an invalid peer
-	err = esp_now_get_peer(peer_addr_to_get, &peer_info);
-	if (err == ESP_OK)
+	while (true)
 	{
-		for (int i = 0; i < peer_list.peer_number; i++)
+		// a scheduler may have been enabled while waiting for a commit
+		if (tx_channel != 0)
+			return dequeueChannelSlot(slot_index, wait);
+		if (fair_active)
+			return dequeueFairSlot(slot_index, wait);
+
+		uint32_t now_us = micros();
+		int chosen = -1;
+		bool promoted = false;
+
+		// anti-starvation first: the lowest class whose oldest frame waited past its limit goes ahead of the others
+		for (int c = TX_PRIORITY_CLASSES - 1; c >= 0 && chosen < 0; c--)
 		{
-			if (memcmp(peer_list.peer[i].mac, peer_addr_to_get, MAC_ADDR_LEN) == 0)
-			{
-				DEBUG(TAG_PEERS, "Success getting peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_get), peer_list.peer_number);
-				return peer_list.peer[i];
-			}
+			tx_slot_index_t head;
+			if (tx_class_max_wait_ms[c] && xQueuePeek(txQueues[c], &head, 0) == pdTRUE &&
+				(uint64_t)(now_us - tx_slot_states[head].enqueued_us) >= (uint64_t)tx_class_max_wait_ms[c] * 1000)
+				chosen = c;
+		}
+		for (int c = 0; c < chosen; c++)
+			promoted |= uxQueueMessagesWaiting(txQueues[c]) > 0;
+
+		// otherwise strict priority
+		for (int c = 0; c < TX_PRIORITY_CLASSES && chosen < 0; c++)
+		{
+			if (uxQueueMessagesWaiting(txQueues[c]) > 0)
+				chosen = c;
 		}
+
+		if (chosen >= 0)
+		{
+			// a sender dropping the oldest frame of the class may have taken it meanwhile, then look again
+			if (xQueueReceive(txQueues[chosen], slot_index, 0) != pdTRUE)
+				continue;
+
+			countDequeuedTXSlot(*slot_index, promoted);
+			return true;
+		}
+
+		// all classes empty, sleep until the next commit
+		if (xSemaphoreTake(txPending, wait) != pdTRUE)
+			return false;
 	}
-	else
+}
+
+void EasyEspNow::countDequeuedTXSlot(tx_slot_index_t slot_index, bool promoted)
+{
+	uint32_t waited_us = micros() - tx_slot_states[slot_index].enqueued_us;
+	tx_slot_state_t &state = tx_slot_states[slot_index];
+	tx_class_stats_t &stats = tx_class_stats[state.priority];
+	portENTER_CRITICAL(&tx_mux);
+	// out of the backlog of its destination, whichever way it was dequeued
+	if (state.flow != FAIR_FLOW_NONE)
 	{
-		ERROR(TAG_PEERS, "Failed to get peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_addr_to_get), esp_err_to_name(err));
-		return peer; // return invalid peer
+		if (fair_flows && fair_flows[state.flow].stats.backlog > 0)
+			fair_flows[state.flow].stats.backlog--;
+		state.flow = FAIR_FLOW_NONE;
 	}
+	if (stats.depth > 0)
+		stats.depth--;
+	if (stats_tx_queue_depth > 0)
+		stats_tx_queue_depth--;
+	stats.dequeued++;
+	if (promoted)
+		stats.starvation_promotions++;
+	stats.wait_total_us += waited_us;
+	if (waited_us > stats.wait_max_us)
+		stats.wait_max_us = waited_us;
+	portEXIT_CRITICAL(&tx_mux);
+	wakeTXWaiters();
 }
 
-bool EasyEspNow::peerExists(const uint8_t *peer_addr)
+void EasyEspNow::freeTXSlot(tx_slot_index_t slot_index)
 {
-	return esp_now_is_peer_exist(peer_addr);
+	xQueueSend(slot_index < tx_user_slots ? txFreeSlots : txLibrarySlots, &slot_index, 0);
+	countUsedTXSlot(false);
+	wakeTXWaiters();
 }
 
-bool EasyEspNow::updateLastSeenPeer(const uint8_t *peer_addr)
+void EasyEspNow::countUsedTXSlot(bool taken)
 {
-	if (peerExists(peer_addr))
+	bool crossed = false;
+	bool above;
+	uint16_t used;
+	portENTER_CRITICAL(&tx_mux);
+	if (taken)
+		tx_slots_used++;
+	else if (tx_slots_used > 0)
+		tx_slots_used--;
+	used = tx_slots_used;
+	// hysteresis: back below only at the low watermark
+	if (tx_watermark_high)
+		crossed = tx_above_high ? used <= tx_watermark_low : used >= tx_watermark_high;
+	if (crossed)
 	{
-		for (int i = 0; i < peer_list.peer_number; i++)
-		{
-			if (memcmp(peer_list.peer[i].mac, peer_addr, MAC_ADDR_LEN) == 0)
-			{
-				uint32_t last_seen = millis();
-				peer_list.peer[i].time_peer_added = last_seen;
-				INFO(TAG_PEERS, "Peer[#%d] with MAC: " EASYMACSTR " was updated to last seen: %d ms", i + 1, EASYMAC2STR(peer_addr), last_seen);
-				return true;
-			}
-		}
+		tx_above_high = !tx_above_high;
+		tx_watermark_crossings++;
 	}
-	WARNING(TAG_PEERS, "Not possible to update last seen for MAC: " EASYMACSTR ". Maybe it does not exists as a peer!", EASYMAC2STR(peer_addr));
-	return false;
+	above = tx_above_high;
+	portEXIT_CRITICAL(&tx_mux);
+
+	if (!crossed)
+		return;
+	signalTXWatermark();
+	if (txWatermark)
+		txWatermark(above, used);
 }
 
-int EasyEspNow::countPeers(CountPeers count_type)
+void EasyEspNow::signalTXWatermark()
 {
-	esp_now_peer_num_t num;
-
-	err = esp_now_get_peer_num(&num);
-	if (err == ESP_OK)
-	{
-		switch (count_type)
-		{
-		case TOTAL_NUM:
-			return num.total_num;
-		case ENCRYPTED_NUM:
-			return num.encrypt_num;
-		case UNENCRYPTED_NUM:
-			return num.total_num - num.encrypt_num;
-		default:
-			ERROR(TAG_PEERS, "Invalid option chosen for peer count type!");
-			return -1;
-		}
-	}
-	else
+	while (true)
 	{
-		ERROR(TAG_PEERS, "Failed to get peer count with error: %s", esp_err_to_name(err));
-		return -1;
+		portENTER_CRITICAL(&tx_mux);
+		EventGroupHandle_t group = tx_watermark_group;
+		EventBits_t set_bits = tx_above_high ? tx_watermark_high_bit : tx_watermark_low_bit;
+		EventBits_t clear_bits = tx_above_high ? tx_watermark_low_bit : tx_watermark_high_bit;
+		uint32_t crossings = tx_watermark_crossings;
+		portEXIT_CRITICAL(&tx_mux);
+
+		if (group == NULL)
+			return;
+		xEventGroupClearBits(group, clear_bits);
+		xEventGroupSetBits(group, set_bits);
+
+		// a crossing in between may have set its bits first, these would be stale
+		portENTER_CRITICAL(&tx_mux);
+		bool current = crossings == tx_watermark_crossings;
+		portEXIT_CRITICAL(&tx_mux);
+		if (current)
+			return;
 	}
 }
 
-void EasyEspNow::printPeerList()
+void EasyEspNow::wakeTXWaiters()
 {
-	Serial.printf("\n\nPrinting Peer List! Number of peers %d\n", peer_list.peer_number);
-	for (int i = 0; i < peer_list.peer_number; i++)
+	if (tx_waiter_count.load(std::memory_order_acquire) == 0)
+		return;
+
+	SemaphoreHandle_t wake[TX_WAITERS];
+	uint8_t count = 0;
+	portENTER_CRITICAL(&tx_mux);
+	for (uint8_t i = 0; i < TX_WAITERS; i++)
 	{
-		Serial.printf("Peer [" EASYMACSTR "] with timestamp %lu is %d ms old\n", MAC2STR(peer_list.peer[i].mac), peer_list.peer[i].time_peer_added, millis() - peer_list.peer[i].time_peer_added);
+		if (tx_waiters[i].kind != TX_WAIT_NONE && txWaitSatisfied(tx_waiters[i].kind, tx_waiters[i].slots))
+			wake[count++] = tx_waiters[i].wake;
 	}
-	Serial.printf("\n\n");
-}
+	portEXIT_CRITICAL(&tx_mux);
 
-/* ==========> Miscellaneous Functions <========== */
+	for (uint8_t i = 0; i < count; i++)
+		xSemaphoreGive(wake[i]);
+}
 
-const char *EasyEspNow::easySendErrorToName(easy_send_error_t send_error)
+bool EasyEspNow::txWaitSatisfied(tx_wait_t kind, uint16_t slots)
 {
-	switch (send_error)
+	switch (kind)
 	{
-	case EASY_SEND_OK:
-		return "EASY_SEND_OK";
-	case EASY_SEND_PARAM_ERROR:
-		return "EASY_SEND_PARAM_ERROR";
-	case EASY_SEND_PAYLOAD_LENGTH_ERROR:
-		return "EASY_SEND_PAYLOAD_LENGTH_ERROR";
-	case EASY_SEND_QUEUE_FULL_ERROR:
-		return "EASY_SEND_QUEUE_FULL_ERROR";
-	case EASY_SEND_MSG_ENQUEUE_ERROR:
-		return "EASY_SEND_MSG_ENQUEUE_ERROR";
-	case EASY_SEND_CONFIRM_ERROR:
-		return "EASY_SEND_CONFIRM_ERROR";
+	case TX_WAIT_SPACE:
+		return tx_queue_size - tx_slots_used >= slots;
+	case TX_WAIT_DRAIN:
+		return tx_slots_used == 0;
+	case TX_WAIT_EMPTY:
+		// staged frames of the schedulers count as queued until the TX task takes them
+		return stats_tx_queue_depth == 0 || tx_task_resumed == false;
 	default:
-		return "UNKNOWN_ERROR";
+		return true;
 	}
 }
 
-wifi_interface_t EasyEspNow::autoselect_if_from_mode(wifi_mode_t mode, bool apstaMOD_to_apIF)
+bool EasyEspNow::waitForTX(tx_wait_t kind, uint16_t slots, TickType_t wait_ticks)
 {
-	if (mode == WIFI_MODE_NULL || mode == WIFI_MODE_MAX)
+	// the place is taken under the same lock a freed slot is counted under, so a wake up can not slip in between
+	int8_t waiter = -1;
+	bool satisfied;
+	portENTER_CRITICAL(&tx_mux);
+	for (uint8_t i = 0; i < TX_WAITERS && waiter < 0; i++)
 	{
-		WARNING(TAG_MISC, "Useless WiFi modes, defaulting WiFi interface to: WIFI_IF_STA");
-		return WIFI_IF_STA;
+		if (tx_waiters[i].kind == TX_WAIT_NONE && tx_waiters[i].wake != NULL)
+		{
+			tx_waiters[i].kind = kind;
+			tx_waiters[i].slots = slots;
+			tx_waiter_count.fetch_add(1, std::memory_order_release);
+			waiter = i;
+		}
 	}
-	else if (mode == WIFI_MODE_STA)
+	satisfied = txWaitSatisfied(kind, slots);
+	portEXIT_CRITICAL(&tx_mux);
+
+	TickType_t start = xTaskGetTickCount();
+	while (!satisfied)
 	{
-		INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_STA  ==>  Auto Selecting WiFi interface: WIFI_IF_STA");
-		return WIFI_IF_STA;
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (wait_ticks != portMAX_DELAY && elapsed >= wait_ticks)
+			break;
+		TickType_t ticks = wait_ticks == portMAX_DELAY ? portMAX_DELAY : wait_ticks - elapsed;
+		// every place taken, poll instead
+		if (waiter < 0)
+			vTaskDelay(1);
+		else
+			xSemaphoreTake(tx_waiters[waiter].wake, ticks);
+
+		portENTER_CRITICAL(&tx_mux);
+		satisfied = txWaitSatisfied(kind, slots);
+		portEXIT_CRITICAL(&tx_mux);
 	}
-	else if (mode == WIFI_MODE_AP)
+
+	if (waiter >= 0)
 	{
-		INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_AP  ==>  Auto Selecting WiFi interface: WIFI_IF_AP");
-		return WIFI_IF_AP;
+		portENTER_CRITICAL(&tx_mux);
+		tx_waiters[waiter].kind = TX_WAIT_NONE;
+		tx_waiter_count.fetch_sub(1, std::memory_order_release);
+		portEXIT_CRITICAL(&tx_mux);
+		// a wake up given after the last check would end the next wait on this place early
+		xSemaphoreTake(tx_waiters[waiter].wake, 0);
 	}
-	else if (mode == WIFI_MODE_APSTA)
-	{
-		if (apstaMOD_to_apIF == true)
+	return satisfied;
+}
+
+void EasyEspNow::stageChannelSlots()
+{
+	for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+	{
+		tx_slot_index_t slot_index;
+		while (xQueueReceive(txQueues[c], &slot_index, 0) == pdTRUE)
+		{
+			tx_slot_state_t &state = tx_slot_states[slot_index];
+			const uint8_t *dst_address = tx_slots[slot_index].dst_address;
+			uint8_t channel = 0;
+			// broadcasts and sends to all peers go out on the home channel
+			if (memcmp(dst_address, zero_mac, MAC_ADDR_LEN) != 0 && memcmp(dst_address, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) != 0)
+			{
+				portENTER_CRITICAL(&peers_mux);
+				EasyPeerTable<peer_t> &table = groupPeerTable();
+				int index = table.find(dst_address);
+				if (index >= 0)
+					channel = table.at(index).channel;
+				portEXIT_CRITICAL(&peers_mux);
+			}
+			state.channel = channel ? channel : wifi_primary_channel;
+			state.channel_next = TX_SLOT_NONE;
+
+			tx_channel_group_t &group = channel_groups[state.channel];
+			if (group.head[c] == TX_SLOT_NONE)
+				group.head[c] = slot_index;
+			else
+				tx_slot_states[group.tail[c]].channel_next = slot_index;
+			group.tail[c] = slot_index;
+			group.count++;
+			portENTER_CRITICAL(&tx_mux);
+			channel_staged++;
+			portEXIT_CRITICAL(&tx_mux);
+		}
+	}
+}
+
+bool EasyEspNow::dequeueChannelSlot(tx_slot_index_t *slot_index, TickType_t wait)
+{
+	if (!channel_peers_follow)
+	{
+		// peers follow the radio, so changing channel does not rewrite them
+		channel_peers_follow = true;
+		setEspNowPeersChannel(0);
+	}
+
+	while (true)
+	{
+		if (channel_scheduling)
+			stageChannelSlots();
+
+		uint32_t now_us = micros();
+		// among the other channels, the one whose oldest frame waited longest
+		uint8_t oldest_channel = 0;
+		uint32_t oldest_wait_us = 0;
+		for (uint8_t channel = 1; channel <= MAX_WIFI_CHANNEL; channel++)
+		{
+			const tx_channel_group_t &group = channel_groups[channel];
+			if (channel == tx_channel || group.count == 0)
+				continue;
+			for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+			{
+				if (group.head[c] == TX_SLOT_NONE)
+					continue;
+				uint32_t waited_us = now_us - tx_slot_states[group.head[c]].enqueued_us;
+				if (oldest_channel == 0 || waited_us > oldest_wait_us)
+				{
+					oldest_channel = channel;
+					oldest_wait_us = waited_us;
+				}
+			}
+		}
+
+		// stay until the channel is drained, or until its batch is sent and another channel waited past the bound
+		if (channel_groups[tx_channel].count == 0)
+		{
+			uint8_t next = oldest_channel ? oldest_channel : wifi_primary_channel;
+			if (next != tx_channel)
+				switchTXChannel(next, false);
+		}
+		else if (oldest_channel && channel_batch == 0 && (uint64_t)oldest_wait_us >= (uint64_t)channel_max_latency_ms * 1000)
+			switchTXChannel(oldest_channel, true);
+
+		tx_channel_group_t &group = channel_groups[tx_channel];
+		if (group.count == 0)
+		{
+			// nothing held anywhere and the radio is home
+			if (channel_scheduling == false)
+			{
+				bool done;
+				portENTER_CRITICAL(&tx_mux);
+				done = channel_scheduling == false && channel_staged == 0;
+				if (done)
+					tx_channel = 0;
+				portEXIT_CRITICAL(&tx_mux);
+				if (done)
+				{
+					channel_peers_follow = false;
+					setEspNowPeersChannel(wifi_primary_channel);
+					return dequeueTXSlot(slot_index, wait);
+				}
+				continue;
+			}
+			if (xSemaphoreTake(txPending, wait) != pdTRUE)
+				return false;
+			continue;
+		}
+
+		// within the channel, classes as in dequeueTXSlot(...)
+		int chosen = -1;
+		bool promoted = false;
+		for (int c = TX_PRIORITY_CLASSES - 1; c >= 0 && chosen < 0; c--)
+		{
+			if (tx_class_max_wait_ms[c] && group.head[c] != TX_SLOT_NONE &&
+				(uint64_t)(now_us - tx_slot_states[group.head[c]].enqueued_us) >= (uint64_t)tx_class_max_wait_ms[c] * 1000)
+				chosen = c;
+		}
+		for (int c = 0; c < chosen; c++)
+			promoted |= group.head[c] != TX_SLOT_NONE;
+		for (int c = 0; c < TX_PRIORITY_CLASSES && chosen < 0; c++)
+		{
+			if (group.head[c] != TX_SLOT_NONE)
+				chosen = c;
+		}
+
+		*slot_index = group.head[chosen];
+		group.head[chosen] = tx_slot_states[*slot_index].channel_next;
+		group.count--;
+		if (channel_batch > 0)
+			channel_batch--;
+		portENTER_CRITICAL(&tx_mux);
+		channel_staged--;
+		channel_stats.frames[tx_channel]++;
+		portEXIT_CRITICAL(&tx_mux);
+		countDequeuedTXSlot(*slot_index, promoted);
+		return true;
+	}
+}
+
+void EasyEspNow::switchTXChannel(uint8_t channel, bool latency)
+{
+	// frames in flight were handed to the radio on the current channel
+	waitForTXCompletionSlot(1);
+
+	esp_err_t ret = esp_wifi_set_channel(channel, wifi_secondary_channel);
+	if (ret != ESP_OK)
+		// the frames still go out, on the channel the radio is on, and fail there if nobody listens
+		WARNING(TAG_HELPER, "Channel scheduler failed to switch to channel %d with error: %s", channel, esp_err_to_name(ret));
+
+	uint32_t now_us = micros();
+	portENTER_CRITICAL(&tx_mux);
+	channel_dwell_us[tx_channel] += now_us - channel_since_us;
+	channel_since_us = now_us;
+	if (ret == ESP_OK)
+	{
+		channel_stats.switches++;
+		if (latency)
+			channel_stats.latency_switches++;
+		channel_stats.arrivals[channel]++;
+	}
+	tx_channel = channel;
+	portEXIT_CRITICAL(&tx_mux);
+	channel_batch = channel_groups[channel].count;
+	DEBUG(TAG_HELPER, "Channel scheduler on channel %d, %d frame(s) to send", channel, channel_batch);
+}
+
+uint8_t EasyEspNow::fairFlow(const uint8_t *dst_address)
+{
+	uint8_t shared = fair_flow_count - 1;
+	int free_flow = -1;
+	int idle_flow = -1;
+	for (uint8_t i = 0; i < shared; i++)
+	{
+		const tx_flow_t &flow = fair_flows[i];
+		if (!flow.used)
+		{
+			if (free_flow < 0)
+				free_flow = i;
+			continue;
+		}
+		if (memcmp(flow.stats.mac, dst_address, MAC_ADDR_LEN) == 0)
+			return i;
+		// nothing queued, the queue can be taken over. One with nothing counted since the last reset goes first, then
+		// the one served longest ago
+		if (flow.stats.backlog == 0)
+		{
+			bool counted = flow.stats.frames || flow.stats.dropped || flow.stats.throttled;
+			bool idle_counted = idle_flow >= 0 && (fair_flows[idle_flow].stats.frames || fair_flows[idle_flow].stats.dropped || fair_flows[idle_flow].stats.throttled);
+			if (idle_flow < 0 || (idle_counted && !counted) ||
+				(idle_counted == counted && (int32_t)(flow.served_us - fair_flows[idle_flow].served_us) < 0))
+				idle_flow = i;
+		}
+	}
+
+	int index = free_flow >= 0 ? free_flow : idle_flow;
+	if (index < 0)
+		return shared;
+
+	tx_flow_t &flow = fair_flows[index];
+	// what the destination was counted goes to the shared queue, so the totals of getTXDestinationStats(...) stay whole
+	if (flow.used)
+	{
+		tx_destination_stats_t &other = fair_flows[shared].stats;
+		other.frames += flow.stats.frames;
+		other.bytes += flow.stats.bytes;
+		other.airtime_us += flow.stats.airtime_us;
+		other.dropped += flow.stats.dropped;
+		other.throttled += flow.stats.throttled;
+	}
+	memset(&flow, 0, sizeof(tx_flow_t));
+	for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+		flow.head[c] = flow.tail[c] = TX_SLOT_NONE;
+	flow.used = true;
+	flow.served_us = micros();
+	memcpy(flow.stats.mac, dst_address, MAC_ADDR_LEN);
+	return (uint8_t)index;
+}
+
+void EasyEspNow::releaseFairBacklog(tx_slot_index_t slot_index)
+{
+	tx_slot_state_t &state = tx_slot_states[slot_index];
+	portENTER_CRITICAL(&tx_mux);
+	if (state.flow != FAIR_FLOW_NONE && fair_flows && fair_flows[state.flow].stats.backlog > 0)
+		fair_flows[state.flow].stats.backlog--;
+	state.flow = FAIR_FLOW_NONE;
+	portEXIT_CRITICAL(&tx_mux);
+}
+
+void EasyEspNow::stageFairSlots()
+{
+	for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+	{
+		tx_slot_index_t slot_index;
+		while (xQueueReceive(txQueues[c], &slot_index, 0) == pdTRUE)
+		{
+			tx_slot_state_t &state = tx_slot_states[slot_index];
+			const uint8_t *dst_address = tx_slots[slot_index].dst_address;
+			uint32_t rate_bytes_per_s = 0;
+			uint16_t rate_burst = 0;
+			if (memcmp(dst_address, zero_mac, MAC_ADDR_LEN) != 0 && memcmp(dst_address, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) != 0)
+			{
+				portENTER_CRITICAL(&peers_mux);
+				EasyPeerTable<peer_t> &table = groupPeerTable();
+				int index = table.find(dst_address);
+				if (index >= 0)
+				{
+					rate_bytes_per_s = table.at(index).rate_bytes_per_s;
+					rate_burst = table.at(index).rate_burst;
+				}
+				portEXIT_CRITICAL(&peers_mux);
+			}
+
+			portENTER_CRITICAL(&tx_mux);
+			// queued before the scheduler was enabled
+			if (state.flow == FAIR_FLOW_NONE)
+			{
+				state.flow = fairFlow(dst_address);
+				tx_destination_stats_t &flow_stats = fair_flows[state.flow].stats;
+				flow_stats.backlog++;
+				if (flow_stats.backlog > flow_stats.backlog_max)
+					flow_stats.backlog_max = flow_stats.backlog;
+			}
+			tx_flow_t &flow = fair_flows[state.flow];
+			// destinations of the shared queue are not capped, they would reset each other's bucket
+			if (state.flow == fair_flow_count - 1)
+				rate_bytes_per_s = 0;
+			if (!flow.rate_copied || flow.rate_bytes_per_s != rate_bytes_per_s || flow.rate_burst != rate_burst)
+			{
+				flow.rate_bytes_per_s = rate_bytes_per_s;
+				flow.rate_burst = rate_burst;
+				// a new queue may belong to a destination that just gave its previous one up with its bucket empty
+				flow.tokens = flow.rate_copied ? rate_burst : 0;
+				flow.rate_copied = true;
+				flow.refill_us = micros();
+			}
+
+			state.flow_next = TX_SLOT_NONE;
+			if (flow.head[c] == TX_SLOT_NONE)
+				flow.head[c] = slot_index;
+			else
+				tx_slot_states[flow.tail[c]].flow_next = slot_index;
+			flow.tail[c] = slot_index;
+			fair_class_staged[c]++;
+			fair_staged++;
+			portEXIT_CRITICAL(&tx_mux);
+		}
+	}
+}
+
+tx_slot_index_t EasyEspNow::pickFairSlot(int priority, uint32_t now_us, uint32_t *ready_in_us)
+{
+	// two rounds at most: every destination with frames gets a new turn in them
+	for (uint16_t n = 0; n < 2 * fair_flow_count; n++)
+	{
+		tx_flow_t &flow = fair_flows[fair_cursor[priority]];
+		tx_slot_index_t head = flow.used ? flow.head[priority] : TX_SLOT_NONE;
+		if (head == TX_SLOT_NONE)
+			// an empty queue keeps no credit
+			flow.deficit_us[priority] = 0;
+		else
+		{
+			uint16_t len = tx_slots[head].payload_len;
+			bool within_rate = true;
+			if (flow.rate_bytes_per_s)
+			{
+				// refill, the time of a fraction of a byte is carried over
+				uint64_t added = (uint64_t)flow.rate_bytes_per_s * (uint32_t)(now_us - flow.refill_us) / 1000000;
+				if (added)
+				{
+					uint64_t tokens = flow.tokens + added;
+					flow.refill_us += (uint32_t)(added * 1000000 / flow.rate_bytes_per_s);
+					if (tokens >= flow.rate_burst)
+					{
+						tokens = flow.rate_burst;
+						flow.refill_us = now_us;
+					}
+					flow.tokens = (uint32_t)tokens;
+				}
+				if (flow.tokens < len)
+				{
+					within_rate = false;
+					uint32_t wait_us = (uint32_t)((uint64_t)(len - flow.tokens) * 1000000 / flow.rate_bytes_per_s) + 1;
+					if (wait_us < *ready_in_us)
+						*ready_in_us = wait_us;
+					if (!flow.throttled_head)
+					{
+						flow.throttled_head = true;
+						flow.stats.throttled++;
+					}
+				}
+			}
+
+			if (within_rate)
+			{
+				// a new turn adds one quantum, enough for a frame of any length
+				if (!fair_turn_started[priority])
+				{
+					flow.deficit_us[priority] += fair_quantum_us;
+					fair_turn_started[priority] = true;
+				}
+				uint32_t cost_us = fairAirtimeUs(len);
+				if (flow.deficit_us[priority] >= cost_us)
+				{
+					flow.deficit_us[priority] -= cost_us;
+					if (flow.rate_bytes_per_s)
+						flow.tokens -= len;
+					flow.head[priority] = tx_slot_states[head].flow_next;
+					flow.throttled_head = false;
+					flow.served_us = now_us;
+					flow.stats.frames++;
+					flow.stats.bytes += len;
+					flow.stats.airtime_us += cost_us;
+					fair_airtime_us += cost_us;
+					fair_class_staged[priority]--;
+					fair_staged--;
+					// the turn goes on while the deficit lasts and frames are left
+					if (flow.head[priority] == TX_SLOT_NONE)
+					{
+						flow.deficit_us[priority] = 0;
+						fair_cursor[priority] = (fair_cursor[priority] + 1) % fair_flow_count;
+						fair_turn_started[priority] = false;
+					}
+					return head;
+				}
+			}
+		}
+
+		fair_cursor[priority] = (fair_cursor[priority] + 1) % fair_flow_count;
+		fair_turn_started[priority] = false;
+	}
+	return TX_SLOT_NONE;
+}
+
+bool EasyEspNow::dequeueFairSlot(tx_slot_index_t *slot_index, TickType_t wait)
+{
+	while (true)
+	{
+		if (fair_scheduling)
+			stageFairSlots();
+
+		uint32_t now_us = micros();
+		uint32_t ready_in_us = UINT32_MAX;
+		tx_slot_index_t picked = TX_SLOT_NONE;
+		bool promoted = false;
+		bool drained;
+
+		portENTER_CRITICAL(&tx_mux);
+		// classes as in dequeueTXSlot(...): the lowest class whose oldest frame waited past its limit, then strict priority
+		int starving = -1;
+		for (int c = TX_PRIORITY_CLASSES - 1; c >= 0 && starving < 0; c--)
+		{
+			if (!tx_class_max_wait_ms[c] || fair_class_staged[c] == 0)
+				continue;
+			for (uint8_t i = 0; i < fair_flow_count && starving < 0; i++)
+			{
+				tx_slot_index_t head = fair_flows[i].head[c];
+				if (head != TX_SLOT_NONE && (uint64_t)(now_us - tx_slot_states[head].enqueued_us) >= (uint64_t)tx_class_max_wait_ms[c] * 1000)
+					starving = c;
+			}
+		}
+		if (starving >= 0)
+		{
+			picked = pickFairSlot(starving, now_us, &ready_in_us);
+			for (int c = 0; c < starving && picked != TX_SLOT_NONE; c++)
+				promoted |= fair_class_staged[c] > 0;
+		}
+		for (int c = 0; c < TX_PRIORITY_CLASSES && picked == TX_SLOT_NONE; c++)
+		{
+			if (fair_class_staged[c] > 0)
+				picked = pickFairSlot(c, now_us, &ready_in_us);
+		}
+		// disabled and nothing held anymore
+		drained = fair_scheduling == false && fair_staged == 0;
+		if (drained)
+			fair_active = false;
+		portEXIT_CRITICAL(&tx_mux);
+
+		if (picked != TX_SLOT_NONE)
+		{
+			*slot_index = picked;
+			countDequeuedTXSlot(picked, promoted);
+			return true;
+		}
+		if (drained)
+			return dequeueTXSlot(slot_index, wait);
+
+		// nothing can go now, sleep until the next commit or until the first destination held back by its rate cap can send
+		TickType_t ticks = wait;
+		if (ready_in_us != UINT32_MAX && pdMS_TO_TICKS(ready_in_us / 1000) + 1 < ticks)
+			ticks = pdMS_TO_TICKS(ready_in_us / 1000) + 1;
+		if (xSemaphoreTake(txPending, ticks) != pdTRUE && ticks == wait)
+			return false;
+	}
+}
+
+void EasyEspNow::completeTXSlot(tx_slot_index_t slot_index, esp_now_send_status_t status)
+{
+	tx_slot_state_t &state = tx_slot_states[slot_index];
+	bool waiting;
+	// the slot may be reused as soon as it is given back
+	uint8_t group_send = state.group_send;
+	uint8_t group_member = state.group_member;
+	state.group_send = 0;
+	uint32_t probe = state.probe;
+	state.probe = 0;
+	if (probe)
+		stampProbe(probe, false, esp_timer_get_time());
+	send_completion_t completion = {};
+	completion.handle = state.handle;
+	bool report = completion.handle != EASY_SEND_HANDLE_NONE && (sendComplete != nullptr || send_completions);
+	if (report)
+	{
+		memcpy(completion.dst_addr, tx_slots[slot_index].dst_address, MAC_ADDR_LEN);
+		completion.latency_us = micros() - state.submitted_us;
+	}
+
+	// destination peer can be evicted from ESP-NOW again
+	if (state.peer_in_flight)
+	{
+		portENTER_CRITICAL(&peers_mux);
+		int index = peer_table.find(tx_slots[slot_index].dst_address);
+		if (index >= 0 && peer_table.at(index).frames_in_flight > 0)
+			peer_table.at(index).frames_in_flight--;
+		EasyPeerTable<peer_t> &table = groupPeerTable();
+		int stats_index = &table == &peer_table ? index : table.find(tx_slots[slot_index].dst_address);
+		if (stats_index >= 0)
+		{
+			table.at(stats_index).stats.tx_frames++;
+			if (status != ESP_NOW_SEND_SUCCESS)
+				table.at(stats_index).stats.tx_failed++;
+		}
+		portEXIT_CRITICAL(&peers_mux);
+		state.peer_in_flight = false;
+	}
+
+	if (status == ESP_NOW_SEND_SUCCESS)
+		stats_tx_delivered.fetch_add(1, std::memory_order_relaxed);
+	else
+		stats_tx_failed.fetch_add(1, std::memory_order_relaxed);
+
+	portENTER_CRITICAL(&tx_mux);
+	state.status = status;
+	state.completed = true;
+	waiting = state.waiting;
+	// a fragmented message is reported with its last fragment, failed if any of the others failed
+	if (completion.handle != EASY_SEND_HANDLE_NONE && state.message != TX_SLOT_NONE)
+	{
+		// the entry is gone if the send aborted, or taken by another message since
+		tx_message_state_t &message = tx_messages[state.message];
+		if (message.handle == completion.handle)
+		{
+			if (status != ESP_NOW_SEND_SUCCESS)
+				message.failed = true;
+			if (state.handle_last)
+			{
+				if (message.failed)
+					status = ESP_NOW_SEND_FAIL;
+				message.handle = EASY_SEND_HANDLE_NONE;
+			}
+		}
+		if (!state.handle_last)
+			report = false;
+	}
+	portEXIT_CRITICAL(&tx_mux);
+	completion.status = status;
+
+	// the synchronous sender gives the slot back after reading the status
+	if (waiting)
+		xSemaphoreGive(state.done);
+	else
+		freeTXSlot(slot_index);
+
+	if (group_send)
+		completeGroupFrame(group_send - 1, group_member, status);
+
+	if (report)
+		reportSendCompletion(completion);
+}
+
+tx_slot_index_t EasyEspNow::openTXMessage(easy_send_handle_t handle)
+{
+	tx_slot_index_t message = TX_SLOT_NONE;
+	portENTER_CRITICAL(&tx_mux);
+	for (tx_slot_index_t i = 0; i < tx_queue_size && message == TX_SLOT_NONE; i++)
+	{
+		if (tx_messages[i].handle == EASY_SEND_HANDLE_NONE)
+		{
+			tx_messages[i].handle = handle;
+			tx_messages[i].failed = false;
+			message = i;
+		}
+	}
+	portEXIT_CRITICAL(&tx_mux);
+	return message;
+}
+
+void EasyEspNow::closeTXMessage(tx_slot_index_t message, easy_send_handle_t handle)
+{
+	portENTER_CRITICAL(&tx_mux);
+	if (tx_messages[message].handle == handle)
+		tx_messages[message].handle = EASY_SEND_HANDLE_NONE;
+	portEXIT_CRITICAL(&tx_mux);
+}
+
+easy_send_handle_t EasyEspNow::newSendHandle()
+{
+	easy_send_handle_t handle = next_send_handle.fetch_add(1, std::memory_order_relaxed);
+	// wrapped around
+	if (handle == EASY_SEND_HANDLE_NONE)
+		handle = next_send_handle.fetch_add(1, std::memory_order_relaxed);
+	return handle;
+}
+
+void EasyEspNow::reportSendCompletion(const send_completion_t &completion)
+{
+	if (send_completions)
+	{
+		bool missed = false;
+		portENTER_CRITICAL(&send_tracking_mux);
+		if (send_completions)
+		{
+			// full, the oldest completion makes room
+			if (send_completions_count == send_completions_size)
+			{
+				send_completions_head = (send_completions_head + 1) % send_completions_size;
+				send_completions_count--;
+				missed = true;
+			}
+			send_completions[(send_completions_head + send_completions_count) % send_completions_size] = completion;
+			send_completions_count++;
+		}
+		portEXIT_CRITICAL(&send_tracking_mux);
+		if (missed)
+			send_completions_missed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	send_complete_data callback = sendComplete;
+	if (callback != nullptr)
+		callback(&completion);
+}
+
+void EasyEspNow::onSendComplete(send_complete_data send_complete_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onSendComplete Callback function");
+	sendComplete = send_complete_cb;
+}
+
+bool EasyEspNow::enableSendTracking(uint16_t completions)
+{
+	if (completions < 1)
+	{
+		ERROR(TAG_CORE, "Invalid send tracking. Completions: %d. Must be greater than 0", completions);
+		return false;
+	}
+
+	send_completion_t *ring = (send_completion_t *)calloc(completions, sizeof(send_completion_t));
+	if (!ring)
+	{
+		ERROR(TAG_CORE, "Failed to allocate %d send completions", completions);
+		return false;
+	}
+
+	portENTER_CRITICAL(&send_tracking_mux);
+	send_completion_t *old_ring = send_completions;
+	send_completions = ring;
+	send_completions_size = completions;
+	send_completions_head = 0;
+	send_completions_count = 0;
+	portEXIT_CRITICAL(&send_tracking_mux);
+	free(old_ring);
+
+	MONITOR(TAG_CORE, "Send tracking enabled. Completions kept: [ %d ]", completions);
+	return true;
+}
+
+void EasyEspNow::disableSendTracking()
+{
+	portENTER_CRITICAL(&send_tracking_mux);
+	send_completion_t *old_ring = send_completions;
+	send_completions = nullptr;
+	send_completions_size = 0;
+	send_completions_head = 0;
+	send_completions_count = 0;
+	portEXIT_CRITICAL(&send_tracking_mux);
+	if (old_ring)
+	{
+		free(old_ring);
+		MONITOR(TAG_CORE, "Send tracking disabled");
+	}
+}
+
+bool EasyEspNow::pollSendCompletion(send_completion_t *completion)
+{
+	if (!completion)
+		return false;
+
+	bool found = false;
+	portENTER_CRITICAL(&send_tracking_mux);
+	if (send_completions && send_completions_count > 0)
+	{
+		*completion = send_completions[send_completions_head];
+		send_completions_head = (send_completions_head + 1) % send_completions_size;
+		send_completions_count--;
+		found = true;
+	}
+	portEXIT_CRITICAL(&send_tracking_mux);
+	return found;
+}
+
+void EasyEspNow::enableTXTask(bool enable)
+{
+	if (!txTaskHandle)
+	{
+		WARNING(TAG_CORE, "Unable to resume or suspend TX Task because it has not been created yet!");
+		return;
+	}
+
+	if (enable && tx_task_resumed == false)
+	{
+		INFO(TAG_CORE, "Resuming TX Task ...");
+		vTaskResume(txTaskHandle);
+		tx_task_resumed = true;
+	}
+
+	else if (enable == false && tx_task_resumed == true)
+	{
+		INFO(TAG_CORE, "Suspending TX Task ...");
+		vTaskSuspend(txTaskHandle);
+		portENTER_CRITICAL(&tx_mux);
+		tx_task_resumed = false;
+		portEXIT_CRITICAL(&tx_mux);
+		// nothing will be dequeued anymore, waitForTXQueueToBeEmptied() returns
+		wakeTXWaiters();
+	}
+
+	return;
+}
+
+bool EasyEspNow::readyToSendData()
+{
+	return txFreeSlots != NULL && uxQueueMessagesWaiting(txFreeSlots) > 0;
+}
+
+void EasyEspNow::waitForTXQueueToBeEmptied()
+{
+	if (txPending == NULL)
+	{
+		WARNING(TAG_CORE, "TX Queue can't be emptied because it has not been initialized...");
+		return;
+	}
+
+	WARNING(TAG_CORE, "Waiting for TX Queue to be emptied...");
+	// if the task is suspended no need to continue blocking, otherwise will be stuck here
+	waitForTX(TX_WAIT_EMPTY, 0, portMAX_DELAY);
+	return;
+}
+
+bool EasyEspNow::waitForSpace(uint16_t slots, TickType_t wait_ticks)
+{
+	if (txFreeSlots == NULL)
+	{
+		WARNING(TAG_CORE, "TX slots have not been initialized. Call begin(...) first");
+		return false;
+	}
+	if (slots < 1 || slots > tx_queue_size)
+	{
+		ERROR(TAG_CORE, "Invalid number of slots to wait for: %d. Must be between [%d ... %d]", slots, 1, tx_queue_size);
+		return false;
+	}
+	return waitForTX(TX_WAIT_SPACE, slots, wait_ticks);
+}
+
+bool EasyEspNow::waitForDrain(TickType_t wait_ticks)
+{
+	if (txFreeSlots == NULL)
+	{
+		WARNING(TAG_CORE, "TX slots have not been initialized. Call begin(...) first");
+		return false;
+	}
+	return waitForTX(TX_WAIT_DRAIN, 0, wait_ticks);
+}
+
+bool EasyEspNow::setTXWatermarks(uint16_t high, uint16_t low, EventGroupHandle_t event_group, EventBits_t high_bit, EventBits_t low_bit)
+{
+	if (high > 0 && (low >= high || (txFreeSlots != NULL && high > tx_queue_size)))
+	{
+		ERROR(TAG_CORE, "Invalid TX watermarks. High: %d, low: %d. Low must be below high, high at most the TX queue size", high, low);
+		return false;
+	}
+	if (event_group != NULL && (high_bit | low_bit) == 0)
+	{
+		ERROR(TAG_CORE, "Invalid TX watermark bits. At least one of high and low bits must be set along with the event group");
+		return false;
+	}
+
+	portENTER_CRITICAL(&tx_mux);
+	tx_watermark_high = high;
+	tx_watermark_low = low;
+	tx_watermark_group = high > 0 ? event_group : NULL;
+	tx_watermark_high_bit = high_bit;
+	tx_watermark_low_bit = low_bit;
+	tx_above_high = high > 0 && tx_slots_used >= high;
+	tx_watermark_crossings++;
+	portEXIT_CRITICAL(&tx_mux);
+	signalTXWatermark();
+
+	if (high > 0)
+		MONITOR(TAG_CORE, "TX watermarks set to: high [ %d ], low [ %d ] slots in use", high, low);
+	else
+		MONITOR(TAG_CORE, "TX watermarks disabled");
+	return true;
+}
+
+void EasyEspNow::onTXWatermark(tx_watermark_data tx_watermark_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onTXWatermark Callback function");
+	txWatermark = tx_watermark_cb;
+}
+
+bool EasyEspNow::setTXPacing(uint8_t max_in_flight, uint8_t no_mem_retries, uint32_t backoff_max_ms, uint32_t completion_timeout_ms)
+{
+	if (max_in_flight < 1 || backoff_max_ms < 1 || completion_timeout_ms < 1)
+	{
+		ERROR(TAG_CORE, "Invalid TX pacing. In flight: %d, backoff max: %" PRIu32 " ms, completion timeout: %" PRIu32 " ms. All must be greater than 0", max_in_flight, backoff_max_ms, completion_timeout_ms);
+		return false;
+	}
+
+	portENTER_CRITICAL(&tx_mux);
+	tx_max_in_flight = max_in_flight;
+	tx_no_mem_retries = no_mem_retries;
+	tx_backoff_max_ms = backoff_max_ms;
+	tx_completion_timeout_ms = completion_timeout_ms;
+	portEXIT_CRITICAL(&tx_mux);
+
+	MONITOR(TAG_CORE, "TX pacing set to: max in flight [ %d ], NO_MEM retries [ %d ], backoff max [ %" PRIu32 " ms ], completion timeout [ %" PRIu32 " ms ]",
+			max_in_flight, no_mem_retries, backoff_max_ms, completion_timeout_ms);
+	return true;
+}
+
+bool EasyEspNow::setTXClass(easy_tx_priority_t priority, uint16_t capacity, tx_drop_policy_t drop_policy, uint32_t max_wait_ms)
+{
+	if (priority >= TX_PRIORITY_CLASSES || drop_policy > TX_DROP_OLDEST)
+	{
+		ERROR(TAG_CORE, "Invalid TX class. Priority must be between [%d ... %d]", TX_PRIORITY_CONTROL, TX_PRIORITY_BULK);
+		return false;
+	}
+
+	portENTER_CRITICAL(&tx_mux);
+	tx_class_capacity[priority] = capacity;
+	tx_class_drop_policy[priority] = drop_policy;
+	tx_class_max_wait_ms[priority] = max_wait_ms;
+	portEXIT_CRITICAL(&tx_mux);
+
+	MONITOR(TAG_CORE, "TX class %d set to: capacity [ %d ], drop [ %s ], max wait [ %" PRIu32 " ms ]",
+			priority, capacity, drop_policy == TX_DROP_OLDEST ? "OLDEST" : "NEWEST", max_wait_ms);
+	return true;
+}
+
+tx_class_stats_t EasyEspNow::getTXClassStats(easy_tx_priority_t priority, bool reset)
+{
+	tx_class_stats_t stats = {};
+	if (priority >= TX_PRIORITY_CLASSES)
+		return stats;
+
+	portENTER_CRITICAL(&tx_mux);
+	stats = tx_class_stats[priority];
+	if (reset)
+	{
+		// depth is the current state of the queue, not a counter
+		uint16_t depth = tx_class_stats[priority].depth;
+		tx_class_stats[priority] = {};
+		tx_class_stats[priority].depth = depth;
+		tx_class_stats[priority].depth_max = depth;
+	}
+	portEXIT_CRITICAL(&tx_mux);
+	return stats;
+}
+
+void EasyEspNow::onDataReceived(frame_rcvd_data frame_rcvd_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onReceive Callback Function");
+	dataReceived = frame_rcvd_cb;
+}
+
+void EasyEspNow::onDataSent(frame_sent_data frame_sent_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onSent Callback function");
+	dataSent = frame_sent_cb;
+}
+
+bool EasyEspNow::beginRXTask(uint16_t ring_size, uint16_t max_batch, UBaseType_t task_priority, BaseType_t task_core)
+{
+	if (ring_size < 1 || max_batch < 1)
+	{
+		ERROR(TAG_CORE, "Invalid RX task configuration. Ring size: %d, max batch: %d. Both must be greater than 0", ring_size, max_batch);
+		return false;
+	}
+
+	stopRXTask();
+
+	rx_ring = (rx_frame_t *)calloc(ring_size, sizeof(rx_frame_t));
+	if (!rx_ring)
+	{
+		ERROR(TAG_CORE, "Failed to allocate RX ring of %d frames", ring_size);
+		return false;
+	}
+	rx_ring_size = ring_size;
+	rx_max_batch = max_batch;
+	rx_ring_head.store(0);
+	rx_ring_tail.store(0);
+
+	BaseType_t task_creation_result = xTaskCreateUniversal(easyEspNowRxTask, "recv_esp_now", 8 * 1024, this, task_priority, &rxTaskHandle, task_core);
+	if (task_creation_result != pdPASS)
+	{
+		ERROR(TAG_CORE, "RX Task creation failed! Error: %d", task_creation_result);
+		rxTaskHandle = NULL;
+		stopRXTask();
+		return false;
+	}
+
+	MONITOR(TAG_CORE, "RX Task creation successful. RX ring size: [ %d ], max batch: [ %d ], priority: [ %d ], core: [ %d ]", ring_size, max_batch, task_priority, task_core);
+	return true;
+}
+
+void EasyEspNow::stopRXTask()
+{
+	if (rxTaskHandle)
+	{
+		INFO(TAG_CORE, "Stopping RX Task ...");
+		TaskHandle_t rx_task = rxTaskHandle;
+		// rx_cb stops pushing frames as soon as the handle is cleared
+		rxTaskHandle = NULL;
+		vTaskDelete(rx_task);
+		// messages reassembled meanwhile would wait for an RX task that is gone
+		deliverReassembledMessages();
+	}
+
+	rx_frame_t *ring = rx_ring;
+	rx_ring = nullptr;
+	rx_ring_size = 0;
+	free(ring);
+}
+
+void EasyEspNow::onDataReceivedBatch(frame_rcvd_batch_data frame_rcvd_batch_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onReceive batch Callback Function");
+	dataReceivedBatch = frame_rcvd_batch_cb;
+}
+
+rx_ring_stats_t EasyEspNow::getRXStats(bool reset)
+{
+	rx_ring_stats_t stats;
+	if (reset)
+	{
+		stats.received = rx_received.exchange(0);
+		stats.delivered = rx_delivered.exchange(0);
+		stats.overflows = rx_overflows.exchange(0);
+		stats.dropped = rx_dropped.exchange(0);
+		stats.duplicates = rx_duplicates.exchange(0);
+	}
+	else
+	{
+		stats.received = rx_received.load();
+		stats.delivered = rx_delivered.load();
+		stats.overflows = rx_overflows.load();
+		stats.dropped = rx_dropped.load();
+		stats.duplicates = rx_duplicates.load();
+	}
+	return stats;
+}
+
+bool EasyEspNow::enableRXDedup(uint16_t sources, uint32_t expiry_ms)
+{
+	// rx_cb stops using the filter before it is reallocated
+	rx_dedup_enabled = false;
+	if (rx_dedup.begin(sources, expiry_ms) == false)
+	{
+		ERROR(TAG_CORE, "Invalid duplicate filter parameters or allocation failed. Sources must be between [%d ... %d], expiry greater than 0", 1, 1024);
+		return false;
+	}
+	rx_dedup_enabled = true;
+
+	MONITOR(TAG_CORE, "RX duplicate filter enabled. Sources: %d, expiry: %" PRIu32 " ms", sources, expiry_ms);
+	return true;
+}
+
+void EasyEspNow::disableRXDedup()
+{
+	rx_dedup_enabled = false;
+	rx_dedup.end();
+}
+
+void EasyEspNow::onRXDedupKey(rx_dedup_key_data rx_dedup_key_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onRXDedupKey Callback Function");
+	rxDedupKey = rx_dedup_key_cb;
+}
+
+bool EasyEspNow::enableAggregation(uint32_t window_ms, uint8_t max_message_len, uint8_t max_open)
+{
+	if (txFreeSlots == NULL)
+	{
+		ERROR(TAG_CORE, "TX Queue has not been initialized. Call begin(...) first");
+		return false;
+	}
+
+	uint8_t max_aggregated_len = max_frame_len - EASY_FRAME_HEADER_LEN - EASY_AGGREGATE_RECORD_HEADER_LEN;
+	if (window_ms == 0 || max_message_len == 0 || max_message_len > max_aggregated_len)
+	{
+		ERROR(TAG_CORE, "Invalid aggregation parameters. Window must be greater than 0 and message length between [%d ... %d] bytes", 1, max_aggregated_len);
+		return false;
+	}
+
+	// every open aggregate holds a slot, keep at least one for the messages that are not packed
+	if (!this->synchronous_send && (max_open == 0 || max_open >= tx_queue_size))
+	{
+		ERROR(TAG_CORE, "Invalid aggregation parameters. Open aggregates: %d, must be between [%d ... %d]", max_open, 1, tx_queue_size - 1);
+		return false;
+	}
+
+	if (aggregation_mutex == NULL)
+	{
+		aggregation_mutex = xSemaphoreCreateMutex();
+		if (aggregation_mutex == NULL)
+		{
+			ERROR(TAG_CORE, "Failed to create the aggregation mutex");
+			return false;
+		}
+	}
+
+	disableAggregation();
+
+	tx_aggregate_t *aggregates = nullptr;
+	if (!this->synchronous_send)
+	{
+		aggregates = (tx_aggregate_t *)calloc(max_open, sizeof(tx_aggregate_t));
+		if (!aggregates)
+		{
+			ERROR(TAG_CORE, "Failed to allocate %d open aggregates", max_open);
+			return false;
+		}
+	}
+
+	xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+	aggregation_window_ms = window_ms;
+	aggregation_max_message_len = max_message_len;
+	aggregation_max_open = aggregates ? max_open : 0;
+	tx_aggregates = aggregates;
+	aggregation_enabled = true;
+	xSemaphoreGive(aggregation_mutex);
+
+	MONITOR(TAG_CORE, "Aggregation enabled. Window: %" PRIu32 " ms, max message length: %d bytes, open aggregates: %d", window_ms, max_message_len, aggregation_max_open);
+	return true;
+}
+
+void EasyEspNow::disableAggregation()
+{
+	if (aggregation_mutex == NULL)
+		return;
+
+	xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+	if (tx_aggregates)
+	{
+		for (uint8_t i = 0; i < aggregation_max_open; i++)
+			flushAggregate(tx_aggregates[i], AGGREGATE_FLUSH_EXPLICIT);
+		free(tx_aggregates);
+		tx_aggregates = nullptr;
+	}
+	aggregation_max_open = 0;
+	aggregation_enabled = false;
+	xSemaphoreGive(aggregation_mutex);
+}
+
+void EasyEspNow::flush()
+{
+	if (aggregation_mutex == NULL)
+		return;
+
+	xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+	for (uint8_t i = 0; tx_aggregates && i < aggregation_max_open; i++)
+		flushAggregate(tx_aggregates[i], AGGREGATE_FLUSH_EXPLICIT);
+	xSemaphoreGive(aggregation_mutex);
+}
+
+aggregation_stats_t EasyEspNow::getAggregationStats(bool reset)
+{
+	aggregation_stats_t stats = {};
+	if (aggregation_mutex != NULL)
+	{
+		xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+		stats = aggregation_stats;
+		if (reset)
+			aggregation_stats = {};
+		xSemaphoreGive(aggregation_mutex);
+	}
+
+	if (reset)
+	{
+		stats.rx_frames = aggregation_rx_frames.exchange(0, std::memory_order_relaxed);
+		stats.rx_messages = aggregation_rx_messages.exchange(0, std::memory_order_relaxed);
+		stats.rx_malformed = aggregation_rx_malformed.exchange(0, std::memory_order_relaxed);
+	}
+	else
+	{
+		stats.rx_frames = aggregation_rx_frames.load(std::memory_order_relaxed);
+		stats.rx_messages = aggregation_rx_messages.load(std::memory_order_relaxed);
+		stats.rx_malformed = aggregation_rx_malformed.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+bool EasyEspNow::enableFragmentation(uint16_t max_message_len, uint8_t reassembly_slots, uint32_t reassembly_timeout_ms)
+{
+	// fragments shrink by the encryption overhead, sender and receiver must agree on their length
+	uint8_t fragment_len = max_frame_len - EASY_FRAME_HEADER_LEN - EASY_FRAGMENT_HEADER_LEN;
+	uint16_t max_fragmented_len = (uint16_t)fragment_len * EASY_MAX_FRAGMENTS;
+	if (max_message_len < 1 || max_message_len > max_fragmented_len || reassembly_slots < 1 || reassembly_timeout_ms == 0)
+	{
+		ERROR(TAG_CORE, "Invalid fragmentation parameters. Message length must be between [%d ... %d] bytes, reassembly slots and timeout greater than 0", 1, max_fragmented_len);
+		return false;
+	}
+
+	// rx_cb stops using the reassembly buffers before they are reallocated
+	fragmentation_enabled = false;
+	if (reassembler.begin(reassembly_slots, max_message_len, fragment_len, reassembly_timeout_ms) == false)
+	{
+		ERROR(TAG_CORE, "Failed to allocate %d reassembly buffers of %d bytes", reassembly_slots, max_message_len);
+		return false;
+	}
+	fragmentation_max_message_len = max_message_len;
+	fragmentation_enabled = true;
+
+	MONITOR(TAG_CORE, "Fragmentation enabled. Max message length: %d bytes, reassembly slots: %d, timeout: %" PRIu32 " ms", max_message_len, reassembly_slots, reassembly_timeout_ms);
+	return true;
+}
+
+fragmentation_stats_t EasyEspNow::getFragmentationStats(bool reset)
+{
+	fragmentation_stats_t stats;
+	std::atomic<uint32_t> *counters[] = {&fragmentation_tx_messages, &fragmentation_tx_fragments, &fragmentation_rx_fragments,
+										 &fragmentation_rx_messages, &fragmentation_rx_duplicates, &fragmentation_rx_dropped};
+	uint32_t *values[] = {&stats.tx_messages, &stats.tx_fragments, &stats.rx_fragments, &stats.rx_messages, &stats.rx_duplicates, &stats.rx_dropped};
+	for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++)
+		*values[i] = reset ? counters[i]->exchange(0, std::memory_order_relaxed) : counters[i]->load(std::memory_order_relaxed);
+
+	EasyReassembler<rx_reassembly_meta_t>::counters_t reassembly = reassembler.counters(reset);
+	stats.rx_timeouts = reassembly.timeouts;
+	stats.rx_evictions = reassembly.evictions;
+	return stats;
+}
+
+bool EasyEspNow::enableReliable(uint8_t window, uint8_t max_peers, uint8_t max_retries, uint32_t ack_delay_ms)
+{
+	if (txFreeSlots == NULL)
+	{
+		ERROR(TAG_CORE, "TX Queue has not been initialized. Call begin(...) first");
+		return false;
+	}
+
+	// sequence numbers wrap around at 2^16, a power of two window keeps `seq & (window - 1)` continuous across the wrap
+	if (window < 1 || window > EASY_RELIABLE_MAX_WINDOW || (window & (window - 1)) != 0 || max_peers < 1 || ack_delay_ms == 0)
+	{
+		ERROR(TAG_CORE, "Invalid reliable parameters. Window must be a power of two up to %d, peers and ACK delay greater than 0", EASY_RELIABLE_MAX_WINDOW);
+		return false;
+	}
+
+	if (reliable_space == NULL)
+	{
+		reliable_space = xSemaphoreCreateBinary();
+		if (reliable_space == NULL)
+		{
+			ERROR(TAG_CORE, "Failed to create the reliable send window semaphore");
+			return false;
+		}
+	}
+
+	reliable_peer_t *peers = (reliable_peer_t *)calloc(max_peers, sizeof(reliable_peer_t));
+	reliable_entry_t *entries = (reliable_entry_t *)calloc((size_t)max_peers * window, sizeof(reliable_entry_t));
+	if (!peers || !entries)
+	{
+		free(peers);
+		free(entries);
+		ERROR(TAG_CORE, "Failed to allocate reliable channels for %d peers with window %d", max_peers, window);
+		return false;
+	}
+	for (uint8_t i = 0; i < max_peers; i++)
+		peers[i].entries = entries + (size_t)i * window;
+
+	portENTER_CRITICAL(&reliable_mux);
+	reliable_peer_t *old_peers = reliable_peers;
+	reliable_peers = peers;
+	reliable_max_peers = max_peers;
+	reliable_window = window;
+	reliable_max_retries = max_retries;
+	reliable_ack_delay_ms = ack_delay_ms;
+	portEXIT_CRITICAL(&reliable_mux);
+
+	if (old_peers)
+	{
+		free(old_peers[0].entries);
+		free(old_peers);
+	}
+
+	MONITOR(TAG_CORE, "Reliable channels enabled. Window: %d, peers: %d, retries: %d, ACK delay: %" PRIu32 " ms", window, max_peers, max_retries, ack_delay_ms);
+	return true;
+}
+
+easy_send_error_t EasyEspNow::sendReliable(const uint8_t *dstAddress, const uint8_t *payload, size_t payload_len, uint32_t window_wait_ms, uint16_t *sequence)
+{
+	if (!reliable_peers)
+	{
+		ERROR(TAG_CORE, "Reliable channels are not enabled. Call enableReliable(...) first");
+		return EASY_SEND_MSG_ENQUEUE_ERROR;
+	}
+
+	if (!dstAddress || !payload || !payload_len ||
+		memcmp(dstAddress, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0 || memcmp(dstAddress, zero_mac, MAC_ADDR_LEN) == 0)
+	{
+		ERROR(TAG_CORE, "Parameters Error. Reliable messages need a unicast destination");
+		return EASY_SEND_PARAM_ERROR;
+	}
+
+	size_t max_reliable_len = (size_t)max_frame_len - EASY_FRAME_HEADER_LEN - EASY_RELIABLE_HEADER_LEN;
+	if (payload_len > max_reliable_len)
+	{
+		ERROR(TAG_CORE, "Length: %zu. Reliable payload length must be between [Min, Max]: [%d ... %zu] bytes", payload_len, 1, max_reliable_len);
+		return EASY_SEND_PAYLOAD_LENGTH_ERROR;
+	}
+
+	TickType_t start = xTaskGetTickCount();
+	TickType_t wait_ticks = pdMS_TO_TICKS(window_wait_ms);
+	while (true)
+	{
+		reliable_peer_t *peer;
+		bool accepted = false;
+		uint16_t seq = 0;
+
+		portENTER_CRITICAL(&reliable_mux);
+		peer = reliablePeer(dstAddress, true);
+		if (peer && (uint16_t)(peer->tx_next - peer->tx_base) < reliable_window)
+		{
+			seq = peer->tx_next++;
+			reliable_entry_t &entry = peer->entries[seq & (reliable_window - 1)];
+			entry.in_use = true;
+			entry.seq = seq;
+			entry.len = (uint8_t)payload_len;
+			entry.transmissions = 0;
+			// sent right below, the TX task only picks it up if there was no free TX slot
+			peer->last_activity_ms = millis();
+			entry.deadline_ms = peer->last_activity_ms + RELIABLE_MIN_RTO_MS;
+			memcpy(entry.payload, payload, payload_len);
+			reliable_stats.sent++;
+			accepted = true;
+		}
+		portEXIT_CRITICAL(&reliable_mux);
+
+		if (accepted)
+		{
+			if (sequence)
+				*sequence = seq;
+			// without a free TX slot now, the TX task sends it as soon as there is one
+			transmitReliable(peer, seq);
+			return EASY_SEND_OK;
+		}
+
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed >= wait_ticks)
+		{
+			WARNING(TAG_CORE, "%s. Dropping reliable message...", peer ? "Send window full" : "No free reliable channel");
+			return EASY_SEND_QUEUE_FULL_ERROR;
+		}
+
+		// several senders can wait for the same window, check again at least every 10 ms
+		TickType_t wait = wait_ticks - elapsed;
+		xSemaphoreTake(reliable_space, wait < pdMS_TO_TICKS(10) ? wait : pdMS_TO_TICKS(10));
+	}
+}
+
+void EasyEspNow::onReliableStatus(reliable_status_data reliable_status_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onReliableStatus Callback Function");
+	reliableStatus = reliable_status_cb;
+}
+
+reliable_stats_t EasyEspNow::getReliableStats(bool reset)
+{
+	portENTER_CRITICAL(&reliable_mux);
+	reliable_stats_t stats = reliable_stats;
+	if (reset)
+		reliable_stats = {};
+	portEXIT_CRITICAL(&reliable_mux);
+	return stats;
+}
+
+/* ==========> Peer Group Functions <========== */
+
+int8_t EasyEspNow::createGroup(const char *name)
+{
+	if (!name || !*name || strlen(name) > MAX_GROUP_NAME_LEN)
+	{
+		ERROR(TAG_CORE, "Parameters Error. Group name must be between [%d ... %d] characters", 1, MAX_GROUP_NAME_LEN);
+		return -1;
+	}
+
+	uint16_t hash = easyGroupHash(name);
+	int8_t group = -1;
+	int8_t free_group = -1;
+	bool collision = false;
+
+	portENTER_CRITICAL(&group_mux);
+	for (uint8_t i = 0; i < MAX_GROUPS && group < 0; i++)
+	{
+		if (!groups[i].used)
+		{
+			if (free_group < 0)
+				free_group = i;
+		}
+		else if (strcmp(groups[i].name, name) == 0)
+			group = i;
+		else if (groups[i].hash == hash)
+			collision = true;
+	}
+	if (group < 0 && !collision && free_group >= 0)
+	{
+		group = free_group;
+		groups[group] = {};
+		groups[group].used = true;
+		strcpy(groups[group].name, name);
+		groups[group].hash = hash;
+	}
+	portEXIT_CRITICAL(&group_mux);
+
+	if (group < 0)
+	{
+		ERROR(TAG_CORE, "Can not create group: %s. %s", name, collision ? "Another group has the same hash, pick another name" : "All groups are used");
+		return -1;
+	}
+	return group;
+}
+
+bool EasyEspNow::deleteGroup(uint8_t group)
+{
+	if (group >= MAX_GROUPS || !groups[group].used)
+		return false;
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	for (int i = table.newer(-1); i >= 0; i = table.newer(i))
+		table.at(i).groups &= ~(1UL << group);
+	portEXIT_CRITICAL(&peers_mux);
+
+	portENTER_CRITICAL(&group_mux);
+	groups[group].used = false;
+	groups[group].joined = false;
+	portEXIT_CRITICAL(&group_mux);
+	return true;
+}
+
+int8_t EasyEspNow::findGroup(const char *name)
+{
+	if (!name)
+		return -1;
+
+	int8_t group = -1;
+	portENTER_CRITICAL(&group_mux);
+	for (uint8_t i = 0; i < MAX_GROUPS && group < 0; i++)
+	{
+		if (groups[i].used && strcmp(groups[i].name, name) == 0)
+			group = i;
+	}
+	portEXIT_CRITICAL(&group_mux);
+	return group;
+}
+
+bool EasyEspNow::addToGroup(uint8_t group, const uint8_t *peer_addr)
+{
+	if (group >= MAX_GROUPS || !groups[group].used || !peer_addr || memcmp(peer_addr, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0)
+	{
+		ERROR(TAG_CORE, "Parameters Error. Group does not exist or peer is not unicast");
+		return false;
+	}
+
+	bool added = false;
+	uint8_t members = 0;
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	for (int i = table.newer(-1); index >= 0 && i >= 0; i = table.newer(i))
+		members += (table.at(i).groups >> group) & 1;
+	if (index >= 0 && members < EASY_GROUP_MAX_MEMBERS)
+	{
+		table.at(index).groups |= 1UL << group;
+		added = true;
+	}
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (!added)
+	{
+		ERROR(TAG_CORE, "Can not add peer: [" EASYMACSTR "] to group: %s. %s", EASYMAC2STR(peer_addr), groups[group].name,
+			  index < 0 ? "Add the peer first" : "Group is full");
+		return false;
+	}
+	return true;
+}
+
+bool EasyEspNow::removeFromGroup(uint8_t group, const uint8_t *peer_addr)
+{
+	if (group >= MAX_GROUPS || !peer_addr)
+		return false;
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	bool member = index >= 0 && (table.at(index).groups >> group) & 1;
+	if (member)
+		table.at(index).groups &= ~(1UL << group);
+	portEXIT_CRITICAL(&peers_mux);
+	return member;
+}
+
+uint8_t EasyEspNow::groupSize(uint8_t group)
+{
+	if (group >= MAX_GROUPS)
+		return 0;
+
+	uint8_t members = 0;
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	for (int i = table.newer(-1); i >= 0; i = table.newer(i))
+		members += (table.at(i).groups >> group) & 1;
+	portEXIT_CRITICAL(&peers_mux);
+	return members;
+}
+
+bool EasyEspNow::joinGroup(const char *name)
+{
+	int8_t group = createGroup(name);
+	if (group < 0)
+		return false;
+
+	groups[group].joined = true;
+	MONITOR(TAG_CORE, "Joined group: %s", groups[group].name);
+	return true;
+}
+
+bool EasyEspNow::leaveGroup(const char *name)
+{
+	int8_t group = findGroup(name);
+	if (group < 0)
+		return false;
+
+	groups[group].joined = false;
+	MONITOR(TAG_CORE, "Left group: %s", groups[group].name);
+	return true;
+}
+
+bool EasyEspNow::enableGroups(uint8_t max_sends, uint32_t ack_timeout_ms, uint8_t broadcast_min_members)
+{
+	if (txFreeSlots == NULL)
+	{
+		ERROR(TAG_CORE, "TX Queue has not been initialized. Call begin(...) first");
+		return false;
+	}
+
+	// TX slots refer to their message by index + 1 in a byte
+	if (max_sends < 1 || max_sends == 0xFF || ack_timeout_ms == 0)
+	{
+		ERROR(TAG_CORE, "Invalid group parameters. Messages in progress must be between [%d ... %d], ACK timeout greater than 0", 1, 0xFE);
+		return false;
+	}
+
+	group_send_t *sends = (group_send_t *)calloc(max_sends, sizeof(group_send_t));
+	if (!sends)
+	{
+		ERROR(TAG_CORE, "Failed to allocate %d group messages", max_sends);
+		return false;
+	}
+
+	portENTER_CRITICAL(&group_mux);
+	group_send_t *old_sends = group_sends;
+	group_sends = sends;
+	group_max_sends = max_sends;
+	group_ack_timeout_ms = ack_timeout_ms;
+	group_broadcast_min_members = broadcast_min_members;
+	portEXIT_CRITICAL(&group_mux);
+	free(old_sends);
+
+	MONITOR(TAG_CORE, "Groups enabled. Messages in progress: %d, ACK timeout: %" PRIu32 " ms, broadcast from %d members", max_sends, ack_timeout_ms, broadcast_min_members);
+	return true;
+}
+
+easy_send_error_t EasyEspNow::sendToGroup(uint8_t group, const uint8_t *payload, size_t payload_len, group_send_mode_t mode, uint16_t *send_id)
+{
+	if (!group_sends)
+	{
+		ERROR(TAG_CORE, "Groups are not enabled. Call enableGroups(...) first");
+		return EASY_SEND_MSG_ENQUEUE_ERROR;
+	}
+
+	if (group >= MAX_GROUPS || !groups[group].used || !payload || !payload_len || mode > GROUP_SEND_BROADCAST)
+	{
+		ERROR(TAG_CORE, "Parameters Error. Group does not exist or no payload");
+		return EASY_SEND_PARAM_ERROR;
+	}
+
+	size_t max_group_len = (size_t)max_frame_len - EASY_FRAME_HEADER_LEN - EASY_GROUP_HEADER_LEN;
+	if (payload_len > max_group_len)
+	{
+		ERROR(TAG_CORE, "Length: %zu. Group payload length must be between [Min, Max]: [%d ... %zu] bytes", payload_len, 1, max_group_len);
+		return EASY_SEND_PAYLOAD_LENGTH_ERROR;
+	}
+
+	// membership may change while the message is in progress, results refer to the members of now
+	uint8_t members[EASY_GROUP_MAX_MEMBERS][MAC_ADDR_LEN];
+	uint8_t member_count = 0;
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	for (int i = table.newer(-1); i >= 0 && member_count < EASY_GROUP_MAX_MEMBERS; i = table.newer(i))
+	{
+		if ((table.at(i).groups >> group) & 1)
+			memcpy(members[member_count++], table.at(i).mac, MAC_ADDR_LEN);
+	}
+	bool broadcast_peer = peer_table.find(ESPNOW_BROADCAST_ADDRESS) >= 0;
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (member_count == 0)
+	{
+		WARNING(TAG_CORE, "Group: %s has no members", groups[group].name);
+		return EASY_SEND_PARAM_ERROR;
+	}
+
+	if (mode == GROUP_SEND_AUTO)
+	{
+		// bytes on the air: one frame per member, against one broadcast plus an acknowledgement per member plus the expected repairs
+		uint32_t frame_len = ESPNOW_AIR_OVERHEAD_LEN + EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN + payload_len;
+		uint32_t unicast_cost = (uint32_t)member_count * (ESPNOW_AIR_OVERHEAD_LEN + payload_len);
+		uint32_t broadcast_cost = frame_len + (uint32_t)member_count * (ESPNOW_AIR_OVERHEAD_LEN + EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN) +
+								  (uint32_t)groups[group].broadcast_loss * member_count * frame_len / 256;
+		mode = broadcast_peer && member_count >= group_broadcast_min_members && broadcast_cost < unicast_cost ? GROUP_SEND_BROADCAST : GROUP_SEND_UNICAST;
+	}
+
+	tx_queue_item_t *broadcast_slot = nullptr;
+	if (mode == GROUP_SEND_BROADCAST)
+	{
+		broadcast_slot = acquireLibraryTXSlot(0);
+		if (!broadcast_slot)
+		{
+			WARNING(TAG_CORE, "TX Queue full. Can not broadcast to group. Dropping message...");
+			return EASY_SEND_QUEUE_FULL_ERROR;
+		}
+	}
+
+	int index = -1;
+	uint16_t id = 0;
+	portENTER_CRITICAL(&group_mux);
+	for (uint8_t i = 0; group_sends && i < group_max_sends && index < 0; i++)
+	{
+		if (!group_sends[i].used)
+			index = i;
+	}
+	if (index >= 0)
+	{
+		group_send_t &send = group_sends[index];
+		id = group_next_id++;
+		send = {};
+		send.used = true;
+		send.send_id = id;
+		send.group = group;
+		send.group_hash = groups[group].hash;
+		send.mode = mode;
+		send.member_count = member_count;
+		memcpy(send.members, members, (size_t)member_count * MAC_ADDR_LEN);
+		send.to_send = mode == GROUP_SEND_UNICAST ? (uint32_t)(((uint64_t)1 << member_count) - 1) : 0;
+		send.broadcast_pending = mode == GROUP_SEND_BROADCAST;
+		send.started_us = micros();
+		send.payload_len = (uint8_t)payload_len;
+		memcpy(send.payload, payload, payload_len);
+		group_stats.sent++;
+		if (mode == GROUP_SEND_BROADCAST)
+		{
+			group_stats.broadcast_sends++;
+			group_stats.frames++;
+		}
+		else
+			group_stats.unicast_sends++;
+	}
+	portEXIT_CRITICAL(&group_mux);
+
+	if (index < 0)
+	{
+		if (broadcast_slot)
+			releaseTXSlot(broadcast_slot);
+		WARNING(TAG_CORE, "%d group messages already in progress. Dropping message...", group_max_sends);
+		return EASY_SEND_QUEUE_FULL_ERROR;
+	}
+
+	if (send_id)
+		*send_id = id;
+
+	if (mode == GROUP_SEND_UNICAST)
+	{
+		// without enough free TX slots now, the TX task sends the rest as soon as there are some
+		transmitGroupUnicasts((uint8_t)index);
+		return EASY_SEND_OK;
+	}
+
+	easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_GROUP_DATA};
+	easy_group_header_t header = {.group = groups[group].hash, .send_id = id, .flags = EASY_GROUP_ACK_REQUESTED};
+	memcpy(broadcast_slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+	memcpy(broadcast_slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_GROUP_HEADER_LEN);
+	memcpy(broadcast_slot->payload_data + EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN, payload, payload_len);
+
+	tx_slot_state_t &state = tx_slot_states[slotIndex(broadcast_slot)];
+	state.group_send = (uint8_t)index + 1;
+	state.group_member = GROUP_MEMBER_ALL;
+	easy_send_error_t result = queueTXSlot(broadcast_slot, ESPNOW_BROADCAST_ADDRESS, EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN + payload_len, 0);
+	if (result != EASY_SEND_OK)
+		completeGroupFrame((uint8_t)index, GROUP_MEMBER_ALL, ESP_NOW_SEND_FAIL);
+	return EASY_SEND_OK;
+}
+
+void EasyEspNow::onGroupSendResult(group_send_data group_send_cb)
+{
+	DEBUG(TAG_CORE, "Registering custom onGroupSendResult Callback Function");
+	groupSendResult = group_send_cb;
+}
+
+group_stats_t EasyEspNow::getGroupStats(bool reset)
+{
+	portENTER_CRITICAL(&group_mux);
+	group_stats_t stats = group_stats;
+	if (reset)
+		group_stats = {};
+	portEXIT_CRITICAL(&group_mux);
+	return stats;
+}
+
+/* ==========> Channel Scheduler Functions <========== */
+
+bool EasyEspNow::enableChannelScheduling(uint32_t max_latency_ms)
+{
+	if (txTaskHandle == NULL)
+	{
+		ERROR(TAG_CORE, "Channel scheduler can not be enabled before begin(...)");
+		return false;
+	}
+
+	if (max_latency_ms < 1)
+	{
+		ERROR(TAG_CORE, "Invalid channel scheduler max latency: %" PRIu32 " ms. Must be greater than 0", max_latency_ms);
+		return false;
+	}
+
+	if (fair_active)
+	{
+		ERROR(TAG_CORE, "Channel scheduler can not be enabled along with the fair scheduler");
+		return false;
+	}
+
+	portENTER_CRITICAL(&tx_mux);
+	// the TX task does not touch the groups while the scheduler is off and they are empty
+	if (tx_channel == 0)
+	{
+		for (uint8_t channel = 0; channel <= MAX_WIFI_CHANNEL; channel++)
+		{
+			for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+				channel_groups[channel].head[c] = channel_groups[channel].tail[c] = TX_SLOT_NONE;
+			channel_groups[channel].count = 0;
+		}
+		channel_batch = 0;
+		channel_since_us = micros();
+		tx_channel = wifi_primary_channel;
+	}
+	channel_max_latency_ms = max_latency_ms;
+	channel_scheduling = true;
+	portEXIT_CRITICAL(&tx_mux);
+	xSemaphoreGive(txPending);
+
+	MONITOR(TAG_CORE, "Channel scheduler enabled. Home channel [ %d ], max latency [ %" PRIu32 " ms ]", wifi_primary_channel, max_latency_ms);
+	return true;
+}
+
+void EasyEspNow::disableChannelScheduling()
+{
+	portENTER_CRITICAL(&tx_mux);
+	channel_scheduling = false;
+	portEXIT_CRITICAL(&tx_mux);
+	// the TX task sends what the scheduler holds and goes back to the home channel
+	if (txPending != NULL)
+		xSemaphoreGive(txPending);
+	MONITOR(TAG_CORE, "Channel scheduler disabled");
+}
+
+bool EasyEspNow::setPeerChannel(const uint8_t *peer_addr, uint8_t channel)
+{
+	if (!peer_addr || channel > MAX_WIFI_CHANNEL)
+	{
+		ERROR(TAG_PEERS, "Invalid peer channel: %d. Must be within the range [0..%d], 0 for the home channel", channel, MAX_WIFI_CHANNEL);
+		return false;
+	}
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	if (index >= 0)
+		table.at(index).channel = channel;
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (index < 0)
+	{
+		WARNING(TAG_PEERS, "Can not set the channel of peer: [" EASYMACSTR "]. Peer does not exist", EASYMAC2STR(peer_addr));
+		return false;
+	}
+	MONITOR(TAG_PEERS, "Peer: [" EASYMACSTR "] listens on channel: %d", EASYMAC2STR(peer_addr), channel);
+	return true;
+}
+
+uint8_t EasyEspNow::getPeerChannel(const uint8_t *peer_addr)
+{
+	if (!peer_addr)
+		return 0;
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	uint8_t channel = index >= 0 ? table.at(index).channel : 0;
+	portEXIT_CRITICAL(&peers_mux);
+	return channel;
+}
+
+channel_stats_t EasyEspNow::getChannelStats(bool reset)
+{
+	channel_stats_t stats;
+	uint64_t dwell_us[MAX_WIFI_CHANNEL + 1];
+	uint32_t now_us = micros();
+
+	portENTER_CRITICAL(&tx_mux);
+	stats = channel_stats;
+	stats.current_channel = tx_channel ? tx_channel : wifi_primary_channel;
+	memcpy(dwell_us, channel_dwell_us, sizeof(dwell_us));
+	// the current visit counts too
+	if (tx_channel != 0)
+		dwell_us[tx_channel] += now_us - channel_since_us;
+	if (reset)
+	{
+		channel_stats = {};
+		memset(channel_dwell_us, 0, sizeof(channel_dwell_us));
+		channel_since_us = now_us;
+	}
+	portEXIT_CRITICAL(&tx_mux);
+
+	for (uint8_t channel = 0; channel <= MAX_WIFI_CHANNEL; channel++)
+		stats.dwell_ms[channel] = dwell_us[channel] / 1000;
+	return stats;
+}
+
+/* ==========> Fair Scheduler Functions <========== */
+
+bool EasyEspNow::enableFairScheduling(uint8_t max_destinations, uint16_t destination_backlog, uint16_t phy_rate_kbps)
+{
+	if (txTaskHandle == NULL)
+	{
+		ERROR(TAG_CORE, "Fair scheduler can not be enabled before begin(...)");
+		return false;
+	}
+
+	if (max_destinations < 1 || max_destinations >= FAIR_FLOW_NONE - 1 || phy_rate_kbps < 1)
+	{
+		ERROR(TAG_CORE, "Invalid fair scheduler parameters. Destinations: %d, must be between [1 ... %d]. PHY rate: %d kbps, must be greater than 0",
+			  max_destinations, FAIR_FLOW_NONE - 2, phy_rate_kbps);
+		return false;
+	}
+
+	uint8_t flow_count = max_destinations + 1;
+	tx_flow_t *flows = (tx_flow_t *)calloc(flow_count, sizeof(tx_flow_t));
+	if (!flows)
+	{
+		ERROR(TAG_CORE, "Failed to allocate the fair scheduler queues of %d destinations", max_destinations);
+		return false;
+	}
+	for (uint8_t i = 0; i < flow_count; i++)
+	{
+		for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+			flows[i].head[c] = flows[i].tail[c] = TX_SLOT_NONE;
+	}
+	// the last queue is shared by the destinations that found none of their own
+	flows[flow_count - 1].used = true;
+	flows[flow_count - 1].stats.shared = true;
+
+	uint16_t backlog = destination_backlog ? destination_backlog : (tx_queue_size / 4 > 0 ? tx_queue_size / 4 : 1);
+	bool channel_scheduler = false;
+	bool resized = false;
+
+	portENTER_CRITICAL(&tx_mux);
+	if (tx_channel != 0)
+		channel_scheduler = true;
+	// queues still being drained keep their size
+	else if (fair_active && fair_flow_count != flow_count)
+		resized = true;
+	else
+	{
+		if (!fair_active)
+		{
+			// the TX task does not touch the queues while the scheduler is off and they are empty
+			tx_flow_t *old_flows = fair_flows;
+			fair_flows = flows;
+			flows = old_flows;
+			fair_flow_count = flow_count;
+			memset(fair_cursor, 0, sizeof(fair_cursor));
+			memset(fair_turn_started, 0, sizeof(fair_turn_started));
+			memset(fair_class_staged, 0, sizeof(fair_class_staged));
+			fair_staged = 0;
+			fair_airtime_us = 0;
+		}
+		fair_destination_backlog = backlog;
+		fair_phy_rate_kbps = phy_rate_kbps;
+		fair_quantum_us = fairAirtimeUs(MAX_DATA_LENGTH);
+		fair_scheduling = true;
+		fair_active = true;
+	}
+	portEXIT_CRITICAL(&tx_mux);
+	free(flows);
+
+	if (channel_scheduler)
+	{
+		ERROR(TAG_CORE, "Fair scheduler can not be enabled along with the channel scheduler");
+		return false;
+	}
+	if (resized)
+	{
+		ERROR(TAG_CORE, "Fair scheduler is still sending the frames of %d destinations. Can not change to %d before they are sent", fair_flow_count - 1, max_destinations);
+		return false;
+	}
+	xSemaphoreGive(txPending);
+
+	MONITOR(TAG_CORE, "Fair scheduler enabled. Destinations [ %d ], backlog per destination [ %d ], PHY rate [ %d kbps ], quantum [ %" PRIu32 " us ]",
+			max_destinations, backlog, phy_rate_kbps, fair_quantum_us);
+	return true;
+}
+
+void EasyEspNow::disableFairScheduling()
+{
+	portENTER_CRITICAL(&tx_mux);
+	fair_scheduling = false;
+	portEXIT_CRITICAL(&tx_mux);
+	// the TX task sends what the scheduler holds first
+	if (txPending != NULL)
+		xSemaphoreGive(txPending);
+	MONITOR(TAG_CORE, "Fair scheduler disabled");
+}
+
+bool EasyEspNow::setPeerRateLimit(const uint8_t *peer_addr, uint32_t bytes_per_s, uint16_t burst_bytes)
+{
+	if (!peer_addr)
+	{
+		ERROR(TAG_PEERS, "Parameters Error");
+		return false;
+	}
+
+	// a burst shorter than a frame would hold that frame forever
+	if (burst_bytes < MAX_DATA_LENGTH)
+		burst_bytes = MAX_DATA_LENGTH;
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	if (index >= 0)
+	{
+		table.at(index).rate_bytes_per_s = bytes_per_s;
+		table.at(index).rate_burst = bytes_per_s ? burst_bytes : 0;
+	}
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (index < 0)
+	{
+		WARNING(TAG_PEERS, "Can not set the rate limit of peer: [" EASYMACSTR "]. Peer does not exist", EASYMAC2STR(peer_addr));
+		return false;
+	}
+	if (bytes_per_s)
+		MONITOR(TAG_PEERS, "Peer: [" EASYMACSTR "] capped to %" PRIu32 " bytes/s, burst %d bytes", EASYMAC2STR(peer_addr), bytes_per_s, burst_bytes);
+	else
+		MONITOR(TAG_PEERS, "Peer: [" EASYMACSTR "] rate cap removed", EASYMAC2STR(peer_addr));
+	return true;
+}
+
+uint8_t EasyEspNow::getTXDestinationStats(tx_destination_stats_t *stats, uint8_t max_stats, bool reset)
+{
+	if (!stats)
+		return 0;
+
+	uint8_t count = 0;
+	uint32_t airtime_total_us;
+	portENTER_CRITICAL(&tx_mux);
+	airtime_total_us = fair_airtime_us;
+	for (uint8_t i = 0; fair_flows && i < fair_flow_count; i++)
+	{
+		tx_destination_stats_t &flow_stats = fair_flows[i].stats;
+		bool idle_shared = flow_stats.shared && !flow_stats.backlog && !flow_stats.frames && !flow_stats.dropped && !flow_stats.throttled;
+		if (!fair_flows[i].used || idle_shared)
+			continue;
+		if (count < max_stats)
+			stats[count++] = flow_stats;
+		if (reset)
+		{
+			// backlog is the current state of the queue, not a counter
+			flow_stats.backlog_max = flow_stats.backlog;
+			flow_stats.frames = 0;
+			flow_stats.bytes = 0;
+			flow_stats.airtime_us = 0;
+			flow_stats.dropped = 0;
+			flow_stats.throttled = 0;
+		}
+	}
+	if (reset)
+		fair_airtime_us = 0;
+	portEXIT_CRITICAL(&tx_mux);
+
+	for (uint8_t i = 0; i < count; i++)
+		stats[i].share_permille = airtime_total_us ? (uint16_t)((uint64_t)stats[i].airtime_us * 1000 / airtime_total_us) : 0;
+	return count;
+}
+
+/* ==========> Encryption Functions <========== */
+
+bool EasyEspNow::enableEncryption(uint8_t max_keys)
+{
+	if (max_keys < 1)
+	{
+		ERROR(TAG_CORE, "Invalid encryption parameters. Peer keys: %d, must be greater than 0", max_keys);
+		return false;
+	}
+
+	// aggregates and fragments are built to the frame length they were enabled with
+	if (aggregation_enabled || fragmentation_enabled)
+	{
+		ERROR(TAG_CORE, "Encryption must be enabled before aggregation and fragmentation");
+		return false;
+	}
+
+	peer_key_t *storage = (peer_key_t *)calloc(max_keys, sizeof(peer_key_t));
+	EasyPeerTable<peer_key_t> keys;
+	if (!storage || keys.begin(storage, max_keys) == false)
+	{
+		ERROR(TAG_CORE, "Failed to allocate %d peer keys", max_keys);
+		free(storage);
+		return false;
+	}
+
+	disableEncryption();
+
+	// a new epoch on every start, so the counter starting over never repeats a nonce
+	seal_epoch = ((uint32_t)random(0, 0x10000) << 16) | (uint32_t)random(0, 0x10000);
+	seal_counter = 0;
+
+	portENTER_CRITICAL(&keys_mux);
+	encryption_key_storage = storage;
+	encryption_keys = keys;
+	portEXIT_CRITICAL(&keys_mux);
+	max_frame_len = MAX_SEALED_DATA_LENGTH;
+	encryption_enabled = true;
+
+	MONITOR(TAG_CORE, "Encryption enabled. Peer keys: %d, max message length: %d bytes", max_keys, max_frame_len);
+	return true;
+}
+
+void EasyEspNow::disableEncryption()
+{
+	encryption_enabled = false;
+	max_frame_len = MAX_DATA_LENGTH;
+
+	portENTER_CRITICAL(&keys_mux);
+	EasyPeerTable<peer_key_t> keys = encryption_keys;
+	peer_key_t *storage = encryption_key_storage;
+	encryption_keys = EasyPeerTable<peer_key_t>();
+	encryption_key_storage = nullptr;
+	network_key.clear();
+	network_key_set = false;
+	portEXIT_CRITICAL(&keys_mux);
+
+	// key schedules are the keys, do not leave them in the heap
+	for (uint16_t i = 0; storage && i < keys.capacity(); i++)
+		storage[i].key.clear();
+	keys.end();
+	free(storage);
+}
+
+bool EasyEspNow::setPeerKey(const uint8_t *peer_addr, const uint8_t *key)
+{
+	if (!peer_addr)
+	{
+		ERROR(TAG_PEERS, "Parameters Error");
+		return false;
+	}
+
+	if (!encryption_enabled)
+	{
+		ERROR(TAG_PEERS, "Encryption is not enabled. Call enableEncryption(...) first");
+		return false;
+	}
+
+	// the key schedule is computed outside of the lock, only copied in under it
+	EasyAead schedule;
+	if (key)
+		schedule.setKey(key);
+	else
+		schedule.clear();
+
+	bool network = memcmp(peer_addr, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0;
+	bool done = true;
+	portENTER_CRITICAL(&keys_mux);
+	if (network)
+	{
+		network_key = schedule;
+		network_key_set = key != nullptr;
+	}
+	else if (key)
+	{
+		int index = encryption_keys.find(peer_addr);
+		if (index < 0)
+			index = encryption_keys.insert(peer_addr);
+		if (index >= 0)
+			encryption_keys.at(index).key = schedule;
+		done = index >= 0;
+	}
+	else
+	{
+		peer_key_t removed;
+		if (encryption_keys.remove(peer_addr, &removed))
+			removed.key.clear();
+	}
+	portEXIT_CRITICAL(&keys_mux);
+	schedule.clear();
+
+	if (!done)
+	{
+		ERROR(TAG_PEERS, "Can not set the key of peer: [" EASYMACSTR "]. All %d peer keys are in use", EASYMAC2STR(peer_addr), encryption_keys.capacity());
+		return false;
+	}
+
+	if (network)
+		MONITOR(TAG_PEERS, "Network key %s", key ? "set" : "removed");
+	else
+		MONITOR(TAG_PEERS, "Key of peer: [" EASYMACSTR "] %s", EASYMAC2STR(peer_addr), key ? "set" : "removed");
+	return true;
+}
+
+encryption_stats_t EasyEspNow::getEncryptionStats(bool reset)
+{
+	encryption_stats_t stats;
+	std::atomic<uint32_t> *counters[] = {&encryption_sealed, &encryption_sent_plain, &encryption_too_long, &encryption_opened,
+										 &encryption_auth_failures, &encryption_no_key, &encryption_plain_dropped};
+	uint32_t *values[] = {&stats.sealed, &stats.sent_plain, &stats.too_long, &stats.opened, &stats.auth_failures, &stats.no_key, &stats.plain_dropped};
+	for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++)
+		*values[i] = reset ? counters[i]->exchange(0, std::memory_order_relaxed) : counters[i]->load(std::memory_order_relaxed);
+	return stats;
+}
+
+/* ==========> Compression Functions <========== */
+
+bool EasyEspNow::enableCompression()
+{
+	compression_enabled = true;
+	uint8_t dictionaries = 0;
+	for (uint8_t i = 0; i < MAX_COMPRESSION_DICTIONARIES; i++)
+		dictionaries += compression_dictionaries[i] != nullptr;
+
+	MONITOR(TAG_CORE, "Compression enabled. Dictionaries: %d", dictionaries);
+	return true;
+}
+
+void EasyEspNow::disableCompression()
+{
+	compression_enabled = false;
+}
+
+bool EasyEspNow::setCompressionDictionary(uint8_t id, const uint8_t *dictionary, uint16_t len)
+{
+	if (id < 1 || id > MAX_COMPRESSION_DICTIONARIES || (dictionary && (len < EasyLz::MIN_MATCH || len > EasyLz::MAX_DICTIONARY_LEN)))
+	{
+		ERROR(TAG_CORE, "Invalid compression dictionary. Id must be between [%d ... %d], length between [%d ... %d] bytes", 1, MAX_COMPRESSION_DICTIONARIES,
+			  EasyLz::MIN_MATCH, EasyLz::MAX_DICTIONARY_LEN);
+		return false;
+	}
+
+	// the TX task and rx_cb read the dictionaries without a lock
+	if (compression_enabled)
+	{
+		ERROR(TAG_CORE, "Dictionaries can only change while compression is disabled. Call disableCompression() first");
+		return false;
+	}
+
+	EasyLz::Dictionary *indexed = nullptr;
+	if (dictionary)
+	{
+		indexed = (EasyLz::Dictionary *)calloc(1, sizeof(EasyLz::Dictionary));
+		if (!indexed)
+		{
+			ERROR(TAG_CORE, "Failed to allocate compression dictionary %d", id);
+			return false;
+		}
+		indexed->set(dictionary, len);
+	}
+
+	free(compression_dictionaries[id - 1]);
+	compression_dictionaries[id - 1] = indexed;
+
+	if (dictionary)
+		MONITOR(TAG_CORE, "Compression dictionary %d set, %d bytes", id, len);
+	return true;
+}
+
+bool EasyEspNow::setPeerCompression(const uint8_t *peer_addr, uint8_t dictionary)
+{
+	if (!peer_addr || (dictionary > MAX_COMPRESSION_DICTIONARIES && dictionary != COMPRESSION_OFF))
+	{
+		ERROR(TAG_PEERS, "Invalid peer compression: %d. Must be a dictionary id within [%d..%d], COMPRESSION_NO_DICTIONARY or COMPRESSION_OFF", dictionary,
+			  1, MAX_COMPRESSION_DICTIONARIES);
+		return false;
+	}
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	if (index >= 0)
+		table.at(index).compression = dictionary;
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (index < 0)
+	{
+		WARNING(TAG_PEERS, "Can not set the compression of peer: [" EASYMACSTR "]. Peer does not exist", EASYMAC2STR(peer_addr));
+		return false;
+	}
+	if (dictionary == COMPRESSION_OFF)
+		MONITOR(TAG_PEERS, "Frames to peer: [" EASYMACSTR "] are not compressed", EASYMAC2STR(peer_addr));
+	else
+		MONITOR(TAG_PEERS, "Frames to peer: [" EASYMACSTR "] are compressed with dictionary: %d", EASYMAC2STR(peer_addr), dictionary);
+	return true;
+}
+
+compression_stats_t EasyEspNow::getCompressionStats(bool reset)
+{
+	compression_stats_t stats;
+	std::atomic<uint32_t> *counters[] = {&compression_compressed, &compression_not_compressed, &compression_bytes_in, &compression_bytes_out,
+										 &compression_encode_us, &compression_inflated, &compression_decode_us, &compression_errors};
+	uint32_t *values[] = {&stats.compressed, &stats.not_compressed, &stats.bytes_in, &stats.bytes_out,
+						  &stats.encode_us, &stats.inflated, &stats.decode_us, &stats.errors};
+	for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++)
+		*values[i] = reset ? counters[i]->exchange(0, std::memory_order_relaxed) : counters[i]->load(std::memory_order_relaxed);
+	return stats;
+}
+
+/* ==========> Probe Functions <========== */
+
+bool EasyEspNow::enableProbes(uint16_t max_probes)
+{
+	if (max_probes > MAX_PING_PROBES)
+	{
+		ERROR(TAG_CORE, "Parameters Error. Probes per ping can be up to %d", MAX_PING_PROBES);
+		return false;
+	}
+
+	if (ping_reply == NULL)
+	{
+		ping_reply = xSemaphoreCreateBinary();
+		if (ping_reply == NULL)
+		{
+			ERROR(TAG_CORE, "Allocation failed for the ping reply semaphore");
+			return false;
+		}
+	}
+
+	probe_record_t *records = nullptr;
+	uint32_t *rtts = nullptr;
+	if (max_probes > 0)
+	{
+		records = (probe_record_t *)calloc(max_probes, sizeof(probe_record_t));
+		rtts = (uint32_t *)calloc(max_probes, sizeof(uint32_t));
+		if (!records || !rtts)
+		{
+			free(records);
+			free(rtts);
+			ERROR(TAG_CORE, "Allocation failed for the timestamps of %d probes", max_probes);
+			return false;
+		}
+	}
+
+	portENTER_CRITICAL(&probe_mux);
+	bool running = ping_running;
+	probe_record_t *old_records = ping_records;
+	uint32_t *old_rtts = ping_rtts;
+	if (!running)
+	{
+		ping_records = records;
+		ping_rtts = rtts;
+		ping_max_probes = max_probes;
+	}
+	portEXIT_CRITICAL(&probe_mux);
+	if (running)
+	{
+		free(records);
+		free(rtts);
+		ERROR(TAG_CORE, "Probes can not be changed while a ping is running");
+		return false;
+	}
+	free(old_records);
+	free(old_rtts);
+	probes_enabled = true;
+
+	MONITOR(TAG_CORE, "Probes enabled, up to %d per ping", max_probes);
+	return true;
+}
+
+void EasyEspNow::disableProbes()
+{
+	portENTER_CRITICAL(&probe_mux);
+	bool running = ping_running;
+	probe_record_t *old_records = running ? nullptr : ping_records;
+	uint32_t *old_rtts = running ? nullptr : ping_rtts;
+	if (!running)
+	{
+		ping_records = nullptr;
+		ping_rtts = nullptr;
+		ping_max_probes = 0;
+	}
+	portEXIT_CRITICAL(&probe_mux);
+	if (running)
+	{
+		WARNING(TAG_CORE, "Probes can not be disabled while a ping is running");
+		return;
+	}
+	probes_enabled = false;
+	free(old_records);
+	free(old_rtts);
+	if (ping_reply != NULL)
+	{
+		vSemaphoreDelete(ping_reply);
+		ping_reply = NULL;
+	}
+}
+
+bool EasyEspNow::ping(const uint8_t *peer_addr, uint16_t count, uint8_t size, ping_result_t *result, uint32_t interval_ms, uint32_t timeout_ms)
+{
+	if (!probes_enabled || ping_max_probes == 0)
+	{
+		ERROR(TAG_CORE, "Probes are not enabled for pinging. Call enableProbes(...) first");
+		return false;
+	}
+	if (!peer_addr || !result || memcmp(peer_addr, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0 || memcmp(peer_addr, zero_mac, MAC_ADDR_LEN) == 0)
+	{
+		ERROR(TAG_CORE, "Parameters Error. A ping needs a unicast peer and a result");
+		return false;
+	}
+	if (count == 0 || count > ping_max_probes || size < EASY_PROBE_OVERHEAD || size > max_frame_len)
+	{
+		ERROR(TAG_CORE, "Parameters Error. A ping sends 1 to %d probes of %d to %d bytes", ping_max_probes, EASY_PROBE_OVERHEAD, max_frame_len);
+		return false;
+	}
+
+	portENTER_CRITICAL(&probe_mux);
+	bool running = ping_running;
+	if (!running)
+	{
+		ping_running = true;
+		ping_id++;
+		ping_count = count;
+		ping_replies = 0;
+		memcpy(ping_peer, peer_addr, MAC_ADDR_LEN);
+		memset(ping_records, 0, count * sizeof(probe_record_t));
+	}
+	uint16_t id = ping_id;
+	portEXIT_CRITICAL(&probe_mux);
+	if (running)
+	{
+		WARNING(TAG_CORE, "Another ping is running");
+		return false;
+	}
+	// a reply of the previous ping may have come after it returned
+	xSemaphoreTake(ping_reply, 0);
+
+	memset(result, 0, sizeof(ping_result_t));
+	uint16_t sent = 0;
+	TickType_t start = xTaskGetTickCount();
+	for (uint16_t seq = 0; seq < count; seq++)
+	{
+		// probes keep their pace even if one of them waited for a slot
+		int32_t wait = (int32_t)(start + pdMS_TO_TICKS(interval_ms) * seq - xTaskGetTickCount());
+		if (wait > 0)
+			vTaskDelay(wait);
+
+		tx_queue_item_t *slot = acquireLibraryTXSlot(pdMS_TO_TICKS(interval_ms ? interval_ms : timeout_ms));
+		if (!slot)
+		{
+			WARNING(TAG_CORE, "No TX slot for probe %d, counted as lost", seq);
+			continue;
+		}
+		easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_PROBE};
+		easy_probe_header_t header = {};
+		header.ping_id = id;
+		header.seq = seq;
+		memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+		memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_PROBE_HEADER_LEN);
+		memset(slot->payload_data + EASY_PROBE_OVERHEAD, 0, size - EASY_PROBE_OVERHEAD);
+		tx_slot_states[slotIndex(slot)].probe = ((uint32_t)id << 16) | (uint32_t)(seq + 1);
+
+		portENTER_CRITICAL(&probe_mux);
+		ping_records[seq].queued_us = esp_timer_get_time();
+		portEXIT_CRITICAL(&probe_mux);
+		easy_send_error_t err = queueTXSlot(slot, peer_addr, size, timeout_ms);
+		if (err == EASY_SEND_OK)
+			sent++;
+		else
+		{
+			portENTER_CRITICAL(&probe_mux);
+			ping_records[seq].queued_us = 0;
+			portEXIT_CRITICAL(&probe_mux);
+		}
+	}
+
+	TickType_t last_sent = xTaskGetTickCount();
+	while (true)
+	{
+		portENTER_CRITICAL(&probe_mux);
+		bool all_replied = ping_replies >= sent;
+		portEXIT_CRITICAL(&probe_mux);
+		TickType_t elapsed = xTaskGetTickCount() - last_sent;
+		if (all_replied || elapsed >= pdMS_TO_TICKS(timeout_ms))
+			break;
+		xSemaphoreTake(ping_reply, pdMS_TO_TICKS(timeout_ms) - elapsed);
+	}
+
+	// from here on no reply or stamp touches the records
+	portENTER_CRITICAL(&probe_mux);
+	ping_running = false;
+	portEXIT_CRITICAL(&probe_mux);
+
+	uint16_t replied = 0;
+	uint16_t best = 0;
+	uint64_t rtt_sum = 0, queue_sum = 0, air_sum = 0, turnaround_sum = 0;
+	uint16_t queued = 0, completed = 0;
+	for (uint16_t seq = 0; seq < count; seq++)
+	{
+		const probe_record_t &record = ping_records[seq];
+		if (!record.queued_us)
+			continue;
+		result->sent++;
+		if (record.sent_us)
+		{
+			queue_sum += record.sent_us - record.queued_us;
+			queued++;
+			if (record.completed_us)
+			{
+				air_sum += record.completed_us - record.sent_us;
+				completed++;
+			}
+		}
+		if (!record.reply_us)
+			continue;
+
+		// a reply faster than the stamp of esp_now_send falls back to the commit
+		int64_t from_us = record.sent_us ? record.sent_us : record.queued_us;
+		int64_t turnaround_us = record.remote_reply_us - record.remote_rx_us;
+		int64_t rtt_us = record.reply_us - from_us - turnaround_us;
+		ping_rtts[replied] = rtt_us > 0 ? (uint32_t)rtt_us : 0;
+		if (replied == 0 || ping_rtts[replied] < ping_rtts[best])
+			best = replied;
+		rtt_sum += ping_rtts[replied];
+		turnaround_sum += turnaround_us > 0 ? turnaround_us : 0;
+		// remember which probe a round trip belongs to for the clock offset
+		if (best == replied)
+			result->clock_offset_us = ((record.remote_rx_us - from_us) + (record.remote_reply_us - record.reply_us)) / 2;
+		replied++;
+	}
+
+	result->received = replied;
+	result->loss_permille = result->sent ? (uint16_t)((uint32_t)(result->sent - replied) * 1000 / result->sent) : 0;
+	result->queue_avg_us = queued ? queue_sum / queued : 0;
+	result->air_avg_us = completed ? air_sum / completed : 0;
+	if (replied == 0)
+		return true;
+
+	int64_t forward_sum = 0, return_sum = 0;
+	for (uint16_t seq = 0; seq < count; seq++)
+	{
+		const probe_record_t &record = ping_records[seq];
+		if (!record.queued_us || !record.reply_us)
+			continue;
+		int64_t from_us = record.sent_us ? record.sent_us : record.queued_us;
+		forward_sum += record.remote_rx_us - from_us - result->clock_offset_us;
+		return_sum += record.reply_us - record.remote_reply_us + result->clock_offset_us;
+	}
+	result->forward_avg_us = (int32_t)(forward_sum / replied);
+	result->return_avg_us = (int32_t)(return_sum / replied);
+	result->rtt_avg_us = rtt_sum / replied;
+	result->turnaround_avg_us = turnaround_sum / replied;
+
+	// insertion sort, a ping is short and mostly in order already
+	for (uint16_t i = 1; i < replied; i++)
+	{
+		uint32_t rtt_us = ping_rtts[i];
+		uint16_t j = i;
+		for (; j > 0 && ping_rtts[j - 1] > rtt_us; j--)
+			ping_rtts[j] = ping_rtts[j - 1];
+		ping_rtts[j] = rtt_us;
+	}
+	result->rtt_min_us = ping_rtts[0];
+	result->rtt_max_us = ping_rtts[replied - 1];
+	result->rtt_p99_us = ping_rtts[(replied * 99 + 99) / 100 - 1];
+
+	MONITOR(TAG_CORE, "Ping [" EASYMACSTR "]: %d/%d replies, RTT min/avg/p99/max %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 " us", EASYMAC2STR(peer_addr), replied, result->sent,
+			result->rtt_min_us, result->rtt_avg_us, result->rtt_p99_us, result->rtt_max_us);
+	return true;
+}
+
+/* ==========> Peer Management Functions <========== */
+
+bool EasyEspNow::addPeer(const uint8_t *peer_addr_to_add)
+{
+	if (directory_table.capacity() > 0)
+	{
+		// logical peer, registered in ESP-NOW now only if there is room, otherwise swapped in when sending to it
+		portENTER_CRITICAL(&peers_mux);
+		int index = directory_table.insert(peer_addr_to_add);
+		if (index >= 0)
+		{
+			directory_table.at(index).time_peer_added = millis();
+			directory_table.at(index).frames_in_flight = 0;
+			directory_table.at(index).groups = 0;
+			directory_table.at(index).channel = 0;
+			directory_table.at(index).compression = COMPRESSION_OFF;
+			directory_table.at(index).rate_bytes_per_s = 0;
+			directory_table.at(index).rate_burst = 0;
+			directory_table.at(index).stats = {};
+		}
+		bool room_in_esp_now = !peer_table.full();
+		portEXIT_CRITICAL(&peers_mux);
+
+		if (index < 0)
+		{
+			ERROR(TAG_PEERS, "Failed to add peer: [" EASYMACSTR "] to the peer directory. Directory is full or peer exists", EASYMAC2STR(peer_addr_to_add));
+			return false;
+		}
+
+		if (room_in_esp_now && registerPeer(peer_addr_to_add) != ESP_OK)
+		{
+			WARNING(TAG_PEERS, "Peer: [" EASYMACSTR "] added to the peer directory only. Failed to register it in ESP-NOW with error: %s", EASYMAC2STR(peer_addr_to_add), esp_err_to_name(err));
+		}
+
+		MONITOR(TAG_PEERS, "Successfully added peer: [" EASYMACSTR "]. Total peers = %d, in ESP-NOW = %d", EASYMAC2STR(peer_addr_to_add), directory_table.size(), peer_list.peer_number);
+		return true;
+	}
+
+	err = registerPeer(peer_addr_to_add);
+	if (err == ESP_OK)
+	{
+		MONITOR(TAG_PEERS, "Successfully added peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_add), peer_list.peer_number);
+		return true;
+	}
+	else
+	{
+		ERROR(TAG_PEERS, "Failed to add peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_addr_to_add), esp_err_to_name(err));
+		return false;
+	}
+}
+
+bool EasyEspNow::deletePeer(const uint8_t *peer_addr_to_delete)
+{
+	bool in_directory = false;
+	bool in_esp_now = true;
+	if (directory_table.capacity() > 0)
+	{
+		portENTER_CRITICAL(&peers_mux);
+		in_directory = directory_table.remove(peer_addr_to_delete);
+		in_esp_now = peer_table.find(peer_addr_to_delete) >= 0;
+		portEXIT_CRITICAL(&peers_mux);
+	}
+
+	if (in_directory && !in_esp_now)
+	{
+		MONITOR(TAG_PEERS, "Successfully deleted peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_delete), directory_table.size());
+		return true;
+	}
+
+	err = esp_now_del_peer(peer_addr_to_delete);
+	if (err == ESP_OK)
+	{
+		// the last peer fills the gap, no shifting
+		portENTER_CRITICAL(&peers_mux);
+		peer_table.remove(peer_addr_to_delete);
+		peer_list.peer_number = peer_table.size();
+		portEXIT_CRITICAL(&peers_mux);
+
+		MONITOR(TAG_PEERS, "Successfully deleted peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_delete), peer_list.peer_number);
+		return true;
+	}
+	else
+	{
+		ERROR(TAG_PEERS, "Failed to delete peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_addr_to_delete), esp_err_to_name(err));
+		return false;
+	}
+}
+
+peer_t EasyEspNow::deletePeer(bool keep_broadcast_addr)
+{
+	peer_t oldest_peer = {}; // for an invalid peer
+	EasyPeerTable<peer_t> &table = directory_table.capacity() > 0 ? directory_table : peer_table;
+
+	//  Time, is saved in millis, time increases, so the oldest peer is at the head of the age order of the table
+	portENTER_CRITICAL(&peers_mux);
+	int oldest_index = table.oldest(keep_broadcast_addr ? ESPNOW_BROADCAST_ADDRESS : nullptr);
+	if (oldest_index >= 0)
+		oldest_peer = table.at(oldest_index);
+	portEXIT_CRITICAL(&peers_mux);
+
+	DEBUG(TAG_PEERS, "Oldest index: %d", oldest_index);
+
+	if (oldest_index < 0)
+	{
+		WARNING(TAG_PEERS, "No valid peer found to delete!");
+		return oldest_peer; // No valid peer to delete
+	}
+
+	if (deletePeer(oldest_peer.mac))
+		return oldest_peer;
+
+	return peer_t{};
+}
+
+peer_t EasyEspNow::getPeer(const uint8_t *peer_addr_to_get, esp_now_peer_info_t &peer_info)
+{
+	peer_t peer = {}; // for an invalid peer
+	err = esp_now_get_peer(peer_addr_to_get, &peer_info);
+	if (err == ESP_OK)
+	{
+		portENTER_CRITICAL(&peers_mux);
+		int index = peer_table.find(peer_addr_to_get);
+		if (index >= 0)
+			peer = peer_table.at(index);
+		portEXIT_CRITICAL(&peers_mux);
+
+		if (index >= 0)
+			DEBUG(TAG_PEERS, "Success getting peer: [" EASYMACSTR "]. Total peers = %d", EASYMAC2STR(peer_addr_to_get), peer_list.peer_number);
+		return peer;
+	}
+
+	// peer may be only in the directory, it gets the same info it would get when registered in ESP-NOW
+	portENTER_CRITICAL(&peers_mux);
+	int index = directory_table.find(peer_addr_to_get);
+	if (index >= 0)
+		peer = directory_table.at(index);
+	portEXIT_CRITICAL(&peers_mux);
+	if (index >= 0)
+	{
+		memset(&peer_info, 0, sizeof(peer_info));
+		memcpy(peer_info.peer_addr, peer_addr_to_get, MAC_ADDR_LEN);
+		peer_info.ifidx = wifi_phy_interface;
+		peer_info.channel = channel_peers_follow ? 0 : wifi_primary_channel;
+		peer_info.encrypt = false;
+		DEBUG(TAG_PEERS, "Success getting peer: [" EASYMACSTR "] from the peer directory", EASYMAC2STR(peer_addr_to_get));
+		return peer;
+	}
+
+	ERROR(TAG_PEERS, "Failed to get peer: [" EASYMACSTR "] with error: %s\n", EASYMAC2STR(peer_addr_to_get), esp_err_to_name(err));
+	return peer; // return invalid peer
+}
+
+bool EasyEspNow::peerExists(const uint8_t *peer_addr)
+{
+	if (esp_now_is_peer_exist(peer_addr))
+		return true;
+
+	portENTER_CRITICAL(&peers_mux);
+	bool in_directory = directory_table.find(peer_addr) >= 0;
+	portEXIT_CRITICAL(&peers_mux);
+	return in_directory;
+}
+
+bool EasyEspNow::updateLastSeenPeer(const uint8_t *peer_addr)
+{
+	uint32_t last_seen = millis();
+
+	portENTER_CRITICAL(&peers_mux);
+	int index = peer_table.find(peer_addr);
+	if (index >= 0)
+	{
+		peer_table.at(index).time_peer_added = last_seen;
+		peer_table.touch(index);
+	}
+	int directory_index = directory_table.find(peer_addr);
+	if (directory_index >= 0)
+	{
+		directory_table.at(directory_index).time_peer_added = last_seen;
+		directory_table.touch(directory_index);
+	}
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (index >= 0 || directory_index >= 0)
+	{
+		INFO(TAG_PEERS, "Peer[#%d] with MAC: " EASYMACSTR " was updated to last seen: %d ms", (index >= 0 ? index : directory_index) + 1, EASYMAC2STR(peer_addr), last_seen);
+		return true;
+	}
+	WARNING(TAG_PEERS, "Not possible to update last seen for MAC: " EASYMACSTR ". Maybe it does not exists as a peer!", EASYMAC2STR(peer_addr));
+	return false;
+}
+
+bool EasyEspNow::enablePeerDirectory(uint16_t capacity)
+{
+	if (directory_table.capacity() > 0)
+	{
+		WARNING(TAG_PEERS, "Peer directory is already enabled with capacity: %d", directory_table.capacity());
+		return false;
+	}
+
+	if (capacity < MAX_TOTAL_PEER_NUM)
+	{
+		ERROR(TAG_PEERS, "Peer directory capacity: %d. Must be at least: %d", capacity, MAX_TOTAL_PEER_NUM);
+		return false;
+	}
+
+	peer_t *storage = (peer_t *)calloc(capacity, sizeof(peer_t));
+	EasyPeerTable<peer_t> table;
+	if (!storage || table.begin(storage, capacity) == false)
+	{
+		ERROR(TAG_PEERS, "Failed to allocate peer directory for %d peers", capacity);
+		free(storage);
+		return false;
+	}
+
+	portENTER_CRITICAL(&peers_mux);
+	// peers already registered in ESP-NOW keep their age order
+	for (int i = peer_table.newer(-1); i >= 0; i = peer_table.newer(i))
+	{
+		int index = table.insert(peer_table.at(i).mac);
+		table.at(index).time_peer_added = peer_table.at(i).time_peer_added;
+		// group membership lives in the directory from now on
+		table.at(index).groups = peer_table.at(i).groups;
+		table.at(index).channel = peer_table.at(i).channel;
+		table.at(index).compression = peer_table.at(i).compression;
+		table.at(index).rate_bytes_per_s = peer_table.at(i).rate_bytes_per_s;
+		table.at(index).rate_burst = peer_table.at(i).rate_burst;
+		table.at(index).stats = peer_table.at(i).stats;
+	}
+	// table was built aside, publish it under the lock so TX and RX paths never see it half initialized
+	peer_directory = storage;
+	directory_table = table;
+	portEXIT_CRITICAL(&peers_mux);
+
+	MONITOR(TAG_PEERS, "Peer directory enabled. Capacity: %d peers, %d peers already added", capacity, directory_table.size());
+	return true;
+}
+
+peer_directory_stats_t EasyEspNow::getPeerDirectoryStats(bool reset)
+{
+	peer_directory_stats_t stats;
+	stats.hits = reset ? directory_hits.exchange(0) : directory_hits.load();
+	stats.misses = reset ? directory_misses.exchange(0) : directory_misses.load();
+	stats.swaps = reset ? directory_swaps.exchange(0) : directory_swaps.load();
+	stats.swap_failures = reset ? directory_swap_failures.exchange(0) : directory_swap_failures.load();
+	stats.swap_time_total_us = reset ? directory_swap_time_total_us.exchange(0) : directory_swap_time_total_us.load();
+	stats.swap_time_max_us = reset ? directory_swap_time_max_us.exchange(0) : directory_swap_time_max_us.load();
+	stats.directory_peers = directory_table.size();
+	stats.directory_capacity = directory_table.capacity();
+	return stats;
+}
+
+easy_stats_t EasyEspNow::getStats(bool reset)
+{
+	easy_stats_t stats;
+	for (uint8_t i = 0; i < EASY_SEND_RESULTS; i++)
+		stats.send_results[i] = reset ? stats_send_results[i].exchange(0) : stats_send_results[i].load();
+
+	portENTER_CRITICAL(&tx_mux);
+	stats.tx_queue_depth = stats_tx_queue_depth;
+	stats.tx_queue_depth_max = stats_tx_queue_depth_max;
+	if (reset)
+		stats_tx_queue_depth_max = stats_tx_queue_depth;
+	portEXIT_CRITICAL(&tx_mux);
+
+	stats.esp_now_send_calls = reset ? stats_esp_now_send_calls.exchange(0) : stats_esp_now_send_calls.load();
+	stats.esp_now_send_errors = reset ? stats_esp_now_send_errors.exchange(0) : stats_esp_now_send_errors.load();
+	stats.esp_now_send_no_mem = reset ? stats_esp_now_send_no_mem.exchange(0) : stats_esp_now_send_no_mem.load();
+	stats.tx_delivered = reset ? stats_tx_delivered.exchange(0) : stats_tx_delivered.load();
+	stats.tx_failed = reset ? stats_tx_failed.exchange(0) : stats_tx_failed.load();
+	stats.tx_completion_timeouts = reset ? stats_tx_completion_timeouts.exchange(0) : stats_tx_completion_timeouts.load();
+	stats.tx_late_completions = reset ? stats_tx_late_completions.exchange(0) : stats_tx_late_completions.load();
+	stats.enqueue_to_send = stats_enqueue_to_send.snapshot(reset);
+	stats.send_to_complete = stats_send_to_complete.snapshot(reset);
+	stats.send_completions_missed = reset ? send_completions_missed.exchange(0) : send_completions_missed.load();
+	return stats;
+}
+
+bool EasyEspNow::getPeerStats(const uint8_t *peer_addr, peer_stats_t &stats, bool reset)
+{
+	if (!peer_addr)
+		return false;
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(peer_addr);
+	if (index >= 0)
+	{
+		peer_stats_t &current = table.at(index).stats;
+		stats = current;
+		if (reset)
+		{
+			current.rx_frames = 0;
+			current.tx_frames = 0;
+			current.tx_failed = 0;
+		}
+	}
+	portEXIT_CRITICAL(&peers_mux);
+
+	if (index < 0)
+	{
+		WARNING(TAG_PEERS, "No stats for MAC: " EASYMACSTR ". Maybe it does not exists as a peer!", EASYMAC2STR(peer_addr));
+		return false;
+	}
+	return true;
+}
+
+int EasyEspNow::countPeers(CountPeers count_type)
+{
+	esp_now_peer_num_t num;
+
+	err = esp_now_get_peer_num(&num);
+	if (err == ESP_OK)
+	{
+		switch (count_type)
+		{
+		case TOTAL_NUM:
+			return num.total_num;
+		case ENCRYPTED_NUM:
+			return num.encrypt_num;
+		case UNENCRYPTED_NUM:
+			return num.total_num - num.encrypt_num;
+		default:
+			ERROR(TAG_PEERS, "Invalid option chosen for peer count type!");
+			return -1;
+		}
+	}
+	else
+	{
+		ERROR(TAG_PEERS, "Failed to get peer count with error: %s", esp_err_to_name(err));
+		return -1;
+	}
+}
+
+void EasyEspNow::printPeerList()
+{
+	Serial.printf("\n\nPrinting Peer List! Number of peers %d\n", peer_list.peer_number);
+	for (int i = peer_table.newer(-1); i >= 0; i = peer_table.newer(i))
+	{
+		Serial.printf("Peer [" EASYMACSTR "] with timestamp %" PRIu32 " is %lu ms old\n", MAC2STR(peer_list.peer[i].mac), peer_list.peer[i].time_peer_added, millis() - peer_list.peer[i].time_peer_added);
+	}
+	Serial.printf("\n\n");
+}
+
+/* ==========> Miscellaneous Functions <========== */
+
+const char *EasyEspNow::easySendErrorToName(easy_send_error_t send_error)
+{
+	switch (send_error)
+	{
+	case EASY_SEND_OK:
+		return "EASY_SEND_OK";
+	case EASY_SEND_PARAM_ERROR:
+		return "EASY_SEND_PARAM_ERROR";
+	case EASY_SEND_PAYLOAD_LENGTH_ERROR:
+		return "EASY_SEND_PAYLOAD_LENGTH_ERROR";
+	case EASY_SEND_QUEUE_FULL_ERROR:
+		return "EASY_SEND_QUEUE_FULL_ERROR";
+	case EASY_SEND_MSG_ENQUEUE_ERROR:
+		return "EASY_SEND_MSG_ENQUEUE_ERROR";
+	case EASY_SEND_CONFIRM_ERROR:
+		return "EASY_SEND_CONFIRM_ERROR";
+	default:
+		return "UNKNOWN_ERROR";
+	}
+}
+
+wifi_interface_t EasyEspNow::autoselect_if_from_mode(wifi_mode_t mode, bool apstaMOD_to_apIF)
+{
+	if (mode == WIFI_MODE_NULL || mode == WIFI_MODE_MAX)
+	{
+		WARNING(TAG_MISC, "Useless WiFi modes, defaulting WiFi interface to: WIFI_IF_STA");
+		return WIFI_IF_STA;
+	}
+	else if (mode == WIFI_MODE_STA)
+	{
+		INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_STA  ==>  Auto Selecting WiFi interface: WIFI_IF_STA");
+		return WIFI_IF_STA;
+	}
+	else if (mode == WIFI_MODE_AP)
+	{
+		INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_AP  ==>  Auto Selecting WiFi interface: WIFI_IF_AP");
+		return WIFI_IF_AP;
+	}
+	else if (mode == WIFI_MODE_APSTA)
+	{
+		if (apstaMOD_to_apIF == true)
+		{
+			INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_APSTA & apstaMOD_to_apIF = true  ==>  Auto Selecting WiFi interface: WIFI_IF_AP");
+			return WIFI_IF_AP;
+		}
+		else if (apstaMOD_to_apIF == false)
+		{
+			INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_APSTA & apstaMOD_to_apIF = false  ==>  Auto Selecting WiFi interface: WIFI_IF_STA");
+			return WIFI_IF_STA;
+		}
+	}
+
+	WARNING(TAG_MISC, "Unknown WiFi mode %d, defaulting WiFi interface to: WIFI_IF_STA", mode);
+	return WIFI_IF_STA;
+}
+
+char *EasyEspNow::easyMac2Char(const uint8_t *some_mac, size_t len, bool upper_case)
+{
+	const uint8_t default_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+	const char *format;
+	if (upper_case)
+		format = "%02X:%02X:%02X:%02X:%02X:%02X";
+	else
+		format = "%02x:%02x:%02x:%02x:%02x:%02x";
+
+	if (!some_mac || len != 6)
+	{
+		some_mac = default_mac;
+		// WARNING(TAG_MISC, "MAC argument is either null or has a length different from 6.  Defaulting to MAC: [00:00:00:00:00:00]");
+	}
+
+	static char mac_2_char[18] = {0};
+	sprintf(mac_2_char, format, some_mac[0], some_mac[1], some_mac[2], some_mac[3], some_mac[4], some_mac[5]);
+	return mac_2_char;
+}
+
+void EasyEspNow::easyPrintMac2Char(const uint8_t *some_mac, size_t len, bool upper_case)
+{
+	const uint8_t default_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+	const char *format;
+	if (upper_case)
+		format = "%02X:%02X:%02X:%02X:%02X:%02X";
+	else
+		format = "%02x:%02x:%02x:%02x:%02x:%02x";
+
+	if (!some_mac || len != 6)
+	{
+		some_mac = default_mac;
+		// WARNING(TAG_MISC, "MAC argument is either null or has a length different from 6.  Defaulting to MAC: [00:00:00:00:00:00]");
+		return;
+	}
+
+	Serial.printf(format, some_mac[0], some_mac[1], some_mac[2], some_mac[3], some_mac[4], some_mac[5]);
+}
+
+int32_t EasyEspNow::getEspNowVersion()
+{
+	uint32_t esp_now_version;
+	err = esp_now_get_version(&esp_now_version);
+	if (err != ESP_OK)
+	{
+		ERROR(TAG_MISC, "Failed to get ESP-NOW version with error: %s", esp_err_to_name(err));
+		return -1;
+	}
+	else
+	{
+		MONITOR(TAG_MISC, "Success getting ESP-NOW version");
+		return (int32_t)esp_now_version;
+	}
+}
+
+uint8_t *EasyEspNow::getDeviceMACAddress()
+{
+	if (memcmp(my_mac_address, zero_mac, MAC_ADDR_LEN) == 0)
+	{
+		WARNING(TAG_MISC, "This device's MAC is not avaiable");
+		return nullptr;
+	}
+
+	return this->my_mac_address;
+}
+
+uint8_t *EasyEspNow::generateRandomMAC(bool local, bool unicast)
+{
+	static uint8_t mac[6]; // Static array to hold the MAC address
+
+	for (int i = 0; i < 6; i++)
+	{
+		mac[i] = random(0, 256); // Generate random byte for each part of the MAC
+	}
+
+	// Set or clear the local bit (bit 1 of the first byte) based on the local flag
+	if (local)
+		mac[0] |= 0x02; // Set to indicate locally administered
+	else
+		mac[0] &= 0xFD; // Clear to indicate globally unique
+
+	// Set or clear the unicast/multicast bit (bit 0 of the first byte) based on the unicast flag
+	if (unicast)
+		mac[0] &= 0xFE; // Clear to indicate unicast
+	else
+		mac[0] |= 0x01; // Set to indicate multicast
+
+	return mac; // Return the pointer to the MAC address array
+}
+
+bool EasyEspNow::switchChannel(uint8_t primary, wifi_second_chan_t second)
+{
+	if (primary < 1 || primary > 14)
+	{
+		WARNING(TAG_MISC, "Can't switch channel. Invalid value[%d] provided. Must be within the range [1..14]", primary);
+		return false;
+	}
+
+	if (tx_channel != 0)
+	{
+		// the channel scheduler owns the radio, it goes to the new home channel once the frames of its channel are sent
+		portENTER_CRITICAL(&tx_mux);
+		wifi_primary_channel = primary;
+		wifi_secondary_channel = second;
+		portEXIT_CRITICAL(&tx_mux);
+		xSemaphoreGive(txPending);
+		MONITOR(TAG_MISC, "Home channel set to: %d. Channel scheduler will move the radio", primary);
+		return true;
+	}
+
+	// This will set the WiFi channel for the home (this station)
+	if (setChannel(primary, second))
+		return setEspNowPeersChannel(primary);
+	else
+		return false;
+}
+
+/* ==========> Helper Functions for the Core Functions <========== */
+
+bool EasyEspNow::initComms()
+{
+	// Init ESP-NOW here
+	err = esp_now_init();
+	if (err == ESP_OK)
+	{
+		MONITOR(TAG_HELPER, "Success initializing ESP-NOW");
+	}
+	else
+	{
+		MONITOR(TAG_HELPER, "Failed to initialize ESP-NOW");
+		ERROR(TAG_HELPER, "Failed to initialize ESP-NOW with error: %s", esp_err_to_name(err));
+		return false;
+	}
+
+	if (peer_table.capacity() == 0 && peer_table.begin(peer_list.peer, MAX_TOTAL_PEER_NUM) == false)
+	{
+		ERROR(TAG_HELPER, "Failed to allocate the peer table");
+		return false;
+	}
+	peer_table.clear();
+	peer_list.peer_number = 0;
+
+	// rx_cb and tx_cb are static, they reach this instance through its radio
+	radioOwner() = this;
+
+	// Register low-level rx cb
+	err = esp_now_register_recv_cb(rx_cb);
+	if (err == ESP_OK)
+	{
+		MONITOR(TAG_HELPER, "Success registering low level ESP-NOW RX callback");
+	}
+	else
+	{
+		MONITOR(TAG_HELPER, "Failed registering low level ESP-NOW RX callback");
+		ERROR(TAG_HELPER, "Failed registering low level ESP-NOW RX callback with error: %s", esp_err_to_name(err));
+		return false;
+	}
+
+	// Register low-level tx cb
+	err = esp_now_register_send_cb(tx_cb);
+	if (err == ESP_OK)
+	{
+		MONITOR(TAG_HELPER, "Success registering low level ESP-NOW TX callback");
+	}
+	else
+	{
+		MONITOR(TAG_HELPER, "Failed registering low level ESP-NOW TX callback");
+		ERROR(TAG_HELPER, "Failed registering low level ESP-NOW TX callback with error: %s", esp_err_to_name(err));
+		return false;
+	}
+
+	// one slot for the application when synchronous send mode, plus the ones kept for the frames of the library: its blocked
+	// send(...) holds its slot until the delivery status comes, acknowledgements and replies must not wait behind it
+	if (this->synchronous_send == true)
+	{
+		tx_user_slots = 1;
+		tx_queue_size = tx_user_slots + TX_SYNC_LIBRARY_SLOTS;
+	}
+	else
+		tx_user_slots = tx_queue_size;
+
+	if (initTXSlots() == false)
+	{
+		ERROR(TAG_HELPER, "Failed to create TX Queue");
+		// Handle the error, possibly halt or retry queue creation
+		return false;
+	}
+	else
+	{
+		MONITOR(TAG_HELPER, "Successfully created TX Queue with %d preallocated slots", tx_queue_size);
+	}
+
+	BaseType_t task_creation_result = xTaskCreateUniversal(easyEspNowTxQueueTask, "send_esp_now", 8 * 1024, this, 1, &txTaskHandle, CONFIG_ARDUINO_RUNNING_CORE);
+	if (task_creation_result != pdPASS)
+	{
+		// Task creation failed
+		ERROR(TAG_HELPER, "TX Task creation failed! Error: %d", task_creation_result);
+		return false;
+	}
+	else
+	{
+		// Task creation succeeded
+		MONITOR(TAG_HELPER, "TX Task creation successful");
+	}
+
+	MONITOR(TAG_HELPER, "TX Synchronous Send mode is set to: [ %s ]. TX Queue Size is set to: [ %d ], [ %d ] more kept for the library",
+			this->synchronous_send ? "TRUE" : "FALSE", tx_user_slots, tx_queue_size - tx_user_slots);
+
+	return true;
+}
+
+bool EasyEspNow::initTXSlots()
+{
+	deinitTXSlots();
+
+	tx_slots = (tx_queue_item_t *)calloc(tx_queue_size, sizeof(tx_queue_item_t));
+	tx_slot_states = (tx_slot_state_t *)calloc(tx_queue_size, sizeof(tx_slot_state_t));
+	tx_in_flight_capacity = tx_queue_size * 2;
+	tx_in_flight_slots = (tx_in_flight_t *)calloc(tx_in_flight_capacity, sizeof(tx_in_flight_t));
+	tx_messages = (tx_message_state_t *)calloc(tx_queue_size, sizeof(tx_message_state_t));
+	txFreeSlots = xQueueCreate(tx_user_slots, sizeof(tx_slot_index_t));
+	if (tx_queue_size > tx_user_slots)
+		txLibrarySlots = xQueueCreate(tx_queue_size - tx_user_slots, sizeof(tx_slot_index_t));
+	txPending = xSemaphoreCreateBinary();
+	if (!tx_slots || !tx_slot_states || !tx_in_flight_slots || !tx_messages || txFreeSlots == NULL || txPending == NULL ||
+		(tx_queue_size > tx_user_slots && txLibrarySlots == NULL))
+	{
+		deinitTXSlots();
+		return false;
+	}
+
+	for (uint8_t i = 0; i < TX_WAITERS; i++)
+	{
+		tx_waiters[i].kind = TX_WAIT_NONE;
+		tx_waiters[i].wake = xSemaphoreCreateBinary();
+		if (tx_waiters[i].wake == NULL)
+		{
+			deinitTXSlots();
+			return false;
+		}
+	}
+
+	// every class can hold all the slots, capacities are enforced on enqueue
+	for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+	{
+		txQueues[c] = xQueueCreate(tx_queue_size, sizeof(tx_slot_index_t));
+		if (txQueues[c] == NULL)
+		{
+			deinitTXSlots();
+			return false;
+		}
+		tx_class_stats[c].depth = 0;
+	}
+
+	for (tx_slot_index_t i = 0; i < tx_queue_size; i++)
+	{
+		tx_slot_states[i].done = xSemaphoreCreateBinary();
+		if (tx_slot_states[i].done == NULL)
+		{
+			deinitTXSlots();
+			return false;
+		}
+		xQueueSend(i < tx_user_slots ? txFreeSlots : txLibrarySlots, &i, 0);
+	}
+
+	tx_in_flight_head = 0;
+	tx_in_flight_count = 0;
+	tx_in_flight = 0;
+
+	// every slot is free again, so is the watermark
+	portENTER_CRITICAL(&tx_mux);
+	tx_slots_used = 0;
+	tx_above_high = false;
+	tx_watermark_crossings++;
+	portEXIT_CRITICAL(&tx_mux);
+	signalTXWatermark();
+
+	return true;
+}
+
+void EasyEspNow::deinitTXSlots()
+{
+	for (int c = 0; c < TX_PRIORITY_CLASSES; c++)
+	{
+		if (txQueues[c] != NULL)
+			vQueueDelete(txQueues[c]);
+		txQueues[c] = NULL;
+	}
+	if (txPending != NULL)
+		vSemaphoreDelete(txPending);
+	if (txFreeSlots != NULL)
+		vQueueDelete(txFreeSlots);
+	if (txLibrarySlots != NULL)
+		vQueueDelete(txLibrarySlots);
+	for (uint8_t i = 0; i < TX_WAITERS; i++)
+	{
+		if (tx_waiters[i].wake != NULL)
+			vSemaphoreDelete(tx_waiters[i].wake);
+		tx_waiters[i].wake = NULL;
+	}
+	if (tx_slot_states)
+	{
+		for (int i = 0; i < tx_queue_size; i++)
+		{
+			if (tx_slot_states[i].done != NULL)
+				vSemaphoreDelete(tx_slot_states[i].done);
+		}
+	}
+	free(tx_slots);
+	free(tx_slot_states);
+	free(tx_in_flight_slots);
+	free(tx_messages);
+
+	txPending = NULL;
+	txFreeSlots = NULL;
+	txLibrarySlots = NULL;
+	tx_slots = nullptr;
+	tx_slot_states = nullptr;
+	tx_in_flight_slots = nullptr;
+	tx_messages = nullptr;
+}
+
+int EasyEspNow::slotIndex(const tx_queue_item_t *slot)
+{
+	if (!slot || !tx_slots || slot < tx_slots || slot >= tx_slots + tx_queue_size)
+		return -1;
+	return slot - tx_slots;
+}
+
+bool EasyEspNow::setChannel(uint8_t primary_channel, wifi_second_chan_t second)
+{
+	esp_err_t ret = esp_wifi_set_channel(primary_channel, second);
+	if (ret == ESP_OK)
+	{
+		MONITOR(TAG_HELPER, "WiFi channel was successfully set to: %d", primary_channel);
+		wifi_primary_channel = primary_channel;
+		wifi_secondary_channel = second;
+		return true;
+	}
+	else
+	{
+		MONITOR(TAG_HELPER, "Failed to set WiFi channel");
+		VERBOSE(TAG_HELPER, "Failed to set WiFi channel with error: %s\n", esp_err_to_name(ret));
+		return false;
+	}
+}
+
+EasyEspNow *&EasyEspNow::radioOwner()
+{
+#ifdef EASY_ESP_NOW_HOST
+	// a host process may simulate several devices, each one with its own radio and its own instance
+	return *(EasyEspNow **)&hostDeviceContext();
+#else
+	static EasyEspNow *owner = nullptr;
+	return owner;
+#endif
+}
+
+void EasyEspNow::rx_cb(const uint8_t *mac_addr, const uint8_t *data, int data_len)
+{
+	DEBUG(TAG_HELPER, "Calling ESP-NOW low level RX cb");
+
+	EasyEspNow *owner = radioOwner();
+	if (owner == nullptr)
+		return;
+	EasyEspNow &self = *owner;
+
+	/** Why This Works:
+	 * In promiscuous mode, the received ESP-NOW data is part of a larger 802.11 packet (Management -> Action Frame ).
+	 * When the data pointer is passed to the callback, it only points to the payload portion of the packet.
+	 * By manipulating the pointer (shifting it back), you're able to access the surrounding metadata,
+	 * such as the frame headers and control information that are part of the full 802.11 packet.
+	 */
+
+	espnow_frame_format_t *esp_now_packet = (espnow_frame_format_t *)(data - sizeof(espnow_frame_format_t));
+	wifi_promiscuous_pkt_t *promiscuous_pkt = (wifi_promiscuous_pkt_t *)(data - sizeof(wifi_pkt_rx_ctrl_t) - sizeof(espnow_frame_format_t));
+	wifi_pkt_rx_ctrl_t *rx_ctrl = &promiscuous_pkt->rx_ctrl;
+
+	espnow_frame_recv_info_t frame_promisc_info = {.radio_header = rx_ctrl, .esp_now_frame = esp_now_packet};
+
+	// authenticated before the duplicate filter and the peer counters, a forged frame leaves no trace.
+	// the driver buffer is read only, the keystream is XORed straight into this one
+	alignas(4) uint8_t plain[MAX_DATA_LENGTH];
+	if (self.encryption_enabled && self.openRXFrame(mac_addr, data, data_len, plain) == false)
+		return;
+
+	// decompressed next, everything after sees the frame as it was sent
+	if (self.compression_enabled && easyFrameIs(data, data_len, EASY_FRAME_COMPRESSED) && self.inflateRXFrame(mac_addr, data, data_len) == false)
+		return;
+
+	if (self.rx_dedup_enabled && self.isRXDuplicate(mac_addr, data, data_len, esp_now_packet))
+		return;
+
+	self.countPeerRX(mac_addr, rx_ctrl->rssi);
+
+	if (data_len >= EASY_FRAME_HEADER_LEN && data[0] == EASY_FRAME_MAGIC && self.receiveLibraryFrame(mac_addr, data, data_len, &frame_promisc_info))
+		return;
+
+	self.deliverRXFrame(mac_addr, data, data_len, &frame_promisc_info);
+}
+
+bool EasyEspNow::isRXDuplicate(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_format_t *esp_now_frame)
+{
+	enum : uint8_t
+	{
+		SEQUENCE_CONTROL = 0,
+		APPLICATION = 1,
+	};
+
+	uint8_t origin[MAC_ADDR_LEN];
+	uint16_t sequence;
+	memcpy(origin, mac_addr, MAC_ADDR_LEN);
+
+	bool duplicate;
+	if (rxDedupKey != nullptr && rxDedupKey(mac_addr, data, data_len, origin, &sequence))
+		duplicate = rx_dedup.seen(origin, APPLICATION, sequence, 16, millis());
+	else
+		// MAC retries keep the sequence number, the upper 12 bits of sequence control
+		duplicate = rx_dedup.seen(mac_addr, SEQUENCE_CONTROL, esp_now_frame->sequence_control >> 4, 12, millis());
+
+	if (duplicate)
+	{
+		rx_duplicates.fetch_add(1, std::memory_order_relaxed);
+		DEBUG(TAG_HELPER, "Duplicate frame from [" EASYMACSTR "] dropped", EASYMAC2STR(mac_addr));
+	}
+	return duplicate;
+}
+
+void EasyEspNow::countPeerRX(const uint8_t *mac_addr, int8_t rssi)
+{
+	uint32_t now_ms = millis();
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(mac_addr);
+	if (index >= 0)
+	{
+		peer_stats_t &stats = table.at(index).stats;
+		stats.rx_frames++;
+		stats.rssi = rssi;
+		// 0 means never seen
+		stats.last_seen_ms = now_ms ? now_ms : 1;
+	}
+	portEXIT_CRITICAL(&peers_mux);
+}
+
+bool EasyEspNow::findKey(const uint8_t *mac, bool network, EasyAead *key)
+{
+	portENTER_CRITICAL(&keys_mux);
+	bool found;
+	if (network)
+	{
+		found = network_key_set;
+		if (found && key)
+			*key = network_key;
+	}
+	else
+	{
+		int index = encryption_keys.capacity() ? encryption_keys.find(mac) : -1;
+		found = index >= 0;
+		if (found && key)
+			*key = encryption_keys.at(index).key;
+	}
+	portEXIT_CRITICAL(&keys_mux);
+	return found;
+}
+
+bool EasyEspNow::openRXFrame(const uint8_t *mac_addr, const uint8_t *&data, int &data_len, uint8_t *plain)
+{
+	if (!easyFrameIs(data, data_len, EASY_FRAME_SEALED))
+	{
+		// a source with a key, or any source once the network has a key, must encrypt
+		if (findKey(mac_addr, false, nullptr) || findKey(mac_addr, true, nullptr))
+		{
+			encryption_plain_dropped.fetch_add(1, std::memory_order_relaxed);
+			DEBUG(TAG_HELPER, "Frame in clear from [" EASYMACSTR "] dropped", EASYMAC2STR(mac_addr));
+			return false;
+		}
+		return true;
+	}
+
+	if (data_len <= EASY_SEALED_OVERHEAD)
+	{
+		encryption_auth_failures.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	easy_sealed_header_t header;
+	memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_SEALED_HEADER_LEN);
+	EasyAead key;
+	if (findKey(mac_addr, header.flags & EASY_SEALED_NETWORK_KEY, &key) == false)
+	{
+		encryption_no_key.fetch_add(1, std::memory_order_relaxed);
+		DEBUG(TAG_HELPER, "Encrypted frame from [" EASYMACSTR "] dropped, no key", EASYMAC2STR(mac_addr));
+		return false;
+	}
+
+	uint8_t nonce[EasyAead::NONCE_LEN];
+	easySealedNonce(mac_addr, header, nonce);
+	const int aad_len = EASY_FRAME_HEADER_LEN + EASY_SEALED_HEADER_LEN;
+	int len = data_len - EASY_SEALED_OVERHEAD;
+	bool authentic = key.open(nonce, data, aad_len, data + aad_len, plain, len, data + aad_len + len);
+	key.clear();
+	if (!authentic)
+	{
+		encryption_auth_failures.fetch_add(1, std::memory_order_relaxed);
+		WARNING(TAG_HELPER, "Encrypted frame from [" EASYMACSTR "] failed authentication, dropped", EASYMAC2STR(mac_addr));
+		return false;
+	}
+
+	encryption_opened.fetch_add(1, std::memory_order_relaxed);
+	data = plain;
+	data_len = len;
+	return true;
+}
+
+bool EasyEspNow::inflateRXFrame(const uint8_t *mac_addr, const uint8_t *&data, int &data_len)
+{
+	if (data_len <= EASY_COMPRESSED_OVERHEAD)
+	{
+		compression_errors.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	easy_compressed_header_t header;
+	memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_COMPRESSED_HEADER_LEN);
+	const EasyLz::Dictionary *dictionary = nullptr;
+	if (header.dictionary != COMPRESSION_NO_DICTIONARY)
+	{
+		dictionary = header.dictionary <= MAX_COMPRESSION_DICTIONARIES ? compression_dictionaries[header.dictionary - 1] : nullptr;
+		if (!dictionary)
+		{
+			compression_errors.fetch_add(1, std::memory_order_relaxed);
+			WARNING(TAG_HELPER, "Compressed frame from [" EASYMACSTR "] dropped, no dictionary %d", EASYMAC2STR(mac_addr), header.dictionary);
+			return false;
+		}
+	}
+
+	uint32_t start_us = micros();
+	int len = EasyLz::decompress(dictionary, data + EASY_COMPRESSED_OVERHEAD, data_len - EASY_COMPRESSED_OVERHEAD, rx_inflated, sizeof(rx_inflated));
+	compression_decode_us.fetch_add(micros() - start_us, std::memory_order_relaxed);
+	if (len < 1)
+	{
+		compression_errors.fetch_add(1, std::memory_order_relaxed);
+		WARNING(TAG_HELPER, "Compressed frame from [" EASYMACSTR "] is malformed, dropped", EASYMAC2STR(mac_addr));
+		return false;
+	}
+
+	compression_inflated.fetch_add(1, std::memory_order_relaxed);
+	data = rx_inflated;
+	data_len = len;
+	return true;
+}
+
+easy_send_error_t EasyEspNow::countSendResult(easy_send_error_t result)
+{
+	int index = -(int)result;
+	if (index >= 0 && index < EASY_SEND_RESULTS)
+		stats_send_results[index].fetch_add(1, std::memory_order_relaxed);
+	return result;
+}
+
+bool EasyEspNow::receiveLibraryFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info)
+{
+	// a message of the application that starts like a library frame, sent by a node that escapes them as this one does
+	if (easyFrameIs(data, data_len, EASY_FRAME_ESCAPED) && frameEscaping())
+	{
+		if (data_len > EASY_FRAME_HEADER_LEN)
+			deliverRXFrame(mac_addr, data + EASY_FRAME_HEADER_LEN, data_len - EASY_FRAME_HEADER_LEN, frame_info);
+		return true;
+	}
+
+	// probes first, every check in front of them adds to the time measured
+	if (probes_enabled && easyFrameIs(data, data_len, EASY_FRAME_PROBE) && data_len >= EASY_PROBE_OVERHEAD)
+	{
+		int64_t rx_us = esp_timer_get_time();
+		easy_probe_header_t header;
+		memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_PROBE_HEADER_LEN);
+		if (header.flags & EASY_PROBE_REPLY)
+			receiveProbeReply(mac_addr, header, rx_us);
+		else
+			answerProbe(mac_addr, data, data_len, header, rx_us);
+		return true;
+	}
+
+	// split an aggregate back into the messages it was packed from, they share the radio metadata of the frame
+	if (aggregation_enabled && easyFrameIs(data, data_len, EASY_FRAME_AGGREGATE))
+	{
+		int messages = easyAggregateCount(data, data_len);
+		if (messages == 0)
+		{
+			aggregation_rx_malformed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		aggregation_rx_frames.fetch_add(1, std::memory_order_relaxed);
+		aggregation_rx_messages.fetch_add(messages, std::memory_order_relaxed);
+
+		int offset = EASY_FRAME_HEADER_LEN;
+		const uint8_t *message;
+		int message_len;
+		while (easyAggregateNext(data, data_len, offset, message, message_len))
+			deliverRXFrame(mac_addr, message, message_len, frame_info);
+		return true;
+	}
+
+	if (reliable_peers && data_len >= EASY_FRAME_HEADER_LEN + EASY_RELIABLE_HEADER_LEN)
+	{
+		if (easyFrameIs(data, data_len, EASY_FRAME_RELIABLE_DATA))
+		{
+			receiveReliableData(mac_addr, data, data_len, frame_info);
+			return true;
+		}
+		if (easyFrameIs(data, data_len, EASY_FRAME_RELIABLE_ACK))
+		{
+			easy_reliable_header_t header;
+			memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_RELIABLE_HEADER_LEN);
+			if (header.flags & EASY_RELIABLE_ACK_VALID)
+				processReliableAck(mac_addr, header);
+			return true;
+		}
+	}
+
+	if (group_sends && data_len >= EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN)
+	{
+		if (easyFrameIs(data, data_len, EASY_FRAME_GROUP_DATA))
+		{
+			receiveGroupData(mac_addr, data, data_len, frame_info);
+			return true;
+		}
+		if (easyFrameIs(data, data_len, EASY_FRAME_GROUP_ACK))
+		{
+			easy_group_header_t header;
+			memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_GROUP_HEADER_LEN);
+			processGroupAck(mac_addr, header);
+			return true;
+		}
+	}
+
+	if (fragmentation_enabled && easyFrameIs(data, data_len, EASY_FRAME_FRAGMENT) && data_len > EASY_FRAME_HEADER_LEN + EASY_FRAGMENT_HEADER_LEN)
+	{
+		easy_fragment_header_t header;
+		memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_FRAGMENT_HEADER_LEN);
+		const uint8_t *fragment = data + EASY_FRAME_HEADER_LEN + EASY_FRAGMENT_HEADER_LEN;
+		int fragment_len = data_len - EASY_FRAME_HEADER_LEN - EASY_FRAGMENT_HEADER_LEN;
+		fragmentation_rx_fragments.fetch_add(1, std::memory_order_relaxed);
+
+		// message in a single fragment, no need for a reassembly buffer
+		if (header.offset == 0 && fragment_len == header.total_len)
+		{
+			fragmentation_rx_messages.fetch_add(1, std::memory_order_relaxed);
+			deliverRXFrame(mac_addr, fragment, fragment_len, frame_info);
+			return true;
+		}
+
+		rx_reassembly_meta_t meta = {.radio_header = *frame_info->radio_header, .esp_now_frame = *frame_info->esp_now_frame};
+		int completed_slot;
+		switch (reassembler.add(mac_addr, header, fragment, fragment_len, millis(), meta, completed_slot))
+		{
+		case EasyReassembler<rx_reassembly_meta_t>::MESSAGE_COMPLETE:
+			fragmentation_rx_messages.fetch_add(1, std::memory_order_relaxed);
+			// with the RX task running the message is delivered from there, like every other frame
+			{
+				TaskHandle_t rx_task = rxTaskHandle;
+				if (rx_task)
+					xTaskNotifyGive(rx_task);
+				else
+					deliverReassembledMessages();
+			}
+			return true;
+		case EasyReassembler<rx_reassembly_meta_t>::FRAGMENT_DUPLICATE:
+			fragmentation_rx_duplicates.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		case EasyReassembler<rx_reassembly_meta_t>::FRAGMENT_DROPPED:
+			WARNING(TAG_HELPER, "All reassembly buffers wait for delivery. Dropping fragment from [" EASYMACSTR "]", EASYMAC2STR(mac_addr));
+			fragmentation_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		case EasyReassembler<rx_reassembly_meta_t>::FRAGMENT_INVALID:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void EasyEspNow::deliverReassembledMessages()
+{
+	for (int slot = reassembler.nextComplete(-1); slot >= 0; slot = reassembler.nextComplete(slot))
+	{
+		rx_reassembly_meta_t meta = reassembler.meta(slot);
+		espnow_frame_recv_info_t frame_info = {.radio_header = &meta.radio_header, .esp_now_frame = &meta.esp_now_frame};
+		if (dataReceived != nullptr)
+			dataReceived(reassembler.source(slot), reassembler.message(slot), reassembler.messageLength(slot), &frame_info);
+		reassembler.release(slot);
+	}
+}
+
+void EasyEspNow::deliverRXFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info)
+{
+	// with the RX task running only copy the frame, user callbacks run in the RX task
+	if (rxTaskHandle)
+	{
+		pushRXFrame(mac_addr, data, data_len, frame_info);
+		return;
+	}
+
+	if (dispatchTypedMessage(mac_addr, data, data_len, const_cast<espnow_frame_recv_info_t *>(frame_info)))
+		return;
+
+	if (dataReceived != nullptr)
+	{
+		dataReceived(mac_addr, data, data_len, const_cast<espnow_frame_recv_info_t *>(frame_info));
+	}
+}
+
+bool EasyEspNow::setTypedHandler(uint16_t type_id, uint8_t size, typed_message_invoke_t invoke, void (*handler)())
+{
+	// probing starts at the home position of the type, the same for a type on every device
+	bool done = false, collision = false;
+	portENTER_CRITICAL(&typed_mux);
+	for (uint8_t probe = 0; probe < MAX_MESSAGE_TYPES; probe++)
+	{
+		typed_handler_t &entry = typed_handlers[(type_id + probe) & (MAX_MESSAGE_TYPES - 1)];
+		if (entry.used && entry.type_id != type_id)
+			continue;
+		if (entry.used && entry.size != size)
+		{
+			collision = true;
+			break;
+		}
+		// a removed type keeps its entry, the types probed past it stay reachable
+		if (!entry.used && handler == nullptr)
+		{
+			done = true;
+			break;
+		}
+		if (!entry.used)
+			typed_handler_count++;
+		entry.used = true;
+		entry.type_id = type_id;
+		entry.size = size;
+		entry.invoke = invoke;
+		entry.handler = handler;
+		done = true;
+		break;
+	}
+	portEXIT_CRITICAL(&typed_mux);
+
+	if (collision)
+	{
+		ERROR(TAG_CORE, "Message type id 0x%04X is taken by another type. Give one of them an id with EASY_MESSAGE_ID(...)", type_id);
+		return false;
+	}
+	if (!done)
+	{
+		ERROR(TAG_CORE, "No room for another message type, %d have a handler", MAX_MESSAGE_TYPES);
+		return false;
+	}
+	if (handler)
+		MONITOR(TAG_CORE, "Handler set for message type 0x%04X, %d bytes", type_id, size);
+	return true;
+}
+
+bool EasyEspNow::findTypedHandler(const uint8_t *data, int data_len, typed_handler_t &handler)
+{
+	if (data_len < EASY_TYPED_OVERHEAD || !easyFrameIs(data, data_len, EASY_FRAME_TYPED))
+		return false;
+
+	uint16_t type_id = (uint16_t)(data[EASY_FRAME_HEADER_LEN] | (data[EASY_FRAME_HEADER_LEN + 1] << 8));
+	bool found = false;
+	portENTER_CRITICAL(&typed_mux);
+	for (uint8_t probe = 0; probe < MAX_MESSAGE_TYPES; probe++)
+	{
+		const typed_handler_t &entry = typed_handlers[(type_id + probe) & (MAX_MESSAGE_TYPES - 1)];
+		if (!entry.used)
+			break;
+		if (entry.type_id != type_id)
+			continue;
+		found = entry.handler != nullptr && data_len == EASY_TYPED_OVERHEAD + entry.size;
+		if (found)
+			handler = entry;
+		break;
+	}
+	portEXIT_CRITICAL(&typed_mux);
+	return found;
+}
+
+bool EasyEspNow::dispatchTypedMessage(const uint8_t *mac_addr, const uint8_t *data, int data_len, espnow_frame_recv_info_t *frame_info)
+{
+	typed_handler_t handler;
+	if (typed_handler_count == 0 || !findTypedHandler(data, data_len, handler))
+		return false;
+
+	handler.invoke(handler.handler, mac_addr, data + EASY_TYPED_OVERHEAD, frame_info);
+	return true;
+}
+
+bool EasyEspNow::pushRXFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info)
+{
+	if (data_len < 0 || data_len > MAX_DATA_LENGTH)
+	{
+		rx_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// single producer: only this function writes the head
+	uint32_t head = rx_ring_head.load(std::memory_order_relaxed);
+	uint32_t tail = rx_ring_tail.load(std::memory_order_acquire);
+	if (head - tail >= rx_ring_size)
+	{
+		rx_overflows.fetch_add(1, std::memory_order_relaxed);
+		rx_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	rx_frame_t &frame = rx_ring[head % rx_ring_size];
+	memcpy(frame.src_address, mac_addr, MAC_ADDR_LEN);
+	frame.radio_header = *frame_info->radio_header;
+	frame.esp_now_frame = *frame_info->esp_now_frame;
+	memcpy(frame.payload, data, data_len);
+	frame.payload_len = data_len;
+
+	// publish the frame to the RX task
+	rx_ring_head.store(head + 1, std::memory_order_release);
+	rx_received.fetch_add(1, std::memory_order_relaxed);
+
+	TaskHandle_t rx_task = rxTaskHandle;
+	if (rx_task)
+		xTaskNotifyGive(rx_task);
+	return true;
+}
+
+void EasyEspNow::easyEspNowRxTask(void *pvParameters)
+{
+	EasyEspNow &self = *(EasyEspNow *)pvParameters;
+	while (true)
+	{
+		// rx_cb notifies this task every time it pushes a frame
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+		while (true)
+		{
+			uint32_t tail = self.rx_ring_tail.load(std::memory_order_relaxed);
+			uint32_t head = self.rx_ring_head.load(std::memory_order_acquire);
+			if (head == tail)
+				break;
+
+			// deliver the frames that are contiguous in the ring, straight from the ring without copying them
+			uint32_t first = tail % self.rx_ring_size;
+			uint32_t batch = head - tail;
+			if (batch > self.rx_ring_size - first)
+				batch = self.rx_ring_size - first;
+			if (batch > self.rx_max_batch)
+				batch = self.rx_max_batch;
+
+			rx_frame_t *frames = &self.rx_ring[first];
+			if (self.dataReceivedBatch != nullptr)
+			{
+				// typed messages go to their handlers, the frames in between to the batch callback, in order
+				uint32_t run = 0;
+				typed_handler_t handler;
+				for (uint32_t i = 0; i < batch && self.typed_handler_count; i++)
+				{
+					if (!self.findTypedHandler(frames[i].payload, frames[i].payload_len, handler))
+						continue;
+					if (i > run)
+						self.dataReceivedBatch(frames + run, i - run);
+					espnow_frame_recv_info_t frame_info = {.radio_header = &frames[i].radio_header, .esp_now_frame = &frames[i].esp_now_frame};
+					handler.invoke(handler.handler, frames[i].src_address, frames[i].payload + EASY_TYPED_OVERHEAD, &frame_info);
+					run = i + 1;
+				}
+				if (batch > run)
+					self.dataReceivedBatch(frames + run, batch - run);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < batch; i++)
+				{
+					espnow_frame_recv_info_t frame_info = {.radio_header = &frames[i].radio_header, .esp_now_frame = &frames[i].esp_now_frame};
+					if (self.dispatchTypedMessage(frames[i].src_address, frames[i].payload, frames[i].payload_len, &frame_info))
+						continue;
+					if (self.dataReceived != nullptr)
+						self.dataReceived(frames[i].src_address, frames[i].payload, frames[i].payload_len, &frame_info);
+				}
+			}
+
+			// give the slots back to rx_cb
+			self.rx_ring_tail.store(tail + batch, std::memory_order_release);
+			self.rx_delivered.fetch_add(batch, std::memory_order_relaxed);
+		}
+
+		self.deliverReassembledMessages();
+	}
+}
+
+void EasyEspNow::tx_cb(const uint8_t *mac_addr, esp_now_send_status_t status)
+{
+	DEBUG(TAG_HELPER, "Calling ESP-NOW low level TX cb");
+
+	EasyEspNow *owner = radioOwner();
+	if (owner == nullptr)
+		return;
+	EasyEspNow &self = *owner;
+
+	// ESP-NOW completes frames in the same order they were sent, the oldest frame in flight is the one this cb belongs to
+	bool slot_completed = false;
+	bool late = true;
+	tx_slot_index_t slot_index = 0;
+	esp_now_send_status_t slot_status = ESP_NOW_SEND_SUCCESS;
+
+	portENTER_CRITICAL(&self.tx_mux);
+	while (self.tx_in_flight_count > 0)
+	{
+		tx_in_flight_t &head = self.tx_in_flight_slots[self.tx_in_flight_head];
+		bool matches = mac_addr == nullptr || memcmp(head.dst_address, self.zero_mac, MAC_ADDR_LEN) == 0 ||
+					   memcmp(head.dst_address, mac_addr, MAC_ADDR_LEN) == 0;
+		if (head.expired)
+		{
+			// a frame given up by the completion timeout: its late cb is absorbed. A cb for another destination means the
+			// ones of the expired frame never come, it goes away and the next frame is looked at
+			if (matches && --head.expired > 0)
+				break;
+			self.tx_in_flight_head = (self.tx_in_flight_head + 1) % self.tx_in_flight_capacity;
+			self.tx_in_flight_count--;
+			if (matches)
+				break;
+			continue;
+		}
+		// a cb for another destination belongs to no frame in flight, it must not complete this one
+		if (!matches)
+			break;
+
+		late = false;
+		if (self.tx_in_flight > 0)
+			self.tx_in_flight--;
+		slot_index = head.slot;
+		tx_slot_state_t &state = self.tx_slot_states[slot_index];
+		if (status != ESP_NOW_SEND_SUCCESS)
+			state.status = ESP_NOW_SEND_FAIL;
+		if (state.pending_completions > 0)
+			state.pending_completions--;
+		if (state.pending_completions == 0)
+		{
+			// all completions arrived (more than one when sending to all unicast peers)
+			self.tx_in_flight_head = (self.tx_in_flight_head + 1) % self.tx_in_flight_capacity;
+			self.tx_in_flight_count--;
+			slot_status = state.status;
+			slot_completed = true;
+		}
+		break;
+	}
+	portEXIT_CRITICAL(&self.tx_mux);
+
+	if (late)
+	{
+		self.stats_tx_late_completions.fetch_add(1, std::memory_order_relaxed);
+		WARNING(TAG_HELPER, "TX completion for [" EASYMACSTR "] matches no frame in flight. Ignored", EASYMAC2STR(mac_addr ? mac_addr : self.zero_mac));
+	}
+
+	if (slot_completed)
+	{
+		self.stats_send_to_complete.record(micros() - self.tx_slot_states[slot_index].sent_us);
+		self.completeTXSlot(slot_index, slot_status);
+	}
+
+	// one less frame in flight, let the TX task hand the next one to ESP-NOW
+	if (self.txTaskHandle)
+		xTaskNotifyGive(self.txTaskHandle);
+
+	if (self.dataSent != nullptr)
+	{
+		self.dataSent(mac_addr, status);
+	}
+}
+
+void EasyEspNow::easyEspNowTxQueueTask(void *pvParameters)
+{
+	EasyEspNow &self = *(EasyEspNow *)pvParameters;
+	tx_slot_index_t slot_index;
+	while (true)
+	{
+		// Wait for data from the queue, waking up in time to flush the aggregates whose window expires
+		// and to retransmit or acknowledge on the reliable channels
+		TickType_t wait = self.flushExpiredAggregates(pdMS_TO_TICKS(10));
+		wait = self.serviceReliable(wait);
+		wait = self.serviceGroups(wait);
+
+		// do not overwhelm 'esp_now_send', otherwise may get error: 'ESP_ERR_ESPNOW_NO_MEM'
+		// wait here until a previous frame has been completed by tx_cb, before picking the next frame,
+		// so a higher priority frame committed meanwhile still goes first
+		self.waitForTXCompletionSlot(self.tx_max_in_flight);
+
+		if (self.dequeueTXSlot(&slot_index, wait))
+		{
+			tx_queue_item_t &item_to_dequeue = self.tx_slots[slot_index];
+
+			uint16_t expected_completions = 1;
+			if (memcmp(item_to_dequeue.dst_address, self.zero_mac, MAC_ADDR_LEN) == 0)
+			{
+				WARNING(TAG_HELPER, "Destination address is NULL, sending data to all unicast peers that are added to the peer list");
+				// ESP-NOW calls tx_cb once for every unicast peer
+				expected_completions = self.countUnicastPeers();
+			}
+
+			else if (self.swapInPeer(item_to_dequeue.dst_address) == false)
+			{
+				ERROR(TAG_HELPER, "Could not register destination peer [" EASYMACSTR "] in ESP-NOW", EASYMAC2STR(item_to_dequeue.dst_address));
+				self.completeTXSlot(slot_index, ESP_NOW_SEND_FAIL);
+				continue;
+			}
+
+			if (expected_completions == 0)
+			{
+				WARNING(TAG_HELPER, "There are no unicast peers to send the data to");
+				self.completeTXSlot(slot_index, ESP_NOW_SEND_FAIL);
+				continue;
+			}
+
+			if (self.compression_enabled)
+				self.compressTXSlot(slot_index);
+
+			if (self.encryption_enabled && self.sealTXSlot(slot_index) == false)
+			{
+				ERROR(TAG_HELPER, "Frame of %zu bytes has no room for the encryption overhead", item_to_dequeue.payload_len);
+				self.completeTXSlot(slot_index, ESP_NOW_SEND_FAIL);
+				continue;
+			}
+
+			self.err = self.sendWithBackoff(slot_index, expected_completions);
+			if (self.err == ESP_OK)
+			{
+				DEBUG(TAG_HELPER, "Succeeded in calling \"esp_now_send(...)\"");
+			}
+			else
+			{
+				ERROR(TAG_HELPER, "Failed in calling \"esp_now_send(...)\" with error: %s", esp_err_to_name(self.err));
+				// no tx_cb will come for this frame
+				self.completeTXSlot(slot_index, ESP_NOW_SEND_FAIL);
+			}
+		}
+	}
+}
+
+void EasyEspNow::waitForTXCompletionSlot(uint8_t max_in_flight)
+{
+	while (tx_in_flight >= max_in_flight)
+	{
+		// tx_cb notifies this task every time a frame is completed
+		if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(tx_completion_timeout_ms)) == 0)
+		{
+			WARNING(TAG_HELPER, "No TX completion in %" PRIu32 " ms. Considering %d in flight frame(s) lost", tx_completion_timeout_ms, tx_in_flight);
+			// the frames stay in the FIFO as expired, a tx_cb that still comes for one of them is absorbed there
+			while (true)
+			{
+				tx_slot_index_t lost_slot = 0;
+				bool any_lost = false;
+				portENTER_CRITICAL(&tx_mux);
+				for (uint16_t i = 0; i < tx_in_flight_count && !any_lost; i++)
+				{
+					tx_in_flight_t &entry = tx_in_flight_slots[(tx_in_flight_head + i) % tx_in_flight_capacity];
+					if (entry.expired)
+						continue;
+					lost_slot = entry.slot;
+					entry.expired = tx_slot_states[lost_slot].pending_completions ? tx_slot_states[lost_slot].pending_completions : 1;
+					any_lost = true;
+				}
+				if (!any_lost)
+					tx_in_flight = 0;
+				portEXIT_CRITICAL(&tx_mux);
+
+				if (!any_lost)
+					break;
+				stats_tx_completion_timeouts.fetch_add(1, std::memory_order_relaxed);
+				completeTXSlot(lost_slot, ESP_NOW_SEND_FAIL);
+			}
+		}
+	}
+}
+
+bool EasyEspNow::sealTXSlot(tx_slot_index_t slot_index)
+{
+	tx_queue_item_t &item = tx_slots[slot_index];
+	// broadcasts and sends to all peers have several receivers, only the network key fits them all
+	bool network = memcmp(item.dst_address, zero_mac, MAC_ADDR_LEN) == 0 || memcmp(item.dst_address, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0;
+	EasyAead key;
+	if (network || findKey(item.dst_address, false, &key) == false)
+	{
+		network = true;
+		if (findKey(nullptr, true, &key) == false)
+		{
+			encryption_sent_plain.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	size_t len = item.payload_len;
+	if (len + EASY_SEALED_OVERHEAD > MAX_DATA_LENGTH)
+	{
+		key.clear();
+		encryption_too_long.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// after 2^32 frames a new epoch, a nonce is never used twice
+	if (++seal_counter == 0)
+		seal_epoch = ((uint32_t)random(0, 0x10000) << 16) | (uint32_t)random(0, 0x10000);
+
+	easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_SEALED};
+	easy_sealed_header_t header = {.flags = (uint8_t)(network ? EASY_SEALED_NETWORK_KEY : 0), .epoch = seal_epoch, .counter = seal_counter};
+	const size_t aad_len = EASY_FRAME_HEADER_LEN + EASY_SEALED_HEADER_LEN;
+
+	// the frame moves past the headers and is encrypted where it lands, the tag goes right after it
+	uint8_t *frame = item.payload_data;
+	memmove(frame + aad_len, frame, len);
+	memcpy(frame, &frame_header, EASY_FRAME_HEADER_LEN);
+	memcpy(frame + EASY_FRAME_HEADER_LEN, &header, EASY_SEALED_HEADER_LEN);
+
+	uint8_t nonce[EasyAead::NONCE_LEN];
+	easySealedNonce(my_mac_address, header, nonce);
+	key.seal(nonce, frame, aad_len, frame + aad_len, len, frame + aad_len + len);
+	key.clear();
+	item.payload_len = len + EASY_SEALED_OVERHEAD;
+
+	encryption_sealed.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void EasyEspNow::compressTXSlot(tx_slot_index_t slot_index)
+{
+	tx_queue_item_t &item = tx_slots[slot_index];
+	// a send to all peers has no single setting to follow
+	if (memcmp(item.dst_address, zero_mac, MAC_ADDR_LEN) == 0)
+		return;
+
+	portENTER_CRITICAL(&peers_mux);
+	EasyPeerTable<peer_t> &table = groupPeerTable();
+	int index = table.find(item.dst_address);
+	uint8_t dictionary = index >= 0 ? table.at(index).compression : COMPRESSION_OFF;
+	portEXIT_CRITICAL(&peers_mux);
+	if (dictionary == COMPRESSION_OFF)
+		return;
+
+	const EasyLz::Dictionary *indexed = dictionary != COMPRESSION_NO_DICTIONARY ? compression_dictionaries[dictionary - 1] : nullptr;
+	if (dictionary != COMPRESSION_NO_DICTIONARY && !indexed)
+	{
+		WARNING(TAG_HELPER, "Compression dictionary %d is not set. Frame sent as it is", dictionary);
+		compression_not_compressed.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// the stream must save at least one byte once the headers are counted, otherwise the frame goes as it is
+	size_t len = item.payload_len;
+	size_t compressed_len = 0;
+	uint32_t start_us = micros();
+	if (len > EASY_COMPRESSED_OVERHEAD + 1)
+		compressed_len = compressor.compress(indexed, item.payload_data, len, compression_buffer + EASY_COMPRESSED_OVERHEAD, len - EASY_COMPRESSED_OVERHEAD - 1);
+	compression_encode_us.fetch_add(micros() - start_us, std::memory_order_relaxed);
+	if (compressed_len == 0)
+	{
+		compression_not_compressed.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_COMPRESSED};
+	easy_compressed_header_t header = {.dictionary = dictionary};
+	memcpy(compression_buffer, &frame_header, EASY_FRAME_HEADER_LEN);
+	memcpy(compression_buffer + EASY_FRAME_HEADER_LEN, &header, EASY_COMPRESSED_HEADER_LEN);
+	item.payload_len = compressed_len + EASY_COMPRESSED_OVERHEAD;
+	memcpy(item.payload_data, compression_buffer, item.payload_len);
+
+	compression_compressed.fetch_add(1, std::memory_order_relaxed);
+	compression_bytes_in.fetch_add(len, std::memory_order_relaxed);
+	compression_bytes_out.fetch_add(item.payload_len, std::memory_order_relaxed);
+}
+
+esp_err_t EasyEspNow::sendWithBackoff(tx_slot_index_t slot_index, uint16_t expected_completions)
+{
+	tx_queue_item_t &item = tx_slots[slot_index];
+	tx_slot_state_t &state = tx_slot_states[slot_index];
+	// all zeros destination means all unicast peers
+	const uint8_t *dst_addr = memcmp(item.dst_address, zero_mac, MAC_ADDR_LEN) == 0 ? NULL : item.dst_address;
+
+	esp_err_t send_err;
+	uint32_t backoff_ms = 1;
+
+	// a peer with frames in flight is never evicted from ESP-NOW by the peer directory
+	if (dst_addr)
+	{
+		portENTER_CRITICAL(&peers_mux);
+		int index = peer_table.find(dst_addr);
+		if (index >= 0)
 		{
-			INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_APSTA & apstaMOD_to_apIF = true  ==>  Auto Selecting WiFi interface: WIFI_IF_AP");
-			return WIFI_IF_AP;
+			peer_table.at(index).frames_in_flight++;
+			state.peer_in_flight = true;
 		}
-		else if (apstaMOD_to_apIF == false)
+		portEXIT_CRITICAL(&peers_mux);
+	}
+
+	for (uint8_t attempt = 0;; attempt++)
+	{
+		// put the slot in flight before sending, tx_cb can run before esp_now_send returns
+		portENTER_CRITICAL(&tx_mux);
+		state.pending_completions = expected_completions;
+		state.status = ESP_NOW_SEND_SUCCESS;
+		// live frames are at most the TX queue size, the oldest expired frames make room if their cb never came
+		while (tx_in_flight_count >= tx_in_flight_capacity && tx_in_flight_slots[tx_in_flight_head].expired)
 		{
-			INFO(TAG_MISC, "WiFi mode chosen: WIFI_MODE_APSTA & apstaMOD_to_apIF = false  ==>  Auto Selecting WiFi interface: WIFI_IF_STA");
-			return WIFI_IF_STA;
+			tx_in_flight_head = (tx_in_flight_head + 1) % tx_in_flight_capacity;
+			tx_in_flight_count--;
+		}
+		tx_in_flight_t &entry = tx_in_flight_slots[(tx_in_flight_head + tx_in_flight_count) % tx_in_flight_capacity];
+		entry.slot = slot_index;
+		entry.expired = 0;
+		memcpy(entry.dst_address, item.dst_address, MAC_ADDR_LEN);
+		tx_in_flight_count++;
+		tx_in_flight += expected_completions;
+		// tx_cb can read it before esp_now_send returns
+		state.sent_us = micros();
+		// and can complete the slot, which can be queued again before esp_now_send returns
+		uint32_t queued_us = state.sent_us - state.enqueued_us;
+		uint32_t probe = state.probe;
+		portEXIT_CRITICAL(&tx_mux);
+
+		if (probe)
+			stampProbe(probe, true, esp_timer_get_time());
+		stats_esp_now_send_calls.fetch_add(1, std::memory_order_relaxed);
+		send_err = esp_now_send(dst_addr, item.payload_data, item.payload_len);
+		if (send_err == ESP_OK)
+		{
+			stats_enqueue_to_send.record(queued_us);
+			return ESP_OK;
+		}
+
+		// no tx_cb will come for a frame that was not accepted, it is the newest one in flight
+		portENTER_CRITICAL(&tx_mux);
+		if (tx_in_flight_count > 0)
+		{
+			tx_in_flight_t &newest = tx_in_flight_slots[(tx_in_flight_head + tx_in_flight_count - 1) % tx_in_flight_capacity];
+			if (newest.slot == slot_index && newest.expired == 0)
+				tx_in_flight_count--;
+		}
+		tx_in_flight = tx_in_flight > expected_completions ? tx_in_flight - expected_completions : 0;
+		portEXIT_CRITICAL(&tx_mux);
+
+		if (send_err == ESP_ERR_ESPNOW_NO_MEM)
+			stats_esp_now_send_no_mem.fetch_add(1, std::memory_order_relaxed);
+		if (send_err != ESP_ERR_ESPNOW_NO_MEM || attempt >= tx_no_mem_retries)
+		{
+			stats_esp_now_send_errors.fetch_add(1, std::memory_order_relaxed);
+			return send_err;
+		}
+
+		DEBUG(TAG_HELPER, "ESP-NOW out of memory. Retry #%d in %" PRIu32 " ms", attempt + 1, backoff_ms);
+		vTaskDelay(pdMS_TO_TICKS(backoff_ms));
+		backoff_ms = backoff_ms * 2 > tx_backoff_max_ms ? tx_backoff_max_ms : backoff_ms * 2;
+	}
+}
+
+easy_send_error_t EasyEspNow::aggregateMessage(const uint8_t *dst_address, const easy_iovec_t *fragments, size_t fragment_count, size_t payload_len,
+											   easy_tx_priority_t priority, easy_send_handle_t *handle)
+{
+	uint32_t now_us = micros();
+	tx_aggregate_t *aggregate = nullptr;
+	tx_aggregate_t *free_aggregate = nullptr;
+	tx_aggregate_t *oldest_aggregate = nullptr;
+
+	for (uint8_t i = 0; i < aggregation_max_open; i++)
+	{
+		tx_aggregate_t &candidate = tx_aggregates[i];
+		if (!candidate.open)
+		{
+			if (!free_aggregate)
+				free_aggregate = &candidate;
+			continue;
+		}
+		if (memcmp(candidate.dst_address, dst_address, MAC_ADDR_LEN) == 0)
+		{
+			aggregate = &candidate;
+			break;
+		}
+		if (!oldest_aggregate || (int32_t)(candidate.opened_us - oldest_aggregate->opened_us) < 0)
+			oldest_aggregate = &candidate;
+	}
+
+	// message does not fit, send what is packed so far and start over
+	if (aggregate && tx_slots[aggregate->slot].payload_len + EASY_AGGREGATE_RECORD_HEADER_LEN + payload_len > max_frame_len)
+	{
+		flushAggregate(*aggregate, AGGREGATE_FLUSH_SIZE);
+		free_aggregate = aggregate;
+		aggregate = nullptr;
+	}
+
+	if (!aggregate)
+	{
+		// all open aggregates are taken by other destinations, the oldest one makes room
+		if (!free_aggregate)
+		{
+			flushAggregate(*oldest_aggregate, AGGREGATE_FLUSH_SIZE);
+			free_aggregate = oldest_aggregate;
+		}
+
+		tx_queue_item_t *slot = acquireTXSlot(0);
+		if (!slot)
+		{
+			WARNING(TAG_CORE, "TX Queue full. Can not open an aggregate. Dropping message...");
+			return EASY_SEND_QUEUE_FULL_ERROR;
+		}
+
+		aggregate = free_aggregate;
+		aggregate->open = true;
+		memcpy(aggregate->dst_address, dst_address, MAC_ADDR_LEN);
+		aggregate->slot = (tx_slot_index_t)slotIndex(slot);
+		aggregate->messages = 0;
+		aggregate->deadline_ms = millis() + aggregation_window_ms;
+		aggregate->enqueue_us_sum = 0;
+		aggregate->opened_us = now_us;
+		aggregate->priority = priority;
+		// one frame, one completion: all the messages packed in it share its handle
+		tx_slot_states[aggregate->slot].handle = newSendHandle();
+		tx_slot_states[aggregate->slot].submitted_us = now_us;
+
+		easy_frame_header_t header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_AGGREGATE};
+		memcpy(slot->payload_data, &header, EASY_FRAME_HEADER_LEN);
+		slot->payload_len = EASY_FRAME_HEADER_LEN;
+	}
+
+	// length prefixed record, gathered straight into the slot
+	tx_queue_item_t &slot = tx_slots[aggregate->slot];
+	slot.payload_data[slot.payload_len++] = (uint8_t)payload_len;
+	for (size_t i = 0; i < fragment_count; i++)
+	{
+		memcpy(slot.payload_data + slot.payload_len, fragments[i].data, fragments[i].len);
+		slot.payload_len += fragments[i].len;
+	}
+
+	*handle = tx_slot_states[aggregate->slot].handle;
+	aggregate->messages++;
+	aggregate->enqueue_us_sum += now_us;
+	// the aggregate goes with the most urgent of its messages
+	if (priority < aggregate->priority)
+		aggregate->priority = priority;
+	aggregation_stats.messages++;
+
+	// not even a one byte message would fit anymore
+	if (slot.payload_len + EASY_AGGREGATE_RECORD_HEADER_LEN + 1 > max_frame_len)
+		flushAggregate(*aggregate, AGGREGATE_FLUSH_SIZE);
+
+	return EASY_SEND_OK;
+}
+
+easy_send_error_t EasyEspNow::sendFragmented(const uint8_t *dstAddress, const easy_iovec_t *fragments, size_t fragment_count, size_t payload_len, uint32_t confirm_timeout_ms,
+											 easy_tx_priority_t priority, easy_send_handle_t *handle)
+{
+	// every fragment carries the handle of the message, the last one reports it
+	easy_send_handle_t message_handle = newSendHandle();
+	uint32_t submitted_us = micros();
+	// where the fragments record a failure for the last one to report
+	tx_slot_index_t message = openTXMessage(message_handle);
+	if (message == TX_SLOT_NONE)
+	{
+		WARNING(TAG_CORE, "As many fragmented messages as TX slots are in flight. Dropping message...");
+		*handle = EASY_SEND_HANDLE_NONE;
+		return EASY_SEND_QUEUE_FULL_ERROR;
+	}
+	*handle = message_handle;
+
+	easy_fragment_header_t header = {.message_id = fragment_next_id.fetch_add(1, std::memory_order_relaxed), .total_len = (uint16_t)payload_len, .offset = 0};
+	easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_FRAGMENT};
+
+	// walk the caller fragments while cutting the message into ESP-NOW frames
+	size_t iov_index = 0;
+	size_t iov_offset = 0;
+	size_t fragment_len = (size_t)max_frame_len - EASY_FRAME_HEADER_LEN - EASY_FRAGMENT_HEADER_LEN;
+	for (size_t offset = 0; offset < payload_len; offset += fragment_len)
+	{
+		size_t chunk_len = payload_len - offset < fragment_len ? payload_len - offset : fragment_len;
+
+		// a missing fragment spoils the whole message, so wait for a slot instead of dropping it
+		tx_queue_item_t *slot = acquireTXSlot(this->synchronous_send ? portMAX_DELAY : pdMS_TO_TICKS(confirm_timeout_ms));
+		if (!slot)
+		{
+			WARNING(TAG_CORE, "TX Queue full. Fragment at offset %zu of %zu bytes message can not be added. Dropping message...", offset, payload_len);
+			closeTXMessage(message, message_handle);
+			*handle = EASY_SEND_HANDLE_NONE;
+			return EASY_SEND_QUEUE_FULL_ERROR;
+		}
+
+		header.offset = (uint16_t)offset;
+		memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+		memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_FRAGMENT_HEADER_LEN);
+
+		size_t written = EASY_FRAME_HEADER_LEN + EASY_FRAGMENT_HEADER_LEN;
+		size_t remaining = chunk_len;
+		while (remaining > 0 && iov_index < fragment_count)
+		{
+			size_t take = fragments[iov_index].len - iov_offset;
+			if (take > remaining)
+				take = remaining;
+			memcpy(slot->payload_data + written, (const uint8_t *)fragments[iov_index].data + iov_offset, take);
+			written += take;
+			remaining -= take;
+			iov_offset += take;
+			if (iov_offset == fragments[iov_index].len)
+			{
+				iov_index++;
+				iov_offset = 0;
+			}
+		}
+		// the caller fragments must hold the whole message
+		if (remaining > 0)
+		{
+			ERROR(TAG_CORE, "Parameters Error. %zu fragments hold less than the %zu bytes of the message", fragment_count, payload_len);
+			releaseTXSlot(slot);
+			closeTXMessage(message, message_handle);
+			*handle = EASY_SEND_HANDLE_NONE;
+			return countSendResult(EASY_SEND_PARAM_ERROR);
+		}
+
+		tx_slot_state_t &state = tx_slot_states[slotIndex(slot)];
+		state.handle = message_handle;
+		state.handle_last = offset + chunk_len >= payload_len;
+		state.message = message;
+		state.submitted_us = submitted_us;
+
+		easy_send_error_t result = queueTXSlot(slot, dstAddress, written, confirm_timeout_ms, priority, nullptr, this->synchronous_send);
+		if (result != EASY_SEND_OK)
+		{
+			closeTXMessage(message, message_handle);
+			*handle = EASY_SEND_HANDLE_NONE;
+			return result;
+		}
+		fragmentation_tx_fragments.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	fragmentation_tx_messages.fetch_add(1, std::memory_order_relaxed);
+	return EASY_SEND_OK;
+}
+
+reliable_peer_t *EasyEspNow::reliablePeer(const uint8_t *mac, bool create)
+{
+	uint32_t now_ms = millis();
+	reliable_peer_t *free_peer = nullptr;
+	reliable_peer_t *idle_peer = nullptr;
+
+	for (uint8_t i = 0; reliable_peers && i < reliable_max_peers; i++)
+	{
+		reliable_peer_t &candidate = reliable_peers[i];
+		if (!candidate.used)
+		{
+			if (!free_peer)
+				free_peer = &candidate;
+			continue;
+		}
+		if (memcmp(candidate.mac, mac, MAC_ADDR_LEN) == 0)
+			return &candidate;
+		// nothing in flight and nothing owed, the channel can be taken over
+		if (candidate.tx_base == candidate.tx_next && !candidate.ack_pending &&
+			(!idle_peer || now_ms - candidate.last_activity_ms > now_ms - idle_peer->last_activity_ms))
+			idle_peer = &candidate;
+	}
+
+	reliable_peer_t *peer = free_peer ? free_peer : idle_peer;
+	if (!create || !peer)
+		return nullptr;
+
+	reliable_entry_t *entries = peer->entries;
+	memset(peer, 0, sizeof(reliable_peer_t));
+	for (uint8_t i = 0; i < reliable_window; i++)
+		entries[i].in_use = false;
+	peer->entries = entries;
+	peer->used = true;
+	memcpy(peer->mac, mac, MAC_ADDR_LEN);
+	// random start, so a restarted sender is not taken for old traffic by the receiver
+	peer->tx_base = peer->tx_next = (uint16_t)random(0, 65536);
+	peer->rto_ms = RELIABLE_INITIAL_RTO_MS;
+	peer->last_activity_ms = now_ms;
+	return peer;
+}
+
+void EasyEspNow::fillReliableAck(reliable_peer_t &peer, easy_reliable_header_t &header)
+{
+	if (!peer.rx_started)
+		return;
+	header.ack = peer.rx_expected;
+	header.sack = peer.rx_received;
+	header.flags |= EASY_RELIABLE_ACK_VALID;
+	peer.ack_pending = false;
+}
+
+bool EasyEspNow::transmitReliable(reliable_peer_t *peer, uint16_t seq)
+{
+	tx_queue_item_t *slot = acquireLibraryTXSlot(0);
+	if (!slot)
+		return false;
+
+	uint8_t dst_address[MAC_ADDR_LEN];
+	size_t len = 0;
+
+	portENTER_CRITICAL(&reliable_mux);
+	reliable_entry_t &entry = peer->entries[seq & (reliable_window - 1)];
+	bool valid = reliable_peers && peer->used && entry.in_use && entry.seq == seq;
+	if (valid)
+	{
+		easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_RELIABLE_DATA};
+		easy_reliable_header_t header = {.seq = seq, .ack = 0, .sack = 0, .flags = (uint8_t)(peer->tx_synced ? 0 : EASY_RELIABLE_SYN)};
+		if (peer->ack_pending)
+			reliable_stats.acks_piggybacked++;
+		fillReliableAck(*peer, header);
+
+		memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+		memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_RELIABLE_HEADER_LEN);
+		memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN + EASY_RELIABLE_HEADER_LEN, entry.payload, entry.len);
+		len = EASY_FRAME_HEADER_LEN + EASY_RELIABLE_HEADER_LEN + entry.len;
+		memcpy(dst_address, peer->mac, MAC_ADDR_LEN);
+
+		uint32_t now_ms = millis();
+		if (entry.transmissions == 0)
+			entry.first_sent_us = micros();
+		else
+			reliable_stats.retransmissions++;
+		entry.transmissions++;
+
+		// exponential backoff of the timeout on every retransmission
+		uint8_t backoff = entry.transmissions - 1 < 6 ? entry.transmissions - 1 : 6;
+		uint32_t rto_ms = peer->rto_ms << backoff;
+		entry.deadline_ms = now_ms + (rto_ms < RELIABLE_MAX_RTO_MS ? rto_ms : RELIABLE_MAX_RTO_MS);
+		peer->last_activity_ms = now_ms;
+		reliable_stats.transmissions++;
+	}
+	portEXIT_CRITICAL(&reliable_mux);
+
+	if (!valid)
+	{
+		// acknowledged or given up meanwhile
+		releaseTXSlot(slot);
+		return true;
+	}
+
+	queueTXSlot(slot, dst_address, len, 0);
+	return true;
+}
+
+void EasyEspNow::processReliableAck(const uint8_t *mac_addr, const easy_reliable_header_t &header)
+{
+	uint16_t delivered[EASY_RELIABLE_MAX_WINDOW];
+	uint8_t delivered_count = 0;
+
+	portENTER_CRITICAL(&reliable_mux);
+	reliable_peer_t *peer = reliablePeer(mac_addr, false);
+	// an acknowledgement for messages never sent belongs to an older channel
+	if (!peer || easySeqDiff(header.ack, peer->tx_next) > 0)
+	{
+		portEXIT_CRITICAL(&reliable_mux);
+		return;
+	}
+
+	uint32_t now_us = micros();
+	uint32_t now_ms = millis();
+	peer->tx_synced = true;
+	peer->last_activity_ms = now_ms;
+
+	for (uint16_t seq = peer->tx_base; easySeqDiff(seq, peer->tx_next) < 0; seq++)
+	{
+		reliable_entry_t &entry = peer->entries[seq & (reliable_window - 1)];
+		int16_t distance = easySeqDiff(seq, header.ack);
+		bool acked = distance < 0 || (distance > 0 && distance <= 32 && (header.sack >> (distance - 1)) & 1);
+		if (!acked || !entry.in_use || entry.seq != seq)
+			continue;
+
+		// Karn: only a message sent once gives an unambiguous round trip time
+		if (entry.transmissions == 1)
+		{
+			uint32_t rtt_us = now_us - entry.first_sent_us;
+			if (!peer->rtt_valid)
+			{
+				peer->srtt_us = rtt_us;
+				peer->rttvar_us = rtt_us / 2;
+				peer->rtt_valid = true;
+			}
+			else
+			{
+				uint32_t delta_us = peer->srtt_us > rtt_us ? peer->srtt_us - rtt_us : rtt_us - peer->srtt_us;
+				peer->rttvar_us = (3 * peer->rttvar_us + delta_us) / 4;
+				peer->srtt_us = (7 * peer->srtt_us + rtt_us) / 8;
+			}
+			uint32_t rto_ms = (peer->srtt_us + 4 * peer->rttvar_us + 999) / 1000;
+			peer->rto_ms = rto_ms < RELIABLE_MIN_RTO_MS ? RELIABLE_MIN_RTO_MS : (rto_ms > RELIABLE_MAX_RTO_MS ? RELIABLE_MAX_RTO_MS : rto_ms);
+			reliable_stats.rtt_samples++;
+			reliable_stats.rtt_last_us = rtt_us;
+		}
+
+		entry.in_use = false;
+		delivered[delivered_count++] = seq;
+		reliable_stats.delivered++;
+	}
+
+	// holes below the highest selectively acknowledged message were lost, send them again now instead of after their timeout
+	if (header.sack)
+	{
+		uint16_t highest = header.ack + 1 + (31 - __builtin_clz(header.sack));
+		for (uint16_t seq = peer->tx_base; easySeqDiff(seq, highest) < 0 && easySeqDiff(seq, peer->tx_next) < 0; seq++)
+		{
+			reliable_entry_t &entry = peer->entries[seq & (reliable_window - 1)];
+			if (entry.in_use && entry.seq == seq && entry.transmissions == 1)
+				entry.deadline_ms = now_ms;
+		}
+	}
+
+	while (peer->tx_base != peer->tx_next)
+	{
+		reliable_entry_t &entry = peer->entries[peer->tx_base & (reliable_window - 1)];
+		if (entry.in_use && entry.seq == peer->tx_base)
+			break;
+		peer->tx_base++;
+	}
+	portEXIT_CRITICAL(&reliable_mux);
+
+	if (delivered_count == 0)
+		return;
+
+	xSemaphoreGive(reliable_space);
+	if (reliableStatus != nullptr)
+	{
+		for (uint8_t i = 0; i < delivered_count; i++)
+			reliableStatus(mac_addr, delivered[i], true);
+	}
+}
+
+void EasyEspNow::receiveReliableData(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info)
+{
+	easy_reliable_header_t header;
+	memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_RELIABLE_HEADER_LEN);
+	const uint8_t *payload = data + EASY_FRAME_HEADER_LEN + EASY_RELIABLE_HEADER_LEN;
+	int payload_len = data_len - EASY_FRAME_HEADER_LEN - EASY_RELIABLE_HEADER_LEN;
+
+	// acknowledgement riding on reverse traffic
+	if (header.flags & EASY_RELIABLE_ACK_VALID)
+		processReliableAck(mac_addr, header);
+
+	bool deliver = false;
+
+	portENTER_CRITICAL(&reliable_mux);
+	reliable_peer_t *peer = reliablePeer(mac_addr, true);
+	if (peer)
+	{
+		uint32_t now_ms = millis();
+		int16_t distance = peer->rx_started ? easySeqDiff(header.seq, peer->rx_expected) : 0;
+
+		// first message from the peer, or the peer restarted and its new sequence numbers are far from the old ones
+		if (!peer->rx_started || ((header.flags & EASY_RELIABLE_SYN) && (distance < -EASY_RELIABLE_MAX_WINDOW || distance > EASY_RELIABLE_MAX_WINDOW)))
+		{
+			peer->rx_started = true;
+			peer->rx_expected = header.seq;
+			peer->rx_received = 0;
+			distance = 0;
+		}
+
+		bool ack_now = false;
+		if (distance < 0)
+		{
+			// the acknowledgement got lost, repeat it
+			reliable_stats.duplicates++;
+			ack_now = true;
+		}
+		else if (distance == 0)
+		{
+			deliver = true;
+			peer->rx_expected++;
+			// messages received ahead that are now in order
+			while (peer->rx_received & 1)
+			{
+				peer->rx_received >>= 1;
+				peer->rx_expected++;
+			}
+			peer->rx_received >>= 1;
+
+			// give reverse traffic a chance to carry the acknowledgement
+			if (!peer->ack_pending)
+			{
+				peer->ack_pending = true;
+				peer->ack_deadline_ms = now_ms + reliable_ack_delay_ms;
+			}
+		}
+		else if (distance <= EASY_RELIABLE_MAX_WINDOW)
+		{
+			uint32_t bit = 1UL << (distance - 1);
+			if (peer->rx_received & bit)
+				reliable_stats.duplicates++;
+			else
+			{
+				peer->rx_received |= bit;
+				deliver = true;
+			}
+			// tell the sender about the hole right away
+			ack_now = true;
+		}
+		else
+			reliable_stats.out_of_window++;
+
+		if (ack_now)
+		{
+			peer->ack_pending = true;
+			peer->ack_deadline_ms = now_ms;
+		}
+		if (deliver)
+			reliable_stats.received++;
+		peer->last_activity_ms = now_ms;
+	}
+	portEXIT_CRITICAL(&reliable_mux);
+
+	if (deliver && payload_len > 0)
+		deliverRXFrame(mac_addr, payload, payload_len, frame_info);
+}
+
+TickType_t EasyEspNow::serviceReliable(TickType_t max_wait)
+{
+	if (!reliable_peers)
+		return max_wait;
+
+	// an acknowledgement owed while the TX task waits must not wait much longer than the ACK delay
+	TickType_t wait = pdMS_TO_TICKS(reliable_ack_delay_ms);
+	if (wait > max_wait)
+		wait = max_wait;
+
+	uint32_t now_ms = millis();
+	for (uint8_t i = 0; i < reliable_max_peers; i++)
+	{
+		uint16_t due[EASY_RELIABLE_MAX_WINDOW];
+		uint16_t failed[EASY_RELIABLE_MAX_WINDOW];
+		uint8_t due_count = 0;
+		uint8_t failed_count = 0;
+		bool send_ack = false;
+		uint8_t mac[MAC_ADDR_LEN];
+
+		portENTER_CRITICAL(&reliable_mux);
+		if (!reliable_peers)
+		{
+			portEXIT_CRITICAL(&reliable_mux);
+			break;
+		}
+		reliable_peer_t *peer = &reliable_peers[i];
+		if (peer->used)
+		{
+			for (uint16_t seq = peer->tx_base; easySeqDiff(seq, peer->tx_next) < 0; seq++)
+			{
+				reliable_entry_t &entry = peer->entries[seq & (reliable_window - 1)];
+				if (!entry.in_use || entry.seq != seq)
+					continue;
+
+				int32_t left_ms = (int32_t)(entry.deadline_ms - now_ms);
+				if (left_ms > 0)
+				{
+					if (pdMS_TO_TICKS(left_ms) < wait)
+						wait = pdMS_TO_TICKS(left_ms);
+				}
+				else if (entry.transmissions > reliable_max_retries)
+				{
+					entry.in_use = false;
+					failed[failed_count++] = seq;
+					reliable_stats.failed++;
+				}
+				else
+					due[due_count++] = seq;
+			}
+
+			while (peer->tx_base != peer->tx_next)
+			{
+				reliable_entry_t &entry = peer->entries[peer->tx_base & (reliable_window - 1)];
+				if (entry.in_use && entry.seq == peer->tx_base)
+					break;
+				peer->tx_base++;
+			}
+
+			if (peer->ack_pending)
+			{
+				int32_t left_ms = (int32_t)(peer->ack_deadline_ms - now_ms);
+				if (left_ms <= 0)
+					send_ack = true;
+				else if (pdMS_TO_TICKS(left_ms) < wait)
+					wait = pdMS_TO_TICKS(left_ms);
+			}
+			memcpy(mac, peer->mac, MAC_ADDR_LEN);
+		}
+		portEXIT_CRITICAL(&reliable_mux);
+
+		for (uint8_t j = 0; j < due_count; j++)
+		{
+			// out of TX slots, try again on the next tick
+			if (transmitReliable(peer, due[j]) == false)
+			{
+				wait = 1;
+				break;
+			}
+		}
+
+		// nothing carried the acknowledgement, send it on its own
+		if (send_ack)
+		{
+			tx_queue_item_t *slot = acquireLibraryTXSlot(0);
+			if (slot)
+			{
+				easy_reliable_header_t header = {.seq = 0, .ack = 0, .sack = 0, .flags = 0};
+				portENTER_CRITICAL(&reliable_mux);
+				bool still_pending = peer->used && peer->ack_pending;
+				if (still_pending)
+				{
+					fillReliableAck(*peer, header);
+					reliable_stats.acks_sent++;
+				}
+				portEXIT_CRITICAL(&reliable_mux);
+
+				if (still_pending)
+				{
+					easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_RELIABLE_ACK};
+					memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+					memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_RELIABLE_HEADER_LEN);
+					queueTXSlot(slot, mac, EASY_FRAME_HEADER_LEN + EASY_RELIABLE_HEADER_LEN, 0, TX_PRIORITY_CONTROL);
+				}
+				else
+					releaseTXSlot(slot);
+			}
+			else
+				wait = 1;
+		}
+
+		if (failed_count > 0)
+		{
+			WARNING(TAG_HELPER, "%d reliable message(s) to [" EASYMACSTR "] not acknowledged after %d retries", failed_count, EASYMAC2STR(mac), reliable_max_retries);
+			xSemaphoreGive(reliable_space);
+			if (reliableStatus != nullptr)
+			{
+				for (uint8_t j = 0; j < failed_count; j++)
+					reliableStatus(mac, failed[j], false);
+			}
 		}
 	}
+
+	return wait > 0 ? wait : 1;
+}
+
+EasyPeerTable<peer_t> &EasyEspNow::groupPeerTable()
+{
+	return directory_table.capacity() > 0 ? directory_table : peer_table;
+}
+
+bool EasyEspNow::transmitGroupUnicasts(uint8_t send_index)
+{
+	while (true)
+	{
+		portENTER_CRITICAL(&group_mux);
+		bool waiting = group_sends && send_index < group_max_sends && group_sends[send_index].used && group_sends[send_index].to_send;
+		portEXIT_CRITICAL(&group_mux);
+		if (!waiting)
+			return true;
+
+		tx_queue_item_t *slot = acquireLibraryTXSlot(0);
+		if (!slot)
+			return false;
+
+		uint8_t member = 0;
+		uint8_t dst_address[MAC_ADDR_LEN];
+		size_t len = 0;
+
+		portENTER_CRITICAL(&group_mux);
+		group_send_t *send = group_sends && send_index < group_max_sends ? &group_sends[send_index] : nullptr;
+		if (send && send->used && send->to_send)
+		{
+			member = __builtin_ctz(send->to_send);
+			send->to_send &= ~(1UL << member);
+			send->pending |= 1UL << member;
+			memcpy(dst_address, send->members[member], MAC_ADDR_LEN);
+
+			// repairs and messages that look like a library frame carry the group header, so the member drops repeats
+			bool repair = send->mode == GROUP_SEND_BROADCAST;
+			if (repair || send->payload[0] == EASY_FRAME_MAGIC)
+			{
+				easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_GROUP_DATA};
+				easy_group_header_t header = {.group = send->group_hash, .send_id = send->send_id, .flags = 0};
+				memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+				memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_GROUP_HEADER_LEN);
+				len = EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN;
+			}
+			memcpy(slot->payload_data + len, send->payload, send->payload_len);
+			len += send->payload_len;
+
+			if (repair)
+			{
+				send->repairs++;
+				group_stats.repairs++;
+			}
+			group_stats.frames++;
+		}
+		portEXIT_CRITICAL(&group_mux);
+
+		if (len == 0)
+		{
+			// reported or disabled meanwhile
+			releaseTXSlot(slot);
+			return true;
+		}
+
+		tx_slot_state_t &state = tx_slot_states[slotIndex(slot)];
+		state.group_send = send_index + 1;
+		state.group_member = member;
+		easy_send_error_t result = queueTXSlot(slot, dst_address, len, 0);
+		if (result != EASY_SEND_OK)
+			completeGroupFrame(send_index, member, ESP_NOW_SEND_FAIL);
+	}
+}
+
+void EasyEspNow::completeGroupFrame(uint8_t send_index, uint8_t member, esp_now_send_status_t status)
+{
+	portENTER_CRITICAL(&group_mux);
+	if (!group_sends || send_index >= group_max_sends || !group_sends[send_index].used)
+	{
+		portEXIT_CRITICAL(&group_mux);
+		return;
+	}
+
+	group_send_t &send = group_sends[send_index];
+	if (member == GROUP_MEMBER_ALL)
+	{
+		// members acknowledge the broadcast from now on. If it could not even be sent, all of them get a repair right away
+		send.broadcast_pending = false;
+		send.awaiting_acks = true;
+		send.ack_deadline_ms = millis() + (status == ESP_NOW_SEND_SUCCESS ? group_ack_timeout_ms : 0);
+	}
+	else if (member < send.member_count)
+	{
+		send.pending &= ~(1UL << member);
+		if (status == ESP_NOW_SEND_SUCCESS)
+			send.delivered |= 1UL << member;
+	}
+	portEXIT_CRITICAL(&group_mux);
+
+	finishGroupSend(send_index);
 }
 
-char *EasyEspNow::easyMac2Char(const uint8_t *some_mac, size_t len, bool upper_case)
+void EasyEspNow::finishGroupSend(uint8_t send_index)
 {
-	const uint8_t default_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+	group_send_result_t result;
 
-	const char *format;
-	if (upper_case)
-		format = "%02X:%02X:%02X:%02X:%02X:%02X";
-	else
-		format = "%02x:%02x:%02x:%02x:%02x:%02x";
+	portENTER_CRITICAL(&group_mux);
+	group_send_t *send = group_sends && send_index < group_max_sends ? &group_sends[send_index] : nullptr;
+	if (!send || !send->used || send->reporting)
+	{
+		portEXIT_CRITICAL(&group_mux);
+		return;
+	}
 
-	if (!some_mac || len != 6)
+	uint32_t all_members = (uint32_t)(((uint64_t)1 << send->member_count) - 1);
+	if (send->awaiting_acks && (send->delivered & all_members) == all_members)
 	{
-		some_mac = default_mac;
-		// WARNING(TAG_MISC, "MAC argument is either null or has a length different from 6.  Defaulting to MAC: [00:00:00:00:00:00]");
+		// every member acknowledged the broadcast, no loss this time
+		send->awaiting_acks = false;
+		peer_group_t &group = groups[send->group];
+		group.broadcast_loss = (uint8_t)(3 * group.broadcast_loss / 4);
+	}
+	if (send->to_send || send->pending || send->broadcast_pending || send->awaiting_acks)
+	{
+		portEXIT_CRITICAL(&group_mux);
+		return;
 	}
 
-	static char mac_2_char[18] = {0};
-	sprintf(mac_2_char, format, some_mac[0], some_mac[1], some_mac[2], some_mac[3], some_mac[4], some_mac[5]);
-	return mac_2_char;
+	uint8_t delivered = __builtin_popcount(send->delivered);
+	group_stats.members_delivered += delivered;
+	group_stats.members_failed += send->member_count - delivered;
+	send->reporting = true;
+	result.send_id = send->send_id;
+	result.group = send->group;
+	result.mode = send->mode;
+	result.member_count = send->member_count;
+	result.members = send->members;
+	result.delivered = send->delivered;
+	result.repairs = send->repairs;
+	result.elapsed_us = micros() - send->started_us;
+	portEXIT_CRITICAL(&group_mux);
+
+	if (delivered < result.member_count)
+		WARNING(TAG_HELPER, "Group message %d delivered to %d of %d members", result.send_id, delivered, result.member_count);
+
+	if (groupSendResult != nullptr)
+		groupSendResult(&result);
+
+	portENTER_CRITICAL(&group_mux);
+	send->reporting = false;
+	send->used = false;
+	portEXIT_CRITICAL(&group_mux);
 }
 
-void EasyEspNow::easyPrintMac2Char(const uint8_t *some_mac, size_t len, bool upper_case)
+void EasyEspNow::receiveGroupData(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info)
 {
-	const uint8_t default_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+	easy_group_header_t header;
+	memcpy(&header, data + EASY_FRAME_HEADER_LEN, EASY_GROUP_HEADER_LEN);
+	const uint8_t *payload = data + EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN;
+	int payload_len = data_len - EASY_FRAME_HEADER_LEN - EASY_GROUP_HEADER_LEN;
 
-	const char *format;
-	if (upper_case)
-		format = "%02X:%02X:%02X:%02X:%02X:%02X";
+	// broadcasts only for the groups this device joined, unicasts were meant for it anyway
+	bool accepted = memcmp(frame_info->esp_now_frame->destination_address, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) != 0;
+	portENTER_CRITICAL(&group_mux);
+	for (uint8_t i = 0; i < MAX_GROUPS && !accepted; i++)
+		accepted = groups[i].used && groups[i].joined && groups[i].hash == header.group;
+	portEXIT_CRITICAL(&group_mux);
+	if (!accepted)
+		return;
+
+	// the acknowledgement of the broadcast got lost and the repair brings the message again
+	bool duplicate = false;
+	for (uint8_t i = 0; i < GROUP_RX_RECENT && !duplicate; i++)
+		duplicate = group_rx_recent[i].send_id == header.send_id && memcmp(group_rx_recent[i].mac, mac_addr, MAC_ADDR_LEN) == 0;
+	if (!duplicate)
+	{
+		memcpy(group_rx_recent[group_rx_recent_next].mac, mac_addr, MAC_ADDR_LEN);
+		group_rx_recent[group_rx_recent_next].send_id = header.send_id;
+		group_rx_recent_next = (group_rx_recent_next + 1) % GROUP_RX_RECENT;
+	}
+
+	portENTER_CRITICAL(&group_mux);
+	if (duplicate)
+		group_stats.rx_duplicates++;
 	else
-		format = "%02x:%02x:%02x:%02x:%02x:%02x";
+		group_stats.rx_messages++;
+	portEXIT_CRITICAL(&group_mux);
 
-	if (!some_mac || len != 6)
+	if (header.flags & EASY_GROUP_ACK_REQUESTED)
 	{
-		some_mac = default_mac;
-		// WARNING(TAG_MISC, "MAC argument is either null or has a length different from 6.  Defaulting to MAC: [00:00:00:00:00:00]");
-		return;
+		tx_queue_item_t *slot = acquireLibraryTXSlot(0);
+		if (slot)
+		{
+			easy_frame_header_t frame_header = {.magic = EASY_FRAME_MAGIC, .type = EASY_FRAME_GROUP_ACK};
+			header.flags = 0;
+			memcpy(slot->payload_data, &frame_header, EASY_FRAME_HEADER_LEN);
+			memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_GROUP_HEADER_LEN);
+			if (queueTXSlot(slot, mac_addr, EASY_FRAME_HEADER_LEN + EASY_GROUP_HEADER_LEN, 0, TX_PRIORITY_CONTROL) == EASY_SEND_OK)
+			{
+				portENTER_CRITICAL(&group_mux);
+				group_stats.acks_sent++;
+				portEXIT_CRITICAL(&group_mux);
+			}
+		}
+		// without a free slot the sender repairs by unicast
 	}
 
-	Serial.printf(format, some_mac[0], some_mac[1], some_mac[2], some_mac[3], some_mac[4], some_mac[5]);
+	if (!duplicate && payload_len > 0)
+		deliverRXFrame(mac_addr, payload, payload_len, frame_info);
 }
 
-int32_t EasyEspNow::getEspNowVersion()
+void EasyEspNow::answerProbe(const uint8_t *mac_addr, const uint8_t *data, int data_len, easy_probe_header_t header, int64_t rx_us)
 {
-	uint32_t esp_now_version;
-	err = esp_now_get_version(&esp_now_version);
-	if (err != ESP_OK)
+	// the reply goes back at once, in the control class, and is as long as the probe
+	tx_queue_item_t *slot = acquireLibraryTXSlot(0);
+	if (!slot || data_len > max_frame_len)
 	{
-		ERROR(TAG_MISC, "Failed to get ESP-NOW version with error: %s", esp_err_to_name(err));
-		return -1;
+		if (slot)
+			releaseTXSlot(slot);
+		// the pinging side counts it as lost
+		WARNING(TAG_CORE, "Probe from [" EASYMACSTR "] not answered", EASYMAC2STR(mac_addr));
+		return;
 	}
-	else
+	memcpy(slot->payload_data, data, data_len);
+	header.flags = EASY_PROBE_REPLY;
+	header.rx_us = rx_us;
+	header.reply_us = esp_timer_get_time();
+	memcpy(slot->payload_data + EASY_FRAME_HEADER_LEN, &header, EASY_PROBE_HEADER_LEN);
+	queueTXSlot(slot, mac_addr, data_len, 0, TX_PRIORITY_CONTROL);
+}
+
+void EasyEspNow::receiveProbeReply(const uint8_t *mac_addr, const easy_probe_header_t &header, int64_t rx_us)
+{
+	bool matched = false;
+	portENTER_CRITICAL(&probe_mux);
+	if (ping_running && header.ping_id == ping_id && header.seq < ping_count && memcmp(mac_addr, ping_peer, MAC_ADDR_LEN) == 0)
 	{
-		MONITOR(TAG_MISC, "Success getting ESP-NOW version");
-		return (int32_t)esp_now_version;
+		probe_record_t &record = ping_records[header.seq];
+		// a duplicate reply is counted once
+		if (record.queued_us && !record.reply_us)
+		{
+			record.reply_us = rx_us;
+			record.remote_rx_us = header.rx_us;
+			record.remote_reply_us = header.reply_us;
+			ping_replies++;
+			matched = true;
+		}
 	}
+	portEXIT_CRITICAL(&probe_mux);
+	if (matched)
+		xSemaphoreGive(ping_reply);
 }
 
-uint8_t *EasyEspNow::getDeviceMACAddress()
+void EasyEspNow::stampProbe(uint32_t probe, bool sent, int64_t at_us)
 {
-	if (memcmp(my_mac_address, zero_mac, MAC_ADDR_LEN) == 0)
+	uint16_t id = probe >> 16;
+	uint16_t seq = (uint16_t)(probe & 0xFFFF) - 1;
+	portENTER_CRITICAL(&probe_mux);
+	if (ping_running && id == ping_id && seq < ping_count)
 	{
-		WARNING(TAG_MISC, "This device's MAC is not avaiable");
-		return nullptr;
+		if (sent)
+			ping_records[seq].sent_us = at_us;
+		else
+			ping_records[seq].completed_us = at_us;
 	}
-
-	return this->my_mac_address;
+	portEXIT_CRITICAL(&probe_mux);
 }
 
-uint8_t *EasyEspNow::generateRandomMAC(bool local, bool unicast)
+void EasyEspNow::processGroupAck(const uint8_t *mac_addr, const easy_group_header_t &header)
 {
-	static uint8_t mac[6]; // Static array to hold the MAC address
+	int index = -1;
 
-	for (int i = 0; i < 6; i++)
+	portENTER_CRITICAL(&group_mux);
+	for (uint8_t i = 0; group_sends && i < group_max_sends && index < 0; i++)
 	{
-		mac[i] = random(0, 256); // Generate random byte for each part of the MAC
+		group_send_t &send = group_sends[i];
+		if (!send.used || send.mode != GROUP_SEND_BROADCAST || send.send_id != header.send_id || send.group_hash != header.group)
+			continue;
+		for (uint8_t member = 0; member < send.member_count; member++)
+		{
+			if (memcmp(send.members[member], mac_addr, MAC_ADDR_LEN) == 0)
+			{
+				send.delivered |= 1UL << member;
+				group_stats.acks_received++;
+				index = i;
+				break;
+			}
+		}
 	}
+	portEXIT_CRITICAL(&group_mux);
 
-	// Set or clear the local bit (bit 1 of the first byte) based on the local flag
-	if (local)
-		mac[0] |= 0x02; // Set to indicate locally administered
-	else
-		mac[0] &= 0xFD; // Clear to indicate globally unique
-
-	// Set or clear the unicast/multicast bit (bit 0 of the first byte) based on the unicast flag
-	if (unicast)
-		mac[0] &= 0xFE; // Clear to indicate unicast
-	else
-		mac[0] |= 0x01; // Set to indicate multicast
-
-	return mac; // Return the pointer to the MAC address array
+	if (index >= 0)
+		finishGroupSend((uint8_t)index);
 }
 
-bool EasyEspNow::switchChannel(uint8_t primary, wifi_second_chan_t second)
+TickType_t EasyEspNow::serviceGroups(TickType_t max_wait)
 {
-	if (primary < 1 || primary > 14)
-	{
-		WARNING(TAG_MISC, "Can't switch channel. Invalid value[%d] provided. Must be within the range [1..14]", primary);
-		return false;
-	}
+	if (!group_sends)
+		return max_wait;
 
-	// This will set the WiFi channel for the home (this station)
-	if (setChannel(primary, second))
+	TickType_t wait = max_wait;
+	uint32_t now_ms = millis();
+	for (uint8_t i = 0; i < group_max_sends; i++)
 	{
-		bool no_errors = true;
-		// iterate through all the peers and change the channel for each of them
-		for (uint8_t i = 0; i < peer_list.peer_number; i++)
-		{
-			uint32_t last_seen = peer_list.peer[i].time_peer_added;
-			uint8_t mac[MAC_ADDR_LEN] = {0};
-			memcpy(mac, peer_list.peer[i].mac, MAC_ADDR_LEN);
-			// Retrieve and modify peer info structures
-			esp_now_peer_info_t fetchedPeer;
+		bool expired = false;
+		bool unicasts_waiting = false;
 
-			esp_err_t get_peer_err, mod_peer_err;
-
-			get_peer_err = esp_now_get_peer(mac, &fetchedPeer);
-			if (get_peer_err == ESP_OK)
+		portENTER_CRITICAL(&group_mux);
+		if (!group_sends)
+		{
+			portEXIT_CRITICAL(&group_mux);
+			break;
+		}
+		group_send_t &send = group_sends[i];
+		if (send.used && !send.reporting)
+		{
+			if (send.awaiting_acks)
 			{
-				fetchedPeer.channel = primary; // New channel for peer
-				mod_peer_err = esp_now_mod_peer(&fetchedPeer);
-				if (mod_peer_err != ESP_OK)
+				int32_t left_ms = (int32_t)(send.ack_deadline_ms - now_ms);
+				if (left_ms > 0)
 				{
-					MONITOR(TAG_MISC, "Failed to modify channel[%d] for peer[#%d] with MAC: " EASYMACSTR ". Error: %s", primary, i + 1, EASYMAC2STR(mac), esp_err_to_name(mod_peer_err));
-					no_errors = false;
+					if (pdMS_TO_TICKS(left_ms) < wait)
+						wait = pdMS_TO_TICKS(left_ms);
 				}
 				else
 				{
-					MONITOR(TAG_MISC, "Successfully modified to channel[%d] for peer[#%d] with MAC: " EASYMACSTR, primary, i + 1, EASYMAC2STR(mac));
+					// members that did not acknowledge get the message by unicast
+					uint32_t all_members = (uint32_t)(((uint64_t)1 << send.member_count) - 1);
+					uint32_t missing = all_members & ~send.delivered;
+					send.awaiting_acks = false;
+					send.to_send |= missing;
+					peer_group_t &group = groups[send.group];
+					group.broadcast_loss = (uint8_t)((3 * group.broadcast_loss + 255 * __builtin_popcount(missing) / send.member_count) / 4);
+					expired = true;
 				}
 			}
-			else
-			{
-				MONITOR(TAG_MISC, "Failed to retrieve info for peer[#%d] with MAC: " EASYMACSTR ". Error: %s", i + 1, EASYMAC2STR(mac), esp_err_to_name(get_peer_err));
-				no_errors = false;
-			}
+			unicasts_waiting = send.to_send != 0;
 		}
-		return no_errors;
+		portEXIT_CRITICAL(&group_mux);
+
+		// out of TX slots, try again on the next tick
+		if (unicasts_waiting && transmitGroupUnicasts(i) == false)
+			wait = 1;
+		if (expired)
+			finishGroupSend(i);
 	}
-	else
-		return false;
-}
 
-/* ==========> Helper Functions for the Core Functions <========== */
+	return wait > 0 ? wait : 1;
+}
 
-bool EasyEspNow::initComms()
+void EasyEspNow::flushAggregate(tx_aggregate_t &aggregate, aggregate_flush_reason_t reason)
 {
-	// Init ESP-NOW here
-	err = esp_now_init();
-	if (err == ESP_OK)
-	{
-		MONITOR(TAG_HELPER, "Success initializing ESP-NOW");
-	}
-	else
-	{
-		MONITOR(TAG_HELPER, "Failed to initialize ESP-NOW");
-		ERROR(TAG_HELPER, "Failed to initialize ESP-NOW with error: %s", esp_err_to_name(err));
-		return false;
-	}
+	if (!aggregate.open)
+		return;
+	aggregate.open = false;
 
-	// Register low-level rx cb
-	err = esp_now_register_recv_cb(rx_cb);
-	if (err == ESP_OK)
-	{
-		MONITOR(TAG_HELPER, "Success registering low level ESP-NOW RX callback");
-	}
-	else
-	{
-		MONITOR(TAG_HELPER, "Failed registering low level ESP-NOW RX callback");
-		ERROR(TAG_HELPER, "Failed registering low level ESP-NOW RX callback with error: %s", esp_err_to_name(err));
-		return false;
-	}
+	// every message waited from the moment it was packed until now
+	uint32_t now_us = micros();
+	uint32_t latency_max_us = now_us - aggregate.opened_us;
+	aggregation_stats.latency_total_us += aggregate.messages * now_us - aggregate.enqueue_us_sum;
+	if (latency_max_us > aggregation_stats.latency_max_us)
+		aggregation_stats.latency_max_us = latency_max_us;
+	aggregation_stats.frames++;
 
-	// Register low-level tx cb
-	err = esp_now_register_send_cb(tx_cb);
-	if (err == ESP_OK)
-	{
-		MONITOR(TAG_HELPER, "Success registering low level ESP-NOW TX callback");
-	}
-	else
+	switch (reason)
 	{
-		MONITOR(TAG_HELPER, "Failed registering low level ESP-NOW TX callback");
-		ERROR(TAG_HELPER, "Failed registering low level ESP-NOW TX callback with error: %s", esp_err_to_name(err));
-		return false;
+	case AGGREGATE_FLUSH_SIZE:
+		aggregation_stats.flushes_size++;
+		break;
+	case AGGREGATE_FLUSH_DEADLINE:
+		aggregation_stats.flushes_deadline++;
+		break;
+	case AGGREGATE_FLUSH_EXPLICIT:
+		aggregation_stats.flushes_explicit++;
+		break;
+	case AGGREGATE_FLUSH_BYPASS:
+		aggregation_stats.flushes_bypass++;
+		break;
 	}
 
-	if (this->synchronous_send == true)
-		tx_queue_size = 1; // may be redundant but set TX Queue size to 1 when synchronous send mode
+	DEBUG(TAG_HELPER, "Flushing aggregate of %d message(s), %zu bytes to [" EASYMACSTR "]", aggregate.messages, tx_slots[aggregate.slot].payload_len, EASYMAC2STR(aggregate.dst_address));
 
-	// tx_queue = xQueueCreate(tx_queue_size, sizeof(int));
-	// xTaskCreateUniversal(processTxQueueTask, "espnow_loop", 8 * 1024, NULL, 1, &txTask_handle, CONFIG_ARDUINO_RUNNING_CORE);
+	memcpy(tx_slots[aggregate.slot].dst_address, aggregate.dst_address, MAC_ADDR_LEN);
+	// aggregates exist only in asynchronous send mode, this does not block
+	enqueueTXSlot(aggregate.slot, 0, aggregate.priority);
+}
 
-	txQueue = xQueueCreate(tx_queue_size, sizeof(tx_queue_item_t));
-	// Check if the queue was created successfully
-	if (txQueue == NULL)
-	{
-		ERROR(TAG_HELPER, "Failed to create TX Queue");
-		// Handle the error, possibly halt or retry queue creation
-		return false;
-	}
-	else
-	{
-		MONITOR(TAG_HELPER, "Successfully created TX Queue");
-	}
+TickType_t EasyEspNow::flushExpiredAggregates(TickType_t max_wait)
+{
+	if (!tx_aggregates)
+		return max_wait;
 
-	BaseType_t task_creation_result = xTaskCreateUniversal(easyEspNowTxQueueTask, "send_esp_now", 8 * 1024, NULL, 1, &txTaskHandle, CONFIG_ARDUINO_RUNNING_CORE);
-	if (task_creation_result != pdPASS)
-	{
-		// Task creation failed
-		ERROR(TAG_HELPER, "TX Task creation failed! Error: %ld", task_creation_result);
-		return false;
-	}
-	else
+	// an aggregate opened while the TX task waits must not overstay its window by more than one window
+	TickType_t wait = pdMS_TO_TICKS(aggregation_window_ms);
+	if (wait > max_wait)
+		wait = max_wait;
+
+	xSemaphoreTake(aggregation_mutex, portMAX_DELAY);
+	uint32_t now_ms = millis();
+	for (uint8_t i = 0; tx_aggregates && i < aggregation_max_open; i++)
 	{
-		// Task creation succeeded
-		MONITOR(TAG_HELPER, "TX Task creation successful");
-	}
+		tx_aggregate_t &aggregate = tx_aggregates[i];
+		if (!aggregate.open)
+			continue;
 
-	MONITOR(TAG_HELPER, "TX Synchronous Send mode is set to: [ %s ]. TX Queue Size is set to: [ %d ]", this->synchronous_send ? "TRUE" : "FALSE", this->tx_queue_size);
+		int32_t left_ms = (int32_t)(aggregate.deadline_ms - now_ms);
+		if (left_ms <= 0)
+			flushAggregate(aggregate, AGGREGATE_FLUSH_DEADLINE);
+		else if (pdMS_TO_TICKS(left_ms) < wait)
+			wait = pdMS_TO_TICKS(left_ms);
+	}
+	xSemaphoreGive(aggregation_mutex);
 
-	return true;
+	return wait > 0 ? wait : 1;
 }
 
-bool EasyEspNow::setChannel(uint8_t primary_channel, wifi_second_chan_t second)
+esp_err_t EasyEspNow::registerPeer(const uint8_t *peer_addr)
 {
-	esp_err_t ret = esp_wifi_set_channel(primary_channel, second);
-	if (ret == ESP_OK)
-	{
-		MONITOR(TAG_HELPER, "WiFi channel was successfully set to: %d", primary_channel);
-		wifi_primary_channel = primary_channel;
-		wifi_secondary_channel = second;
-		return true;
-	}
-	else
+	// peer can be in a different interface from the home (this station) and still receive the message.
+	esp_now_peer_info_t peer_info;
+	memset(&peer_info, 0, sizeof(peer_info));
+	memcpy(peer_info.peer_addr, peer_addr, MAC_ADDR_LEN);
+	peer_info.ifidx = wifi_phy_interface; // this does not really matter to set it the same as the peer. This is relevant to the home station WiFi mode and interface. ESP_ERR_ESPNOW_IF
+	// with the channel scheduler the peer follows the radio
+	peer_info.channel = channel_peers_follow ? 0 : wifi_primary_channel;
+	peer_info.encrypt = false;
+
+	err = esp_now_add_peer(&peer_info);
+	if (err == ESP_OK)
 	{
-		MONITOR(TAG_HELPER, "Failed to set WiFi channel");
-		VERBOSE(TAG_HELPER, "Failed to set WiFi channel with error: %s\n", esp_err_to_name(ret));
-		return false;
+		portENTER_CRITICAL(&peers_mux);
+		int index = peer_table.insert(peer_addr);
+		if (index >= 0)
+		{
+			peer_table.at(index).time_peer_added = millis();
+			peer_table.at(index).frames_in_flight = 0;
+			peer_table.at(index).groups = 0;
+			peer_table.at(index).channel = 0;
+			peer_table.at(index).compression = COMPRESSION_OFF;
+			peer_table.at(index).rate_bytes_per_s = 0;
+			peer_table.at(index).rate_burst = 0;
+			peer_table.at(index).stats = {};
+		}
+		peer_list.peer_number = peer_table.size();
+		portEXIT_CRITICAL(&peers_mux);
 	}
+	return err;
 }
 
-void EasyEspNow::rx_cb(const uint8_t *mac_addr, const uint8_t *data, int data_len)
+static void atomicMax(std::atomic<uint32_t> &target, uint32_t value)
 {
-	DEBUG(TAG_HELPER, "Calling ESP-NOW low level RX cb");
-
-	/** Why This Works:
-	 * In promiscuous mode, the received ESP-NOW data is part of a larger 802.11 packet (Management -> Action Frame ).
-	 * When the data pointer is passed to the callback, it only points to the payload portion of the packet.
-	 * By manipulating the pointer (shifting it back), you're able to access the surrounding metadata,
-	 * such as the frame headers and control information that are part of the full 802.11 packet.
-	 */
+	uint32_t current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		;
+}
 
-	espnow_frame_format_t *esp_now_packet = (espnow_frame_format_t *)(data - sizeof(espnow_frame_format_t));
-	wifi_promiscuous_pkt_t *promiscuous_pkt = (wifi_promiscuous_pkt_t *)(data - sizeof(wifi_pkt_rx_ctrl_t) - sizeof(espnow_frame_format_t));
-	wifi_pkt_rx_ctrl_t *rx_ctrl = &promiscuous_pkt->rx_ctrl;
+bool EasyEspNow::swapInPeer(const uint8_t *peer_addr)
+{
+	if (directory_table.capacity() == 0 || memcmp(peer_addr, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) == 0)
+		return true;
 
-	espnow_frame_recv_info_t frame_promisc_info = {.radio_header = rx_ctrl, .esp_now_frame = esp_now_packet};
+	portENTER_CRITICAL(&peers_mux);
+	int index = peer_table.find(peer_addr);
+	// least recently used order of the ESP-NOW peers
+	if (index >= 0)
+		peer_table.touch(index);
+	bool in_directory = directory_table.find(peer_addr) >= 0;
+	portEXIT_CRITICAL(&peers_mux);
 
-	if (easyEspNow.dataReceived != nullptr)
+	if (index >= 0)
 	{
-		easyEspNow.dataReceived(mac_addr, data, data_len, &frame_promisc_info);
+		directory_hits.fetch_add(1, std::memory_order_relaxed);
+		return true;
 	}
-}
+	if (!in_directory)
+		return true; // unknown peer, esp_now_send will report it
 
-void EasyEspNow::tx_cb(const uint8_t *mac_addr, esp_now_send_status_t status)
-{
-	DEBUG(TAG_HELPER, "Calling ESP-NOW low level TX cb");
+	directory_misses.fetch_add(1, std::memory_order_relaxed);
+	uint32_t swap_start = micros();
 
-	if (easyEspNow.dataSent != nullptr)
+	for (uint8_t attempt = 0; attempt < 2; attempt++)
 	{
-		easyEspNow.dataSent(mac_addr, status);
+		bool need_eviction;
+		bool victim_found = false;
+		uint8_t victim_mac[MAC_ADDR_LEN];
+
+		portENTER_CRITICAL(&peers_mux);
+		need_eviction = peer_table.full();
+		for (int i = peer_table.newer(-1); need_eviction && i >= 0; i = peer_table.newer(i))
+		{
+			const peer_t &candidate = peer_table.at(i);
+			if (candidate.frames_in_flight == 0 && memcmp(candidate.mac, ESPNOW_BROADCAST_ADDRESS, MAC_ADDR_LEN) != 0)
+			{
+				memcpy(victim_mac, candidate.mac, MAC_ADDR_LEN);
+				victim_found = true;
+				break;
+			}
+		}
+		portEXIT_CRITICAL(&peers_mux);
+
+		if (need_eviction && !victim_found)
+		{
+			// every ESP-NOW peer has frames in flight, give tx_cb a chance to complete one
+			ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(tx_completion_timeout_ms));
+			continue;
+		}
+
+		if (victim_found)
+		{
+			err = esp_now_del_peer(victim_mac);
+			if (err != ESP_OK)
+				break;
+			portENTER_CRITICAL(&peers_mux);
+			peer_table.remove(victim_mac);
+			peer_list.peer_number = peer_table.size();
+			portEXIT_CRITICAL(&peers_mux);
+			DEBUG(TAG_PEERS, "Evicted peer: [" EASYMACSTR "] from ESP-NOW", EASYMAC2STR(victim_mac));
+		}
+
+		if (registerPeer(peer_addr) != ESP_OK)
+			break;
+
+		uint32_t swap_time = micros() - swap_start;
+		directory_swaps.fetch_add(1, std::memory_order_relaxed);
+		directory_swap_time_total_us.fetch_add(swap_time, std::memory_order_relaxed);
+		atomicMax(directory_swap_time_max_us, swap_time);
+		DEBUG(TAG_PEERS, "Swapped peer: [" EASYMACSTR "] into ESP-NOW in %" PRIu32 " us", EASYMAC2STR(peer_addr), swap_time);
+		return true;
 	}
+
+	directory_swap_failures.fetch_add(1, std::memory_order_relaxed);
+	return false;
 }
 
-void EasyEspNow::easyEspNowTxQueueTask(void *pvParameters)
+bool EasyEspNow::setEspNowPeersChannel(uint8_t channel)
 {
-	tx_queue_item_t item_to_dequeue;
-	while (true)
+	bool no_errors = true;
+	// iterate through all the peers and change the channel for each of them
+	for (uint8_t i = 0; i < peer_list.peer_number; i++)
 	{
-		// Wait for data from the queue
-		if (xQueueReceive(easyEspNow.txQueue, &item_to_dequeue, pdMS_TO_TICKS(10)) == pdTRUE)
-		{
-			if (memcmp(item_to_dequeue.dst_address, easyEspNow.zero_mac, MAC_ADDR_LEN) == 0)
-			{
-				WARNING(TAG_HELPER, "Destination address is NULL, sending data to all unicast peers that are added to the peer list");
-				easyEspNow.err = esp_now_send(NULL, item_to_dequeue.payload_data, item_to_dequeue.payload_len);
-			}
-			else
-				easyEspNow.err = esp_now_send(item_to_dequeue.dst_address, item_to_dequeue.payload_data, item_to_dequeue.payload_len);
+		uint8_t mac[MAC_ADDR_LEN] = {0};
+		memcpy(mac, peer_list.peer[i].mac, MAC_ADDR_LEN);
+		// Retrieve and modify peer info structures
+		esp_now_peer_info_t fetchedPeer;
+
+		esp_err_t get_peer_err, mod_peer_err;
 
-			if (easyEspNow.err == ESP_OK)
+		get_peer_err = esp_now_get_peer(mac, &fetchedPeer);
+		if (get_peer_err == ESP_OK)
+		{
+			fetchedPeer.channel = channel; // New channel for peer
+			mod_peer_err = esp_now_mod_peer(&fetchedPeer);
+			if (mod_peer_err != ESP_OK)
 			{
-				DEBUG(TAG_HELPER, "Succeeded in calling \"esp_now_send(...)\"");
+				MONITOR(TAG_MISC, "Failed to modify channel[%d] for peer[#%d] with MAC: " EASYMACSTR ". Error: %s", channel, i + 1, EASYMAC2STR(mac), esp_err_to_name(mod_peer_err));
+				no_errors = false;
 			}
 			else
 			{
-				ERROR(TAG_HELPER, "Failed in calling \"esp_now_send(...)\" with error: %s", esp_err_to_name(easyEspNow.err));
+				MONITOR(TAG_MISC, "Successfully modified to channel[%d] for peer[#%d] with MAC: " EASYMACSTR, channel, i + 1, EASYMAC2STR(mac));
 			}
-
-			// add some delay to not overwhelm 'esp_now_send' method
-			// otherwise may get error: 'ESP_ERR_ESPNOW_NO_MEM'
-			// during debug set this higher than 13 to simulate delay
-			// TX exhaust rate
-			vTaskDelay(pdMS_TO_TICKS(13));
+		}
+		else
+		{
+			MONITOR(TAG_MISC, "Failed to retrieve info for peer[#%d] with MAC: " EASYMACSTR ". Error: %s", i + 1, EASYMAC2STR(mac), esp_err_to_name(get_peer_err));
+			no_errors = false;
 		}
 	}
+	return no_errors;
+}
+
+uint16_t EasyEspNow::countUnicastPeers()
+{
+	portENTER_CRITICAL(&peers_mux);
+	uint16_t unicast_peers = peer_table.size() - (peer_table.find(ESPNOW_BROADCAST_ADDRESS) >= 0 ? 1 : 0);
+	portEXIT_CRITICAL(&peers_mux);
+	return unicast_peers;
 }
 
 #endif // ESP32
\ No newline at end of file
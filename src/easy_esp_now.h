@@ -1,18 +1,31 @@
 #ifndef EASY_ESP_NOW_H
 #define EASY_ESP_NOW_H
-#ifdef ESP32
+#if defined(ESP32) || defined(EASY_ESP_NOW_HOST)
 
 #include "Arduino.h"
 #include "easy_debug.h"
 #include "comms_hal_interface.h"
+#include "easy_peer_table.h"
+#include "easy_frame.h"
+#include "easy_reassembly.h"
+#include "easy_dedup.h"
+#include "easy_stats.h"
+#include "easy_aead.h"
+#include "easy_lz.h"
+#include "easy_message.h"
 
 #include <WiFi.h>
 #include <esp_now.h>
+#include <esp_timer.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/queue.h>
 #include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include <atomic>
+#include <type_traits>
 
 static uint8_t ESPNOW_BROADCAST_ADDRESS[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 static const uint8_t MIN_WIFI_CHANNEL = 0; // if channel would be 0, then set the channel to the default/ or the channel that the radio is actually on
@@ -22,11 +35,87 @@ static const uint8_t LMK_LENGTH = ESP_NOW_KEY_LEN;
 static const uint8_t MAX_TOTAL_PEER_NUM = ESP_NOW_MAX_TOTAL_PEER_NUM;
 static const uint8_t MAX_ENCRYPT_PEER_NUM = ESP_NOW_MAX_ENCRYPT_PEER_NUM;
 static const uint8_t MAX_DATA_LENGTH = ESP_NOW_MAX_DATA_LEN;
+static const uint8_t DEFAULT_TX_MAX_IN_FLIGHT = 1;		   ///< @brief Frames handed to `esp_now_send` that may wait for `tx_cb` at the same time
+static const uint8_t DEFAULT_TX_NO_MEM_RETRIES = 6;		   ///< @brief Retries of `esp_now_send` when it returns `ESP_ERR_ESPNOW_NO_MEM`
+static const uint32_t DEFAULT_TX_BACKOFF_MAX_MS = 32;	   ///< @brief Upper bound of the exponential backoff between retries
+static const uint32_t DEFAULT_TX_COMPLETION_TIMEOUT_MS = 50; ///< @brief Time to wait for a `tx_cb` before considering it lost
+static const uint32_t DEFAULT_SYNCH_SEND_TIMEOUT_MS = 1000;  ///< @brief Time a synchronous send waits for the delivery status of its frame
+static const uint8_t TX_SYNC_LIBRARY_SLOTS = 4;			  ///< @brief TX slots kept for the frames of the library in synchronous send mode (acknowledgements, ...)
+static const uint16_t DEFAULT_RX_RING_SIZE = 16;			  ///< @brief Frames the RX ring can hold until the RX task delivers them
+static const uint16_t DEFAULT_RX_MAX_BATCH = 8;			  ///< @brief Maximum frames delivered in one call of the batch callback
+static const uint16_t DEFAULT_RX_DEDUP_SOURCES = 16;		  ///< @brief Sources tracked by the duplicate filter
+static const uint32_t DEFAULT_RX_DEDUP_EXPIRY_MS = 1000;	  ///< @brief Idle time after which the duplicate filter forgets a source
+static const uint16_t DEFAULT_PEER_DIRECTORY_SIZE = 256;	  ///< @brief Logical peers kept in RAM when the peer directory is enabled
+static const uint32_t DEFAULT_AGGREGATION_WINDOW_MS = 5;	  ///< @brief Longest time a small message waits in an open aggregate
+static const uint8_t DEFAULT_AGGREGATION_MAX_MESSAGE_LEN = 64; ///< @brief Messages up to this length are aggregated
+static const uint8_t DEFAULT_AGGREGATION_MAX_OPEN = 4;		  ///< @brief Destinations that can have an open aggregate at the same time
+static const uint8_t MAX_AGGREGATED_MESSAGE_LEN = MAX_DATA_LENGTH - EASY_FRAME_HEADER_LEN - EASY_AGGREGATE_RECORD_HEADER_LEN;
+static const uint8_t MAX_FRAGMENT_PAYLOAD_LEN = MAX_DATA_LENGTH - EASY_FRAME_HEADER_LEN - EASY_FRAGMENT_HEADER_LEN; ///< @brief Message bytes carried by one fragment
+static const uint16_t MAX_FRAGMENTED_MESSAGE_LEN = (uint16_t)MAX_FRAGMENT_PAYLOAD_LEN * EASY_MAX_FRAGMENTS;	  ///< @brief Longest message that can be fragmented
+static const uint16_t DEFAULT_MAX_FRAGMENTED_MESSAGE_LEN = 4096;											  ///< @brief Longest message when fragmentation is enabled
+static const uint8_t DEFAULT_REASSEMBLY_SLOTS = 4;															  ///< @brief Messages that can be reassembled at the same time
+static const uint32_t DEFAULT_REASSEMBLY_TIMEOUT_MS = 500;													  ///< @brief Time an incomplete message is kept since its last fragment
+static const uint8_t MAX_RELIABLE_PAYLOAD_LEN = MAX_DATA_LENGTH - EASY_FRAME_HEADER_LEN - EASY_RELIABLE_HEADER_LEN;		  ///< @brief Longest message of a reliable channel
+static const uint8_t DEFAULT_RELIABLE_WINDOW = 8;																		  ///< @brief Unacknowledged messages in flight per peer
+static const uint8_t DEFAULT_RELIABLE_MAX_PEERS = 4;																	  ///< @brief Peers with a reliable channel at the same time
+static const uint8_t DEFAULT_RELIABLE_MAX_RETRIES = 8;																	  ///< @brief Retransmissions before a message is reported as failed
+static const uint32_t DEFAULT_RELIABLE_ACK_DELAY_MS = 5;																  ///< @brief Time an acknowledgement waits for reverse traffic to ride on
+static const uint32_t DEFAULT_RELIABLE_WAIT_MS = 1000;																	  ///< @brief Time `sendReliable(...)` waits for room in the send window
+static const uint32_t RELIABLE_INITIAL_RTO_MS = 200;																	  ///< @brief Retransmission timeout until the first RTT sample
+static const uint32_t RELIABLE_MIN_RTO_MS = 10;
+static const uint32_t RELIABLE_MAX_RTO_MS = 2000;
+static const uint32_t DEFAULT_TX_INTERACTIVE_MAX_WAIT_MS = 50; ///< @brief Interactive frame waiting longer than this is sent before control frames
+static const uint32_t DEFAULT_TX_BULK_MAX_WAIT_MS = 200;	   ///< @brief Bulk frame waiting longer than this is sent before higher classes
+static const uint8_t MAX_GROUPS = 32;						   ///< @brief Peer groups, one bit each in `peer_t::groups`
+static const uint8_t MAX_GROUP_NAME_LEN = 15;
+static const uint8_t MAX_GROUP_PAYLOAD_LEN = MAX_DATA_LENGTH - EASY_FRAME_HEADER_LEN - EASY_GROUP_HEADER_LEN; ///< @brief Longest group message
+static const uint8_t DEFAULT_GROUP_MAX_SENDS = 4;												  ///< @brief Group messages in progress at the same time
+static const uint32_t DEFAULT_GROUP_ACK_TIMEOUT_MS = 30;										  ///< @brief Time members have to acknowledge a group broadcast
+static const uint8_t DEFAULT_GROUP_BROADCAST_MIN_MEMBERS = 4;									  ///< @brief Smaller groups always get unicasts
+static const uint8_t GROUP_RX_RECENT = 8;														  ///< @brief Group messages remembered by a member to drop repeats
+static const uint32_t DEFAULT_CHANNEL_MAX_LATENCY_MS = 20;										  ///< @brief Frame for another channel waiting longer than this moves the channel scheduler
+static const uint8_t DEFAULT_ENCRYPTION_KEYS = 20;												  ///< @brief Peer keys kept when encryption is enabled
+static const uint8_t ENCRYPTION_KEY_LEN = EasyAead::KEY_LEN;										  ///< @brief ChaCha20-Poly1305 key, 256 bits
+static const uint8_t MAX_SEALED_DATA_LENGTH = MAX_DATA_LENGTH - EASY_SEALED_OVERHEAD;			  ///< @brief Longest frame once encryption is enabled
+static const uint8_t MAX_COMPRESSION_DICTIONARIES = 4;											  ///< @brief Pre-shared dictionaries, ids `1` to `4`
+static const uint8_t COMPRESSION_NO_DICTIONARY = 0;												  ///< @brief Frames compressed on their own
+static const uint8_t COMPRESSION_OFF = 0xFF;													  ///< @brief Frames sent as they are
+static const uint8_t MAX_TYPED_MESSAGE_LEN = MAX_DATA_LENGTH - EASY_TYPED_OVERHEAD;				  ///< @brief Largest struct `send<T>(...)` takes
+static const uint8_t MAX_MESSAGE_TYPES = 16;													  ///< @brief Message types with a handler, power of two
+static const uint16_t DEFAULT_SEND_COMPLETIONS = 32;											  ///< @brief Completions kept for `pollSendCompletion(...)` until they are polled
+static const uint8_t ESPNOW_AIR_OVERHEAD_LEN = 43; ///< @brief Bytes on the air around an ESP-NOW payload: MAC header, action and vendor headers, FCS
+static const uint16_t ESPNOW_AIR_PREAMBLE_US = 192;												  ///< @brief Long PLCP preamble and header of a 1 Mbps frame
+static const uint8_t DEFAULT_FAIR_MAX_DESTINATIONS = 8;											  ///< @brief Destinations the fair scheduler keeps apart, the others share one queue
+static const uint16_t DEFAULT_FAIR_PHY_RATE_KBPS = 1000;										  ///< @brief PHY rate the fair scheduler estimates airtime with, the ESP-NOW default
+static const uint8_t FAIR_FLOW_NONE = 0xFF;														  ///< @brief Frame not held by a destination queue of the fair scheduler
+static const uint16_t DEFAULT_PING_MAX_PROBES = 64;												  ///< @brief Probes one `ping(...)` can send
+static const uint16_t MAX_PING_PROBES = 1024;
+static const uint32_t DEFAULT_PING_INTERVAL_MS = 100;											  ///< @brief Time between two probes of a ping
+static const uint32_t DEFAULT_PING_TIMEOUT_MS = 1000;											  ///< @brief Time the replies are waited for after the last probe
+
+/**
+ * Traffic counters of one peer, kept along with the peer
+ */
+typedef struct
+{
+	uint32_t rx_frames;	   /**< Frames received from the peer, duplicates dropped by the filter not included*/
+	uint32_t tx_frames;	   /**< Frames sent to the peer and completed*/
+	uint32_t tx_failed;	   /**< Frames sent to the peer and not delivered*/
+	int8_t rssi;		   /**< RSSI of the last frame received from the peer, dBm*/
+	uint32_t last_seen_ms; /**< `millis()` when the last frame was received from the peer, `0` if never*/
+} peer_stats_t;
 
 typedef struct
 {
 	uint8_t mac[MAC_ADDR_LEN];
 	uint32_t time_peer_added;
+	uint8_t frames_in_flight; /**< Frames sent to this peer that still wait for their `tx_cb`*/
+	uint32_t groups;		  /**< Bit `i` set means the peer is a member of group `i`*/
+	uint8_t channel;		  /**< Channel the peer listens on, `0` for the home channel. See `setPeerChannel(...)`*/
+	uint8_t compression;	  /**< Dictionary the frames to the peer are compressed with, `COMPRESSION_OFF` if they are not. See `setPeerCompression(...)`*/
+	uint32_t rate_bytes_per_s; /**< Rate cap of the frames to the peer, `0` for none. See `setPeerRateLimit(...)`*/
+	uint16_t rate_burst;	   /**< Bytes the peer can be sent at once after being idle*/
+	peer_stats_t stats;		  /**< Traffic of the peer, see `getPeerStats(...)`*/
 } peer_t;
 
 typedef struct
@@ -42,6 +131,9 @@ enum CountPeers
 	UNENCRYPTED_NUM = 2
 };
 
+/**
+ * TX slot. Slots are preallocated when `begin(...)` is called and only the slot index moves through the TX queue
+ */
 typedef struct
 {
 	uint8_t dst_address[MAC_ADDR_LEN];	   /**< Destination MAC*/
@@ -49,6 +141,599 @@ typedef struct
 	size_t payload_len;					   /**< Payload length*/
 } tx_queue_item_t;
 
+typedef uint16_t tx_slot_index_t;
+
+/**
+ * Identifies a message from `send(...)` to the report of its delivery status, see `onSendComplete(...)`.
+ * Handles increase by one with every message, `EASY_SEND_HANDLE_NONE` is never given
+ */
+typedef uint32_t easy_send_handle_t;
+
+static const easy_send_handle_t EASY_SEND_HANDLE_NONE = 0;
+
+static const tx_slot_index_t TX_SLOT_NONE = 0xFFFF; ///< @brief End of a list of slots
+
+/**
+ * Priority classes of the TX queue. All classes share the slots of the TX queue, each class has its own queue of committed
+ * slots and a capacity, see `setTXClass(...)`. The TX task always sends from the highest class that has frames,
+ * unless a frame of a lower class waited longer than the limit of its class: then the lowest such class goes first and
+ * the frame counts as a starvation promotion. By default interactive frames are promoted after
+ * `DEFAULT_TX_INTERACTIVE_MAX_WAIT_MS`, bulk frames after `DEFAULT_TX_BULK_MAX_WAIT_MS`, control frames are never promoted
+ * since nothing is above them
+ */
+typedef enum : uint8_t
+{
+	TX_PRIORITY_CONTROL = 0,	 /**< Commands, acknowledgements*/
+	TX_PRIORITY_INTERACTIVE = 1, /**< Default, what every send was before priority classes*/
+	TX_PRIORITY_BULK = 2,		 /**< Telemetry, transfers*/
+	TX_PRIORITY_CLASSES = 3,
+} easy_tx_priority_t;
+
+static const easy_tx_priority_t DEFAULT_TX_PRIORITY = TX_PRIORITY_INTERACTIVE;
+
+/**
+ * What happens to a new frame when its priority class is at capacity. Only frames of that class are ever dropped,
+ * a saturated bulk class never costs a control or interactive frame its place
+ */
+typedef enum : uint8_t
+{
+	TX_DROP_NEWEST = 0, /**< New frame is refused with `EASY_SEND_QUEUE_FULL_ERROR`*/
+	TX_DROP_OLDEST = 1, /**< Oldest queued frame of the class is dropped (completed as failed) to make room*/
+} tx_drop_policy_t;
+
+/**
+ * Counters of one priority class of the TX queue
+ */
+typedef struct
+{
+	uint16_t depth;				   /**< Frames queued right now*/
+	uint16_t depth_max;			   /**< Most frames queued at the same time*/
+	uint32_t enqueued;			   /**< Frames queued*/
+	uint32_t dequeued;			   /**< Frames taken by the TX task*/
+	uint32_t dropped;			   /**< Frames refused or dropped because the class was at capacity*/
+	uint32_t starvation_promotions; /**< Frames sent ahead of higher classes because they waited too long*/
+	uint32_t wait_total_us;		   /**< Time frames spent queued, sum*/
+	uint32_t wait_max_us;		   /**< Time frames spent queued, longest*/
+} tx_class_stats_t;
+
+/**
+ * Bookkeeping of a TX slot from the moment it is committed until its `tx_cb` completion arrives
+ */
+typedef struct
+{
+	SemaphoreHandle_t done;		  /**< Given on completion when a synchronous sender waits for this slot*/
+	uint16_t pending_completions; /**< `tx_cb` calls still expected for this slot*/
+	bool waiting;				  /**< A synchronous sender waits for the completion of this slot*/
+	bool completed;				  /**< Completion arrived*/
+	bool peer_in_flight;		  /**< Counted in `frames_in_flight` of the destination peer*/
+	easy_tx_priority_t priority;  /**< Priority class the slot was queued in*/
+	uint8_t group_send;			  /**< Group message the frame belongs to plus one, `0` for none*/
+	uint8_t group_member;		  /**< Member the frame goes to, `GROUP_MEMBER_ALL` for the broadcast*/
+	uint32_t enqueued_us;		  /**< `micros()` when the slot was queued*/
+	uint32_t sent_us;			  /**< `micros()` when `esp_now_send` accepted the slot*/
+	esp_now_send_status_t status; /**< Delivery status, fail if any of the completions failed*/
+	uint8_t channel;			  /**< Channel the frame goes out on, set when the channel scheduler groups it*/
+	tx_slot_index_t channel_next; /**< Next frame of the same channel and class in the channel scheduler*/
+	easy_send_handle_t handle;	  /**< Message the frame carries, `EASY_SEND_HANDLE_NONE` for the frames of the library*/
+	bool handle_last;			  /**< Last frame of the message, the one its completion is reported with. Only fragments have others*/
+	tx_slot_index_t message;	  /**< Fragmented message the frame belongs to in `tx_messages`, `TX_SLOT_NONE` for a single frame*/
+	uint32_t submitted_us;		  /**< `micros()` when the message was sent, for the latency of its completion*/
+	uint8_t flow;				  /**< Destination queue of the fair scheduler, `FAIR_FLOW_NONE` if none*/
+	tx_slot_index_t flow_next;	  /**< Next frame of the same destination and class in the fair scheduler*/
+	uint32_t probe;				  /**< Ping id in the high half and probe number plus one in the low half for a probe of `ping(...)`, `0` for the other frames*/
+} tx_slot_state_t;
+
+/**
+ * Frame handed to `esp_now_send`, in the order its `tx_cb` calls will arrive. A frame given up by the completion timeout stays
+ * in place as expired, so its late `tx_cb` calls are absorbed by it instead of completing the frames sent after it
+ */
+typedef struct
+{
+	tx_slot_index_t slot;			   /**< Slot of the frame, free to be reused once the frame expired*/
+	uint16_t expired;				   /**< `tx_cb` calls still to absorb once the frame expired, `0` while it is live*/
+	uint8_t dst_address[MAC_ADDR_LEN]; /**< Destination of the frame, all zeros when sent to all unicast peers*/
+} tx_in_flight_t;
+
+/**
+ * Fragmented message with a handle, from the commit of its first fragment until its last one completes or the send aborts
+ */
+typedef struct
+{
+	easy_send_handle_t handle; /**< `EASY_SEND_HANDLE_NONE` when the entry is free*/
+	bool failed;			   /**< A fragment failed, the message is reported failed with its last one*/
+} tx_message_state_t;
+
+/**
+ * Delivery status of a message, reported once its frame (all of them for a fragmented message) completed
+ */
+typedef struct
+{
+	easy_send_handle_t handle;		/**< As returned by `send(...)`*/
+	uint8_t dst_addr[MAC_ADDR_LEN]; /**< Destination, all zeros for a send to all peers*/
+	esp_now_send_status_t status;	/**< Delivered, or failed if any frame of the message or any peer of a send to all failed*/
+	uint32_t latency_us;			/**< From `send(...)` to the completion*/
+} send_completion_t;
+
+typedef EasyCallback<void(const send_completion_t *completion)> send_complete_data;
+
+/**
+ * Timestamps of one probe of `ping(...)`, all of them `esp_timer_get_time()`. The ones of the responder are on its clock
+ */
+typedef struct
+{
+	int64_t queued_us;		 /**< Committed to the TX queue, `0` if it could not be*/
+	int64_t sent_us;		 /**< Handed to `esp_now_send`*/
+	int64_t completed_us;	 /**< Its `tx_cb`*/
+	int64_t remote_rx_us;	 /**< Reached `rx_cb` of the responder*/
+	int64_t remote_reply_us; /**< Reply queued by the responder*/
+	int64_t reply_us;		 /**< Reply reached `rx_cb`, `0` if it did not before the timeout*/
+} probe_record_t;
+
+/**
+ * Result of `ping(...)`. A round trip goes from `esp_now_send` of a probe to its reply reaching `rx_cb`, less the time
+ * the reply waited at the responder
+ */
+typedef struct
+{
+	uint16_t sent;				/**< Probes queued*/
+	uint16_t received;			/**< Replies received before the timeout*/
+	uint16_t loss_permille;		/**< Probes without a reply, per thousand probes sent*/
+	uint32_t rtt_min_us;
+	uint32_t rtt_avg_us;
+	uint32_t rtt_p99_us;
+	uint32_t rtt_max_us;
+	uint32_t queue_avg_us;		/**< From the commit of a probe to `esp_now_send`*/
+	uint32_t air_avg_us;		/**< From `esp_now_send` of a probe to its `tx_cb`*/
+	uint32_t turnaround_avg_us; /**< From a probe reaching the responder to its reply being queued there*/
+	int64_t clock_offset_us;	/**< Responder clock minus this one, from the probe with the shortest round trip as NTP does*/
+	int32_t forward_avg_us;		/**< One way to the responder, clock offset taken out*/
+	int32_t return_avg_us;		/**< One way back from the responder, clock offset taken out*/
+} ping_result_t;
+
+/**
+ * Called when the TX slots in use reach the high watermark (`above_high` is `true`) and when they fall back to the low one
+ */
+typedef EasyCallback<void(bool above_high, uint16_t slots_used)> tx_watermark_data;
+
+static const uint8_t TX_WAITERS = 4; ///< @brief Tasks woken by the TX task while blocked in `waitForSpace(...)`, `waitForDrain(...)` or `waitForTXQueueToBeEmptied()`. More poll every tick
+
+/**
+ * What a task blocked on the TX queue waits for
+ */
+typedef enum : uint8_t
+{
+	TX_WAIT_NONE,  /**< Place free*/
+	TX_WAIT_SPACE, /**< `slots` free slots*/
+	TX_WAIT_DRAIN, /**< Every slot free: nothing queued, in flight or loaned*/
+	TX_WAIT_EMPTY, /**< Nothing queued anymore, or the TX task suspended*/
+} tx_wait_t;
+
+/**
+ * Task blocked on the TX queue, given `wake` when what it waits for may have happened
+ */
+typedef struct
+{
+	tx_wait_t kind;
+	uint16_t slots;
+	SemaphoreHandle_t wake;
+} tx_waiter_t;
+
+/**
+ * Frames of one channel held by the channel scheduler, one FIFO per priority class linked through `tx_slot_state_t::channel_next`
+ */
+typedef struct
+{
+	tx_slot_index_t head[TX_PRIORITY_CLASSES];
+	tx_slot_index_t tail[TX_PRIORITY_CLASSES];
+	uint16_t count; /**< Frames of the channel, all classes*/
+} tx_channel_group_t;
+
+/**
+ * Counters of the channel scheduler. Arrays are indexed by channel, `1` to `MAX_WIFI_CHANNEL`
+ */
+typedef struct
+{
+	uint32_t switches;						 /**< Channel changes made by the scheduler*/
+	uint32_t latency_switches;				 /**< Of which forced by the latency bound before the frames of the channel were all sent*/
+	uint8_t current_channel;				 /**< Channel the radio is on*/
+	uint32_t arrivals[MAX_WIFI_CHANNEL + 1]; /**< Switches to each channel*/
+	uint32_t dwell_ms[MAX_WIFI_CHANNEL + 1]; /**< Time spent on each channel, the current visit included*/
+	uint32_t frames[MAX_WIFI_CHANNEL + 1];	 /**< Frames sent on each channel*/
+} channel_stats_t;
+
+/**
+ * Backlog and service of one destination of the fair scheduler
+ */
+typedef struct
+{
+	uint8_t mac[MAC_ADDR_LEN]; /**< Destination, all zeros for sends to all peers*/
+	bool shared;			   /**< Queue of the destinations that found no queue of their own, `mac` is not set*/
+	uint16_t backlog;		   /**< Frames queued right now*/
+	uint16_t backlog_max;	   /**< Most frames queued at the same time*/
+	uint32_t frames;		   /**< Frames sent*/
+	uint32_t bytes;			   /**< Payload bytes sent*/
+	uint32_t airtime_us;	   /**< Airtime the frames sent are estimated to take*/
+	uint16_t share_permille;   /**< Share of the airtime of all destinations, in 1/1000*/
+	uint32_t dropped;		   /**< Frames refused because the destination had its whole backlog queued*/
+	uint32_t throttled;		   /**< Frames held back by the rate cap of the destination*/
+} tx_destination_stats_t;
+
+/**
+ * Destination queue of the fair scheduler: its frames, one FIFO per priority class linked through `tx_slot_state_t::flow_next`,
+ * its deficit and its token bucket
+ */
+typedef struct
+{
+	bool used;
+	tx_slot_index_t head[TX_PRIORITY_CLASSES];
+	tx_slot_index_t tail[TX_PRIORITY_CLASSES];
+	uint32_t deficit_us[TX_PRIORITY_CLASSES]; /**< Airtime the destination may still use in its turn, per class*/
+	uint32_t rate_bytes_per_s;				  /**< Rate cap copied from the peer, `0` for none*/
+	uint16_t rate_burst;
+	bool rate_copied;						  /**< Cap copied once. The bucket of a new queue starts empty, a cap changed later fills it*/
+	uint32_t tokens;	 /**< Bytes the destination can be sent right now*/
+	uint32_t refill_us;	 /**< `micros()` the tokens were counted up to*/
+	bool throttled_head; /**< Frame at the head already counted in `throttled`*/
+	uint32_t served_us;	 /**< `micros()` a frame of the destination was last sent*/
+	tx_destination_stats_t stats;
+} tx_flow_t;
+
+/**
+ * Key of a peer, kept as its key schedule
+ */
+typedef struct
+{
+	uint8_t mac[MAC_ADDR_LEN];
+	EasyAead key;
+} peer_key_t;
+
+/**
+ * Counters of the encryption stage
+ */
+typedef struct
+{
+	uint32_t sealed;		/**< Frames encrypted before being sent*/
+	uint32_t sent_plain;	/**< Frames sent in clear, neither their destination nor the network has a key*/
+	uint32_t too_long;		/**< Frames queued before encryption was enabled that had no room left for the overhead, failed*/
+	uint32_t opened;		/**< Frames received that were authentic and decrypted*/
+	uint32_t auth_failures; /**< Encrypted frames dropped because the tag did not match: forged, corrupted or another key*/
+	uint32_t no_key;		/**< Encrypted frames dropped because there is no key for their sender*/
+	uint32_t plain_dropped; /**< Frames received in clear from a source that must encrypt*/
+} encryption_stats_t;
+
+/**
+ * Counters of the compression stage. The compression ratio is `bytes_in / bytes_out`, the time per frame
+ * `encode_us / (compressed + not_compressed)` and `decode_us / inflated`
+ */
+typedef struct
+{
+	uint32_t compressed;	 /**< Frames sent compressed*/
+	uint32_t not_compressed; /**< Frames to a compressing peer sent as they were, compressing did not make them shorter*/
+	uint32_t bytes_in;		 /**< Length of the frames sent compressed, before compression*/
+	uint32_t bytes_out;		 /**< Length of the same frames once compressed, headers included*/
+	uint32_t encode_us;		 /**< Time spent compressing, frames sent as they were included*/
+	uint32_t inflated;		 /**< Compressed frames received and decompressed*/
+	uint32_t decode_us;		 /**< Time spent decompressing*/
+	uint32_t errors;		 /**< Compressed frames dropped: unknown dictionary or malformed stream*/
+} compression_stats_t;
+
+/**
+ * One fragment of a message that is gathered into a TX slot by `sendv(...)`
+ */
+typedef struct
+{
+	const void *data; /**< Fragment content*/
+	size_t len;		  /**< Fragment length*/
+} easy_iovec_t;
+
+/**
+ * Received frame as copied by `rx_cb` into the RX ring. Holds a copy of the radio metadata and of the ESP-NOW frame header,
+ * so it stays valid after the WiFi task has reused its own buffers
+ */
+typedef struct
+{
+	uint8_t src_address[MAC_ADDR_LEN];	 /**< Source Address*/
+	wifi_pkt_rx_ctrl_t radio_header;	 /**< Radio metadata, including RSSI and channel*/
+	espnow_frame_format_t esp_now_frame; /**< ESP-NOW frame header*/
+	alignas(4) uint8_t payload[MAX_DATA_LENGTH]; /**< Message payload, aligned so the struct of a typed message can be read in place*/
+	int payload_len;					 /**< Payload length*/
+} rx_frame_t;
+
+/**
+ * Counters of the RX ring
+ */
+typedef struct
+{
+	uint32_t received;	/**< Frames copied into the RX ring*/
+	uint32_t delivered; /**< Frames delivered to the user callbacks*/
+	uint32_t overflows; /**< Frames dropped because the RX ring was full*/
+	uint32_t dropped;	/**< All dropped frames, overflows included*/
+	uint32_t duplicates; /**< Frames dropped by the duplicate filter before any callback, see `enableRXDedup(...)`*/
+} rx_ring_stats_t;
+
+typedef EasyCallback<void(const rx_frame_t *frames, size_t frame_count)> frame_rcvd_batch_data;
+
+/**
+ * Handler of a typed message, see `onMessage<T>(...)`. A plain function or a lambda without captures
+ * @param src_mac Source of the message
+ * @param message The struct, valid during the call only
+ * @param frame_info Radio metadata of the frame
+ */
+template <typename T>
+using typed_message_data = void (*)(const uint8_t *src_mac, const T &message, espnow_frame_recv_info_t *frame_info);
+
+/**
+ * Calls the handler of a message type with the received bytes as the struct. One instance per type, see `onMessage<T>(...)`
+ */
+typedef void (*typed_message_invoke_t)(void (*handler)(), const uint8_t *src_mac, const uint8_t *message, espnow_frame_recv_info_t *frame_info);
+
+/**
+ * Entry of the typed message table. Its home position is the id of the type modulo `MAX_MESSAGE_TYPES`, known at compile time
+ */
+typedef struct
+{
+	bool used;					   /**< Entry belongs to `type_id`, kept when the handler is removed so lookups probe past it*/
+	uint16_t type_id;			   /**< `EasyMessageType<T>::id()`*/
+	uint8_t size;				   /**< `sizeof(T)`, a frame of another length is not this message*/
+	typed_message_invoke_t invoke; /**< `invokeTypedHandler<T>`*/
+	void (*handler)();			   /**< The `typed_message_data<T>`, `nullptr` when removed*/
+} typed_handler_t;
+
+/**
+ * Extracts an application sequence number from a received frame for the duplicate filter
+ * @param src_addr Source of the frame
+ * @param data Frame payload
+ * @param data_len Payload length
+ * @param origin_addr Set to `src_addr`, can be changed to the device that originated a rebroadcast message
+ * @param sequence Receives the sequence number
+ * @return `true` if the frame has one, `false` to filter it by the 802.11 sequence control
+ */
+typedef EasyCallback<bool(const uint8_t *src_addr, const uint8_t *data, int data_len, uint8_t *origin_addr, uint16_t *sequence)> rx_dedup_key_data;
+
+/**
+ * Counters of the peer directory, to size it for a fleet
+ */
+typedef struct
+{
+	uint32_t hits;				 /**< Unicast frames whose peer was already registered in ESP-NOW*/
+	uint32_t misses;			 /**< Unicast frames whose peer had to be swapped into ESP-NOW*/
+	uint32_t swaps;				 /**< Peers swapped into ESP-NOW*/
+	uint32_t swap_failures;		 /**< Frames failed because no ESP-NOW peer slot could be freed*/
+	uint32_t swap_time_total_us; /**< Time spent swapping peers*/
+	uint32_t swap_time_max_us;	 /**< Longest swap*/
+	uint16_t directory_peers;	 /**< Peers in the directory*/
+	uint16_t directory_capacity; /**< Capacity of the directory*/
+} peer_directory_stats_t;
+
+/**
+ * Radio metadata kept with a message being reassembled, taken from its last fragment
+ */
+typedef struct
+{
+	wifi_pkt_rx_ctrl_t radio_header;	 /**< Radio metadata, including RSSI and channel*/
+	espnow_frame_format_t esp_now_frame; /**< ESP-NOW frame header*/
+} rx_reassembly_meta_t;
+
+/**
+ * Counters of the fragmentation and reassembly of large messages
+ */
+typedef struct
+{
+	uint32_t tx_messages;	/**< Messages sent in fragments*/
+	uint32_t tx_fragments;	/**< Fragments handed to the TX queue*/
+	uint32_t rx_fragments;	/**< Fragments received*/
+	uint32_t rx_messages;	/**< Messages reassembled*/
+	uint32_t rx_duplicates; /**< Fragments received twice*/
+	uint32_t rx_dropped;	/**< Fragments dropped because all reassembly buffers wait for delivery*/
+	uint32_t rx_timeouts;	/**< Incomplete messages dropped because their timeout expired*/
+	uint32_t rx_evictions;	/**< Incomplete messages dropped to make room for a new one*/
+} fragmentation_stats_t;
+
+/**
+ * Message of a reliable channel kept until it is acknowledged
+ */
+typedef struct
+{
+	bool in_use;							   /**< Waiting for its acknowledgement*/
+	uint16_t seq;							   /**< Sequence number*/
+	uint8_t len;							   /**< Message length*/
+	uint8_t transmissions;					   /**< Times handed to the TX queue, `0` if not sent yet*/
+	uint32_t first_sent_us;					   /**< `micros()` of the first transmission, for the RTT*/
+	uint32_t deadline_ms;					   /**< `millis()` when it is sent (again)*/
+	uint8_t payload[MAX_RELIABLE_PAYLOAD_LEN]; /**< Message*/
+} reliable_entry_t;
+
+/**
+ * Both directions of the reliable channel with one peer
+ */
+typedef struct
+{
+	bool used;				   /**< Slot belongs to `mac`*/
+	uint8_t mac[MAC_ADDR_LEN]; /**< Peer*/
+	uint32_t last_activity_ms; /**< Last frame sent to or received from the peer*/
+	reliable_entry_t *entries; /**< Send window, entry of a sequence number is `seq & (window - 1)`*/
+	uint16_t tx_base;		   /**< Oldest unacknowledged sequence number*/
+	uint16_t tx_next;		   /**< Sequence number of the next message*/
+	bool tx_synced;			   /**< Peer acknowledged something, no need to set `EASY_RELIABLE_SYN` anymore*/
+	bool rtt_valid;			   /**< `srtt_us` holds a sample*/
+	uint32_t srtt_us;		   /**< Smoothed round trip time*/
+	uint32_t rttvar_us;		   /**< Round trip time variation*/
+	uint32_t rto_ms;		   /**< Retransmission timeout, `srtt + 4 * rttvar`*/
+	bool rx_started;		   /**< Some message was received from the peer*/
+	uint16_t rx_expected;	   /**< Next sequence number expected from the peer*/
+	uint32_t rx_received;	   /**< Bit `i` set means `rx_expected + 1 + i` was received*/
+	bool ack_pending;		   /**< An acknowledgement is owed to the peer*/
+	uint32_t ack_deadline_ms;  /**< `millis()` when a standalone acknowledgement is sent if no reverse traffic carried it*/
+} reliable_peer_t;
+
+/**
+ * Counters of the reliable channels
+ */
+typedef struct
+{
+	uint32_t sent;				/**< Messages accepted by `sendReliable(...)`*/
+	uint32_t transmissions;		/**< Data frames handed to the TX queue, retransmissions included*/
+	uint32_t retransmissions;	/**< Data frames sent again because no acknowledgement came in time*/
+	uint32_t delivered;			/**< Messages acknowledged by the receiver*/
+	uint32_t failed;			/**< Messages given up after all the retries*/
+	uint32_t acks_sent;			/**< Standalone acknowledgement frames*/
+	uint32_t acks_piggybacked;	/**< Acknowledgements carried by data frames*/
+	uint32_t received;			/**< Messages delivered to the user*/
+	uint32_t duplicates;		/**< Messages received again and not delivered*/
+	uint32_t out_of_window;		/**< Messages received too far ahead and dropped*/
+	uint32_t rtt_samples;		/**< Round trip times measured*/
+	uint32_t rtt_last_us;		/**< Last round trip time measured*/
+} reliable_stats_t;
+
+typedef EasyCallback<void(const uint8_t *dst_addr, uint16_t sequence, bool delivered)> reliable_status_data;
+
+/**
+ * How a group message reaches the members
+ */
+typedef enum : uint8_t
+{
+	GROUP_SEND_AUTO = 0,	  /**< Cheapest on the air, from group size, message length and broadcast loss seen so far*/
+	GROUP_SEND_UNICAST = 1,	  /**< One unicast per member, delivery from the MAC layer acknowledgements*/
+	GROUP_SEND_BROADCAST = 2, /**< One broadcast, members acknowledge it, the ones that did not get a unicast repair*/
+} group_send_mode_t;
+
+static const uint8_t GROUP_MEMBER_ALL = 0xFF;
+
+/**
+ * Peer group, known by name. Sending groups have members, receiving devices join a group by the same name
+ */
+typedef struct
+{
+	bool used;
+	bool joined;						 /**< Group messages broadcast to this group are accepted*/
+	char name[MAX_GROUP_NAME_LEN + 1];	 /**< Group name*/
+	uint16_t hash;						 /**< `easyGroupHash(name)`, identifies the group on the air*/
+	uint8_t broadcast_loss;				 /**< Members that missed a broadcast, moving average in 1/256*/
+} peer_group_t;
+
+/**
+ * Outcome of a group message, for every member at once
+ */
+typedef struct
+{
+	uint16_t send_id;							/**< As returned by `sendToGroup(...)`*/
+	uint8_t group;								/**< Group the message was sent to*/
+	group_send_mode_t mode;						/**< Mode actually used, unicast or broadcast*/
+	uint8_t member_count;						/**< Members when the message was sent*/
+	const uint8_t (*members)[MAC_ADDR_LEN];		/**< MAC of every member, valid during the callback only*/
+	uint32_t delivered;							/**< Bit `i` set means `members[i]` got the message*/
+	uint8_t repairs;							/**< Unicasts sent to members that missed the broadcast*/
+	uint32_t elapsed_us;						/**< Time from `sendToGroup(...)` to the last result*/
+} group_send_result_t;
+
+typedef EasyCallback<void(const group_send_result_t *result)> group_send_data;
+
+/**
+ * Group message in progress
+ */
+typedef struct
+{
+	bool used;										/**< Slot holds a message*/
+	bool reporting;									/**< Result is being delivered to the user*/
+	uint16_t send_id;								/**< Identifies the message in acknowledgements*/
+	uint8_t group;									/**< Group index*/
+	uint16_t group_hash;							/**< Group hash, acknowledgements carry it*/
+	group_send_mode_t mode;							/**< Unicast or broadcast*/
+	uint8_t member_count;							/**< Members snapshot when the message was sent*/
+	uint8_t members[EASY_GROUP_MAX_MEMBERS][MAC_ADDR_LEN];
+	uint32_t to_send;								/**< Members that still need a unicast, waiting for a free TX slot*/
+	uint32_t pending;								/**< Members whose unicast waits for its `tx_cb`*/
+	uint32_t delivered;								/**< Members that got the message*/
+	bool broadcast_pending;							/**< Broadcast waits for its `tx_cb`*/
+	bool awaiting_acks;								/**< Broadcast sent, waiting for the acknowledgements*/
+	uint32_t ack_deadline_ms;						/**< `millis()` when the members that did not acknowledge get a repair*/
+	uint8_t repairs;								/**< Repair unicasts sent*/
+	uint32_t started_us;							/**< `micros()` when the message was sent*/
+	uint8_t payload_len;							/**< Length of `payload`*/
+	uint8_t payload[MAX_GROUP_PAYLOAD_LEN];			/**< Kept for the unicasts that wait for a slot and for repairs*/
+} group_send_t;
+
+/**
+ * Counters of the group messages
+ */
+typedef struct
+{
+	uint32_t sent;				  /**< Messages accepted by `sendToGroup(...)`*/
+	uint32_t unicast_sends;		  /**< Messages sent as one unicast per member*/
+	uint32_t broadcast_sends;	  /**< Messages sent as one broadcast*/
+	uint32_t frames;			  /**< Frames handed to the TX queue, repairs included*/
+	uint32_t repairs;			  /**< Unicasts to members that missed a broadcast*/
+	uint32_t acks_received;		  /**< Acknowledgements from members*/
+	uint32_t members_delivered;	  /**< Members that got a message*/
+	uint32_t members_failed;	  /**< Members that did not*/
+	uint32_t rx_messages;		  /**< Group messages delivered to the user on this device*/
+	uint32_t rx_duplicates;		  /**< Group messages received again and dropped*/
+	uint32_t acks_sent;			  /**< Acknowledgements sent by this device*/
+} group_stats_t;
+
+/**
+ * Aggregate being filled with small messages for one destination. It holds a loaned TX slot until it is flushed
+ */
+typedef struct
+{
+	bool open;						   /**< Slot is loaned and being filled*/
+	uint8_t dst_address[MAC_ADDR_LEN]; /**< Destination of all the messages in the aggregate*/
+	tx_slot_index_t slot;			   /**< TX slot the messages are packed into*/
+	uint16_t messages;				   /**< Messages packed so far*/
+	uint32_t deadline_ms;			   /**< `millis()` when the aggregate must be flushed*/
+	uint32_t enqueue_us_sum;		   /**< Sum of the `micros()` each message was packed, for the added latency*/
+	uint32_t opened_us;				   /**< `micros()` of the first message*/
+	easy_tx_priority_t priority;	   /**< Priority of the first message, the whole aggregate is queued with it*/
+} tx_aggregate_t;
+
+typedef enum
+{
+	AGGREGATE_FLUSH_SIZE = 0,	  /**< Next message did not fit or no room left*/
+	AGGREGATE_FLUSH_DEADLINE = 1, /**< Aggregation window expired*/
+	AGGREGATE_FLUSH_EXPLICIT = 2, /**< `flush()` was called*/
+	AGGREGATE_FLUSH_BYPASS = 3,	  /**< A message that is not aggregated goes to the same destination, keeps the order*/
+} aggregate_flush_reason_t;
+
+/**
+ * Counters of the small-message aggregation. Packing ratio is `messages / frames`
+ */
+typedef struct
+{
+	uint32_t messages;			/**< Messages packed into aggregates*/
+	uint32_t frames;			/**< Aggregate frames handed to the TX queue*/
+	uint32_t flushes_size;		/**< Flushed because full*/
+	uint32_t flushes_deadline;	/**< Flushed because the window expired*/
+	uint32_t flushes_explicit;	/**< Flushed by `flush()`*/
+	uint32_t flushes_bypass;	/**< Flushed to keep the order with a larger message to the same destination*/
+	uint32_t latency_total_us;	/**< Sum over all messages of the time they waited in an aggregate*/
+	uint32_t latency_max_us;	/**< Longest time a message waited in an aggregate*/
+	uint32_t rx_frames;			/**< Aggregate frames received*/
+	uint32_t rx_messages;		/**< Messages split out of received aggregates*/
+	uint32_t rx_malformed;		/**< Received aggregates delivered as they are because their records did not add up*/
+} aggregation_stats_t;
+
+static const uint8_t EASY_SEND_RESULTS = 6; ///< @brief Values of `easy_send_error_t`, from `EASY_SEND_OK` (0) down to `EASY_SEND_CONFIRM_ERROR` (-5)
+
+/**
+ * Snapshot of the library metrics, see `getStats(...)`
+ */
+typedef struct
+{
+	uint32_t send_results[EASY_SEND_RESULTS]; /**< Frames offered to the TX queue by result, index is `-easy_send_error_t`. Messages packed in an aggregate count as their aggregate frame*/
+	uint16_t tx_queue_depth;				  /**< Frames queued right now, all priority classes*/
+	uint16_t tx_queue_depth_max;			  /**< High-water mark of `tx_queue_depth`*/
+	uint32_t esp_now_send_calls;			  /**< Calls of `esp_now_send`, retries included*/
+	uint32_t esp_now_send_errors;			  /**< Frames `esp_now_send` did not accept, after the retries*/
+	uint32_t esp_now_send_no_mem;			  /**< `ESP_ERR_ESPNOW_NO_MEM` returned by `esp_now_send`, retried or not*/
+	uint32_t tx_delivered;					  /**< Frames completed as delivered*/
+	uint32_t tx_failed;						  /**< Frames completed as not delivered, refused by ESP-NOW, dropped or lost included*/
+	uint32_t tx_completion_timeouts;		  /**< Frames whose `tx_cb` never came*/
+	uint32_t tx_late_completions;			  /**< `tx_cb` calls that came after their frame was given up, or for no frame in flight, ignored*/
+	latency_histogram_t enqueue_to_send;	  /**< From the commit of a frame to `esp_now_send` accepting it*/
+	latency_histogram_t send_to_complete;	  /**< From `esp_now_send` accepting a frame to its `tx_cb`*/
+	uint32_t send_completions_missed;		  /**< Completions overwritten before `pollSendCompletion(...)` read them*/
+} easy_stats_t;
+
 class EasyEspNow : public CommsHalInterface
 {
 public:
@@ -75,8 +760,10 @@ public:
 	 * @brief Sends data to TX queue, to further be sent to the destination peer
 	 * @param dstAddress Destination address of peer to send the data to
 	 * @param payload Data buffer that contain the message to be sent
-	 * @param payload_len Data length in number of bytes
+	 * @param payload_len Data length in number of bytes. Up to `MAX_DATA_LENGTH`, longer with `enableFragmentation(...)`
 	 * @return Returns sending status. 0 for success, any other value to indicate an error.
+	 * In synchronous send mode it blocks until ESP-NOW reports the delivery status of this message and returns
+	 * `EASY_SEND_CONFIRM_ERROR` if the message was not delivered within `DEFAULT_SYNCH_SEND_TIMEOUT_MS`
 	 * @attention If dstAddress is `NULL` or `nullptr`, send data to all unicast peers that are added to the peer list
 	 * @note When sending to `Broadcast` address, status will always be delivered,
 	 * when sending to unicast peers, the message can be sent but it will be delivered only when the peer
@@ -84,6 +771,17 @@ public:
 	 */
 	easy_send_error_t send(const uint8_t *dstAddress, const uint8_t *payload, size_t payload_len) override;
 
+	/**
+	 * @brief Same as `send(dstAddress, payload, payload_len)` with a caller supplied timeout for the delivery status and priority class
+	 * @param confirm_timeout_ms Only for synchronous send mode. How long to block waiting for the delivery status of this message
+	 * @param priority Priority class of the TX queue the message goes to
+	 * @param handle If not `nullptr`, receives the handle the delivery status of the message is reported with, see `onSendComplete(...)`.
+	 * `EASY_SEND_HANDLE_NONE` when the message was not queued
+	 * @return Returns sending status. 0 for success, any other value to indicate an error
+	 */
+	easy_send_error_t send(const uint8_t *dstAddress, const uint8_t *payload, size_t payload_len, uint32_t confirm_timeout_ms,
+						   easy_tx_priority_t priority = DEFAULT_TX_PRIORITY, easy_send_handle_t *handle = nullptr);
+
 	/**
 	 * @brief Makes a call to `send()` function and uses the Broadcast address as destination
 	 * @param payload Data buffer that contain the message to be sent
@@ -95,6 +793,64 @@ public:
 		return send(ESPNOW_BROADCAST_ADDRESS, payload, payload_len);
 	}
 
+	/**
+	 * @brief Gathers several fragments (for example a header and a body) directly into a TX slot and enqueues it,
+	 * without the need of a staging buffer
+	 * @param dstAddress Destination address of peer to send the data to. `NULL` or `nullptr` to send to all unicast peers
+	 * @param fragments Array of fragments to gather, in order
+	 * @param fragment_count Number of fragments in the array
+	 * @param confirm_timeout_ms Only for synchronous send mode. How long to block waiting for the delivery status of this message
+	 * @param priority Priority class of the TX queue the message goes to
+	 * @param handle If not `nullptr`, receives the handle the delivery status of the message is reported with, see `onSendComplete(...)`
+	 * @return Returns sending status. 0 for success, any other value to indicate an error.
+	 * @note Total length of all fragments must be between 1 and `MAX_DATA_LENGTH`, or the maximum message length set by `enableFragmentation(...)`
+	 */
+	easy_send_error_t sendv(const uint8_t *dstAddress, const easy_iovec_t *fragments, size_t fragment_count, uint32_t confirm_timeout_ms = DEFAULT_SYNCH_SEND_TIMEOUT_MS,
+							easy_tx_priority_t priority = DEFAULT_TX_PRIORITY, easy_send_handle_t *handle = nullptr);
+
+	/**
+	 * @brief Loans a free TX slot to the caller, so the payload can be written directly into `payload_data` of the slot.
+	 * The slot must be given back either by `commitTXSlot(...)` or `releaseTXSlot(...)`
+	 * @param wait_ticks How long to wait for a free slot. `0` to return immediately, `portMAX_DELAY` to wait indefinitely
+	 * @return
+	 * 	- `nullptr` if there is no free slot or TX queue has not been initialized,
+	 *
+	 *  - `tx_queue_item_t *` pointer to the loaned slot
+	 */
+	tx_queue_item_t *acquireTXSlot(TickType_t wait_ticks = 0);
+
+	/**
+	 * @brief Enqueues a slot loaned by `acquireTXSlot(...)` for sending. Only the slot index is moved through the TX queue
+	 * @param slot Slot loaned by `acquireTXSlot(...)`, with the payload already written in `payload_data`
+	 * @param dstAddress Destination address of peer to send the data to. `NULL` or `nullptr` to send to all unicast peers
+	 * @param payload_len Number of bytes written in `payload_data`
+	 * @param confirm_timeout_ms Only for synchronous send mode. How long to block waiting for the delivery status of this message
+	 * @param priority Priority class of the TX queue the slot goes to
+	 * @param handle If not `nullptr`, the frame gets a handle, reported by `onSendComplete(...)` like the ones of `send(...)`.
+	 * Slots committed without one are not reported
+	 * @return Returns sending status. 0 for success, any other value to indicate an error.
+	 * @note On error the slot is released, the caller must not use it anymore. While a library frame feature or `setFrameEscaping(...)`
+	 * is enabled, a payload that starts with `EASY_FRAME_MAGIC` is sent behind a `EASY_FRAME_HEADER_LEN` bytes escape header so the
+	 * receiver does not take it for a library frame, it must leave room for it
+	 */
+	easy_send_error_t commitTXSlot(tx_queue_item_t *slot, const uint8_t *dstAddress, size_t payload_len, uint32_t confirm_timeout_ms = DEFAULT_SYNCH_SEND_TIMEOUT_MS,
+								   easy_tx_priority_t priority = DEFAULT_TX_PRIORITY, easy_send_handle_t *handle = nullptr);
+
+	/**
+	 * @brief Gives back a slot loaned by `acquireTXSlot(...)` without sending it
+	 * @param slot Slot loaned by `acquireTXSlot(...)`
+	 */
+	void releaseTXSlot(tx_queue_item_t *slot);
+
+	/**
+	 * @brief Escapes the messages that start with `EASY_FRAME_MAGIC` even with no library frame feature enabled, and strips the escape
+	 * of received ones. Aggregation, fragmentation, reliable channels, groups, encryption, compression and probes do it on their own.
+	 * Only for a plain node talking to nodes that have one of them: without any, the bytes on the air are the ones of the application
+	 * @param enabled `true` to escape, `false` to leave it to the features
+	 * @note Sender and receiver must agree: a receiver that does not escape delivers the escape header along with the message
+	 */
+	void setFrameEscaping(bool enabled);
+
 	/**
 	 * @brief Enables or disables transmission of queued messages by resuming or suspending the TX task
 	 * @param enable `true` to resume TX task, `false` to suspend TX task
@@ -103,7 +859,8 @@ public:
 
 	/**
 	 * @brief Function to check readiness to send data in the TX Queue
-	 * @note Can be ready to send data to queue whenever there is space in the queue. Good to use when we do not want to drop packets. Can be used in conjunction with `waitForTXQueueToBeEmptied()`
+	 * @note Can be ready to send data to queue whenever there is space in the queue. Good to use when we do not want to drop packets. Can be used in conjunction with `waitForTXQueueToBeEmptied()`.
+	 * It is a snapshot, to block until there is space use `waitForSpace(...)` instead of calling it in a loop
 	 * @return
 	 * 	- `true` if TX queue i not full
 	 *
@@ -117,20 +874,634 @@ public:
 	 */
 	void waitForTXQueueToBeEmptied();
 
+	/**
+	 * @brief Blocks until `slots` TX slots are free, woken by the completion that frees them instead of polling
+	 * @param slots Free slots to wait for, between 1 and the TX queue size
+	 * @param wait_ticks How long to wait. `0` to return immediately, `portMAX_DELAY` to wait indefinitely
+	 * @return `true` if the slots are free, `false` on timeout or if some parameter is invalid
+	 * @note Another sender may take the slots first. A priority class at its capacity still refuses frames
+	 */
+	bool waitForSpace(uint16_t slots = 1, TickType_t wait_ticks = portMAX_DELAY);
+
+	/**
+	 * @brief Blocks until every TX slot is free: every frame sent and completed, open aggregates flushed, no slot loaned
+	 * @param wait_ticks How long to wait. `0` to return immediately, `portMAX_DELAY` to wait indefinitely
+	 * @return `true` if drained, `false` on timeout
+	 * @note Unlike `waitForTXQueueToBeEmptied()`, it also waits for the frames in flight, so their delivery status is known when it returns
+	 */
+	bool waitForDrain(TickType_t wait_ticks = portMAX_DELAY);
+
+	/**
+	 * @brief Sets the watermarks of the TX slots in use, so producers learn when to hold back and when to resume instead of polling.
+	 * Reaching `high` calls `onTXWatermark(...)` with `above_high` set, falling back to `low` calls it again with `above_high` clear
+	 * @param high Slots in use (queued, in flight or loaned) that raise the high watermark, `0` to disable the watermarks
+	 * @param low Slots in use the count must fall back to, below `high`
+	 * @param event_group If not `NULL`, `high_bit` is set and `low_bit` cleared above the high watermark, the other way round
+	 * once back at the low one. Set to the current state right away
+	 * @param high_bit Bits of `event_group` set above the high watermark
+	 * @param low_bit Bits of `event_group` set at the low watermark and below
+	 * @return `true` if success, `false` if some parameter is invalid
+	 * @note Can be called before or after `begin(...)`. `event_group` must outlive the registration: it is forgotten by
+	 * `setTXWatermarks(0, 0)` and by `stop()`, delete it only after one of them
+	 */
+	bool setTXWatermarks(uint16_t high, uint16_t low, EventGroupHandle_t event_group = NULL, EventBits_t high_bit = 0, EventBits_t low_bit = 0);
+
+	/**
+	 * @brief Attach a callback function to be run when the TX slots in use cross the watermarks set by `setTXWatermarks(...)`
+	 * @param tx_watermark_cb Function, or lambda capturing up to `EASY_CALLBACK_CAPACITY` bytes. `nullptr` to remove it
+	 * @note Runs in the sender that reached the high watermark, or where the slot that reached the low one was freed:
+	 * the WiFi task (`tx_cb`), the TX task or a sender. Keep it short
+	 */
+	void onTXWatermark(tx_watermark_data tx_watermark_cb);
+
+	/**
+	 * @brief Configures how the TX task paces outgoing frames. Instead of a fixed delay after every `esp_now_send`,
+	 * the next frame is handed to ESP-NOW as soon as the completion (`tx_cb`) of a previous one arrives
+	 * @param max_in_flight Number of frames that can be handed to `esp_now_send` while still waiting for their `tx_cb`. Must be greater than 0
+	 * @param no_mem_retries How many times to retry `esp_now_send` when it returns `ESP_ERR_ESPNOW_NO_MEM`. Backoff starts at 1 ms and doubles on every retry
+	 * @param backoff_max_ms Upper bound for the exponential backoff between retries
+	 * @param completion_timeout_ms Time to wait for a `tx_cb` when the in flight limit is reached. When it expires the completions are considered lost and the frames
+	 * completed as failed, a `tx_cb` that still comes for one of them is ignored (`tx_late_completions` of `getStats(...)`)
+	 * @return `true` if the configuration was accepted, `false` if some parameter is invalid
+	 * @note Can be called before or after `begin(...)`. Other errors returned by `esp_now_send` are not retried
+	 */
+	bool setTXPacing(uint8_t max_in_flight, uint8_t no_mem_retries = DEFAULT_TX_NO_MEM_RETRIES,
+					 uint32_t backoff_max_ms = DEFAULT_TX_BACKOFF_MAX_MS, uint32_t completion_timeout_ms = DEFAULT_TX_COMPLETION_TIMEOUT_MS);
+
+	/**
+	 * @brief Configures a priority class of the TX queue
+	 * @param priority Class to configure
+	 * @param capacity Frames the class can hold queued, `0` for the whole TX queue size. All classes share the slots of the TX queue
+	 * @param drop_policy What happens to a new frame when the class is at capacity
+	 * @param max_wait_ms Anti-starvation: a frame of this class that waited longer is sent before frames of higher classes. `0` to never promote
+	 * @return `true` if the configuration was accepted, `false` if some parameter is invalid
+	 * @note Can be called before or after `begin(...)`. By default every class has the whole TX queue, drops the newest frame and the
+	 * limits are `DEFAULT_TX_INTERACTIVE_MAX_WAIT_MS` and `DEFAULT_TX_BULK_MAX_WAIT_MS`
+	 */
+	bool setTXClass(easy_tx_priority_t priority, uint16_t capacity, tx_drop_policy_t drop_policy, uint32_t max_wait_ms);
+
+	/**
+	 * @brief Returns the queue depth and wait time counters of a priority class
+	 * @param priority Class to read
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `tx_class_stats_t`
+	 */
+	tx_class_stats_t getTXClassStats(easy_tx_priority_t priority, bool reset = false);
+
 	void sendTest(int data);
 
 	/**
 	 * @brief Attach a callback function to be run on every received message
-	 * @param frame_rcvd_cb Pointer to the callback function
+	 * @param frame_rcvd_cb Function, or lambda capturing up to `EASY_CALLBACK_CAPACITY` bytes. Stored in place, never allocates
 	 */
 	void onDataReceived(frame_rcvd_data frame_rcvd_cb) override;
 
+	/**
+	 * @brief Same as `onDataReceived(frame_rcvd_cb)` with a function that gets `context` as its first argument, a class instance for example
+	 */
+	void onDataReceived(void (*frame_rcvd_cb)(void *context, const uint8_t *src_mac, const uint8_t *data, int data_len, espnow_frame_recv_info_t *esp_now_frame),
+						void *context)
+	{
+		onDataReceived(frame_rcvd_data(frame_rcvd_cb, context));
+	}
+
 	/**
 	 * @brief Attach a callback function to be run after sending a message
-	 * @param frame_sent_cb Pointer to the callback function
+	 * @param frame_sent_cb Function, or lambda capturing up to `EASY_CALLBACK_CAPACITY` bytes. Stored in place, never allocates
 	 */
 	void onDataSent(frame_sent_data frame_sent_cb) override;
 
+	/**
+	 * @brief Same as `onDataSent(frame_sent_cb)` with a function that gets `context` as its first argument
+	 */
+	void onDataSent(void (*frame_sent_cb)(void *context, const uint8_t *dst_addr, uint8_t status), void *context)
+	{
+		onDataSent(frame_sent_data(frame_sent_cb, context));
+	}
+
+	/**
+	 * @brief Attach a callback function to be run with the delivery status of every message sent by `send(...)` and `sendv(...)`,
+	 * identified by the handle they returned. Unlike `onDataSent(...)`, that gets every frame with its destination only,
+	 * it tells which of several messages queued to the same peer failed, so exactly that one can be sent again
+	 * @param send_complete_cb Pointer to the callback function, `nullptr` to remove it
+	 * @note Runs where the completion happens: in the WiFi task (`tx_cb`), in the TX task (refused by ESP-NOW, lost completion)
+	 * or in the sender that dropped the oldest frame of a class. Keep it short. Messages packed in one aggregate share the handle of their frame
+	 */
+	void onSendComplete(send_complete_data send_complete_cb);
+
+	/**
+	 * @brief Keeps the completions of the last `completions` messages for `pollSendCompletion(...)`, for senders that would
+	 * rather collect them than get a callback
+	 * @param completions Completions kept until they are polled, the oldest is overwritten when full and counted in `easy_stats_t::send_completions_missed`
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 */
+	bool enableSendTracking(uint16_t completions = DEFAULT_SEND_COMPLETIONS);
+
+	/**
+	 * @brief Stops keeping completions and frees them
+	 */
+	void disableSendTracking();
+
+	/**
+	 * @brief Takes the oldest completion not polled yet
+	 * @param completion Receives the handle, destination, delivery status and latency of the message
+	 * @return `true` if there was one, `false` if there is none or `enableSendTracking(...)` was not called
+	 */
+	bool pollSendCompletion(send_completion_t *completion);
+
+	/**
+	 * @brief Starts the library owned RX task. From now on `rx_cb` only copies every frame and its radio metadata into a
+	 * preallocated lock-free ring and returns, so slow handlers do not stall the WiFi task.
+	 * The RX task delivers the frames through `onDataReceivedBatch(...)` callback or, if that is not set, one by one through `onDataReceived(...)`
+	 * @param ring_size Number of frames the RX ring can hold. When full, new frames are dropped and counted as overflow
+	 * @param max_batch Maximum number of frames delivered in one call of the batch callback
+	 * @param task_priority Priority of the RX task
+	 * @param task_core Core where the RX task runs
+	 * @return `true` if success, `false` if some error ocurred
+	 * @note Call after `begin(...)`. Calling it again restarts the RX task with the new configuration
+	 */
+	bool beginRXTask(uint16_t ring_size = DEFAULT_RX_RING_SIZE, uint16_t max_batch = DEFAULT_RX_MAX_BATCH,
+					 UBaseType_t task_priority = 1, BaseType_t task_core = CONFIG_ARDUINO_RUNNING_CORE);
+
+	/**
+	 * @brief Stops the RX task and frees the RX ring. Frames are delivered again directly from the WiFi task
+	 * @note Do not call it from the RX callbacks, they run in the RX task
+	 */
+	void stopRXTask();
+
+	/**
+	 * @brief Attach a callback function that receives batches of frames from the RX task
+	 * @param frame_rcvd_batch_cb Pointer to the callback function
+	 * @note The frames are valid only during the call. Only used when the RX task is running, see `beginRXTask(...)`
+	 */
+	void onDataReceivedBatch(frame_rcvd_batch_data frame_rcvd_batch_cb);
+
+	/**
+	 * @brief Returns the counters of the RX ring
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `rx_ring_stats_t`
+	 */
+	rx_ring_stats_t getRXStats(bool reset = false);
+
+	/**
+	 * @brief Enables the duplicate filter of `rx_cb`: frames repeated by MAC retries or rebroadcasts are dropped before any callback runs.
+	 * Every source has a window of its last sequence numbers, from the 802.11 sequence control of the frame or from the application
+	 * sequence number returned by the callback set with `onRXDedupKey(...)`
+	 * @param sources Sources tracked at the same time, a new source replaces the one idle the longest
+	 * @param expiry_ms Idle time after which a source starts over
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 * @note Dropped frames are counted in `rx_ring_stats_t::duplicates`
+	 */
+	bool enableRXDedup(uint16_t sources = DEFAULT_RX_DEDUP_SOURCES, uint32_t expiry_ms = DEFAULT_RX_DEDUP_EXPIRY_MS);
+
+	/**
+	 * @brief Disables the duplicate filter and frees it
+	 */
+	void disableRXDedup();
+
+	/**
+	 * @brief Attach a callback function that extracts an application sequence number for the duplicate filter
+	 * @param rx_dedup_key_cb Pointer to the callback function
+	 * @note Runs in the WiFi task for every received frame, keep it short
+	 */
+	void onRXDedupKey(rx_dedup_key_data rx_dedup_key_cb);
+
+	/**
+	 * @brief Enables packing of small messages for the same destination into a single ESP-NOW frame of up to `MAX_DATA_LENGTH` bytes.
+	 * `send(...)` and `sendv(...)` append small messages to an open aggregate of their destination, which is handed to the TX queue
+	 * when the next message does not fit, when the aggregation window expires or when `flush()` is called.
+	 * The receiver splits the frame back and delivers every message on its own
+	 * @param window_ms Longest time a message waits in an open aggregate
+	 * @param max_message_len Messages up to this length are aggregated, longer ones are sent as they are. At most `MAX_AGGREGATED_MESSAGE_LEN`
+	 * @param max_open Destinations that can have an open aggregate at the same time. Each one holds a TX slot, must be less than the TX queue size
+	 * @return `true` if success, `false` if some parameter is invalid
+	 * @note Call after `begin(...)`. The receiver must enable aggregation too, otherwise it gets the packed frame.
+	 * In synchronous send mode every message waits for its own delivery status, so nothing is packed but received aggregates are still split.
+	 * Slots loaned with `acquireTXSlot(...)` are never aggregated
+	 */
+	bool enableAggregation(uint32_t window_ms = DEFAULT_AGGREGATION_WINDOW_MS, uint8_t max_message_len = DEFAULT_AGGREGATION_MAX_MESSAGE_LEN,
+						   uint8_t max_open = DEFAULT_AGGREGATION_MAX_OPEN);
+
+	/**
+	 * @brief Flushes the open aggregates and stops aggregating
+	 */
+	void disableAggregation();
+
+	/**
+	 * @brief Hands all the open aggregates to the TX queue right away
+	 */
+	void flush();
+
+	/**
+	 * @brief Returns the packing and latency counters of the aggregation
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `aggregation_stats_t`
+	 */
+	aggregation_stats_t getAggregationStats(bool reset = false);
+
+	/**
+	 * @brief Enables sending and receiving messages larger than `MAX_DATA_LENGTH`. `send(...)` and `sendv(...)` split them into fragments,
+	 * the receiver copies the fragments of every sender into preallocated buffers and delivers each complete message through `onDataReceived(...)`
+	 * @param max_message_len Longest message that is sent or reassembled. At most `MAX_FRAGMENTED_MESSAGE_LEN`
+	 * @param reassembly_slots Messages that can be reassembled at the same time, each one takes a `max_message_len` buffer.
+	 * When all are taken, the incomplete message that made no progress for the longest time is evicted
+	 * @param reassembly_timeout_ms Time an incomplete message is kept since its last fragment
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 * @note Both ends must enable fragmentation. Complete messages are delivered from the RX task when it runs, but never through
+	 * `onDataReceivedBatch(...)` since they do not fit in `rx_frame_t`. In synchronous send mode `send(...)` waits for the delivery status of every fragment
+	 */
+	bool enableFragmentation(uint16_t max_message_len = DEFAULT_MAX_FRAGMENTED_MESSAGE_LEN, uint8_t reassembly_slots = DEFAULT_REASSEMBLY_SLOTS,
+							 uint32_t reassembly_timeout_ms = DEFAULT_REASSEMBLY_TIMEOUT_MS);
+
+	/**
+	 * @brief Returns the counters of fragmentation and reassembly
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `fragmentation_stats_t`
+	 */
+	fragmentation_stats_t getFragmentationStats(bool reset = false);
+
+	/**
+	 * @brief Enables reliable channels: `sendReliable(...)` numbers every message of a peer and keeps it until the receiver acknowledges it,
+	 * retransmitting it after a timeout derived from the measured round trip time. Several messages can be in flight at once (sliding window).
+	 * Receivers acknowledge cumulatively and selectively, riding on their own reliable messages to the same peer when there are some
+	 * @param window Messages in flight per peer. Power of two, at most `EASY_RELIABLE_MAX_WINDOW`
+	 * @param max_peers Peers with a reliable channel at the same time
+	 * @param max_retries Retransmissions before a message is reported as failed through `onReliableStatus(...)`
+	 * @param ack_delay_ms Time an acknowledgement waits for reverse traffic before it is sent on its own
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 * @note Call after `begin(...)`. Both ends must enable it. In synchronous send mode `sendReliable(...)` does not block for the
+	 * delivery status either, acknowledgements report it through `onReliableStatus(...)`. Messages are delivered once,
+	 * in the order they arrive, which can differ from the order they were sent after a loss
+	 */
+	bool enableReliable(uint8_t window = DEFAULT_RELIABLE_WINDOW, uint8_t max_peers = DEFAULT_RELIABLE_MAX_PEERS,
+						uint8_t max_retries = DEFAULT_RELIABLE_MAX_RETRIES, uint32_t ack_delay_ms = DEFAULT_RELIABLE_ACK_DELAY_MS);
+
+	/**
+	 * @brief Sends a message over the reliable channel with a unicast peer
+	 * @param dstAddress Destination peer, must be unicast
+	 * @param payload Data buffer that contain the message to be sent
+	 * @param payload_len Data length, up to `MAX_RELIABLE_PAYLOAD_LEN`
+	 * @param window_wait_ms How long to wait when the send window of the peer is full
+	 * @param sequence If not `nullptr`, receives the sequence number reported later by `onReliableStatus(...)`
+	 * @return Returns sending status. 0 when the message is in the send window, any other value to indicate an error
+	 */
+	easy_send_error_t sendReliable(const uint8_t *dstAddress, const uint8_t *payload, size_t payload_len,
+								   uint32_t window_wait_ms = DEFAULT_RELIABLE_WAIT_MS, uint16_t *sequence = nullptr);
+
+	/**
+	 * @brief Attach a callback function to be run when a reliable message is acknowledged or given up
+	 * @param reliable_status_cb Pointer to the callback function
+	 * @note Runs in the WiFi task (acknowledged) or in the TX task (given up), keep it short
+	 */
+	void onReliableStatus(reliable_status_data reliable_status_cb);
+
+	/**
+	 * @brief Returns the counters of the reliable channels
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `reliable_stats_t`
+	 */
+	reliable_stats_t getReliableStats(bool reset = false);
+
+	/* ==========> Peer Group Functions <========== */
+
+	/**
+	 * @brief Creates a named peer group. Members are added with `addToGroup(...)`
+	 * @param name Group name, up to `MAX_GROUP_NAME_LEN` characters. Members join it by the same name
+	 * @return index of the group, the existing one if the name is taken, or `-1` if all `MAX_GROUPS` are used
+	 */
+	int8_t createGroup(const char *name);
+
+	/**
+	 * @brief Deletes a group and its membership. A message in progress to the group still completes
+	 */
+	bool deleteGroup(uint8_t group);
+
+	/**
+	 * @return index of the group with that name or `-1`
+	 */
+	int8_t findGroup(const char *name);
+
+	/**
+	 * @brief Adds a peer to a group. The peer must have been added with `addPeer(...)`, deleting it removes it from its groups
+	 * @return `true` if success, `false` if the group or the peer does not exist or the group has `EASY_GROUP_MAX_MEMBERS` already
+	 */
+	bool addToGroup(uint8_t group, const uint8_t *peer_addr);
+
+	/**
+	 * @brief Removes a peer from a group
+	 */
+	bool removeFromGroup(uint8_t group, const uint8_t *peer_addr);
+
+	/**
+	 * @return number of members of the group
+	 */
+	uint8_t groupSize(uint8_t group);
+
+	/**
+	 * @brief Accepts the group messages broadcast to the group with that name, creating it if needed
+	 * @note Group messages sent as unicasts are always accepted. Add the sender as a peer, so the acknowledgements can reach it
+	 */
+	bool joinGroup(const char *name);
+
+	/**
+	 * @brief Stops accepting the group messages broadcast to the group with that name
+	 */
+	bool leaveGroup(const char *name);
+
+	/**
+	 * @brief Enables group messages: `sendToGroup(...)` and the group frames of other devices are recognized
+	 * @param max_sends Group messages in progress at the same time
+	 * @param ack_timeout_ms Time members have to acknowledge a broadcast before they get a unicast repair
+	 * @param broadcast_min_members Groups with fewer members always get unicasts in `GROUP_SEND_AUTO` mode
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 * @note Call after `begin(...)`. Members must enable it too. Broadcast needs the Broadcast peer added with `addPeer(...)`
+	 */
+	bool enableGroups(uint8_t max_sends = DEFAULT_GROUP_MAX_SENDS, uint32_t ack_timeout_ms = DEFAULT_GROUP_ACK_TIMEOUT_MS,
+					  uint8_t broadcast_min_members = DEFAULT_GROUP_BROADCAST_MIN_MEMBERS);
+
+	/**
+	 * @brief Sends a message to every member of a group, as one unicast per member or as a single broadcast that members acknowledge.
+	 * Members that miss the broadcast get a unicast repair. The outcome for all the members is reported once through `onGroupSendResult(...)`
+	 * @param group Group index
+	 * @param payload Data buffer that contain the message to be sent
+	 * @param payload_len Data length, up to `MAX_GROUP_PAYLOAD_LEN`
+	 * @param mode `GROUP_SEND_AUTO` picks the cheapest on the air from group size, message length and the broadcast loss seen so far
+	 * @param send_id If not `nullptr`, receives the id reported later by `onGroupSendResult(...)`
+	 * @return Returns sending status. 0 when the message is on its way, any other value to indicate an error
+	 */
+	easy_send_error_t sendToGroup(uint8_t group, const uint8_t *payload, size_t payload_len, group_send_mode_t mode = GROUP_SEND_AUTO,
+								  uint16_t *send_id = nullptr);
+
+	/**
+	 * @brief Attach a callback function to be run when all the members of a group message have a result
+	 * @param group_send_cb Pointer to the callback function
+	 * @note Runs in the WiFi task or in the TX task, keep it short
+	 */
+	void onGroupSendResult(group_send_data group_send_cb);
+
+	/**
+	 * @brief Returns the counters of the group messages
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `group_stats_t`
+	 */
+	group_stats_t getGroupStats(bool reset = false);
+
+	/* ==========> Channel Scheduler Functions <========== */
+
+	/**
+	 * @brief Enables the channel scheduler, to send to peers that listen on different channels without `switchChannel(...)`.
+	 * The TX task groups the queued frames by the channel of their destination and stays on a channel until its frames are
+	 * all sent, then moves to the channel whose oldest frame waited longest. When a frame for another channel waited longer
+	 * than `max_latency_ms`, the radio moves as soon as the frames found on arrival on the current channel are sent.
+	 * Frames in flight are completed before every change, and with nothing left to send the radio goes back to the home channel
+	 * @param max_latency_ms Longest wait of a frame for another channel before the scheduler leaves the current one early
+	 * @return `true` if success, `false` if some error ocurred
+	 * @note Call after `begin(...)`. Peers are registered in ESP-NOW on channel `0`, the one the radio is on, so no peer is
+	 * rewritten on a change. Broadcasts and sends to all peers go out on the home channel. While the radio is on another
+	 * channel, frames sent on the home channel are not received. Frames held by the scheduler are out of reach of `TX_DROP_OLDEST`
+	 */
+	bool enableChannelScheduling(uint32_t max_latency_ms = DEFAULT_CHANNEL_MAX_LATENCY_MS);
+
+	/**
+	 * @brief Disables the channel scheduler. Frames it holds are still sent on their channel, then the radio goes back to the home channel
+	 * @note Peers are registered again on the home channel
+	 */
+	void disableChannelScheduling();
+
+	/**
+	 * @brief Sets the channel a peer listens on. The channel scheduler sends the frames of the peer on it
+	 * @param peer_addr MAC of the peer
+	 * @param channel `1` to `MAX_WIFI_CHANNEL`, `0` for the home channel
+	 * @return `true` if success, `false` if the peer does not exist or the channel is invalid
+	 * @note Frames already queued for the peer keep the channel they were queued with
+	 */
+	bool setPeerChannel(const uint8_t *peer_addr, uint8_t channel);
+
+	/**
+	 * @brief Returns the channel a peer listens on, as set by `setPeerChannel(...)`
+	 * @return channel, `0` for the home channel or if the peer does not exist
+	 */
+	uint8_t getPeerChannel(const uint8_t *peer_addr);
+
+	/**
+	 * @brief Returns the channel switches and the time spent on every channel by the channel scheduler
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `channel_stats_t`
+	 */
+	channel_stats_t getChannelStats(bool reset = false);
+
+	/* ==========> Fair Scheduler Functions <========== */
+
+	/**
+	 * @brief Enables the fair scheduler, so one destination sending flat out can no longer fill the TX queue and hold back the
+	 * frames of the others. Each destination queues up to `destination_backlog` frames, the next ones are refused with
+	 * `EASY_SEND_QUEUE_FULL_ERROR` while the other destinations still get in. Within a priority class the TX task serves the
+	 * destinations by deficit round robin, charging every frame the airtime its length takes at `phy_rate_kbps`, so a
+	 * destination of long frames gets the same airtime as one of short frames, not the same number of frames.
+	 * A peer can also be capped to a rate with `setPeerRateLimit(...)`
+	 * @param max_destinations Destinations with a queue of their own. Further destinations share one queue, a destination
+	 * without frames queued gives its queue up to a new one and its counters go to the shared queue
+	 * @param destination_backlog Frames one destination can have queued, `0` for a quarter of the TX queue
+	 * @param phy_rate_kbps PHY rate of ESP-NOW frames, as set with `esp_wifi_config_espnow_rate()`, `1000` by default
+	 * @return `true` if success, `false` if some parameter is invalid, allocation failed or the channel scheduler is enabled
+	 * @note Call after `begin(...)`. The number of destinations is kept until `stop()`. Priority classes still go first,
+	 * fairness is between the destinations of a class. Frames held by the scheduler are out of reach of `TX_DROP_OLDEST`
+	 */
+	bool enableFairScheduling(uint8_t max_destinations = DEFAULT_FAIR_MAX_DESTINATIONS, uint16_t destination_backlog = 0,
+							  uint16_t phy_rate_kbps = DEFAULT_FAIR_PHY_RATE_KBPS);
+
+	/**
+	 * @brief Disables the fair scheduler. Frames it holds are still sent, fairly, then frames go in the order of their class again
+	 */
+	void disableFairScheduling();
+
+	/**
+	 * @brief Caps the rate of the frames sent to a peer with a token bucket, enforced by the fair scheduler
+	 * @param peer_addr MAC of the peer
+	 * @param bytes_per_s Payload bytes per second, `0` to remove the cap
+	 * @param burst_bytes Bytes that can go at once after the peer was idle, at least one frame of `MAX_DATA_LENGTH`
+	 * @return `true` if success, `false` if the peer does not exist
+	 * @note Frames over the cap wait in the scheduler, other destinations go meanwhile. A capped peer that gets a queue of the
+	 * scheduler starts with an empty bucket, so giving its queue up and getting it back never lets it exceed the cap
+	 */
+	bool setPeerRateLimit(const uint8_t *peer_addr, uint32_t bytes_per_s, uint16_t burst_bytes = 2 * MAX_DATA_LENGTH);
+
+	/**
+	 * @brief Returns the backlog and the share of the airtime of every destination of the fair scheduler
+	 * @param stats Receives up to `max_stats` destinations
+	 * @param max_stats Room in `stats`
+	 * @param reset `true` to reset the counters after reading them
+	 * @return destinations written to `stats`
+	 */
+	uint8_t getTXDestinationStats(tx_destination_stats_t *stats, uint8_t max_stats, bool reset = false);
+
+	/* ==========> Encryption Functions <========== */
+
+	/**
+	 * @brief Enables the encryption stage: ChaCha20-Poly1305 authenticated encryption of every frame sent to, or received from,
+	 * a peer that has a key. The TX task encrypts a frame in its slot right before handing it to ESP-NOW, `rx_cb` checks and
+	 * decrypts a frame before anything else looks at it. A frame to a peer with a key of its own is sealed with it, any other
+	 * frame with the network key if there is one, broadcasts and sends to all peers always with the network key.
+	 * Frames received in clear from a peer with a key, or from anyone once the network key is set, are dropped.
+	 * Every frame grows by `EASY_SEALED_OVERHEAD` bytes, so messages are limited to `MAX_SEALED_DATA_LENGTH` bytes
+	 * and the limits of aggregates, fragments, reliable and group messages shrink by as much
+	 * @param max_keys Peers that can have a key, besides the network key
+	 * @return `true` if success, `false` if some error ocurred
+	 * @note Call before `enableAggregation(...)` and `enableFragmentation(...)`, both size their frames for the overhead.
+	 * Both sides must have encryption enabled. Key schedules are computed by `setPeerKey(...)`, there is no allocation per frame.
+	 * Replayed frames are not detected, see `onRXDedupKey(...)` for an application sequence number that the filter can check
+	 */
+	bool enableEncryption(uint8_t max_keys = DEFAULT_ENCRYPTION_KEYS);
+
+	/**
+	 * @brief Disables the encryption stage and forgets every key
+	 */
+	void disableEncryption();
+
+	/**
+	 * @brief Sets or removes the key used with a peer
+	 * @param peer_addr MAC of the peer, `ESPNOW_BROADCAST_ADDRESS` for the network key
+	 * @param key `ENCRYPTION_KEY_LEN` bytes, the same on both sides. `nullptr` removes the key
+	 * @return `true` if success, `false` if encryption is not enabled or there is no room for another key
+	 * @note The peer does not need to exist, its key is kept until removed
+	 */
+	bool setPeerKey(const uint8_t *peer_addr, const uint8_t *key);
+
+	/**
+	 * @brief Returns the frames encrypted and decrypted, and the ones dropped by the encryption stage
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `encryption_stats_t`
+	 */
+	encryption_stats_t getEncryptionStats(bool reset = false);
+
+	/* ==========> Compression Functions <========== */
+
+	/**
+	 * @brief Enables the compression stage: frames sent to a peer set with `setPeerCompression(...)` are compressed by the TX task
+	 * right before they are encrypted and sent, `rx_cb` decompresses every compressed frame right after decrypting it.
+	 * The codec is a small window LZ77 (`EasyLz`) that can match against a pre-shared dictionary, so even one short message
+	 * finds the keys and the boilerplate of its kind in it. A frame is only sent compressed when that makes it shorter,
+	 * compressed and uncompressed frames are told apart by their header and mix freely
+	 * @return `true` if success, `false` if some error ocurred
+	 * @note Both sides must have compression enabled and the same dictionaries under the same ids. Message length limits do not change,
+	 * the gain is airtime and, with fragmentation, fewer bytes per fragment. All the working memory is in the object, nothing is allocated per frame
+	 */
+	bool enableCompression();
+
+	/**
+	 * @brief Disables the compression stage. Frames are sent as they are and compressed frames received are no longer decompressed
+	 */
+	void disableCompression();
+
+	/**
+	 * @brief Registers a pre-shared dictionary. Its index is built here, once
+	 * @param id Dictionary id, `1` to `MAX_COMPRESSION_DICTIONARIES`
+	 * @param dictionary Dictionary bytes, up to `EasyLz::MAX_DICTIONARY_LEN`. Not copied, must stay valid until `stop()`.
+	 * `nullptr` removes the dictionary. See `extras/host/tools/easy_lz_train` to train one from captured traffic
+	 * @param len Length of `dictionary`
+	 * @return `true` if success, `false` if compression is enabled, the parameters are invalid or allocation failed
+	 * @note Only while compression is disabled, the TX task and `rx_cb` use the dictionaries without a lock
+	 */
+	bool setCompressionDictionary(uint8_t id, const uint8_t *dictionary, uint16_t len);
+
+	/**
+	 * @brief Sets how the frames sent to a peer are compressed
+	 * @param peer_addr MAC of the peer, `ESPNOW_BROADCAST_ADDRESS` for broadcasts once the broadcast peer is added
+	 * @param dictionary Dictionary id, `COMPRESSION_NO_DICTIONARY` to compress without one or `COMPRESSION_OFF`
+	 * @return `true` if success, `false` if the peer does not exist or the dictionary id is out of range
+	 * @note Frames sent to all peers at once (`NULL` destination) are never compressed, the peers may not share a setting
+	 */
+	bool setPeerCompression(const uint8_t *peer_addr, uint8_t dictionary);
+
+	/**
+	 * @brief Returns the frames compressed and decompressed, the bytes saved and the time spent
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `compression_stats_t`
+	 */
+	compression_stats_t getCompressionStats(bool reset = false);
+
+	/* ==========> Typed Message Functions <========== */
+
+	/**
+	 * @brief Sends a struct as a typed message. The frame carries the id of the type in `EASY_TYPED_OVERHEAD` bytes of headers,
+	 * the receiver hands it to the handler set for the type with `onMessage<T>(...)`
+	 * @param dstAddress Destination address of peer to send the data to. `NULL` or `nullptr` to send to all unicast peers
+	 * @param message Struct declared with `EASY_MESSAGE(T)`, trivially copyable, up to `MAX_TYPED_MESSAGE_LEN` bytes. Both checked at compile time
+	 * @param priority Priority class of the TX queue the message goes to
+	 * @return Returns sending status. 0 for success, any other value to indicate an error
+	 * @note The struct travels as its bytes, sender and receiver must lay it out the same way (same compiler, packed or fixed width fields).
+	 * Small typed messages are aggregated like any other. With encryption enabled the struct is limited to `MAX_SEALED_DATA_LENGTH - EASY_TYPED_OVERHEAD`
+	 */
+	template <typename T>
+	easy_send_error_t send(const uint8_t *dstAddress, const T &message, easy_tx_priority_t priority = DEFAULT_TX_PRIORITY, easy_send_handle_t *handle = nullptr)
+	{
+		static_assert(!std::is_pointer<T>::value, "send<T>(...) sends the struct, not what a pointer points to");
+		static_assert(std::is_trivially_copyable<T>::value, "a typed message is sent as its bytes, it must be trivially copyable");
+		static_assert(sizeof(T) <= MAX_TYPED_MESSAGE_LEN, "typed message longer than MAX_TYPED_MESSAGE_LEN");
+
+		const uint16_t type_id = EasyMessageType<T>::id();
+		const uint8_t header[EASY_TYPED_OVERHEAD] = {EASY_FRAME_MAGIC, EASY_FRAME_TYPED, (uint8_t)type_id, (uint8_t)(type_id >> 8)};
+		const easy_iovec_t fragments[] = {{header, sizeof(header)}, {&message, sizeof(T)}};
+		return sendv(dstAddress, fragments, 2, DEFAULT_SYNCH_SEND_TIMEOUT_MS, priority, handle);
+	}
+
+	/**
+	 * @brief Makes a call to `send<T>(...)` and uses the Broadcast address as destination
+	 */
+	template <typename T>
+	easy_send_error_t sendBroadcast(const T &message, easy_tx_priority_t priority = DEFAULT_TX_PRIORITY)
+	{
+		return send(ESPNOW_BROADCAST_ADDRESS, message, priority);
+	}
+
+	/**
+	 * @brief Sets the handler of a message type. Typed messages of that type no longer reach `onDataReceived(...)` or
+	 * `onDataReceivedBatch(...)`, they are handed to the handler as a `const T &` that points straight into the receive buffer
+	 * when it is aligned for `T`, or to a copy on the stack when it is not (messages split out of an aggregate)
+	 * @param handler Function or lambda without captures, `easyEspNow.onMessage<T>([](const uint8_t *mac, const T &m, espnow_frame_recv_info_t *info) { ... })`.
+	 * `nullptr` removes the handler, messages of the type are then delivered as they are
+	 * @return `true` if success, `false` if `MAX_MESSAGE_TYPES` types have a handler already or another type has the same id
+	 * @note Runs where `onDataReceived(...)` would: in the WiFi task, or in the RX task when it is running. Set the handlers before
+	 * the messages arrive. The table is looked up from the id in the frame, starting at a position the compiler computed for each type
+	 */
+	template <typename T>
+	bool onMessage(typed_message_data<T> handler)
+	{
+		static_assert(sizeof(T) <= MAX_TYPED_MESSAGE_LEN, "typed message longer than MAX_TYPED_MESSAGE_LEN");
+		return setTypedHandler(EasyMessageType<T>::id(), sizeof(T), &invokeTypedHandler<T>, reinterpret_cast<void (*)()>(handler));
+	}
+
+	/* ==========> Probe Functions <========== */
+
+	/**
+	 * @brief Enables latency probes: `rx_cb` answers every probe right away, with the time it arrived and the time the reply
+	 * was queued on its clock, and `ping(...)` can measure the link to a peer. Timestamps are `esp_timer_get_time()` microseconds
+	 * @param max_probes Probes one `ping(...)` can send, up to `MAX_PING_PROBES`, their timestamps are preallocated. `0` to only answer
+	 * @return `true` if success, `false` if some parameter is invalid, a ping is running or allocation failed
+	 * @note Both sides must have probes enabled. Replies are unicasts, the pinging device must be a peer of the responder
+	 */
+	bool enableProbes(uint16_t max_probes = DEFAULT_PING_MAX_PROBES);
+
+	/**
+	 * @brief Stops answering probes and frees the probe timestamps. Probes received are then delivered as they are
+	 */
+	void disableProbes();
+
+	/**
+	 * @brief Measures the link to a peer: sends `count` probes of `size` bytes, one every `interval_ms`, and waits for their replies
+	 * @param peer_addr Unicast peer with probes enabled
+	 * @param count Probes to send, up to the `max_probes` of `enableProbes(...)`
+	 * @param size Length of every probe and of its reply, from `EASY_PROBE_OVERHEAD` to the longest frame
+	 * @param result Receives the loss rate, minimum, average, 99th percentile and maximum round trip, where the time went and
+	 * an estimate of the offset between the two clocks
+	 * @param interval_ms Time between two probes, `0` to send them back to back
+	 * @param timeout_ms Time the replies are waited for after the last probe
+	 * @return `true` if the probes were sent, `false` if some parameter is invalid, probes are disabled or another ping is running
+	 * @note Blocks the caller until every reply arrived or the timeout expired. Probes go in the interactive class, replies in the control class
+	 */
+	bool ping(const uint8_t *peer_addr, uint16_t count, uint8_t size, ping_result_t *result, uint32_t interval_ms = DEFAULT_PING_INTERVAL_MS,
+			  uint32_t timeout_ms = DEFAULT_PING_TIMEOUT_MS);
+
 	/* ==========> Peer Management Functions <========== */
 
 	/**
@@ -155,32 +1526,69 @@ public:
 	 * 	- `true`: Broadcast address should be kept and not deleted
 	 *
 	 *  - `false`: Broadcast address should not be kept and can be deleted
+	 * @return The deleted peer, by value. When nothing can be deleted the returned peer has
+	 * MAC [00:00:00:00:00:00] and `time_peer_added` 0, same as an invalid peer returned by `getPeer(...)`
+	 * @note Constant time, the oldest peer is always known. Nothing is allocated
+	 */
+	peer_t deletePeer(bool keep_broadcast_addr = true); // this should delete the oldest peer
+
+	peer_t getPeer(const uint8_t *peer_addr_to_get, esp_now_peer_info_t &peer_info);
+	// needed a modify peer TODO
+
+	/**
+	 * @brief Checks if peer exists or no
+	 * @note A wrapper which makes a call to ESP-NOW function: `esp_now_is_peer_exist(...)`
+	 * @param peer_addr Peer address to check for existance
 	 * @return
-	 * 	- `nullptr` if nothing can be deleted or,
+	 * 	- `true` if peer exists
 	 *
-	 *  - `uint8_t *` pointer to the deleted peer MAC address
+	 *  - `false` if peer does not exist
+	 */
+	bool peerExists(const uint8_t *peer_addr);
+
+	/**
+	 * @brief Enables a logical peer directory in RAM that can hold many more peers than ESP-NOW (`MAX_TOTAL_PEER_NUM`).
+	 * Peers added with `addPeer(...)` go to the directory and, while there is room, to ESP-NOW as well.
+	 * When sending to a peer that is not registered in ESP-NOW, the TX task swaps it in, evicting the least recently used
+	 * ESP-NOW peer that has no frames in flight. Broadcast peer is never evicted
+	 * @param capacity Number of peers the directory can hold
+	 * @return `true` if success, `false` if some error ocurred
+	 * @note Call after `begin(...)`. Peers already added are moved into the directory.
+	 * With the directory enabled `deletePeer(bool)` deletes the oldest peer of the directory and `getPeerList()` returns the peers registered in ESP-NOW
+	 */
+	bool enablePeerDirectory(uint16_t capacity = DEFAULT_PEER_DIRECTORY_SIZE);
+
+	/**
+	 * @brief Returns the hit, miss and swap cost counters of the peer directory
+	 * @param reset `true` to reset the counters after reading them
+	 * @return counters in the type of `peer_directory_stats_t`
 	 */
-	uint8_t *deletePeer(bool keep_broadcast_addr = true); // this should delete the oldest peer
+	peer_directory_stats_t getPeerDirectoryStats(bool reset = false);
 
-	peer_t getPeer(const uint8_t *peer_addr_to_get, esp_now_peer_info_t &peer_info);
-	// needed a modify peer TODO
+	/**
+	 * @brief Returns a snapshot of the library metrics: send results, TX queue depth, `esp_now_send` errors and latency histograms
+	 * @param reset `true` to reset the counters after reading them, for periodic scraping. Current queue depth is never reset
+	 * @return metrics in the type of `easy_stats_t`
+	 * @note Counters are updated with relaxed atomic increments, they are always on
+	 */
+	easy_stats_t getStats(bool reset = false);
 
 	/**
-	 * @brief Checks if peer exists or no
-	 * @note A wrapper which makes a call to ESP-NOW function: `esp_now_is_peer_exist(...)`
-	 * @param peer_addr Peer address to check for existance
-	 * @return
-	 * 	- `true` if peer exists
-	 *
-	 *  - `false` if peer does not exist
+	 * @brief Returns the traffic counters of a peer: frames received and sent, RSSI and last time it was heard
+	 * @param peer_addr MAC of the peer
+	 * @param stats Receives the counters
+	 * @param reset `true` to reset the frame counters after reading them. RSSI and last seen are kept
+	 * @return `true` if success, `false` if the peer does not exist
+	 * @note With the peer directory enabled counters live in the directory, so they survive swapping the peer in and out of ESP-NOW
 	 */
-	bool peerExists(const uint8_t *peer_addr);
+	bool getPeerStats(const uint8_t *peer_addr, peer_stats_t &stats, bool reset = false);
 
 	/**
 	 * @brief Update last seen value for peer with MAC address
 	 * @param peer_addr peer's mac that we want to update for last seen
 	 * @return `true` for success, `false` for fail - maybe peer does not exists
-	 * @note This function will only update `time_peer_added` value for the peer in the `peer_list_t`. It will be set equal to `millis()`
+	 * @note This function will only update `time_peer_added` value for the peer in the `peer_list_t`. It will be set equal to `millis()`.
+	 * Constant time, it is cheap enough to be called on every received frame
 	 */
 	bool updateLastSeenPeer(const uint8_t *peer_addr);
 
@@ -202,7 +1610,7 @@ public:
 	int countPeers(CountPeers count_type);
 
 	/**
-	 * @brief Prints the peer list that `peer_list_t` structure keeps as reference to the ESP-NOW peers
+	 * @brief Prints the peer list that `peer_list_t` structure keeps as reference to the ESP-NOW peers, from oldest to newest
 	 */
 	void printPeerList();
 
@@ -214,8 +1622,15 @@ public:
 	 * Original Structure Unaffected: Any changes made to the returned copy will not affect the original structure.
 	 * No Risk of Modifying Protected Data: Since the function returns a copy, it does not provide direct access to the original data.
 	 * This is useful in cases where you want to prevent unintended modifications to protected data.
+	 * Peers in the list are not kept in the order they were added, use `time_peer_added` to order them.
 	 */
-	peer_list_t getPeerList() { return peer_list; }
+	peer_list_t getPeerList()
+	{
+		portENTER_CRITICAL(&peers_mux);
+		peer_list_t copy = peer_list;
+		portEXIT_CRITICAL(&peers_mux);
+		return copy;
+	}
 
 	/* ==========> Miscellaneous Functions <========== */
 
@@ -297,7 +1712,7 @@ public:
 	 * @note Determined by ESP-NOW API
 	 * @return MAX_DATA_LENGTH - number of bytes of of max data length
 	 */
-	uint8_t getMaxMessageLength() override { return MAX_DATA_LENGTH; }
+	uint8_t getMaxMessageLength() override { return max_frame_len; }
 
 	/**
 	 * @brief Get MAC address of this device.
@@ -359,10 +1774,212 @@ protected:
 	bool synchronous_send;
 	bool tx_task_resumed = true;
 
+	uint8_t tx_max_in_flight = DEFAULT_TX_MAX_IN_FLIGHT;
+	uint8_t tx_no_mem_retries = DEFAULT_TX_NO_MEM_RETRIES;
+	uint32_t tx_backoff_max_ms = DEFAULT_TX_BACKOFF_MAX_MS;
+	uint32_t tx_completion_timeout_ms = DEFAULT_TX_COMPLETION_TIMEOUT_MS;
+	volatile uint16_t tx_in_flight = 0; ///< @brief Completions (`tx_cb`) still expected for frames handed to `esp_now_send`
+	portMUX_TYPE tx_mux = portMUX_INITIALIZER_UNLOCKED;
+
 	TaskHandle_t txTaskHandle;
-	QueueHandle_t txQueue;
+	QueueHandle_t txQueues[TX_PRIORITY_CLASSES] = {}; ///< @brief Indexes of committed slots waiting to be sent, one queue per priority class
+	SemaphoreHandle_t txPending = NULL;				  ///< @brief Given on every commit, wakes up the TX task
+	uint16_t tx_class_capacity[TX_PRIORITY_CLASSES] = {};
+	tx_drop_policy_t tx_class_drop_policy[TX_PRIORITY_CLASSES] = {TX_DROP_NEWEST, TX_DROP_NEWEST, TX_DROP_NEWEST};
+	uint32_t tx_class_max_wait_ms[TX_PRIORITY_CLASSES] = {0, DEFAULT_TX_INTERACTIVE_MAX_WAIT_MS, DEFAULT_TX_BULK_MAX_WAIT_MS};
+	tx_class_stats_t tx_class_stats[TX_PRIORITY_CLASSES] = {}; ///< @brief Updated under `tx_mux`
+	QueueHandle_t txFreeSlots = NULL; ///< @brief Indexes of free slots
+	QueueHandle_t txLibrarySlots = NULL; ///< @brief Indexes of free slots kept for the frames of the library, synchronous send mode only
+	int tx_user_slots = 0;				 ///< @brief Slots in `txFreeSlots`, the first ones. The others are kept for the library
+	uint16_t tx_slots_used = 0;		  ///< @brief Slots loaned, queued or in flight. Updated under `tx_mux`
+	tx_waiter_t tx_waiters[TX_WAITERS] = {}; ///< @brief Updated under `tx_mux`
+	std::atomic<uint8_t> tx_waiter_count{0}; ///< @brief Places of `tx_waiters` taken, nobody to wake when `0`
+	uint16_t tx_watermark_high = 0;
+	uint16_t tx_watermark_low = 0;
+	bool tx_above_high = false;		 ///< @brief Updated under `tx_mux`
+	uint32_t tx_watermark_crossings = 0; ///< @brief Updated under `tx_mux`, tells a stale event group update from the last one
+	EventGroupHandle_t tx_watermark_group = NULL;
+	EventBits_t tx_watermark_high_bit = 0;
+	EventBits_t tx_watermark_low_bit = 0;
+	tx_watermark_data txWatermark = nullptr;
+	tx_queue_item_t *tx_slots = nullptr;
+	tx_slot_state_t *tx_slot_states = nullptr;
+	tx_in_flight_t *tx_in_flight_slots = nullptr; ///< @brief Frames handed to `esp_now_send`, expired ones first. Updated under `tx_mux`
+	uint16_t tx_in_flight_capacity = 0;			  ///< @brief Twice the TX queue size: every slot in flight, and as many expired frames
+	uint16_t tx_in_flight_head = 0;
+	uint16_t tx_in_flight_count = 0;
+
+	std::atomic<uint32_t> stats_send_results[EASY_SEND_RESULTS] = {};
+	uint16_t stats_tx_queue_depth = 0;	   ///< @brief Updated under `tx_mux`
+	uint16_t stats_tx_queue_depth_max = 0; ///< @brief Updated under `tx_mux`
+	std::atomic<uint32_t> stats_esp_now_send_calls{0};
+	std::atomic<uint32_t> stats_esp_now_send_errors{0};
+	std::atomic<uint32_t> stats_esp_now_send_no_mem{0};
+	std::atomic<uint32_t> stats_tx_delivered{0};
+	std::atomic<uint32_t> stats_tx_failed{0};
+	std::atomic<uint32_t> stats_tx_completion_timeouts{0};
+	std::atomic<uint32_t> stats_tx_late_completions{0};
+	EasyLatencyHistogram stats_enqueue_to_send;
+	EasyLatencyHistogram stats_send_to_complete;
+
+	TaskHandle_t rxTaskHandle = NULL;
+	rx_frame_t *rx_ring = nullptr;
+	uint16_t rx_ring_size = 0;
+	uint16_t rx_max_batch = DEFAULT_RX_MAX_BATCH;
+	std::atomic<uint32_t> rx_ring_head{0}; ///< @brief Written only by `rx_cb`
+	std::atomic<uint32_t> rx_ring_tail{0}; ///< @brief Written only by the RX task
+	std::atomic<uint32_t> rx_received{0};
+	std::atomic<uint32_t> rx_delivered{0};
+	std::atomic<uint32_t> rx_overflows{0};
+	std::atomic<uint32_t> rx_dropped{0};
+	EasyDedup rx_dedup;					///< @brief Only used by `rx_cb`
+	volatile bool rx_dedup_enabled = false;
+	std::atomic<uint32_t> rx_duplicates{0};
+	rx_dedup_key_data rxDedupKey = nullptr;
+	frame_rcvd_batch_data dataReceivedBatch = nullptr;
+
+	tx_aggregate_t *tx_aggregates = nullptr; ///< @brief Open aggregates, `nullptr` when aggregation is disabled
+	uint8_t aggregation_max_open = 0;
+	uint8_t aggregation_max_message_len = DEFAULT_AGGREGATION_MAX_MESSAGE_LEN;
+	uint32_t aggregation_window_ms = DEFAULT_AGGREGATION_WINDOW_MS;
+	bool aggregation_enabled = false;		   ///< @brief Received aggregates are split
+	SemaphoreHandle_t aggregation_mutex = NULL; ///< @brief Guards the open aggregates and the TX counters, created once and kept
+	aggregation_stats_t aggregation_stats = {};
+	std::atomic<uint32_t> aggregation_rx_frames{0};
+	std::atomic<uint32_t> aggregation_rx_messages{0};
+	std::atomic<uint32_t> aggregation_rx_malformed{0};
+
+	bool fragmentation_enabled = false;
+	uint16_t fragmentation_max_message_len = MAX_DATA_LENGTH;
+	EasyReassembler<rx_reassembly_meta_t> reassembler;
+	std::atomic<uint16_t> fragment_next_id{0};
+	std::atomic<uint32_t> fragmentation_tx_messages{0};
+	std::atomic<uint32_t> fragmentation_tx_fragments{0};
+	std::atomic<uint32_t> fragmentation_rx_fragments{0};
+	std::atomic<uint32_t> fragmentation_rx_messages{0};
+	std::atomic<uint32_t> fragmentation_rx_duplicates{0};
+	std::atomic<uint32_t> fragmentation_rx_dropped{0};
+
+	reliable_peer_t *reliable_peers = nullptr; ///< @brief `nullptr` when reliable channels are disabled
+	uint8_t reliable_max_peers = 0;
+	uint8_t reliable_window = DEFAULT_RELIABLE_WINDOW;
+	uint8_t reliable_max_retries = DEFAULT_RELIABLE_MAX_RETRIES;
+	uint32_t reliable_ack_delay_ms = DEFAULT_RELIABLE_ACK_DELAY_MS;
+	portMUX_TYPE reliable_mux = portMUX_INITIALIZER_UNLOCKED;
+	SemaphoreHandle_t reliable_space = NULL; ///< @brief Given every time a send window slides
+	reliable_stats_t reliable_stats = {};	 ///< @brief Updated under `reliable_mux`
+	reliable_status_data reliableStatus = nullptr;
+
+	peer_group_t groups[MAX_GROUPS] = {};
+	group_send_t *group_sends = nullptr; ///< @brief Messages in progress, `nullptr` when groups are disabled
+	uint8_t group_max_sends = 0;
+	uint32_t group_ack_timeout_ms = DEFAULT_GROUP_ACK_TIMEOUT_MS;
+	uint8_t group_broadcast_min_members = DEFAULT_GROUP_BROADCAST_MIN_MEMBERS;
+	uint16_t group_next_id = 0;
+	portMUX_TYPE group_mux = portMUX_INITIALIZER_UNLOCKED;
+	group_stats_t group_stats = {}; ///< @brief Updated under `group_mux`
+	group_send_data groupSendResult = nullptr;
+	struct
+	{
+		uint8_t mac[MAC_ADDR_LEN];
+		uint16_t send_id;
+	} group_rx_recent[GROUP_RX_RECENT] = {}; ///< @brief Last group messages received, only touched by `rx_cb`
+	uint8_t group_rx_recent_next = 0;
 
 	peer_list_t peer_list;
+	EasyPeerTable<peer_t> peer_table; ///< @brief MAC index and age order of the peers kept in `peer_list`
+	portMUX_TYPE peers_mux = portMUX_INITIALIZER_UNLOCKED;
+
+	peer_t *peer_directory = nullptr;
+	EasyPeerTable<peer_t> directory_table; ///< @brief Logical peers, when the peer directory is enabled
+	std::atomic<uint32_t> directory_hits{0};
+	std::atomic<uint32_t> directory_misses{0};
+	std::atomic<uint32_t> directory_swaps{0};
+	std::atomic<uint32_t> directory_swap_failures{0};
+	std::atomic<uint32_t> directory_swap_time_total_us{0};
+	std::atomic<uint32_t> directory_swap_time_max_us{0};
+
+	bool channel_scheduling = false; ///< @brief New frames are grouped by the channel of their destination
+	uint32_t channel_max_latency_ms = DEFAULT_CHANNEL_MAX_LATENCY_MS;
+	tx_channel_group_t channel_groups[MAX_WIFI_CHANNEL + 1]; ///< @brief Frames held by the channel scheduler, touched by the TX task only
+	uint16_t channel_staged = 0;							 ///< @brief Frames in `channel_groups`, updated under `tx_mux`
+	uint8_t tx_channel = 0;									 ///< @brief Channel the radio is on, another one than `wifi_primary_channel` while the scheduler visits it
+	uint16_t channel_batch = 0;								 ///< @brief Frames to send on the current channel before the latency bound can move the radio
+	bool channel_peers_follow = false;						 ///< @brief ESP-NOW peers are registered on channel `0`, touched by the TX task only
+	uint32_t channel_since_us = 0;							 ///< @brief `micros()` of the arrival on the current channel, updated under `tx_mux`
+	uint64_t channel_dwell_us[MAX_WIFI_CHANNEL + 1] = {};	 ///< @brief Updated under `tx_mux`
+	channel_stats_t channel_stats = {};						 ///< @brief Updated under `tx_mux`
+
+	bool fair_scheduling = false; ///< @brief New frames are queued by destination
+	bool fair_active = false;	  ///< @brief The TX task takes the frames from the destination queues, until they are drained once disabled
+	tx_flow_t *fair_flows = nullptr; ///< @brief Destination queues, the last one shared. All of it under `tx_mux`
+	uint8_t fair_flow_count = 0;
+	uint16_t fair_destination_backlog = 0;
+	uint16_t fair_phy_rate_kbps = DEFAULT_FAIR_PHY_RATE_KBPS;
+	uint32_t fair_quantum_us = 0;					   ///< @brief Airtime added to a destination every turn, one frame of `MAX_DATA_LENGTH`
+	uint8_t fair_cursor[TX_PRIORITY_CLASSES] = {};	   ///< @brief Destination whose turn it is, per class
+	bool fair_turn_started[TX_PRIORITY_CLASSES] = {}; ///< @brief That destination got its quantum already
+	uint16_t fair_class_staged[TX_PRIORITY_CLASSES] = {};
+	uint16_t fair_staged = 0;	   ///< @brief Frames in the destination queues, updated under `tx_mux`
+	uint32_t fair_airtime_us = 0; ///< @brief Airtime of all destinations, for their share
+
+	uint8_t max_frame_len = MAX_DATA_LENGTH;	///< @brief Longest frame taken by the TX queue, `MAX_SEALED_DATA_LENGTH` with encryption enabled
+	volatile bool encryption_enabled = false;
+	peer_key_t *encryption_key_storage = nullptr;
+	EasyPeerTable<peer_key_t> encryption_keys; ///< @brief Keys of the peers, by MAC
+	EasyAead network_key;
+	bool network_key_set = false;
+	portMUX_TYPE keys_mux = portMUX_INITIALIZER_UNLOCKED; ///< @brief Guards the keys, they are copied out before use
+	uint32_t seal_epoch = 0;						   ///< @brief Touched by the TX task only
+	uint32_t seal_counter = 0;						   ///< @brief Touched by the TX task only
+	std::atomic<uint32_t> encryption_sealed{0};
+	std::atomic<uint32_t> encryption_sent_plain{0};
+	std::atomic<uint32_t> encryption_too_long{0};
+	std::atomic<uint32_t> encryption_opened{0};
+	std::atomic<uint32_t> encryption_auth_failures{0};
+	std::atomic<uint32_t> encryption_no_key{0};
+	std::atomic<uint32_t> encryption_plain_dropped{0};
+
+	volatile bool compression_enabled = false;
+	EasyLz::Dictionary *compression_dictionaries[MAX_COMPRESSION_DICTIONARIES] = {}; ///< @brief By id - 1, only changed while compression is disabled
+	EasyLz compressor;												  ///< @brief Working memory of the encoder, touched by the TX task only
+	uint8_t compression_buffer[MAX_DATA_LENGTH];					  ///< @brief Compressed frame before it goes back to its slot, touched by the TX task only
+	alignas(4) uint8_t rx_inflated[MAX_DATA_LENGTH];				  ///< @brief Decompressed frame, touched by `rx_cb` only
+	std::atomic<uint32_t> compression_compressed{0};
+	std::atomic<uint32_t> compression_not_compressed{0};
+	std::atomic<uint32_t> compression_bytes_in{0};
+	std::atomic<uint32_t> compression_bytes_out{0};
+	std::atomic<uint32_t> compression_encode_us{0};
+	std::atomic<uint32_t> compression_inflated{0};
+	std::atomic<uint32_t> compression_decode_us{0};
+	std::atomic<uint32_t> compression_errors{0};
+
+	typed_handler_t typed_handlers[MAX_MESSAGE_TYPES] = {}; ///< @brief Open addressing by type id, updated under `typed_mux`
+	uint8_t typed_handler_count = 0;						///< @brief Entries used, `0` skips the lookup
+	portMUX_TYPE typed_mux = portMUX_INITIALIZER_UNLOCKED;
+
+	volatile bool probes_enabled = false;
+	volatile bool frame_escaping = false; ///< @brief Set by `setFrameEscaping(...)`, the features escape on their own
+	probe_record_t *ping_records = nullptr; ///< @brief Timestamps of the probes of the running ping, updated under `probe_mux`
+	uint32_t *ping_rtts = nullptr;			///< @brief Round trips of the last ping, sorted for the percentiles
+	uint16_t ping_max_probes = 0;
+	bool ping_running = false;				///< @brief Updated under `probe_mux`
+	uint16_t ping_id = 0;					///< @brief Of the running or last ping, updated under `probe_mux`
+	uint16_t ping_count = 0;				///< @brief Probes of the running ping, updated under `probe_mux`
+	uint16_t ping_replies = 0;				///< @brief Replies of the running ping, updated under `probe_mux`
+	uint8_t ping_peer[MAC_ADDR_LEN] = {};
+	SemaphoreHandle_t ping_reply = NULL; ///< @brief Given on every reply of the running ping
+	portMUX_TYPE probe_mux = portMUX_INITIALIZER_UNLOCKED;
+
+	std::atomic<uint32_t> next_send_handle{1};
+	send_complete_data sendComplete = nullptr;
+	tx_message_state_t *tx_messages = nullptr; ///< @brief Fragmented messages in flight, one entry per TX slot, updated under `tx_mux`
+	send_completion_t *send_completions = nullptr; ///< @brief Ring for `pollSendCompletion(...)`, `nullptr` when tracking is disabled
+	uint16_t send_completions_size = 0;
+	uint16_t send_completions_head = 0;
+	uint16_t send_completions_count = 0;
+	std::atomic<uint32_t> send_completions_missed{0};
+	portMUX_TYPE send_tracking_mux = portMUX_INITIALIZER_UNLOCKED;
 
 	/* ==========> Helper Functions for the Core Functions <========== */
 
@@ -388,6 +2005,109 @@ protected:
 	 */
 	static void rx_cb(const uint8_t *mac_addr, const uint8_t *data, int data_len);
 
+	/**
+	 * @brief Instance `rx_cb` and `tx_cb` belong to, set by `begin(...)` and cleared by `stop()`
+	 * @note One per device: on the ESP32 a static, in host builds the slot of the simulated device
+	 */
+	static EasyEspNow *&radioOwner();
+
+	/**
+	 * @brief Copies a received frame and its metadata into the RX ring and wakes up the RX task
+	 * @return `true` if the frame was copied, `false` if it was dropped
+	 */
+	bool pushRXFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info);
+
+	/**
+	 * @brief Runs a received frame through the duplicate filter
+	 * @return `true` if the frame was already received and must be dropped
+	 */
+	bool isRXDuplicate(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_format_t *esp_now_frame);
+
+	/**
+	 * @brief Counts a received frame in the traffic counters of its source peer
+	 */
+	void countPeerRX(const uint8_t *mac_addr, int8_t rssi);
+
+	/**
+	 * @brief Checks and decrypts a received frame when encryption is enabled
+	 * @param data Frame as received, moved to `plain` when it was decrypted
+	 * @param data_len Length of the frame, updated along with `data`
+	 * @param plain Buffer of `MAX_DATA_LENGTH` bytes for the plaintext
+	 * @return `true` if the frame goes on, `false` if it is dropped
+	 */
+	bool openRXFrame(const uint8_t *mac_addr, const uint8_t *&data, int &data_len, uint8_t *plain);
+
+	/**
+	 * @brief Decompresses a received compressed frame into `rx_inflated`
+	 * @param data Compressed frame, moved to `rx_inflated`
+	 * @param data_len Length of the frame, updated along with `data`
+	 * @return `true` if the frame goes on, `false` if it is dropped
+	 */
+	bool inflateRXFrame(const uint8_t *mac_addr, const uint8_t *&data, int &data_len);
+
+	/**
+	 * @brief Sets or removes the handler of a message type in `typed_handlers`, see `onMessage<T>(...)`
+	 */
+	bool setTypedHandler(uint16_t type_id, uint8_t size, typed_message_invoke_t invoke, void (*handler)());
+
+	/**
+	 * @brief Finds the handler of a received typed message
+	 * @param handler Receives a copy of the entry, so it can be called outside of `typed_mux`
+	 * @return `true` if the frame is a typed message of the length of its type and the type has a handler
+	 */
+	bool findTypedHandler(const uint8_t *data, int data_len, typed_handler_t &handler);
+
+	/**
+	 * @brief Hands a received frame to the handler of its message type
+	 * @return `true` if a handler took it, `false` if it must be delivered as it is
+	 */
+	bool dispatchTypedMessage(const uint8_t *mac_addr, const uint8_t *data, int data_len, espnow_frame_recv_info_t *frame_info);
+
+	/**
+	 * @brief `typed_message_invoke_t` of a message type: calls the handler with the struct in place when `message` is aligned for it,
+	 * with a copy otherwise
+	 */
+	template <typename T>
+	static void invokeTypedHandler(void (*handler)(), const uint8_t *src_mac, const uint8_t *message, espnow_frame_recv_info_t *frame_info)
+	{
+		typed_message_data<T> typed = reinterpret_cast<typed_message_data<T>>(handler);
+		if (((uintptr_t)message & (alignof(T) - 1)) == 0)
+		{
+			typed(src_mac, *reinterpret_cast<const T *>(message), frame_info);
+			return;
+		}
+		alignas(T) uint8_t copy[sizeof(T)];
+		memcpy(copy, message, sizeof(T));
+		typed(src_mac, *reinterpret_cast<const T *>(copy), frame_info);
+	}
+
+	/**
+	 * @brief Counts a result of offering a frame to the TX queue in `getStats(...)`
+	 * @return `result`, so it can wrap a return value
+	 */
+	easy_send_error_t countSendResult(easy_send_error_t result);
+
+	/**
+	 * @brief Handles a frame built by the library (aggregate, fragment, ...) for a feature that is enabled
+	 * @return `true` if the frame was consumed, `false` if it must be delivered as it is
+	 */
+	bool receiveLibraryFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info);
+
+	/**
+	 * @brief Delivers the reassembled messages to `onDataReceived(...)` and gives their buffers back
+	 */
+	void deliverReassembledMessages();
+
+	/**
+	 * @brief Hands a received message to the user, through the RX ring when the RX task is running or straight to `onDataReceived(...)`
+	 */
+	void deliverRXFrame(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info);
+
+	/**
+	 * @brief Task that delivers the frames of the RX ring to the user callbacks, in batches
+	 */
+	static void easyEspNowRxTask(void *pvParameters);
+
 	/**
 	 * @brief Low Level Callback function of sending ESPNOW data
 	 * @param mac_addr Source peer MAC address, to where the message was sent to
@@ -403,6 +2123,357 @@ protected:
 	 *  `esp_now_send`
 	 */
 	static void easyEspNowTxQueueTask(void *pvParameters);
+
+	/**
+	 * @brief Allocates the TX slots and creates the queues that hold free and committed slot indexes
+	 * @return `true` if success, `false` if some allocation failed
+	 */
+	bool initTXSlots();
+
+	/**
+	 * @brief Frees the TX slots and deletes the queues that hold slot indexes
+	 */
+	void deinitTXSlots();
+
+	/**
+	 * @brief Converts a slot pointer to its index in the slot pool
+	 * @return index of the slot or `-1` if pointer does not belong to the pool
+	 */
+	int slotIndex(const tx_queue_item_t *slot);
+
+	/**
+	 * @brief Blocks the TX task while the number of frames in flight is at `max_in_flight`
+	 * @note Woken up by `tx_cb`. If no completion arrives within `tx_completion_timeout_ms` the frames in flight are
+	 * completed as failed, so a lost callback can not stall the TX queue forever
+	 */
+	void waitForTXCompletionSlot(uint8_t max_in_flight);
+
+	/**
+	 * @brief Calls `esp_now_send` for a slot and retries with exponential backoff only when it returns `ESP_ERR_ESPNOW_NO_MEM`
+	 * @param slot_index Slot to send. Stays in flight until all its `tx_cb` completions arrive
+	 * @param expected_completions Number of `tx_cb` calls that ESP-NOW will make for this frame
+	 * @return last error returned by `esp_now_send`
+	 */
+	esp_err_t sendWithBackoff(tx_slot_index_t slot_index, uint16_t expected_completions);
+
+	/**
+	 * @brief Enqueues a committed slot to the TX queue of its priority class and, if `synchronous`, waits for its delivery status
+	 * @param slot_index Slot with destination, payload and length already set
+	 * @param confirm_timeout_ms How long to wait for the delivery status if `synchronous`
+	 * @param priority Priority class of the slot
+	 * @param synchronous Frame of the application in synchronous send mode. Frames of the library never wait, they are sent
+	 * from the TX task and `rx_cb`, which can not block on their own completion
+	 * @return Returns sending status. 0 for success, any other value to indicate an error
+	 */
+	easy_send_error_t enqueueTXSlot(tx_slot_index_t slot_index, uint32_t confirm_timeout_ms, easy_tx_priority_t priority = DEFAULT_TX_PRIORITY,
+								   bool synchronous = false);
+
+	/**
+	 * @brief Takes the next slot to send: from the highest priority class that has one, unless a lower class waited past its limit
+	 * @param slot_index Receives the slot
+	 * @param wait How long to wait when all classes are empty
+	 * @return `true` if a slot was taken
+	 */
+	bool dequeueTXSlot(tx_slot_index_t *slot_index, TickType_t wait);
+
+	/**
+	 * @brief Counts a slot taken by the TX task in the counters of its priority class
+	 * @param promoted `true` if it went ahead of higher classes because it waited too long
+	 */
+	void countDequeuedTXSlot(tx_slot_index_t slot_index, bool promoted);
+
+	/**
+	 * @brief Gives a slot back to the free slots, crosses the low watermark and wakes the waiters it satisfies
+	 */
+	void freeTXSlot(tx_slot_index_t slot_index);
+
+	/**
+	 * @brief Takes a free slot from a pool and resets its bookkeeping
+	 * @param pool `txFreeSlots` or `txLibrarySlots`
+	 */
+	tx_queue_item_t *takeTXSlot(QueueHandle_t pool, TickType_t wait_ticks);
+
+	/**
+	 * @brief `acquireTXSlot(...)` for the frames of the library: takes a slot kept for them first, so in synchronous send mode
+	 * acknowledgements and replies do not wait for the one slot of the application, held by its blocked `send(...)`
+	 */
+	tx_queue_item_t *acquireLibraryTXSlot(TickType_t wait_ticks = 0);
+
+	/**
+	 * @brief Counts a slot taken or given back and signals the watermark it crossed, if any
+	 */
+	void countUsedTXSlot(bool taken);
+
+	/**
+	 * @brief Sets the bits of the watermark event group to the current side of the watermarks
+	 */
+	void signalTXWatermark();
+
+	/**
+	 * @brief Gives `wake` to every blocked task whose wait is over. Call after freeing or dequeuing a slot
+	 */
+	void wakeTXWaiters();
+
+	/**
+	 * @brief Tells if what `kind` waits for happened. Call under `tx_mux`
+	 */
+	bool txWaitSatisfied(tx_wait_t kind, uint16_t slots);
+
+	/**
+	 * @brief Blocks until what `kind` waits for happened, woken by `wakeTXWaiters()`
+	 */
+	bool waitForTX(tx_wait_t kind, uint16_t slots, TickType_t wait_ticks);
+
+	/**
+	 * @brief Moves the committed slots from the class queues to the group of their channel. Called by the TX task
+	 */
+	void stageChannelSlots();
+
+	/**
+	 * @brief `dequeueTXSlot(...)` of the channel scheduler: picks the channel to be on, switches to it and takes the next
+	 * slot of its group, by class as `dequeueTXSlot(...)` does
+	 */
+	bool dequeueChannelSlot(tx_slot_index_t *slot_index, TickType_t wait);
+
+	/**
+	 * @brief Moves the radio to another channel once the frames in flight are completed. Called by the TX task
+	 * @param latency `true` if the latency bound forced the change
+	 */
+	void switchTXChannel(uint8_t channel, bool latency);
+
+	/**
+	 * @brief Queue of a destination in the fair scheduler, taking one that is free or idle when it has none. Must be called with `tx_mux` taken
+	 * @return index in `fair_flows`, the shared queue if all are busy
+	 */
+	uint8_t fairFlow(const uint8_t *dst_address);
+
+	/**
+	 * @brief Gives back the place a slot took in the backlog of its destination when it is dropped before being staged
+	 */
+	void releaseFairBacklog(tx_slot_index_t slot_index);
+
+	/**
+	 * @brief Moves the committed slots from the class queues to the queue of their destination. Called by the TX task
+	 */
+	void stageFairSlots();
+
+	/**
+	 * @brief `dequeueTXSlot(...)` of the fair scheduler: picks the class as `dequeueTXSlot(...)` does, then the destination
+	 * by deficit round robin among the ones within their rate cap
+	 */
+	bool dequeueFairSlot(tx_slot_index_t *slot_index, TickType_t wait);
+
+	/**
+	 * @brief Next slot of a class by deficit round robin. Must be called with `tx_mux` taken
+	 * @param ready_in_us Lowered to the time until the first destination held back by its rate cap can send
+	 * @return slot, `TX_SLOT_NONE` if no destination of the class can send now
+	 */
+	tx_slot_index_t pickFairSlot(int priority, uint32_t now_us, uint32_t *ready_in_us);
+
+	/**
+	 * @brief Airtime of a frame of `len` payload bytes at the PHY rate of the fair scheduler
+	 */
+	uint32_t fairAirtimeUs(size_t len) const
+	{
+		return ESPNOW_AIR_PREAMBLE_US + (uint32_t)((len + ESPNOW_AIR_OVERHEAD_LEN) * 8000 / fair_phy_rate_kbps);
+	}
+
+	/**
+	 * @brief Sets the channel of every ESP-NOW peer, `0` to follow the radio. Used when the channel scheduler is enabled or disabled
+	 */
+	bool setEspNowPeersChannel(uint8_t channel);
+
+	/**
+	 * @brief Finishes a slot once its delivery status is known. Wakes up the synchronous sender waiting for it,
+	 * otherwise gives the slot back to the pool
+	 * @param slot_index Slot that was completed
+	 * @param status Delivery status of the slot
+	 */
+	void completeTXSlot(tx_slot_index_t slot_index, esp_now_send_status_t status);
+
+	/**
+	 * @brief Next message handle, never `EASY_SEND_HANDLE_NONE`
+	 */
+	easy_send_handle_t newSendHandle();
+
+	/**
+	 * @brief Checks if messages starting with `EASY_FRAME_MAGIC` are escaped: with `setFrameEscaping(...)` or a library frame feature enabled
+	 */
+	bool frameEscaping() const;
+
+	/**
+	 * @brief `commitTXSlot(...)` without the escape, for the frames of the library
+	 * @param synchronous Waits for the delivery status in synchronous send mode, only for the messages of the application
+	 */
+	easy_send_error_t queueTXSlot(tx_queue_item_t *slot, const uint8_t *dstAddress, size_t payload_len, uint32_t confirm_timeout_ms,
+								  easy_tx_priority_t priority = DEFAULT_TX_PRIORITY, easy_send_handle_t *handle = nullptr, bool synchronous = false);
+
+	/**
+	 * @brief Takes an entry of `tx_messages` for a fragmented message, its fragments point to it
+	 * @return Index of the entry, `TX_SLOT_NONE` if as many fragmented messages as TX slots are in flight
+	 */
+	tx_slot_index_t openTXMessage(easy_send_handle_t handle);
+
+	/**
+	 * @brief Frees the entry of a fragmented message whose send aborted. The fragments still in flight are not reported
+	 */
+	void closeTXMessage(tx_slot_index_t message, easy_send_handle_t handle);
+
+	/**
+	 * @brief Reports the completion of a message to `onSendComplete(...)` and to the ring of `pollSendCompletion(...)`
+	 */
+	void reportSendCompletion(const send_completion_t &completion);
+
+	/**
+	 * @brief Encrypts a slot in place with the key of its destination, right before it is sent. Left in clear if there is no key
+	 * @return `true` if the slot can be sent, `false` if it has no room for the overhead
+	 */
+	bool sealTXSlot(tx_slot_index_t slot_index);
+
+	/**
+	 * @brief Compresses a slot in place with the dictionary of its destination, right before it is sealed.
+	 * Left as it is if the destination does not compress or the frame would not get shorter
+	 */
+	void compressTXSlot(tx_slot_index_t slot_index);
+
+	/**
+	 * @brief Copies out the key to use with a peer
+	 * @param mac Peer, ignored for the network key
+	 * @param network `true` for the network key
+	 * @param key Receives the key, `nullptr` to only check that there is one
+	 * @return `true` if there is such a key
+	 */
+	bool findKey(const uint8_t *mac, bool network, EasyAead *key);
+
+	/**
+	 * @brief Packs a small message into the open aggregate of its destination, opening a new one if needed
+	 * @return Returns sending status. 0 for success, any other value to indicate an error
+	 */
+	easy_send_error_t aggregateMessage(const uint8_t *dst_address, const easy_iovec_t *fragments, size_t fragment_count, size_t payload_len, easy_tx_priority_t priority,
+									   easy_send_handle_t *handle);
+
+	/**
+	 * @brief Splits a message larger than one frame into fragments and enqueues them, in order
+	 * @return Returns sending status. 0 for success, any other value to indicate an error
+	 */
+	easy_send_error_t sendFragmented(const uint8_t *dstAddress, const easy_iovec_t *fragments, size_t fragment_count, size_t payload_len, uint32_t confirm_timeout_ms,
+									 easy_tx_priority_t priority, easy_send_handle_t *handle);
+
+	/**
+	 * @brief Hands an open aggregate to the TX queue. Must be called with `aggregation_mutex` taken
+	 */
+	void flushAggregate(tx_aggregate_t &aggregate, aggregate_flush_reason_t reason);
+
+	/**
+	 * @brief Flushes the aggregates whose window expired. Called by the TX task
+	 * @return ticks until the next aggregate expires, at most `max_wait`
+	 */
+	TickType_t flushExpiredAggregates(TickType_t max_wait);
+
+	/**
+	 * @brief Finds the reliable channel of a peer, claiming a free or idle one if it has none. Must be called under `reliable_mux`
+	 * @return channel or `nullptr` if all are busy
+	 */
+	reliable_peer_t *reliablePeer(const uint8_t *mac, bool create);
+
+	/**
+	 * @brief Puts the receive state of a peer in a reliable header and clears the pending acknowledgement. Must be called under `reliable_mux`
+	 */
+	void fillReliableAck(reliable_peer_t &peer, easy_reliable_header_t &header);
+
+	/**
+	 * @brief Hands a message of the send window to the TX queue, with the acknowledgement owed to the peer on it
+	 * @return `false` if there was no free TX slot, the message stays due
+	 */
+	bool transmitReliable(reliable_peer_t *peer, uint16_t seq);
+
+	/**
+	 * @brief Applies an acknowledgement received from a peer. Slides its send window and samples the round trip time
+	 */
+	void processReliableAck(const uint8_t *mac_addr, const easy_reliable_header_t &header);
+
+	/**
+	 * @brief Handles a reliable data frame: detects duplicates, updates the receive state and delivers new messages
+	 */
+	void receiveReliableData(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info);
+
+	/**
+	 * @brief Retransmits the messages whose timeout expired and sends the acknowledgements nobody carried. Called by the TX task
+	 * @return ticks until the next deadline, at most `max_wait`
+	 */
+	TickType_t serviceReliable(TickType_t max_wait);
+
+	/**
+	 * @brief Table where the group membership and traffic counters of the peers are kept: the peer directory when enabled, the ESP-NOW peers otherwise.
+	 * Must be called under `peers_mux`
+	 */
+	EasyPeerTable<peer_t> &groupPeerTable();
+
+	/**
+	 * @brief Hands the unicasts of a group message that wait for a TX slot to the TX queue
+	 * @return `false` if some are still waiting because there was no free TX slot
+	 */
+	bool transmitGroupUnicasts(uint8_t send_index);
+
+	/**
+	 * @brief Records the delivery status of a frame of a group message. Called when its TX slot completes
+	 */
+	void completeGroupFrame(uint8_t send_index, uint8_t member, esp_now_send_status_t status);
+
+	/**
+	 * @brief Reports a group message through `onGroupSendResult(...)` and frees it once every member has a result
+	 */
+	void finishGroupSend(uint8_t send_index);
+
+	/**
+	 * @brief Handles a group data frame: drops repeats, delivers the message and acknowledges it when asked
+	 */
+	void receiveGroupData(const uint8_t *mac_addr, const uint8_t *data, int data_len, const espnow_frame_recv_info_t *frame_info);
+
+	/**
+	 * @brief Applies the acknowledgement of a member to the group message it belongs to
+	 */
+	void processGroupAck(const uint8_t *mac_addr, const easy_group_header_t &header);
+
+	/**
+	 * @brief Sends a probe back to its sender with the time it arrived and the time the reply was queued. Called by `rx_cb`
+	 */
+	void answerProbe(const uint8_t *mac_addr, const uint8_t *data, int data_len, easy_probe_header_t header, int64_t rx_us);
+
+	/**
+	 * @brief Records the reply of a probe of the running ping. Called by `rx_cb`
+	 */
+	void receiveProbeReply(const uint8_t *mac_addr, const easy_probe_header_t &header, int64_t rx_us);
+
+	/**
+	 * @brief Records when a probe of the running ping was handed to `esp_now_send` (`sent`) or completed
+	 * @param probe `tx_slot_state_t::probe` of its slot
+	 */
+	void stampProbe(uint32_t probe, bool sent, int64_t at_us);
+
+	/**
+	 * @brief Repairs the broadcasts whose acknowledgement time expired and sends the unicasts that waited for a TX slot. Called by the TX task
+	 * @return ticks until the next deadline, at most `max_wait`
+	 */
+	TickType_t serviceGroups(TickType_t max_wait);
+
+	/**
+	 * @brief Registers a peer in ESP-NOW and in the table of ESP-NOW peers
+	 * @return error returned by `esp_now_add_peer`
+	 */
+	esp_err_t registerPeer(const uint8_t *peer_addr);
+
+	/**
+	 * @brief Makes sure the destination of a unicast frame is registered in ESP-NOW, swapping it in from the peer directory if needed
+	 * @param peer_addr Destination of the frame
+	 * @return `true` if the peer is registered in ESP-NOW or is unknown to the directory, `false` if no ESP-NOW slot could be freed
+	 */
+	bool swapInPeer(const uint8_t *peer_addr);
+
+	/**
+	 * @brief Counts the peers that receive a frame sent with `esp_now_send(NULL, ...)`, which is every peer but Broadcast
+	 */
+	uint16_t countUnicastPeers();
 };
 
 extern EasyEspNow easyEspNow;
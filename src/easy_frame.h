@@ -0,0 +1,228 @@
+#ifndef EASY_FRAME_H
+#define EASY_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Wire format of the frames built by the library itself (aggregates, ...). They start with a two bytes header,
+ * a magic byte and the frame type. Frames of a feature are only recognized by a receiver that has that feature enabled,
+ * all other frames are delivered untouched to the user callbacks.
+ */
+
+static const uint8_t EASY_FRAME_MAGIC = 0xE5;
+
+typedef enum : uint8_t
+{
+	EASY_FRAME_AGGREGATE = 1,	  ///< @brief Several small messages, each prefixed by its length
+	EASY_FRAME_FRAGMENT = 2,	  ///< @brief Piece of a message larger than one frame, followed by `easy_fragment_header_t`
+	EASY_FRAME_RELIABLE_DATA = 3, ///< @brief Message of a reliable channel, followed by `easy_reliable_header_t`
+	EASY_FRAME_RELIABLE_ACK = 4,  ///< @brief Standalone acknowledgement of a reliable channel, only `easy_reliable_header_t`
+	EASY_FRAME_GROUP_DATA = 5,	  ///< @brief Message to a peer group, followed by `easy_group_header_t`
+	EASY_FRAME_GROUP_ACK = 6,	  ///< @brief Member acknowledging a group message, only `easy_group_header_t`
+	EASY_FRAME_SEALED = 7,		  ///< @brief Encrypted frame, followed by `easy_sealed_header_t`, the ciphertext and the tag
+	EASY_FRAME_COMPRESSED = 8,	  ///< @brief Compressed frame, followed by `easy_compressed_header_t` and the `EasyLz` stream of the original frame
+	EASY_FRAME_TYPED = 9,		  ///< @brief Message sent by `send<T>(...)`, followed by `easy_typed_header_t` and the bytes of the struct
+	EASY_FRAME_PROBE = 10,		  ///< @brief Latency probe of `ping(...)` or its reply, followed by `easy_probe_header_t` and padding up to the probe size
+	EASY_FRAME_ESCAPED = 11,	  ///< @brief Message of the application that starts with `EASY_FRAME_MAGIC`, follows as it is. Recognized while any feature or `setFrameEscaping(...)` is enabled
+} easy_frame_type_t;
+
+typedef struct __attribute__((packed))
+{
+	uint8_t magic; /**< `EASY_FRAME_MAGIC`*/
+	uint8_t type;  /**< `easy_frame_type_t`*/
+} easy_frame_header_t;
+
+/**
+ * Follows the frame header of a fragment. All fragments of a message but the last one carry the same number of bytes,
+ * so the position of a fragment in the message is `offset / fragment length`
+ */
+typedef struct __attribute__((packed))
+{
+	uint16_t message_id; /**< Same for all the fragments of a message, per sender*/
+	uint16_t total_len;	 /**< Length of the whole message*/
+	uint16_t offset;	 /**< Position of this fragment in the message*/
+} easy_fragment_header_t;
+
+static const uint8_t EASY_RELIABLE_ACK_VALID = 0x01; ///< @brief `ack` and `sack` carry the receive state of the sender of the frame
+static const uint8_t EASY_RELIABLE_SYN = 0x02;		 ///< @brief Sender has not been acknowledged yet since it started, receiver may resynchronize on this frame
+
+/**
+ * Follows the frame header of reliable channel frames. Every data frame carries the receive state of its sender too,
+ * so acknowledgements ride on reverse traffic whenever there is some
+ */
+typedef struct __attribute__((packed))
+{
+	uint16_t seq;  /**< Sequence number of the message, data frames only*/
+	uint16_t ack;  /**< Cumulative: next sequence number expected, all the previous ones were received*/
+	uint32_t sack; /**< Selective: bit `i` set means `ack + 1 + i` was received as well*/
+	uint8_t flags; /**< `EASY_RELIABLE_ACK_VALID`, `EASY_RELIABLE_SYN`*/
+} easy_reliable_header_t;
+
+static const uint8_t EASY_GROUP_ACK_REQUESTED = 0x01; ///< @brief Sender tracks the members through acknowledgements, not through the MAC layer
+
+/**
+ * Follows the frame header of group frames. Groups are known on the air by a hash of their name,
+ * so members only need to join a group by the same name
+ */
+typedef struct __attribute__((packed))
+{
+	uint16_t group;	  /**< `easyGroupHash(...)` of the group name*/
+	uint16_t send_id; /**< Same for all the frames of a group message, per sender*/
+	uint8_t flags;	  /**< `EASY_GROUP_ACK_REQUESTED`*/
+} easy_group_header_t;
+
+static const uint8_t EASY_SEALED_NETWORK_KEY = 0x01; ///< @brief Sealed with the network key, not with the key of the sender and receiver pair
+
+/**
+ * Follows the frame header of an encrypted frame. The nonce is the last four bytes of the sender MAC, `epoch` and `counter`,
+ * the frame header and this header are authenticated along with the ciphertext. The ciphertext of the original frame follows,
+ * then the tag
+ */
+typedef struct __attribute__((packed))
+{
+	uint8_t flags;	  /**< `EASY_SEALED_NETWORK_KEY`*/
+	uint32_t epoch;	  /**< Drawn at random when the sender enables encryption, so a restart never reuses a nonce*/
+	uint32_t counter; /**< Incremented on every frame the sender encrypts*/
+} easy_sealed_header_t;
+
+/**
+ * Follows the frame header of a compressed frame. Sender and receiver must have registered the same dictionary under that id
+ */
+typedef struct __attribute__((packed))
+{
+	uint8_t dictionary; /**< Pre-shared dictionary the frame was compressed with, `0` for none*/
+} easy_compressed_header_t;
+
+/**
+ * Follows the frame header of a typed message. Typed messages travel like any other message, through aggregates, reliable
+ * channels and groups, and are recognized where messages are delivered
+ */
+typedef struct __attribute__((packed))
+{
+	uint16_t type_id; /**< `EasyMessageType<T>::id()` of the struct that follows*/
+} easy_typed_header_t;
+
+static const uint8_t EASY_PROBE_REPLY = 0x01; ///< @brief Reply of the responder, carries its timestamps
+
+/**
+ * Follows the frame header of a probe. The responder sends the probe back with the same length, its flags set to
+ * `EASY_PROBE_REPLY` and its own `esp_timer_get_time()` of the arrival and of the reply, so the sender can take the time
+ * the reply waited at the responder out of the round trip and estimate the offset between the two clocks
+ */
+typedef struct __attribute__((packed))
+{
+	uint8_t flags;	   /**< `EASY_PROBE_REPLY`*/
+	uint16_t ping_id;  /**< Same for all the probes of a `ping(...)`, per sender*/
+	uint16_t seq;	   /**< Probe number in the ping*/
+	int64_t rx_us;	   /**< Reply only: responder clock when the probe reached `rx_cb`*/
+	int64_t reply_us;  /**< Reply only: responder clock when the reply was queued*/
+} easy_probe_header_t;
+
+static const uint8_t EASY_FRAME_HEADER_LEN = sizeof(easy_frame_header_t);
+static const uint8_t EASY_AGGREGATE_RECORD_HEADER_LEN = 1; ///< @brief Length byte in front of every message of an aggregate
+static const uint8_t EASY_FRAGMENT_HEADER_LEN = sizeof(easy_fragment_header_t);
+static const uint8_t EASY_MAX_FRAGMENTS = 32; ///< @brief Fragments of one message, one bit each in the reassembly bitmap
+static const uint8_t EASY_RELIABLE_HEADER_LEN = sizeof(easy_reliable_header_t);
+static const uint8_t EASY_RELIABLE_MAX_WINDOW = 32; ///< @brief Frames in flight per peer, bounded by the `sack` bitmap
+static const uint8_t EASY_GROUP_HEADER_LEN = sizeof(easy_group_header_t);
+static const uint8_t EASY_GROUP_MAX_MEMBERS = 32; ///< @brief Members of one group, one bit each in the delivery bitmap
+static const uint8_t EASY_SEALED_HEADER_LEN = sizeof(easy_sealed_header_t);
+static const uint8_t EASY_SEALED_TAG_LEN = 16;
+static const uint8_t EASY_SEALED_OVERHEAD = EASY_FRAME_HEADER_LEN + EASY_SEALED_HEADER_LEN + EASY_SEALED_TAG_LEN; ///< @brief Bytes an encrypted frame takes on top of the original one
+static const uint8_t EASY_COMPRESSED_HEADER_LEN = sizeof(easy_compressed_header_t);
+static const uint8_t EASY_COMPRESSED_OVERHEAD = EASY_FRAME_HEADER_LEN + EASY_COMPRESSED_HEADER_LEN; ///< @brief Headers in front of the compressed stream
+static const uint8_t EASY_TYPED_HEADER_LEN = sizeof(easy_typed_header_t);
+static const uint8_t EASY_TYPED_OVERHEAD = EASY_FRAME_HEADER_LEN + EASY_TYPED_HEADER_LEN; ///< @brief Headers in front of a typed message, 4 bytes so the struct stays aligned
+static const uint8_t EASY_PROBE_HEADER_LEN = sizeof(easy_probe_header_t);
+static const uint8_t EASY_PROBE_OVERHEAD = EASY_FRAME_HEADER_LEN + EASY_PROBE_HEADER_LEN; ///< @brief Shortest probe
+
+/**
+ * @brief Compares sequence numbers across wrap around
+ * @return negative if `a` is before `b`, `0` if equal, positive if after
+ */
+static inline int16_t easySeqDiff(uint16_t a, uint16_t b)
+{
+	return (int16_t)(a - b);
+}
+
+/**
+ * @brief Hash of a group name as carried by `easy_group_header_t` (FNV-1a folded to 16 bits)
+ */
+static inline uint16_t easyGroupHash(const char *name)
+{
+	uint32_t h = 2166136261u;
+	while (*name)
+	{
+		h ^= (uint8_t)*name++;
+		h *= 16777619u;
+	}
+	return (uint16_t)(h ^ (h >> 16));
+}
+
+/**
+ * @brief Nonce of an encrypted frame: the last four bytes of the sender MAC, then `epoch` and `counter` as carried on the air
+ */
+static inline void easySealedNonce(const uint8_t *sender_mac, const easy_sealed_header_t &header, uint8_t nonce[12])
+{
+	memcpy(nonce, sender_mac + 2, 4);
+	memcpy(nonce + 4, &header.epoch, sizeof(header.epoch));
+	memcpy(nonce + 8, &header.counter, sizeof(header.counter));
+}
+
+/**
+ * @brief Checks if a frame starts with the header of a library frame of the given type
+ */
+static inline bool easyFrameIs(const uint8_t *data, int len, easy_frame_type_t type)
+{
+	return len >= EASY_FRAME_HEADER_LEN && data[0] == EASY_FRAME_MAGIC && data[1] == type;
+}
+
+/**
+ * @brief Checks if a message of the application could be taken for a library frame by the receiver, and must be sent escaped.
+ * Typed messages are not: they are delivered like the other messages, whatever starts them
+ */
+static inline bool easyFrameNeedsEscape(const uint8_t *data, size_t len)
+{
+	return len >= EASY_FRAME_HEADER_LEN && data[0] == EASY_FRAME_MAGIC && data[1] != EASY_FRAME_TYPED;
+}
+
+/**
+ * @brief Walks the messages of an aggregate frame
+ * @param data Aggregate frame, header included
+ * @param len Length of the frame
+ * @param offset Position of the next record, start with `EASY_FRAME_HEADER_LEN`. Moved past the returned message
+ * @param message Receives the start of the message
+ * @param message_len Receives the length of the message
+ * @return `true` if a message was returned, `false` at the end of the frame or if the record is malformed
+ */
+static inline bool easyAggregateNext(const uint8_t *data, int len, int &offset, const uint8_t *&message, int &message_len)
+{
+	if (offset + EASY_AGGREGATE_RECORD_HEADER_LEN > len)
+		return false;
+	int record_len = data[offset];
+	if (record_len == 0 || offset + EASY_AGGREGATE_RECORD_HEADER_LEN + record_len > len)
+		return false;
+	message = data + offset + EASY_AGGREGATE_RECORD_HEADER_LEN;
+	message_len = record_len;
+	offset += EASY_AGGREGATE_RECORD_HEADER_LEN + record_len;
+	return true;
+}
+
+/**
+ * @brief Checks that the records of an aggregate frame cover it exactly
+ * @return number of messages in the frame, `0` if it is malformed
+ */
+static inline int easyAggregateCount(const uint8_t *data, int len)
+{
+	int offset = EASY_FRAME_HEADER_LEN;
+	int count = 0;
+	const uint8_t *message;
+	int message_len;
+	while (easyAggregateNext(data, len, offset, message, message_len))
+		count++;
+	return offset == len ? count : 0;
+}
+
+#endif
@@ -0,0 +1,359 @@
+#ifdef EASY_LOG_DEFERRED
+
+#include <Arduino.h>
+#include <new>
+
+#include "easy_log.h"
+#include "easy_debug.h"
+
+static const char *const LOG_LABELS[] = {"NONE", "MONITOR", "ERROR", "WARNING", "INFO", "DEBUG", "VERBOSE"};
+static const uint8_t LOG_MAX_STRING_LEN = 64; ///< @brief `%s` arguments are cut here, a dangling pointer cannot run away
+static const uint16_t LOG_LINE_LEN = 256;
+
+static EasyLogRing log_ring;
+static std::atomic<bool> log_started{false};
+static std::atomic<bool> log_stop{false};
+static std::atomic<bool> log_task_running{false};
+static bool log_binary = false;
+static std::atomic<uint32_t> log_written{0};
+static std::atomic<uint32_t> log_flushed{0};
+static std::atomic<uint32_t> log_dropped{0};
+
+bool EasyLogRing::begin(uint16_t size)
+{
+	end();
+	if (size < 2 || (size & (size - 1)) != 0)
+		return false;
+
+	cells = new (std::nothrow) cell_t[size];
+	if (!cells)
+		return false;
+
+	// cell `i` is first written at position `i`
+	for (uint16_t i = 0; i < size; i++)
+		cells[i].turn.store(i, std::memory_order_relaxed);
+	mask = size - 1;
+	write_position.store(0, std::memory_order_relaxed);
+	read_position = 0;
+	return true;
+}
+
+void EasyLogRing::end()
+{
+	delete[] cells;
+	cells = nullptr;
+	mask = 0;
+}
+
+easy_log_record_t *EasyLogRing::reserve(uint32_t &position)
+{
+	uint32_t current = write_position.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		cell_t &cell = cells[current & mask];
+		int32_t lag = (int32_t)(cell.turn.load(std::memory_order_acquire) - current);
+		if (lag == 0)
+		{
+			if (write_position.compare_exchange_weak(current, current + 1, std::memory_order_relaxed))
+			{
+				position = current;
+				return &cell.record;
+			}
+		}
+		else if (lag < 0)
+		{
+			// cell still holds the record of the previous lap
+			return nullptr;
+		}
+		else
+		{
+			current = write_position.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void EasyLogRing::commit(uint32_t position)
+{
+	cells[position & mask].turn.store(position + 1, std::memory_order_release);
+}
+
+bool EasyLogRing::take(easy_log_record_t &record)
+{
+	cell_t &cell = cells[read_position & mask];
+	if ((int32_t)(cell.turn.load(std::memory_order_acquire) - (read_position + 1)) < 0)
+		return false;
+
+	record = cell.record;
+	cell.turn.store(read_position + mask + 1, std::memory_order_release);
+	read_position++;
+	return true;
+}
+
+size_t easyLogFormat(char *out, size_t size, const char *format, const uint32_t *args, uint8_t words)
+{
+	if (size == 0)
+		return 0;
+
+	uint8_t available = words < EASY_LOG_MAX_WORDS ? words : EASY_LOG_MAX_WORDS;
+	uint8_t next = 0;
+	size_t len = 0;
+	auto append = [&](int written)
+	{
+		if (written > 0)
+			len = len + written < size ? len + written : size - 1;
+	};
+
+	const char *p = format;
+	while (*p && len < size - 1)
+	{
+		if (*p != '%')
+		{
+			out[len++] = *p++;
+			continue;
+		}
+		if (p[1] == '%')
+		{
+			out[len++] = '%';
+			p += 2;
+			continue;
+		}
+
+		// rebuild the conversion with `*` resolved and the length modifier matching the words it takes
+		char spec[40];
+		size_t spec_len = 0;
+		bool has_precision = false;
+		bool wide = false;
+		spec[spec_len++] = *p++;
+		while (*p && strchr("-+ #0", *p) && spec_len < 8)
+			spec[spec_len++] = *p++;
+		for (int part = 0; part < 2; part++)
+		{
+			if (part == 1)
+			{
+				if (*p != '.')
+					break;
+				has_precision = true;
+				spec[spec_len++] = *p++;
+			}
+			if (*p == '*')
+			{
+				p++;
+				int value = next < available ? (int32_t)args[next] : 0;
+				next++;
+				spec_len += snprintf(spec + spec_len, 6, "%d", value < -9999 ? -9999 : (value > 9999 ? 9999 : value));
+			}
+			while (*p >= '0' && *p <= '9')
+			{
+				if (spec_len < 16)
+					spec[spec_len++] = *p;
+				p++;
+			}
+		}
+		while (*p && strchr("hlLqjzt", *p))
+		{
+			if (*p == 'j' || *p == 'q' || (*p == 'l' && p[1] == 'l'))
+				wide = true;
+			if (*p == 'l' && p[1] == 'l')
+				p++;
+			p++;
+		}
+
+		char conversion = *p;
+		if (!conversion)
+			break;
+		p++;
+
+		uint8_t needed = (wide || strchr("fFeEgGaA", conversion)) ? 2 : 1;
+		if (conversion == 'n')
+			continue;
+		if (next + needed > available)
+		{
+			// argument was not kept, the record had more words than fit
+			append(snprintf(out + len, size - len, "?"));
+			next += needed;
+			continue;
+		}
+
+		const uint32_t *value = args + next;
+		next += needed;
+		uint64_t value64 = needed == 2 ? ((uint64_t)value[1] << 32) | value[0] : value[0];
+		switch (conversion)
+		{
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			if (wide)
+			{
+				spec[spec_len++] = 'l';
+				spec[spec_len++] = 'l';
+			}
+			spec[spec_len++] = conversion;
+			spec[spec_len] = 0;
+			if (wide)
+				append(snprintf(out + len, size - len, spec, (long long)value64));
+			else
+				append(snprintf(out + len, size - len, spec, (int)value[0]));
+			break;
+		case 'c':
+			spec[spec_len++] = conversion;
+			spec[spec_len] = 0;
+			append(snprintf(out + len, size - len, spec, (int)value[0]));
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+		{
+			double number;
+			memcpy(&number, &value64, sizeof(number));
+			spec[spec_len++] = conversion;
+			spec[spec_len] = 0;
+			append(snprintf(out + len, size - len, spec, number));
+			break;
+		}
+		case 's':
+		{
+			const char *text = (const char *)(uintptr_t)value[0];
+			if (!text)
+				text = "(null)";
+			if (!has_precision)
+				spec_len += snprintf(spec + spec_len, 4, ".%u", LOG_MAX_STRING_LEN);
+			spec[spec_len++] = 's';
+			spec[spec_len] = 0;
+			append(snprintf(out + len, size - len, spec, text));
+			break;
+		}
+		case 'p':
+			append(snprintf(out + len, size - len, "%p", (void *)(uintptr_t)value[0]));
+			break;
+		default:
+			break;
+		}
+	}
+
+	out[len] = 0;
+	return len;
+}
+
+static void easyLogPrint(const easy_log_record_t &record)
+{
+	char line[LOG_LINE_LEN];
+	const char *label = record.level < sizeof(LOG_LABELS) / sizeof(LOG_LABELS[0]) ? LOG_LABELS[record.level] : "?";
+	int header = snprintf(line, sizeof(line), "[%lu] [%s] [%s]: ", (unsigned long)record.timestamp_ms, label,
+						  (const char *)(uintptr_t)record.tag);
+	if (header < 0 || header >= (int)sizeof(line))
+		header = 0;
+	easyLogFormat(line + header, sizeof(line) - header, (const char *)(uintptr_t)record.format, record.args, record.words);
+	Serial.println(line);
+}
+
+static void easyLogFlush(const easy_log_record_t &record)
+{
+	if (log_binary)
+		Serial.write((const uint8_t *)&record, sizeof(record));
+	else
+		easyLogPrint(record);
+}
+
+static void easyLogFlushTask(void *pvParameters)
+{
+	easy_log_record_t record;
+	for (;;)
+	{
+		bool stop = log_stop.load(std::memory_order_acquire);
+		while (log_ring.take(record))
+		{
+			easyLogFlush(record);
+			log_flushed.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (stop)
+			break;
+		vTaskDelay(pdMS_TO_TICKS(EASY_LOG_FLUSH_INTERVAL_MS));
+	}
+
+	log_task_running.store(false, std::memory_order_release);
+	vTaskDelete(NULL);
+}
+
+void easyLogWrite(easy_log_record_t &record)
+{
+	record.timestamp_ms = millis();
+	if (!log_started.load(std::memory_order_acquire))
+	{
+		easyLogPrint(record);
+		return;
+	}
+
+	uint32_t position;
+	easy_log_record_t *cell = log_ring.reserve(position);
+	if (!cell)
+	{
+		log_dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	memcpy(cell, &record, sizeof(record));
+	log_ring.commit(position);
+	log_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool easyLogBegin(uint16_t ring_size, bool binary, UBaseType_t task_priority, BaseType_t task_core)
+{
+	if (log_started.load(std::memory_order_acquire))
+		easyLogEnd();
+
+	if (!log_ring.begin(ring_size))
+		return false;
+
+	log_binary = binary;
+	log_stop.store(false, std::memory_order_relaxed);
+	log_task_running.store(true, std::memory_order_relaxed);
+	log_started.store(true, std::memory_order_release);
+	if (xTaskCreateUniversal(easyLogFlushTask, "easy_log", 4096, NULL, task_priority, NULL, task_core) != pdPASS)
+	{
+		log_started.store(false, std::memory_order_release);
+		log_task_running.store(false, std::memory_order_relaxed);
+		log_ring.end();
+		return false;
+	}
+	return true;
+}
+
+void easyLogEnd()
+{
+	if (!log_started.load(std::memory_order_acquire))
+		return;
+
+	// new records are printed right away from now on, the task drains what is left
+	log_started.store(false, std::memory_order_release);
+	log_stop.store(true, std::memory_order_release);
+	while (log_task_running.load(std::memory_order_acquire))
+		vTaskDelay(pdMS_TO_TICKS(EASY_LOG_FLUSH_INTERVAL_MS));
+	log_ring.end();
+}
+
+easy_log_stats_t easyLogStats(bool reset)
+{
+	easy_log_stats_t stats;
+	if (reset)
+	{
+		stats.written = log_written.exchange(0, std::memory_order_relaxed);
+		stats.flushed = log_flushed.exchange(0, std::memory_order_relaxed);
+		stats.dropped = log_dropped.exchange(0, std::memory_order_relaxed);
+	}
+	else
+	{
+		stats.written = log_written.load(std::memory_order_relaxed);
+		stats.flushed = log_flushed.load(std::memory_order_relaxed);
+		stats.dropped = log_dropped.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef EASY_LOG_H
+#define EASY_LOG_H
+
+/*
+ * Deferred logging, enabled by building with `EASY_LOG_DEFERRED` defined.
+ *
+ * The log macros of `easy_debug.h` do not format anything: they write the address of the format string, the address of
+ * the tag and the raw arguments into a lock-free ring. A low priority task started with `easyLogBegin(...)` takes the records
+ * out and either formats them to `Serial`, or writes them as they are (binary) to be decoded on a host with
+ * `extras/easy_log_decode.py` and the firmware ELF, which holds the format strings.
+ *
+ * Arguments are kept as 32 bit words, so only 32 bit targets are supported. `%s` arguments are kept as pointers:
+ * they must still point to the string when the record is flushed, string literals always do.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const uint8_t EASY_LOG_MAX_WORDS = 10;		 ///< @brief Argument words kept per record, a MAC takes 6
+static const uint16_t EASY_LOG_RECORD_SYNC = 0x5EA1; ///< @brief Starts every binary record, lets the decoder find records in a mixed stream
+static const uint16_t DEFAULT_EASY_LOG_RING_SIZE = 64;
+static const uint32_t EASY_LOG_FLUSH_INTERVAL_MS = 20; ///< @brief Flush task sleeps this long when the ring is empty
+
+/**
+ * One log record, as kept in the ring and as written in binary mode (little endian, 56 bytes).
+ * Every field is naturally aligned, so the layout needs no packing
+ */
+typedef struct
+{
+	uint16_t sync;						  /**< `EASY_LOG_RECORD_SYNC`*/
+	uint8_t level;						  /**< `LOG_ERROR`, `LOG_DEBUG`, ...*/
+	uint8_t words;						  /**< Argument words written by the caller, can be more than kept*/
+	uint32_t format;					  /**< Address of the format string*/
+	uint32_t tag;						  /**< Address of the tag*/
+	uint32_t timestamp_ms;				  /**< `millis()` when the record was written*/
+	uint32_t args[EASY_LOG_MAX_WORDS];	  /**< Arguments, 64 bit ones and doubles take two words*/
+} easy_log_record_t;
+
+static_assert(sizeof(easy_log_record_t) == 56, "Binary log records are decoded as 56 bytes");
+
+/**
+ * Counters of the deferred log
+ */
+typedef struct
+{
+	uint32_t written; /**< Records written to the ring*/
+	uint32_t flushed; /**< Records taken out by the flush task*/
+	uint32_t dropped; /**< Records dropped because the ring was full*/
+} easy_log_stats_t;
+
+/**
+ * Bounded multi-producer single-consumer ring. Every cell carries a sequence number telling whose turn it is,
+ * so producers only race on the position counter and never block each other or the consumer
+ */
+class EasyLogRing
+{
+public:
+	/**
+	 * @param size Records, power of two
+	 */
+	bool begin(uint16_t size);
+	void end();
+
+	/**
+	 * @brief Reserves a cell, the caller fills it and calls `commit(...)`
+	 * @return cell or `nullptr` if the ring is full
+	 */
+	easy_log_record_t *reserve(uint32_t &position);
+	void commit(uint32_t position);
+
+	/**
+	 * @brief Copies the oldest committed record out of the ring
+	 * @return `false` if there is none
+	 */
+	bool take(easy_log_record_t &record);
+
+	bool active() const { return cells != nullptr; }
+
+private:
+	typedef struct
+	{
+		std::atomic<uint32_t> turn;
+		easy_log_record_t record;
+	} cell_t;
+
+	cell_t *cells = nullptr;
+	uint32_t mask = 0;
+	std::atomic<uint32_t> write_position{0};
+	uint32_t read_position = 0;
+};
+
+/**
+ * @brief Starts the deferred log: allocates the ring and the flush task
+ * @param ring_size Records the ring can hold, power of two
+ * @param binary `true` to write the records as they are for `extras/easy_log_decode.py`, `false` to format them on the device
+ * @param task_priority Priority of the flush task, keep it low
+ * @param task_core Core where the flush task runs
+ * @return `true` if success, `false` if some parameter is invalid or allocation failed
+ * @note Until it is called, records are formatted and printed right away
+ */
+bool easyLogBegin(uint16_t ring_size = DEFAULT_EASY_LOG_RING_SIZE, bool binary = false, UBaseType_t task_priority = 0,
+				  BaseType_t task_core = tskNO_AFFINITY);
+
+/**
+ * @brief Flushes what is in the ring, stops the flush task and frees the ring
+ * @note Call it when no task logs anymore, a log being written to the ring while it is freed is not guarded against
+ */
+void easyLogEnd();
+
+/**
+ * @brief Returns the counters of the deferred log
+ * @param reset `true` to reset the counters after reading them
+ */
+easy_log_stats_t easyLogStats(bool reset = false);
+
+/**
+ * @brief Formats a record like `printf` would have, from its argument words
+ * @return length written, without the terminating zero
+ */
+size_t easyLogFormat(char *out, size_t size, const char *format, const uint32_t *args, uint8_t words);
+
+/**
+ * @brief Writes a record to the ring, or prints it right away when the ring is not started
+ */
+void easyLogWrite(easy_log_record_t &record);
+
+namespace easy_log
+{
+	// arguments are split into 32 bit words the same way `easyLogFormat(...)` and the host decoder read them back
+
+	inline void put(easy_log_record_t &record, uint32_t word)
+	{
+		if (record.words < EASY_LOG_MAX_WORDS)
+			record.args[record.words] = word;
+		if (record.words < 0xFF)
+			record.words++;
+	}
+
+	template <typename T>
+	inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type pack(easy_log_record_t &record, T value)
+	{
+		uint64_t word = (uint64_t)value;
+		put(record, (uint32_t)word);
+		if (sizeof(T) > 4)
+			put(record, (uint32_t)(word >> 32));
+	}
+
+	inline void pack(easy_log_record_t &record, double value)
+	{
+		uint64_t word;
+		memcpy(&word, &value, sizeof(word));
+		put(record, (uint32_t)word);
+		put(record, (uint32_t)(word >> 32));
+	}
+
+	inline void pack(easy_log_record_t &record, float value)
+	{
+		pack(record, (double)value);
+	}
+
+	template <typename T>
+	inline void pack(easy_log_record_t &record, T *value)
+	{
+		put(record, (uint32_t)(uintptr_t)value);
+	}
+
+	inline void packAll(easy_log_record_t &record) {}
+
+	template <typename T, typename... Rest>
+	inline void packAll(easy_log_record_t &record, T value, Rest... rest)
+	{
+		pack(record, value);
+		packAll(record, rest...);
+	}
+}
+
+/**
+ * @brief Hot path of the deferred log macros: a handful of stores, no formatting
+ */
+template <typename... Args>
+inline void easyLogDeferred(uint8_t level, const char *tag, const char *format, Args... args)
+{
+	static_assert(sizeof(void *) == 4, "Deferred logging keeps pointers in 32 bit words");
+	easy_log_record_t record;
+	record.sync = EASY_LOG_RECORD_SYNC;
+	record.level = level;
+	record.words = 0;
+	record.format = (uint32_t)(uintptr_t)format;
+	record.tag = (uint32_t)(uintptr_t)tag;
+	easy_log::packAll(record, args...);
+	easyLogWrite(record);
+}
+
+#endif
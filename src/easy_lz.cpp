@@ -0,0 +1,149 @@
+#include <string.h>
+
+#include "easy_lz.h"
+
+static inline size_t matchLength(const uint8_t *a, const uint8_t *b, size_t max)
+{
+	size_t n = 0;
+	while (n < max && a[n] == b[n])
+		n++;
+	return n;
+}
+
+bool EasyLz::Dictionary::set(const uint8_t *dictionary, uint16_t dictionary_len)
+{
+	if (dictionary_len > MAX_DICTIONARY_LEN || (!dictionary && dictionary_len))
+		return false;
+
+	data = dictionary;
+	len = dictionary_len;
+	memset(head, 0xFF, sizeof(head));
+	for (uint16_t i = 0; i + MIN_MATCH <= len; i++)
+	{
+		uint16_t h = hash(data + i);
+		prev[i] = head[h];
+		head[h] = i;
+	}
+	return true;
+}
+
+size_t EasyLz::compress(const Dictionary *dictionary, const uint8_t *in, size_t len, uint8_t *out, size_t out_cap)
+{
+	if (len > MAX_INPUT_LEN)
+		return 0;
+
+	const uint16_t dict_len = dictionary ? dictionary->len : 0;
+	memset(head, 0xFF, sizeof(head));
+
+	size_t i = 0, o = 0, flags_at = 0;
+	uint8_t item = 8;
+	while (i < len)
+	{
+		if (item == 8)
+		{
+			if (o >= out_cap)
+				return 0;
+			flags_at = o++;
+			out[flags_at] = 0;
+			item = 0;
+		}
+
+		size_t best_len = 0, best_distance = 0;
+		if (i + MIN_MATCH <= len)
+		{
+			uint16_t h = hash(in + i);
+			size_t max = len - i < MAX_MATCH ? len - i : MAX_MATCH;
+
+			// the frame first, its matches are the closest
+			uint8_t chain = 0;
+			for (uint16_t p = head[h]; p != NIL && chain < MAX_CHAIN && best_len < max; p = prev[p], chain++)
+			{
+				size_t n = matchLength(in + p, in + i, max);
+				if (n > best_len)
+				{
+					best_len = n;
+					best_distance = i - p;
+				}
+			}
+
+			// then the dictionary, a match there stops at its end
+			for (uint16_t p = dict_len ? dictionary->head[h] : NIL; p != NIL && chain < MAX_CHAIN && best_len < max; p = dictionary->prev[p], chain++)
+			{
+				size_t distance = i + dict_len - p;
+				if (distance > MAX_DISTANCE)
+					break;
+				size_t room = (size_t)(dict_len - p) < max ? dict_len - p : max;
+				size_t n = matchLength(dictionary->data + p, in + i, room);
+				if (n > best_len)
+				{
+					best_len = n;
+					best_distance = distance;
+				}
+			}
+		}
+
+		size_t step;
+		if (best_len >= MIN_MATCH)
+		{
+			if (o + 2 > out_cap)
+				return 0;
+			out[flags_at] |= 1 << item;
+			out[o++] = (uint8_t)(best_distance - 1);
+			out[o++] = (uint8_t)((((best_distance - 1) >> 8) << 6) | (best_len - MIN_MATCH));
+			step = best_len;
+		}
+		else
+		{
+			if (o >= out_cap)
+				return 0;
+			out[o++] = in[i];
+			step = 1;
+		}
+		item++;
+
+		// every position covered is indexed, later matches can start anywhere
+		for (size_t end = i + step; i < end; i++)
+		{
+			if (i + MIN_MATCH <= len)
+			{
+				uint16_t h = hash(in + i);
+				prev[i] = head[h];
+				head[h] = (uint16_t)i;
+			}
+		}
+	}
+	return o;
+}
+
+int EasyLz::decompress(const Dictionary *dictionary, const uint8_t *in, size_t len, uint8_t *out, size_t out_cap)
+{
+	const uint16_t dict_len = dictionary ? dictionary->len : 0;
+	size_t i = 0, o = 0;
+	while (i < len)
+	{
+		uint8_t flags = in[i++];
+		for (uint8_t item = 0; item < 8 && i < len; item++)
+		{
+			if (!(flags & (1 << item)))
+			{
+				if (o >= out_cap)
+					return -1;
+				out[o++] = in[i++];
+				continue;
+			}
+
+			if (i + 2 > len)
+				return -1;
+			size_t distance = ((size_t)in[i] | ((size_t)(in[i + 1] >> 6) << 8)) + 1;
+			size_t n = (in[i + 1] & 0x3F) + MIN_MATCH;
+			i += 2;
+			if (distance > o + dict_len || o + n > out_cap)
+				return -1;
+
+			// byte by byte: a match may overlap what it produces, or start in the dictionary and run into the frame
+			for (size_t k = 0; k < n; k++, o++)
+				out[o] = distance > o ? dictionary->data[dict_len - (distance - o)] : out[o - distance];
+		}
+	}
+	return (int)o;
+}
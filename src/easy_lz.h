@@ -0,0 +1,89 @@
+#ifndef EASY_LZ_H
+#define EASY_LZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Small window LZ77 codec for single frames, in portable C++ so it runs the same on the ESP32 and on a host.
+ *
+ * The stream is a flag byte followed by up to eight items, bit `i` of the flag byte telling if item `i` is a literal byte
+ * or a match. A match is two bytes: a 10 bits distance back into what was already decoded and a 6 bits length, so it
+ * copies 3 to 66 bytes from up to 1024 bytes back. A pre-shared dictionary sits right in front of the frame as if it had
+ * been sent before it, the first messages of the kind compress as well as the later ones. The dictionary is indexed once
+ * when it is set, compressing a frame only indexes the frame.
+ *
+ * All the working memory is in the objects, sized by the constants below, nothing is allocated.
+ */
+class EasyLz
+{
+public:
+	static const uint16_t MAX_DICTIONARY_LEN = 512; ///< @brief Dictionary and frame must fit in the 1024 bytes window
+	static const uint16_t MAX_INPUT_LEN = 256;		 ///< @brief Longest frame the encoder indexes
+	static const uint8_t MIN_MATCH = 3;
+	static const uint8_t MAX_MATCH = MIN_MATCH + 63;
+	static const uint16_t MAX_DISTANCE = 1024;
+	static const uint8_t HASH_BITS = 8;
+	static const uint16_t HASH_SIZE = 1 << HASH_BITS;
+	static const uint8_t MAX_CHAIN = 16; ///< @brief Candidates tried per position, bounds the encoding time
+	static const uint16_t NIL = 0xFFFF;
+
+	/**
+	 * Pre-shared dictionary with its index, usable once `set(...)`. The bytes are not copied, they must stay valid while the dictionary is in use
+	 */
+	class Dictionary
+	{
+	public:
+		/**
+		 * @brief Indexes a dictionary
+		 * @param data Dictionary bytes, typically a `const` array trained by `extras/host/tools/easy_lz_train`
+		 * @param len Length of `data`, up to `MAX_DICTIONARY_LEN`
+		 * @return `true` if success, `false` if the dictionary is too long
+		 */
+		bool set(const uint8_t *data, uint16_t len);
+
+		uint16_t length() const { return len; }
+
+	private:
+		friend class EasyLz;
+		const uint8_t *data;
+		uint16_t len;
+		uint16_t head[HASH_SIZE];		///< @brief Newest dictionary position of every hash
+		uint16_t prev[MAX_DICTIONARY_LEN]; ///< @brief Older dictionary position of the same hash
+	};
+
+	/**
+	 * @brief Longest stream a frame of `len` bytes can turn into, when nothing matches
+	 */
+	static size_t maxCompressedLength(size_t len) { return len + (len + 7) / 8; }
+
+	/**
+	 * @brief Compresses a frame
+	 * @param dictionary Dictionary to match against, `nullptr` for none
+	 * @param in Frame, up to `MAX_INPUT_LEN` bytes
+	 * @param len Length of `in`
+	 * @param out Receives the stream
+	 * @param out_cap Room in `out`
+	 * @return Length of the stream, `0` if it would not fit in `out_cap`
+	 */
+	size_t compress(const Dictionary *dictionary, const uint8_t *in, size_t len, uint8_t *out, size_t out_cap);
+
+	/**
+	 * @brief Decompresses a stream. Every distance and length is checked, a malformed stream never reads or writes out of bounds
+	 * @param dictionary Dictionary the stream was compressed with, `nullptr` for none
+	 * @return Length of the frame, `-1` if the stream is malformed or the frame longer than `out_cap`
+	 */
+	static int decompress(const Dictionary *dictionary, const uint8_t *in, size_t len, uint8_t *out, size_t out_cap);
+
+private:
+	uint16_t head[HASH_SIZE];	 ///< @brief Newest frame position of every hash
+	uint16_t prev[MAX_INPUT_LEN]; ///< @brief Older frame position of the same hash
+
+	static uint16_t hash(const uint8_t *p)
+	{
+		uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+		return (uint16_t)((v * 2654435761u) >> (32 - HASH_BITS));
+	}
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef EASY_MESSAGE_H
+#define EASY_MESSAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Compile time identity of the structs sent with `send<T>(...)` and received with `onMessage<T>(...)`.
+ *
+ * A struct becomes a message type with `EASY_MESSAGE(T)` at global scope: its id is a 16 bits hash of the type name and
+ * of its size, computed by the compiler, so two builds agree on it without a registry and a struct that changed size gets
+ * another id. `EASY_MESSAGE_ID(T, id)` picks the id by hand instead, to keep it across a rename.
+ * Sender and receiver must declare the struct the same way, it travels as its bytes.
+ */
+
+/**
+ * @brief FNV-1a of a string, folded with `seed`. C++11 `constexpr`, one recursion per character
+ */
+static constexpr uint32_t easyMessageHash(const char *text, uint32_t seed = 2166136261u)
+{
+	return *text ? easyMessageHash(text + 1, (seed ^ (uint8_t)*text) * 16777619u) : seed;
+}
+
+/**
+ * @brief Id of a message type named `name` of `size` bytes, as carried by `easy_typed_header_t`
+ */
+static constexpr uint16_t easyMessageId(const char *name, size_t size)
+{
+	return (uint16_t)((easyMessageHash(name, (uint32_t)size * 16777619u) >> 16) ^ easyMessageHash(name, (uint32_t)size * 16777619u));
+}
+
+/**
+ * Declared by `EASY_MESSAGE(...)` for every message type. Left undefined for the others, so sending or handling a struct
+ * that was not declared fails to compile
+ */
+template <typename T>
+struct EasyMessageType;
+
+#define EASY_MESSAGE(T)                                                     \
+	template <>                                                             \
+	struct EasyMessageType<T>                                               \
+	{                                                                       \
+		static constexpr uint16_t id() { return easyMessageId(#T, sizeof(T)); } \
+	}
+
+#define EASY_MESSAGE_ID(T, ID)                                              \
+	template <>                                                             \
+	struct EasyMessageType<T>                                               \
+	{                                                                       \
+		static constexpr uint16_t id() { return (ID); }                     \
+	}
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef EASY_PEER_TABLE_H
+#define EASY_PEER_TABLE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Peer table with constant time add, lookup, touch and eviction.
+ *
+ * Entries live densely in a storage array owned by the caller (so it can still be handed out as a plain list),
+ * an open-addressing hash maps MAC -> entry index, and an intrusive doubly linked list keeps the entries ordered by
+ * last seen time: every add or touch moves the entry to the newest end, so the oldest peer is always at the head.
+ * Deleting swaps the last entry into the freed position, no shifting of the array.
+ *
+ * `Entry` must have a `uint8_t mac[6]` member.
+ */
+template <typename Entry>
+class EasyPeerTable
+{
+public:
+	static const uint16_t NIL = 0xFFFF;
+	static const uint8_t MAC_LEN = 6;
+
+	/**
+	 * @brief Allocates the index for `capacity` entries. This is the only allocation the table does
+	 * @param storage Array of at least `capacity` entries where the peers are kept
+	 * @param capacity Maximum number of peers
+	 * @return `true` if success, `false` if allocation failed
+	 */
+	bool begin(Entry *storage, uint16_t capacity)
+	{
+		end();
+		if (!storage || capacity == 0 || capacity >= NIL / 2)
+			return false;
+
+		// keep the load factor under 50% so probe sequences stay short
+		uint32_t hash_size = 1;
+		while (hash_size < (uint32_t)capacity * 2)
+			hash_size <<= 1;
+
+		hash = (uint16_t *)malloc(hash_size * sizeof(uint16_t));
+		prev = (uint16_t *)malloc(capacity * sizeof(uint16_t));
+		next = (uint16_t *)malloc(capacity * sizeof(uint16_t));
+		if (!hash || !prev || !next)
+		{
+			end();
+			return false;
+		}
+
+		items = storage;
+		cap = capacity;
+		hash_mask = hash_size - 1;
+		clear();
+		return true;
+	}
+
+	/**
+	 * @brief Frees the index. The storage array is not touched
+	 */
+	void end()
+	{
+		free(hash);
+		free(prev);
+		free(next);
+		hash = prev = next = nullptr;
+		items = nullptr;
+		cap = count = 0;
+	}
+
+	/**
+	 * @brief Removes all the peers
+	 */
+	void clear()
+	{
+		if (hash)
+			memset(hash, 0xFF, (hash_mask + 1) * sizeof(uint16_t));
+		count = 0;
+		head = tail = NIL;
+	}
+
+	uint16_t size() const { return count; }
+	uint16_t capacity() const { return cap; }
+	bool full() const { return count >= cap; }
+	Entry &at(uint16_t index) { return items[index]; }
+	const Entry &at(uint16_t index) const { return items[index]; }
+
+	/**
+	 * @brief Looks up a peer
+	 * @return index of the entry or `-1` if peer is not in the table
+	 */
+	int find(const uint8_t *mac) const
+	{
+		if (!hash || !mac)
+			return -1;
+		for (uint32_t pos = hashMac(mac) & hash_mask;; pos = (pos + 1) & hash_mask)
+		{
+			uint16_t index = hash[pos];
+			if (index == NIL)
+				return -1;
+			if (memcmp(items[index].mac, mac, MAC_LEN) == 0)
+				return index;
+		}
+	}
+
+	/**
+	 * @brief Adds a peer as the newest one. Only the MAC of the new entry is set, caller fills in the rest
+	 * @return index of the new entry or `-1` if table is full or peer already exists
+	 */
+	int insert(const uint8_t *mac)
+	{
+		if (!hash || !mac || full() || find(mac) >= 0)
+			return -1;
+
+		uint16_t index = count++;
+		memcpy(items[index].mac, mac, MAC_LEN);
+
+		uint32_t pos = hashMac(mac) & hash_mask;
+		while (hash[pos] != NIL)
+			pos = (pos + 1) & hash_mask;
+		hash[pos] = index;
+
+		linkNewest(index);
+		return index;
+	}
+
+	/**
+	 * @brief Removes a peer. The last entry of the storage array is moved into the freed position
+	 * @param mac Peer to remove
+	 * @param removed If not `nullptr`, receives a copy of the removed entry
+	 * @return `true` if the peer was removed, `false` if it was not in the table
+	 */
+	bool remove(const uint8_t *mac, Entry *removed = nullptr)
+	{
+		int found = find(mac);
+		if (found < 0)
+			return false;
+
+		uint16_t index = (uint16_t)found;
+		if (removed)
+			*removed = items[index];
+
+		unlinkHash(index);
+		unlinkAge(index);
+
+		uint16_t last = --count;
+		if (index != last)
+		{
+			// fill the gap with the last entry and fix the references to it
+			items[index] = items[last];
+			*hashSlotOf(last) = index;
+			prev[index] = prev[last];
+			next[index] = next[last];
+			if (prev[index] != NIL)
+				next[prev[index]] = index;
+			else
+				head = index;
+			if (next[index] != NIL)
+				prev[next[index]] = index;
+			else
+				tail = index;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Marks a peer as the newest one
+	 */
+	void touch(uint16_t index)
+	{
+		if (index >= count || index == tail)
+			return;
+		unlinkAge(index);
+		linkNewest(index);
+	}
+
+	/**
+	 * @brief Returns the oldest peer
+	 * @param skip_mac If not `nullptr`, this peer is never returned (for example to keep the Broadcast peer)
+	 * @return index of the oldest entry or `-1` if there is none
+	 */
+	int oldest(const uint8_t *skip_mac = nullptr) const
+	{
+		uint16_t index = head;
+		if (index != NIL && skip_mac && memcmp(items[index].mac, skip_mac, MAC_LEN) == 0)
+			index = next[index];
+		return index == NIL ? -1 : index;
+	}
+
+	/**
+	 * @brief Iterates the peers from oldest to newest
+	 * @param index Current entry, `-1` to get the oldest one
+	 * @return index of the next newer entry or `-1` when done
+	 */
+	int newer(int index) const
+	{
+		uint16_t n = index < 0 ? head : next[index];
+		return n == NIL ? -1 : n;
+	}
+
+private:
+	Entry *items = nullptr;
+	uint16_t *hash = nullptr; ///< @brief entry index per hash slot, NIL if empty
+	uint16_t *prev = nullptr; ///< @brief next older entry
+	uint16_t *next = nullptr; ///< @brief next newer entry
+	uint16_t cap = 0;
+	uint16_t count = 0;
+	uint16_t head = NIL; ///< @brief oldest entry
+	uint16_t tail = NIL; ///< @brief newest entry
+	uint32_t hash_mask = 0;
+
+	static uint32_t hashMac(const uint8_t *mac)
+	{
+		// vendor part changes little between peers, mix the device part well
+		uint32_t h = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+		h ^= ((uint32_t)mac[0] << 8 | mac[1]) * 0x9E3779B1u;
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		return h;
+	}
+
+	uint16_t *hashSlotOf(uint16_t index)
+	{
+		for (uint32_t pos = hashMac(items[index].mac) & hash_mask;; pos = (pos + 1) & hash_mask)
+		{
+			if (hash[pos] == index)
+				return &hash[pos];
+		}
+	}
+
+	void unlinkHash(uint16_t index)
+	{
+		uint16_t *slot = hashSlotOf(index);
+		uint32_t pos = slot - hash;
+		hash[pos] = NIL;
+
+		// backward shift deletion: move up the entries of the cluster that can not be found anymore
+		for (uint32_t scan = (pos + 1) & hash_mask; hash[scan] != NIL; scan = (scan + 1) & hash_mask)
+		{
+			uint32_t home = hashMac(items[hash[scan]].mac) & hash_mask;
+			// entry can move to the hole only if its home is not in (hole, scan]
+			if (((scan - home) & hash_mask) >= ((scan - pos) & hash_mask))
+			{
+				hash[pos] = hash[scan];
+				hash[scan] = NIL;
+				pos = scan;
+			}
+		}
+	}
+
+	void linkNewest(uint16_t index)
+	{
+		prev[index] = tail;
+		next[index] = NIL;
+		if (tail != NIL)
+			next[tail] = index;
+		else
+			head = index;
+		tail = index;
+	}
+
+	void unlinkAge(uint16_t index)
+	{
+		if (prev[index] != NIL)
+			next[prev[index]] = next[index];
+		else
+			head = next[index];
+		if (next[index] != NIL)
+			prev[next[index]] = prev[index];
+		else
+			tail = prev[index];
+	}
+};
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef EASY_REASSEMBLY_H
+#define EASY_REASSEMBLY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+#include "easy_frame.h"
+
+/**
+ * Reassembly of fragmented messages in a fixed number of preallocated buffers, one message per buffer.
+ *
+ * Fragments are added by a single producer (the receive path). A completed buffer is handed to a single consumer
+ * that calls `release(...)` after delivering it, so completion and delivery can run in different tasks.
+ * Incomplete messages are dropped when their timeout expires, or evicted (oldest first) when a new message needs a buffer.
+ *
+ * `Meta` is whatever the receive path wants to keep along with a message, for example the radio metadata of its last fragment.
+ */
+template <typename Meta>
+class EasyReassembler
+{
+public:
+	typedef enum
+	{
+		FRAGMENT_STORED = 0,	/**< Fragment copied, message not complete yet*/
+		MESSAGE_COMPLETE = 1,	/**< Last missing fragment, message is ready for delivery*/
+		FRAGMENT_DUPLICATE = 2, /**< Fragment was already received*/
+		FRAGMENT_DROPPED = 3,	/**< No buffer could be freed, all are waiting for delivery*/
+		FRAGMENT_INVALID = 4,	/**< Header does not add up or message too long*/
+	} add_result_t;
+
+	typedef struct
+	{
+		uint32_t timeouts;	/**< Incomplete messages dropped because their timeout expired*/
+		uint32_t evictions; /**< Incomplete messages dropped to make room for a new one*/
+	} counters_t;
+
+	/**
+	 * @brief Allocates the buffers. This is the only allocation the reassembler does
+	 * @param slots Messages that can be reassembled at the same time
+	 * @param max_message_len Longest message, at most `EASY_MAX_FRAGMENTS` fragments
+	 * @param fragment_len Bytes carried by every fragment but the last one
+	 * @param timeout_ms Time an incomplete message is kept since its last fragment
+	 * @return `true` if success, `false` if some parameter is invalid or allocation failed
+	 */
+	bool begin(uint8_t slots, uint16_t max_message_len, uint16_t fragment_len, uint32_t timeout_ms)
+	{
+		end();
+		if (slots == 0 || fragment_len == 0 || max_message_len == 0 || (uint32_t)max_message_len > (uint32_t)fragment_len * EASY_MAX_FRAGMENTS)
+			return false;
+
+		states = (slot_t *)calloc(slots, sizeof(slot_t));
+		buffers = (uint8_t *)malloc((size_t)slots * max_message_len);
+		if (!states || !buffers)
+		{
+			end();
+			return false;
+		}
+
+		slot_count = slots;
+		max_len = max_message_len;
+		frag_len = fragment_len;
+		timeout = timeout_ms;
+		return true;
+	}
+
+	/**
+	 * @brief Frees the buffers
+	 */
+	void end()
+	{
+		free(states);
+		free(buffers);
+		states = nullptr;
+		buffers = nullptr;
+		slot_count = 0;
+	}
+
+	uint8_t slots() const { return slot_count; }
+	uint16_t maxMessageLength() const { return max_len; }
+
+	/**
+	 * @brief Copies a fragment into the buffer of its message
+	 * @param src Sender of the fragment
+	 * @param header Fragment header as received
+	 * @param data Fragment content
+	 * @param len Fragment length
+	 * @param now_ms Current time in ms
+	 * @param meta Kept with the message, overwritten by every fragment
+	 * @param completed_slot Receives the buffer of the message when `MESSAGE_COMPLETE` is returned
+	 */
+	add_result_t add(const uint8_t *src, const easy_fragment_header_t &header, const uint8_t *data, uint16_t len,
+					 uint32_t now_ms, const Meta &meta, int &completed_slot)
+	{
+		if (!states || len == 0 || header.total_len == 0 || header.total_len > max_len || header.offset % frag_len != 0 ||
+			(uint32_t)header.offset + len > header.total_len || (len != frag_len && (uint32_t)header.offset + len != header.total_len))
+			return FRAGMENT_INVALID;
+
+		expire(now_ms);
+
+		int index = find(src, header.message_id, header.total_len);
+		if (index < 0)
+		{
+			index = claim(now_ms);
+			if (index < 0)
+				return FRAGMENT_DROPPED;
+			slot_t &fresh = states[index];
+			memcpy(fresh.src, src, sizeof(fresh.src));
+			fresh.message_id = header.message_id;
+			fresh.total_len = header.total_len;
+			fresh.received_len = 0;
+			fresh.received = 0;
+			fresh.state.store(FILLING, std::memory_order_relaxed);
+		}
+
+		slot_t &slot = states[index];
+		uint32_t bit = 1UL << (header.offset / frag_len);
+		if (slot.received & bit)
+			return FRAGMENT_DUPLICATE;
+
+		memcpy(buffers + (size_t)index * max_len + header.offset, data, len);
+		slot.received |= bit;
+		slot.received_len += len;
+		slot.last_update_ms = now_ms;
+		slot.meta = meta;
+
+		if (slot.received_len < slot.total_len)
+			return FRAGMENT_STORED;
+
+		// hand the buffer to the consumer
+		slot.state.store(COMPLETE, std::memory_order_release);
+		completed_slot = index;
+		return MESSAGE_COMPLETE;
+	}
+
+	/**
+	 * @brief Iterates the complete messages waiting for delivery
+	 * @param index Current buffer, `-1` to start
+	 * @return next buffer holding a complete message or `-1` when done
+	 */
+	int nextComplete(int index) const
+	{
+		for (int i = index + 1; states && i < slot_count; i++)
+		{
+			if (states[i].state.load(std::memory_order_acquire) == COMPLETE)
+				return i;
+		}
+		return -1;
+	}
+
+	const uint8_t *message(int index) const { return buffers + (size_t)index * max_len; }
+	uint16_t messageLength(int index) const { return states[index].total_len; }
+	const uint8_t *source(int index) const { return states[index].src; }
+	const Meta &meta(int index) const { return states[index].meta; }
+
+	/**
+	 * @brief Gives a delivered buffer back to the producer
+	 */
+	void release(int index)
+	{
+		if (states && index >= 0 && index < slot_count)
+			states[index].state.store(FREE, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Returns the timeout and eviction counters
+	 * @param reset `true` to reset the counters after reading them
+	 */
+	counters_t counters(bool reset = false)
+	{
+		counters_t current = {.timeouts = timeouts.load(std::memory_order_relaxed), .evictions = evictions.load(std::memory_order_relaxed)};
+		if (reset)
+		{
+			timeouts.fetch_sub(current.timeouts, std::memory_order_relaxed);
+			evictions.fetch_sub(current.evictions, std::memory_order_relaxed);
+		}
+		return current;
+	}
+
+private:
+	enum : uint8_t
+	{
+		FREE = 0,
+		FILLING = 1,
+		COMPLETE = 2,
+	};
+
+	typedef struct
+	{
+		std::atomic<uint8_t> state; ///< @brief Only `COMPLETE -> FREE` is done by the consumer
+		uint8_t src[6];
+		uint16_t message_id;
+		uint16_t total_len;
+		uint16_t received_len;
+		uint32_t received; ///< @brief One bit per received fragment
+		uint32_t last_update_ms;
+		Meta meta;
+	} slot_t;
+
+	slot_t *states = nullptr;
+	uint8_t *buffers = nullptr;
+	uint8_t slot_count = 0;
+	uint16_t max_len = 0;
+	uint16_t frag_len = 0;
+	uint32_t timeout = 0;
+	std::atomic<uint32_t> timeouts{0};
+	std::atomic<uint32_t> evictions{0};
+
+	int find(const uint8_t *src, uint16_t message_id, uint16_t total_len) const
+	{
+		for (int i = 0; i < slot_count; i++)
+		{
+			const slot_t &slot = states[i];
+			if (slot.state.load(std::memory_order_relaxed) == FILLING && slot.message_id == message_id &&
+				slot.total_len == total_len && memcmp(slot.src, src, sizeof(slot.src)) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	void expire(uint32_t now_ms)
+	{
+		for (int i = 0; i < slot_count; i++)
+		{
+			slot_t &slot = states[i];
+			if (slot.state.load(std::memory_order_relaxed) == FILLING && now_ms - slot.last_update_ms > timeout)
+			{
+				slot.state.store(FREE, std::memory_order_relaxed);
+				timeouts.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	int claim(uint32_t now_ms)
+	{
+		int oldest = -1;
+		for (int i = 0; i < slot_count; i++)
+		{
+			uint8_t state = states[i].state.load(std::memory_order_acquire);
+			if (state == FREE)
+				return i;
+			if (state == FILLING && (oldest < 0 || now_ms - states[i].last_update_ms > now_ms - states[oldest].last_update_ms))
+				oldest = i;
+		}
+
+		// memory pressure, the incomplete message that made no progress for the longest time goes
+		if (oldest >= 0)
+			evictions.fetch_add(1, std::memory_order_relaxed);
+		return oldest;
+	}
+};
+
+#endif
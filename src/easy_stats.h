@@ -0,0 +1,85 @@
+#ifndef EASY_STATS_H
+#define EASY_STATS_H
+
+#include <stdint.h>
+#include <atomic>
+
+static const uint8_t LATENCY_HISTOGRAM_BUCKETS = 20; ///< @brief Bucket `i` holds latencies of `[2^i, 2^(i+1))` µs, the last one everything from ~0.5 s
+
+/**
+ * Snapshot of a latency histogram with log2 buckets
+ */
+typedef struct
+{
+	uint32_t count;								/**< Latencies recorded*/
+	uint32_t total_us;							/**< Sum, wraps after ~71 minutes of accumulated latency*/
+	uint32_t max_us;							/**< Longest*/
+	uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS]; /**< Bucket `0` also holds 0 µs*/
+} latency_histogram_t;
+
+/**
+ * Latency histogram recorded with relaxed atomic increments only, so any task or callback can record into it
+ * without taking a lock. A snapshot is not atomic as a whole, buckets recorded while it is taken may miss it
+ */
+class EasyLatencyHistogram
+{
+public:
+	void record(uint32_t latency_us)
+	{
+		// position of the highest bit set, cheap on every target
+		uint8_t bucket = latency_us ? 31 - __builtin_clz(latency_us) : 0;
+		if (bucket >= LATENCY_HISTOGRAM_BUCKETS)
+			bucket = LATENCY_HISTOGRAM_BUCKETS - 1;
+
+		buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		total_us.fetch_add(latency_us, std::memory_order_relaxed);
+		uint32_t current = max_us.load(std::memory_order_relaxed);
+		while (latency_us > current && !max_us.compare_exchange_weak(current, latency_us, std::memory_order_relaxed))
+			;
+	}
+
+	/**
+	 * @param reset `true` to reset the histogram after reading it
+	 */
+	latency_histogram_t snapshot(bool reset = false)
+	{
+		latency_histogram_t histogram;
+		histogram.count = reset ? count.exchange(0, std::memory_order_relaxed) : count.load(std::memory_order_relaxed);
+		histogram.total_us = reset ? total_us.exchange(0, std::memory_order_relaxed) : total_us.load(std::memory_order_relaxed);
+		histogram.max_us = reset ? max_us.exchange(0, std::memory_order_relaxed) : max_us.load(std::memory_order_relaxed);
+		for (uint8_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+			histogram.buckets[i] = reset ? buckets[i].exchange(0, std::memory_order_relaxed) : buckets[i].load(std::memory_order_relaxed);
+		return histogram;
+	}
+
+private:
+	std::atomic<uint32_t> count{0};
+	std::atomic<uint32_t> total_us{0};
+	std::atomic<uint32_t> max_us{0};
+	std::atomic<uint32_t> buckets[LATENCY_HISTOGRAM_BUCKETS] = {};
+};
+
+/**
+ * @brief Latency below which the given fraction of a histogram falls, at the upper edge of its bucket
+ * @param histogram Histogram snapshot
+ * @param percentile From `0` to `100`
+ * @return upper edge of the bucket in µs, `0` if the histogram is empty
+ */
+static inline uint32_t easyLatencyPercentile(const latency_histogram_t &histogram, uint8_t percentile)
+{
+	if (histogram.count == 0)
+		return 0;
+
+	uint64_t target = ((uint64_t)histogram.count * percentile + 99) / 100;
+	uint64_t seen = 0;
+	for (uint8_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+	{
+		seen += histogram.buckets[i];
+		if (seen >= target && seen > 0)
+			return i == LATENCY_HISTOGRAM_BUCKETS - 1 ? histogram.max_us : ((uint32_t)2 << i) - 1;
+	}
+	return histogram.max_us;
+}
+
+#endif